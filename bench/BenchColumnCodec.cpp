@@ -0,0 +1,124 @@
+// Column serialization: one value at a time into a fresh buffer (the pattern of
+// marshalInt*_t / marshalBool / DataNullBitMapTuple) against the batch column
+// codec writing into one caller-owned span, at every SIMD level the CPU has.
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "../src/columnCodec.h"
+
+// reference copies of the per-value style, big endian by shifts
+static std::vector<uint8_t> marshalInt32PerValue(int32_t value) {
+    std::vector<uint8_t> out;
+    for (int i = 3; i >= 0; --i) {
+        out.push_back(static_cast<uint8_t>(static_cast<uint32_t>(value) >> (8 * i)));
+    }
+    return out;
+}
+
+static std::vector<uint8_t> marshalInt64PerValue(int64_t value) {
+    std::vector<uint8_t> out;
+    for (int i = 7; i >= 0; --i) {
+        out.push_back(static_cast<uint8_t>(static_cast<uint64_t>(value) >> (8 * i)));
+    }
+    return out;
+}
+
+static std::vector<uint8_t> nullBitmapBitByBit(const std::vector<bool>& bitmap) {
+    std::vector<uint8_t> out;
+    uint8_t current = 0;
+    for (size_t i = 0; i < bitmap.size(); ++i) {
+        if (bitmap[i]) {
+            current |= static_cast<uint8_t>(1 << (i % 8));
+        }
+        if (i % 8 == 7) {
+            out.push_back(current);
+            current = 0;
+        }
+    }
+    if (bitmap.size() % 8 != 0) {
+        out.push_back(current);
+    }
+    return out;
+}
+
+template<typename F>
+static double nsPerValue(size_t values, int rounds, F body) {
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r) {
+        body();
+    }
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    return elapsed / static_cast<double>(values * rounds);
+}
+
+static const char* levelName(ColumnCodecLevel level) {
+    switch (level) {
+        case ColumnCodecLevel::AVX2: return "avx2";
+        case ColumnCodecLevel::SSSE3: return "ssse3";
+        default: return "scalar";
+    }
+}
+
+int main() {
+    const size_t N = 1 << 16;
+    const int ROUNDS = 200;
+    std::mt19937_64 rng(1);
+    std::vector<int32_t> ints32(N);
+    std::vector<int64_t> ints64(N);
+    std::vector<bool> bitmap(N);
+    std::vector<uint8_t> flags(N);
+    for (size_t i = 0; i < N; ++i) {
+        ints32[i] = static_cast<int32_t>(rng());
+        ints64[i] = static_cast<int64_t>(rng());
+        bitmap[i] = rng() % 4 != 0;
+        flags[i] = bitmap[i] ? 1 : 0;
+    }
+    std::vector<uint8_t> out(N * sizeof(int64_t));
+    uint64_t sink = 0;
+
+    double perValue32 = nsPerValue(N, ROUNDS, [&]() {
+        for (size_t i = 0; i < N; ++i) {
+            sink += marshalInt32PerValue(ints32[i])[0];
+        }
+    });
+    double perValue64 = nsPerValue(N, ROUNDS, [&]() {
+        for (size_t i = 0; i < N; ++i) {
+            sink += marshalInt64PerValue(ints64[i])[0];
+        }
+    });
+    double perBit = nsPerValue(N, ROUNDS, [&]() {
+        sink += nullBitmapBitByBit(bitmap)[0];
+    });
+    std::cout << "ns/value            int32 BE   int64 BE   null bitmap" << std::endl;
+    std::cout << "per value           " << perValue32 << "   " << perValue64 << "   " << perBit << std::endl;
+
+    ColumnCodecLevel best = detectColumnCodecLevel();
+    for (ColumnCodecLevel level : {ColumnCodecLevel::SCALAR, ColumnCodecLevel::SSSE3, ColumnCodecLevel::AVX2}) {
+        if (level > best) {
+            break;
+        }
+        columnCodecLevel = level;
+        double batch32 = nsPerValue(N, ROUNDS, [&]() {
+            encodeColumn(ints32.data(), N, out.data(), ColumnByteOrder::BIG);
+            sink += out[0];
+        });
+        double batch64 = nsPerValue(N, ROUNDS, [&]() {
+            encodeColumn(ints64.data(), N, out.data(), ColumnByteOrder::BIG);
+            sink += out[0];
+        });
+        double batchBits = nsPerValue(N, ROUNDS, [&]() {
+            packNullBitmap(flags.data(), N, out.data());
+            sink += out[0];
+        });
+        std::cout << "batch " << levelName(level) << "        " << batch32 << "   " << batch64 << "   " << batchBits << std::endl;
+    }
+    columnCodecLevel = best;
+    double vectorBool = nsPerValue(N, ROUNDS, [&]() {
+        packNullBitmap(bitmap, out.data());
+        sink += out[0];
+    });
+    std::cout << "batch vector<bool> bitmap  " << vectorBool << std::endl;
+    return sink == 42 ? 1 : 0;
+}
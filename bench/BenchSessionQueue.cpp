@@ -0,0 +1,108 @@
+// Session task handoff: std::queue + mutex + condvar (what Session::submit/run
+// used before) against the lock-free MpscRing with batched dequeue.
+#include <pthread.h>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <queue>
+#include <thread>
+#include <vector>
+#include "../src/taskQueue.h"
+
+struct BenchTask {
+    int32_t userIp = -1;
+    void* user = nullptr;
+    void* tupleData = nullptr;
+    void* tableHeaderData = nullptr;
+};
+
+class MutexQueue {
+    private:
+        pthread_mutex_t m = PTHREAD_MUTEX_INITIALIZER;
+        pthread_cond_t cv = PTHREAD_COND_INITIALIZER;
+        std::queue<BenchTask> q;
+    public:
+        void submit(BenchTask t) {
+            pthread_mutex_lock(&m);
+            q.push(t);
+            pthread_cond_signal(&cv);
+            pthread_mutex_unlock(&m);
+        }
+        BenchTask take() {
+            pthread_mutex_lock(&m);
+            while (q.empty()) {
+                pthread_cond_wait(&cv, &m);
+            }
+            BenchTask t = q.front();
+            q.pop();
+            pthread_mutex_unlock(&m);
+            return t;
+        }
+};
+
+static double runMutexQueue(int producers, int64_t perProducer) {
+    MutexQueue queue;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&queue, perProducer]() {
+            for (int64_t i = 0; i < perProducer; ++i) {
+                BenchTask t;
+                t.userIp = 1;
+                queue.submit(t);
+            }
+        });
+    }
+    int64_t sum = 0;
+    for (int64_t i = 0; i < producers * perProducer; ++i) {
+        sum += queue.take().userIp;
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    return sum > 0 ? elapsed / static_cast<double>(sum) : 0.0;
+}
+
+static double runMpscRing(int producers, int64_t perProducer) {
+    MpscRing<BenchTask> ring(4096);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&ring, perProducer]() {
+            for (int64_t i = 0; i < perProducer; ++i) {
+                BenchTask t;
+                t.userIp = 1;
+                ring.push(t);
+            }
+        });
+    }
+    int64_t sum = 0;
+    BenchTask batch[64];
+    while (sum < producers * perProducer) {
+        size_t n = ring.popBatch(batch, 64);
+        if (n == 0) {
+            ring.waitForData(nullptr);
+            continue;
+        }
+        for (size_t i = 0; i < n; ++i) {
+            sum += batch[i].userIp;
+        }
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    return elapsed / static_cast<double>(sum);
+}
+
+int main() {
+    const int64_t TASKS = 2000000;
+    std::cout << "producers  mutex+condvar ns/task  mpsc ring ns/task" << std::endl;
+    for (int producers : {1, 2, 4, 8}) {
+        double mutexNs = runMutexQueue(producers, TASKS / producers);
+        double ringNs = runMpscRing(producers, TASKS / producers);
+        std::cout << producers << "          " << mutexNs << "                  " << ringNs << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,352 @@
+#include <errno.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <linux/io_uring.h>
+#include "asyncPageIo.h"
+#include "../../bufforing-stm/src/log.h"
+
+// ---- sync fallback ----
+
+SyncPageIo::SyncPageIo(uint32_t depth) : queueDepth(depth > 0 ? depth : 1) {
+    prepared.reserve(queueDepth);
+}
+
+bool SyncPageIo::prepare(const PageIoRequest& request) {
+    if (inFlight() >= static_cast<int32_t>(queueDepth)) {
+        return false;
+    }
+    prepared.push_back(request);
+    return true;
+}
+
+int32_t SyncPageIo::submit() {
+    int32_t count = static_cast<int32_t>(prepared.size());
+    for (const PageIoRequest& r : prepared) {
+        ssize_t rc;
+        do {
+            switch (r.op) {
+                case PageIoOp::READ:
+                    rc = pread(r.fd, r.buf, r.length, static_cast<off_t>(r.offset));
+                    break;
+                case PageIoOp::WRITE:
+                    rc = pwrite(r.fd, r.buf, r.length, static_cast<off_t>(r.offset));
+                    break;
+                case PageIoOp::FSYNC:
+                default:
+                    rc = fdatasync(r.fd);
+                    break;
+            }
+        } while (rc < 0 && errno == EINTR);
+        completed.push_back({r.userData, rc < 0 ? -errno : static_cast<int32_t>(rc)});
+    }
+    prepared.clear();
+    return count;
+}
+
+int32_t SyncPageIo::reap(PageIoCompletion* out, int32_t max, int32_t minComplete) {
+    (void)minComplete;   // everything submitted is already complete
+    int32_t n = 0;
+    while (n < max && !completed.empty()) {
+        out[n++] = completed.front();
+        completed.pop_front();
+    }
+    return n;
+}
+
+void SyncPageIo::drain() {
+    prepared.clear();
+    completed.clear();
+}
+
+// ---- io_uring ----
+
+static int ioUringSetup(uint32_t entries, io_uring_params* params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int ioUringEnter(int fd, uint32_t toSubmit, uint32_t minComplete, uint32_t flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+IoUringPageIo::IoUringPageIo(uint32_t depth) {
+    queueDepth = depth > 0 ? depth : 1;
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = queueDepth * 2;
+    ringFd = ioUringSetup(queueDepth, &params);
+    if (ringFd < 0) {
+        LOG_DEBUG("io_uring_setup failed, errno " << errno);
+        ringFd = -1;
+        return;
+    }
+    // the kernel rounds entries up to a power of two, keep our own limit on in-flight requests
+    sqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool singleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMmap) {
+        sqRingSize = cqRingSize = sqRingSize > cqRingSize ? sqRingSize : cqRingSize;
+    }
+    sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+    if (sqRing == MAP_FAILED) {
+        sqRing = nullptr;
+        release();
+        return;
+    }
+    if (singleMmap) {
+        cqRing = sqRing;
+    } else {
+        cqRing = mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+        if (cqRing == MAP_FAILED) {
+            cqRing = nullptr;
+            release();
+            return;
+        }
+    }
+    sqeMapSize = params.sq_entries * sizeof(io_uring_sqe);
+    sqeMap = mmap(nullptr, sqeMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+    if (sqeMap == MAP_FAILED) {
+        sqeMap = nullptr;
+        release();
+        return;
+    }
+    char* sq = static_cast<char*>(sqRing);
+    sqHead = reinterpret_cast<uint32_t*>(sq + params.sq_off.head);
+    sqTail = reinterpret_cast<uint32_t*>(sq + params.sq_off.tail);
+    sqMask = *reinterpret_cast<uint32_t*>(sq + params.sq_off.ring_mask);
+    sqArray = reinterpret_cast<uint32_t*>(sq + params.sq_off.array);
+    char* cq = static_cast<char*>(cqRing);
+    cqHead = reinterpret_cast<uint32_t*>(cq + params.cq_off.head);
+    cqTail = reinterpret_cast<uint32_t*>(cq + params.cq_off.tail);
+    cqMask = *reinterpret_cast<uint32_t*>(cq + params.cq_off.ring_mask);
+    cqes = cq + params.cq_off.cqes;
+    sqes = sqeMap;
+    localTail = *sqTail;
+    if (queueDepth > params.sq_entries) {
+        queueDepth = params.sq_entries;
+    }
+}
+
+IoUringPageIo::~IoUringPageIo() {
+    // buffers of the requests still belong to the kernel, wait for them before unmapping
+    drain();
+    release();
+}
+
+void IoUringPageIo::release() {
+    if (sqeMap) {
+        munmap(sqeMap, sqeMapSize);
+        sqeMap = nullptr;
+    }
+    if (cqRing && cqRing != sqRing) {
+        munmap(cqRing, cqRingSize);
+    }
+    cqRing = nullptr;
+    if (sqRing) {
+        munmap(sqRing, sqRingSize);
+        sqRing = nullptr;
+    }
+    if (ringFd >= 0) {
+        close(ringFd);
+        ringFd = -1;
+    }
+}
+
+bool IoUringPageIo::prepare(const PageIoRequest& request) {
+    if (ringFd < 0 || inFlightCount >= static_cast<int32_t>(queueDepth)) {
+        return false;
+    }
+    uint32_t index = localTail & sqMask;
+    io_uring_sqe* sqe = static_cast<io_uring_sqe*>(sqes) + index;
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->fd = request.fd;
+    sqe->user_data = request.userData;
+    switch (request.op) {
+        case PageIoOp::READ:
+            sqe->opcode = IORING_OP_READ;
+            break;
+        case PageIoOp::WRITE:
+            sqe->opcode = IORING_OP_WRITE;
+            break;
+        case PageIoOp::FSYNC:
+        default:
+            sqe->opcode = IORING_OP_FSYNC;
+            sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+            break;
+    }
+    if (request.op != PageIoOp::FSYNC) {
+        sqe->addr = reinterpret_cast<uint64_t>(request.buf);
+        sqe->len = request.length;
+        sqe->off = request.offset;
+    }
+    sqArray[index] = index;
+    localTail++;
+    toSubmit++;
+    inFlightCount++;
+    return true;
+}
+
+int32_t IoUringPageIo::submit() {
+    if (ringFd < 0 || toSubmit == 0) {
+        return 0;
+    }
+    // the kernel reads the entries after it sees the new tail
+    __atomic_store_n(sqTail, localTail, __ATOMIC_RELEASE);
+    int32_t submitted = 0;
+    while (toSubmit > 0) {
+        int rc = ioUringEnter(ringFd, toSubmit, 0, 0);
+        if (rc < 0) {
+            if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+                continue;
+            }
+            LOG_ERROR("io_uring_enter submit failed, errno " << errno);
+            break;
+        }
+        toSubmit -= static_cast<uint32_t>(rc);
+        submitted += rc;
+    }
+    return submitted;
+}
+
+int32_t IoUringPageIo::reap(PageIoCompletion* out, int32_t max, int32_t minComplete) {
+    if (ringFd < 0) {
+        return -1;
+    }
+    // entries never handed to the kernel cannot complete
+    int32_t submitted = inFlightCount - static_cast<int32_t>(toSubmit);
+    if (minComplete > submitted) {
+        minComplete = submitted;
+    }
+    if (minComplete > max) {
+        minComplete = max;
+    }
+    int32_t n = 0;
+    while (true) {
+        uint32_t head = *cqHead;
+        uint32_t tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+        while (head != tail && n < max) {
+            const io_uring_cqe* cqe = static_cast<const io_uring_cqe*>(cqes) + (head & cqMask);
+            out[n].userData = cqe->user_data;
+            out[n].result = cqe->res;
+            n++;
+            head++;
+        }
+        __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+        if (n >= minComplete) {
+            break;
+        }
+        int rc = ioUringEnter(ringFd, 0, static_cast<uint32_t>(minComplete - n), IORING_ENTER_GETEVENTS);
+        if (rc < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+            LOG_ERROR("io_uring_enter wait failed, errno " << errno);
+            break;
+        }
+    }
+    inFlightCount -= n;
+    return n;
+}
+
+void IoUringPageIo::drain() {
+    if (ringFd < 0) {
+        return;
+    }
+    // entries past the kernel's head were never consumed, taking the tail back drops them
+    // (no SQPOLL, the kernel only reads the ring inside io_uring_enter)
+    uint32_t head = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+    inFlightCount -= static_cast<int32_t>(localTail - head);
+    localTail = head;
+    toSubmit = 0;
+    __atomic_store_n(sqTail, localTail, __ATOMIC_RELEASE);
+    // the consumed ones still write into (or read from) their buffers until they complete
+    PageIoCompletion dropped[32];
+    while (inFlightCount > 0) {
+        if (reap(dropped, 32, 1) <= 0) {
+            sched_yield();
+        }
+    }
+}
+
+std::unique_ptr<AsyncPageIo> makeAsyncPageIo(uint32_t depth, PageIoBackend backend) {
+    if (backend != PageIoBackend::SYNC) {
+        std::unique_ptr<IoUringPageIo> ring = std::make_unique<IoUringPageIo>(depth);
+        if (ring->isReady()) {
+            return ring;
+        }
+        if (backend == PageIoBackend::IO_URING) {
+            return nullptr;
+        }
+        LOG_INFO("io_uring not available, page I/O falls back to pread/pwrite");
+    }
+    return std::make_unique<SyncPageIo>(depth);
+}
+
+int32_t runPageIo(AsyncPageIo& io, std::vector<PageIoRequest>& requests, std::vector<int32_t>& results) {
+    size_t n = requests.size();
+    results.assign(n, 0);
+    std::vector<uint32_t> done(n, 0);
+    std::vector<bool> complete(n, false);
+    std::deque<size_t> retry;      // short transfers waiting for a free ring entry
+    std::vector<PageIoCompletion> completions(io.depth());
+    size_t next = 0;
+    size_t finished = 0;
+    int32_t failed = 0;
+
+    auto prepareRest = [&](size_t i) {
+        PageIoRequest r = requests[i];
+        r.userData = i;
+        if (r.op != PageIoOp::FSYNC) {
+            r.buf = static_cast<char*>(r.buf) + done[i];
+            r.length -= done[i];
+            r.offset += done[i];
+        }
+        return io.prepare(r);
+    };
+    auto finish = [&](size_t i, int32_t result) {
+        results[i] = result;
+        complete[i] = true;
+        finished++;
+        if (result < 0) {
+            failed++;
+        }
+    };
+
+    while (finished < n) {
+        while (!retry.empty() && prepareRest(retry.front())) {
+            retry.pop_front();
+        }
+        while (retry.empty() && next < n && prepareRest(next)) {
+            next++;
+        }
+        io.submit();
+        int32_t got = io.reap(completions.data(), static_cast<int32_t>(completions.size()), 1);
+        if (got <= 0) {
+            LOG_ERROR("Page I/O engine stopped with " << (n - finished) << " requests left");
+            // requests the kernel took still own their buffers, the caller may free them once we return
+            io.drain();
+            for (size_t i = 0; i < n; ++i) {
+                if (!complete[i]) {
+                    finish(i, -EIO);
+                }
+            }
+            break;
+        }
+        for (int32_t c = 0; c < got; ++c) {
+            size_t i = static_cast<size_t>(completions[c].userData);
+            int32_t res = completions[c].result;
+            if (res < 0) {
+                finish(i, res);
+                continue;
+            }
+            done[i] += static_cast<uint32_t>(res);
+            bool eof = requests[i].op == PageIoOp::READ && res == 0;
+            if (requests[i].op == PageIoOp::FSYNC || eof || done[i] >= requests[i].length) {
+                finish(i, static_cast<int32_t>(done[i]));
+            } else {
+                retry.push_back(i);
+            }
+        }
+    }
+    return failed;
+}
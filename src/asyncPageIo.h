@@ -0,0 +1,135 @@
+#ifndef ASYNCPAGEIO_H
+#define ASYNCPAGEIO_H
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+// Asynchronous page I/O. A caller prepares many reads/writes, submits them in
+// one go and reaps the completions in batches, so the device sees a real queue
+// depth instead of one blocking pread/pwrite at a time. The io_uring backend
+// talks to the kernel directly (no liburing); where io_uring is missing or
+// blocked (old kernel, seccomp) the sync backend runs the same requests with
+// pread/pwrite at submit() time, so callers do not need two code paths.
+//
+// An engine is not thread safe: the evictor, the background writer and every
+// block loader own their own engine (rings are cheap).
+
+constexpr uint32_t ASYNC_PAGE_IO_DEFAULT_DEPTH = 64;
+
+enum class PageIoOp : uint8_t {
+    READ = 0,
+    WRITE = 1,
+    FSYNC = 2    // fdatasync of fd, buf/length/offset unused
+};
+
+enum class PageIoBackend : int8_t {
+    AUTO = 0,       // io_uring when the kernel allows it, sync otherwise
+    IO_URING = 1,
+    SYNC = 2
+};
+
+struct PageIoRequest {
+    PageIoOp op = PageIoOp::READ;
+    int fd = -1;
+    void* buf = nullptr;
+    uint32_t length = 0;
+    uint64_t offset = 0;
+    uint64_t userData = 0;   // returned as is in the completion
+};
+
+struct PageIoCompletion {
+    uint64_t userData = 0;
+    int32_t result = 0;      // bytes transferred or -errno
+};
+
+class AsyncPageIo {
+    public:
+        virtual ~AsyncPageIo() = default;
+        // queues a request, false when depth() requests are already in flight
+        virtual bool prepare(const PageIoRequest& request) = 0;
+        // hands everything prepared to the kernel, returns how many requests were submitted
+        virtual int32_t submit() = 0;
+        // waits until at least minComplete completions are ready, copies up to max of them into out
+        virtual int32_t reap(PageIoCompletion* out, int32_t max, int32_t minComplete) = 0;
+        // drops what was prepared but not taken by the kernel and waits for the rest to
+        // complete, discarding the completions; after it no request owns its buffer
+        virtual void drain() = 0;
+        // prepared and not reaped yet
+        virtual int32_t inFlight() const = 0;
+        virtual uint32_t depth() const = 0;
+        virtual PageIoBackend backend() const = 0;
+};
+
+// pread/pwrite fallback, requests run one after another inside submit()
+class SyncPageIo : public AsyncPageIo {
+    private:
+        uint32_t queueDepth;
+        std::vector<PageIoRequest> prepared;
+        std::deque<PageIoCompletion> completed;
+    public:
+        explicit SyncPageIo(uint32_t depth);
+        bool prepare(const PageIoRequest& request) override;
+        int32_t submit() override;
+        int32_t reap(PageIoCompletion* out, int32_t max, int32_t minComplete) override;
+        void drain() override;
+        int32_t inFlight() const override { return static_cast<int32_t>(prepared.size() + completed.size()); }
+        uint32_t depth() const override { return queueDepth; }
+        PageIoBackend backend() const override { return PageIoBackend::SYNC; }
+};
+
+// io_uring through the raw syscalls. The CQ ring has twice the SQ entries and
+// at most depth requests are in flight, so completions never overflow.
+class IoUringPageIo : public AsyncPageIo {
+    private:
+        int ringFd = -1;
+        uint32_t queueDepth = 0;
+        int32_t inFlightCount = 0;
+        uint32_t toSubmit = 0;
+        void* sqRing = nullptr;
+        size_t sqRingSize = 0;
+        void* cqRing = nullptr;        // same mapping as sqRing with IORING_FEAT_SINGLE_MMAP
+        size_t cqRingSize = 0;
+        void* sqeMap = nullptr;
+        size_t sqeMapSize = 0;
+        uint32_t* sqHead = nullptr;
+        uint32_t* sqTail = nullptr;
+        uint32_t sqMask = 0;
+        uint32_t* sqArray = nullptr;
+        uint32_t* cqHead = nullptr;
+        uint32_t* cqTail = nullptr;
+        uint32_t cqMask = 0;
+        void* sqes = nullptr;
+        void* cqes = nullptr;
+        uint32_t localTail = 0;
+
+        void release();
+    public:
+        explicit IoUringPageIo(uint32_t depth);
+        ~IoUringPageIo() override;
+        IoUringPageIo(const IoUringPageIo&) = delete;
+        IoUringPageIo& operator=(const IoUringPageIo&) = delete;
+
+        // false when the ring could not be set up, the engine must not be used then
+        bool isReady() const { return ringFd >= 0; }
+        bool prepare(const PageIoRequest& request) override;
+        int32_t submit() override;
+        int32_t reap(PageIoCompletion* out, int32_t max, int32_t minComplete) override;
+        // polls the CQ ring when io_uring_enter itself is what fails
+        void drain() override;
+        int32_t inFlight() const override { return inFlightCount; }
+        uint32_t depth() const override { return queueDepth; }
+        PageIoBackend backend() const override { return PageIoBackend::IO_URING; }
+};
+
+std::unique_ptr<AsyncPageIo> makeAsyncPageIo(uint32_t depth = ASYNC_PAGE_IO_DEFAULT_DEPTH, PageIoBackend backend = PageIoBackend::AUTO);
+
+// Runs all requests keeping up to io.depth() of them in flight and reaping in
+// batches. Short reads/writes are resubmitted for the rest of the range (a read
+// stops at EOF). results[i] is the total byte count of requests[i] or -errno;
+// userData of the requests is overwritten. Returns the number of failed requests.
+// If the engine stops, it is drained before the requests left are failed.
+int32_t runPageIo(AsyncPageIo& io, std::vector<PageIoRequest>& requests, std::vector<int32_t>& results);
+
+#endif
@@ -0,0 +1,635 @@
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include "btreeIndex.h"
+#include "paxPage.h"
+#include "tableScan.h"
+#include "../../bufforing-stm/src/log.h"
+
+BTreeIndexRegistry sharedBTreeIndexes;
+
+static const uint32_t BTREE_MAGIC = 0x42545245;   // "BTRE"
+static const size_t NODE_DATA = sizeof(SlottedPageHeader) + sizeof(BTreeNodeHeader);
+
+const size_t BTreeIndex::LEAF_CAPACITY = (PAGE_FILE_BLOCK_SIZE - NODE_DATA) / sizeof(BTreeKey);
+const size_t BTreeIndex::INTERNAL_CAPACITY = (PAGE_FILE_BLOCK_SIZE - NODE_DATA) / sizeof(BTreeInternalEntry);
+
+static BTreeKey minusInfinity(int64_t key = INT64_MIN) {
+    BTreeKey k;
+    k.key = key;
+    k.ctid.blockNum = INT32_MIN;
+    return k;
+}
+
+static BTreeMeta* metaOf(const IndexPage& page) {
+    return reinterpret_cast<BTreeMeta*>(page.data + sizeof(SlottedPageHeader));
+}
+
+static const BTreeKey& keyOf(const BTreeKey& entry) { return entry; }
+static const BTreeKey& keyOf(const BTreeInternalEntry& entry) { return entry.key; }
+
+bool indexKeyOf(const allVars& value, int64_t& key) {
+    switch (value.index()) {
+        case TUPLE_TYPE_INT8: key = std::get<int8_t>(value); return true;
+        case TUPLE_TYPE_INT16: key = std::get<int16_t>(value); return true;
+        case TUPLE_TYPE_INT32: key = std::get<int32_t>(value); return true;
+        case TUPLE_TYPE_INT64: key = std::get<int64_t>(value); return true;
+        default: return false;
+    }
+}
+
+BTreeIndex::BTreeIndex(int32_t indexId, int32_t cacheFrames) : indexId(indexId), cache(cacheFrames) {}
+
+BTreeNodeHeader* BTreeIndex::node(const IndexPage& page) {
+    return reinterpret_cast<BTreeNodeHeader*>(page.data + sizeof(SlottedPageHeader));
+}
+
+BTreeKey* BTreeIndex::leafEntries(const IndexPage& page) {
+    return reinterpret_cast<BTreeKey*>(page.data + NODE_DATA);
+}
+
+BTreeInternalEntry* BTreeIndex::internalEntries(const IndexPage& page) {
+    return reinterpret_cast<BTreeInternalEntry*>(page.data + NODE_DATA);
+}
+
+void BTreeIndex::initNode(const IndexPage& page, uint16_t level) {
+    memset(page.data, 0, PAGE_FILE_BLOCK_SIZE);
+    SlottedPageHeader* h = reinterpret_cast<SlottedPageHeader*>(page.data);
+    h->tableId = indexId;
+    h->blockNum = page.blockNum;
+    h->format = PAGE_FORMAT_BTREE;
+    h->lower = static_cast<uint16_t>(NODE_DATA);
+    h->upper = static_cast<uint16_t>(PAGE_FILE_BLOCK_SIZE);
+    h->special = static_cast<uint16_t>(PAGE_FILE_BLOCK_SIZE);
+    BTreeNodeHeader* n = node(page);
+    n->level = level;
+    n->count = 0;
+    n->rightLink = BTREE_NO_BLOCK;
+}
+
+bool BTreeIndex::open(const std::string& path) {
+    if (!cache.open(path)) {
+        return false;
+    }
+    if (cache.getBlockCount() > 0) {
+        IndexPage meta = cache.pin(BTREE_META_BLOCK);
+        bool ok = meta.data && metaOf(meta)->magic == BTREE_MAGIC;
+        cache.unpin(meta);
+        if (!ok) {
+            LOG_ERROR("Index file " << path << " is not a B-tree");
+            cache.close();
+        }
+        return ok;
+    }
+    IndexPage meta = cache.allocate();
+    IndexPage root = cache.allocate();
+    if (!meta.data || !root.data) {
+        cache.unpin(meta);
+        cache.unpin(root);
+        return false;
+    }
+    initNode(meta, 0);
+    BTreeMeta* m = metaOf(meta);
+    m->magic = BTREE_MAGIC;
+    m->root = root.blockNum;
+    m->rootLevel = 0;
+    initNode(root, 0);
+    cache.markDirty(meta);
+    cache.markDirty(root);
+    cache.unpin(meta);
+    cache.unpin(root);
+    LOG_DEBUG("Created B-tree index ID " << indexId << " in " << path);
+    return cache.flush();
+}
+
+void BTreeIndex::close() {
+    cache.close();
+}
+
+bool BTreeIndex::readMeta(int32_t& root, uint16_t& rootLevel) {
+    IndexPage meta = cache.pin(BTREE_META_BLOCK);
+    if (!meta.data) {
+        return false;
+    }
+    cache.latch(meta, false);
+    root = metaOf(meta)->root;
+    rootLevel = metaOf(meta)->rootLevel;
+    cache.unlatch(meta);
+    cache.unpin(meta);
+    return true;
+}
+
+int32_t BTreeIndex::getHeight() {
+    int32_t root;
+    uint16_t rootLevel;
+    return readMeta(root, rootLevel) ? rootLevel + 1 : 0;
+}
+
+// follows right links while key belongs to a right sibling; the returned page is
+// latched in the given mode, the ones passed over are released. A sibling that
+// cannot be pinned gives no page with blockNum set to it
+IndexPage BTreeIndex::moveRight(IndexPage page, const BTreeKey& key, bool exclusive) {
+    while (true) {
+        BTreeNodeHeader* h = node(page);
+        if (h->rightLink == BTREE_NO_BLOCK || key < h->highKey) {
+            return page;
+        }
+        int32_t rightLink = h->rightLink;
+        IndexPage next = cache.pin(rightLink);
+        if (!next.data) {
+            LOG_ERROR("B-tree index ID " << indexId << " lost block " << rightLink);
+            cache.unlatch(page);
+            cache.unpin(page);
+            next.blockNum = rightLink;
+            return next;
+        }
+        cache.latch(next, exclusive);
+        cache.unlatch(page);
+        cache.unpin(page);
+        page = next;
+    }
+}
+
+// node of the given level whose range holds key, latched; no page when the
+// level is above the root (data == nullptr, blockNum == BTREE_NO_BLOCK) or on error
+IndexPage BTreeIndex::descend(const BTreeKey& key, uint16_t level, bool exclusive) {
+    int32_t block;
+    uint16_t rootLevel;
+    if (!readMeta(block, rootLevel) || level > rootLevel) {
+        return IndexPage();
+    }
+    while (true) {
+        IndexPage page = cache.pin(block);
+        if (!page.data) {
+            LOG_ERROR("B-tree index ID " << indexId << " lost block " << block);
+            page.blockNum = block;
+            return page;
+        }
+        cache.latch(page, false);
+        bool target = node(page)->level == level;
+        if (target && exclusive) {
+            // the level of a node never changes, a split in between is handled by moveRight
+            cache.unlatch(page);
+            cache.latch(page, true);
+        }
+        page = moveRight(page, key, target && exclusive);
+        if (!page.data || target) {
+            return page;
+        }
+        BTreeNodeHeader* h = node(page);
+        BTreeInternalEntry* entries = internalEntries(page);
+        BTreeInternalEntry* it = std::upper_bound(entries + 1, entries + h->count, key,
+            [](const BTreeKey& k, const BTreeInternalEntry& e) { return k < e.key; });
+        block = (it - 1)->child;
+        cache.unlatch(page);
+        cache.unpin(page);
+    }
+}
+
+// new root above the old one after the root split: 1 done, 0 when another
+// inserter grew the tree first (the caller descends again), -1 on error
+int32_t BTreeIndex::growRoot(uint16_t level, const BTreeKey& separator, int32_t rightChild) {
+    IndexPage meta = cache.pin(BTREE_META_BLOCK);
+    if (!meta.data) {
+        return -1;
+    }
+    cache.latch(meta, true);
+    BTreeMeta* m = metaOf(meta);
+    int32_t grown = 0;
+    if (m->rootLevel < level) {
+        IndexPage root = cache.allocate();
+        grown = -1;
+        if (root.data) {
+            initNode(root, level);
+            BTreeInternalEntry* entries = internalEntries(root);
+            entries[0].key = minusInfinity();
+            entries[0].child = m->root;
+            entries[1].key = separator;
+            entries[1].child = rightChild;
+            node(root)->count = 2;
+            cache.markDirty(root);
+            cache.unpin(root);
+            m->root = root.blockNum;
+            m->rootLevel = level;
+            cache.markDirty(meta);
+            grown = 1;
+        }
+    }
+    cache.unlatch(meta);
+    cache.unpin(meta);
+    return grown;
+}
+
+// adds entry at pos, splitting into a new right sibling when the node is full;
+// page is latched exclusive and is released here
+template<typename Entry>
+static bool addEntry(IndexPageCache& cache, const IndexPage& page, BTreeNodeHeader* h, Entry* entries, size_t capacity, size_t pos,
+                     const Entry& entry, BTreeKey& separator, int32_t& rightChild, bool& split,
+                     IndexPage (*newSibling)(IndexPageCache&, const IndexPage&)) {
+    split = false;
+    if (h->count < capacity) {
+        memmove(entries + pos + 1, entries + pos, (h->count - pos) * sizeof(Entry));
+        entries[pos] = entry;
+        h->count++;
+        cache.markDirty(page);
+        cache.unlatch(page);
+        cache.unpin(page);
+        return true;
+    }
+    IndexPage right = newSibling(cache, page);
+    if (!right.data) {
+        cache.unlatch(page);
+        cache.unpin(page);
+        return false;
+    }
+    std::vector<Entry> all(entries, entries + h->count);
+    all.insert(all.begin() + pos, entry);
+    size_t leftCount = all.size() / 2;
+    BTreeNodeHeader* rh = reinterpret_cast<BTreeNodeHeader*>(right.data + sizeof(SlottedPageHeader));
+    Entry* rightEntries = reinterpret_cast<Entry*>(right.data + NODE_DATA);
+    memcpy(entries, all.data(), leftCount * sizeof(Entry));
+    memcpy(rightEntries, all.data() + leftCount, (all.size() - leftCount) * sizeof(Entry));
+    h->count = static_cast<uint16_t>(leftCount);
+    rh->count = static_cast<uint16_t>(all.size() - leftCount);
+    // the right node takes over the old right link; readers of the left node see the
+    // new high key and link together, both are changed under its exclusive latch
+    rh->rightLink = h->rightLink;
+    rh->highKey = h->highKey;
+    separator = keyOf(all[leftCount]);
+    h->rightLink = right.blockNum;
+    h->highKey = separator;
+    rightChild = right.blockNum;
+    split = true;
+    cache.markDirty(right);
+    cache.markDirty(page);
+    cache.unpin(right);
+    cache.unlatch(page);
+    cache.unpin(page);
+    return true;
+}
+
+bool BTreeIndex::insertAtLevel(uint16_t level, const BTreeKey& key, int32_t child, BTreeKey& separator, int32_t& rightChild, bool& split) {
+    split = false;
+    IndexPage page;
+    while (true) {
+        page = descend(key, level, true);
+        if (page.data) {
+            break;
+        }
+        if (level == 0 || page.blockNum != BTREE_NO_BLOCK) {
+            return false;
+        }
+        // the node split at level - 1 was the root
+        int32_t grown = growRoot(level, key, child);
+        if (grown != 0) {
+            return grown > 0;
+        }
+    }
+    // allocated empty, becomes the right sibling of page; nobody else can reach it yet
+    IndexPage (*newSibling)(IndexPageCache&, const IndexPage&) = [](IndexPageCache& c, const IndexPage& left) {
+        IndexPage right = c.allocate();
+        if (right.data) {
+            memcpy(right.data, left.data, NODE_DATA);
+            reinterpret_cast<SlottedPageHeader*>(right.data)->blockNum = right.blockNum;
+        }
+        return right;
+    };
+    BTreeNodeHeader* h = node(page);
+    if (level == 0) {
+        BTreeKey* entries = leafEntries(page);
+        BTreeKey* it = std::lower_bound(entries, entries + h->count, key);
+        if (it != entries + h->count && *it == key) {
+            cache.unlatch(page);
+            cache.unpin(page);
+            return true;
+        }
+        return addEntry(cache, page, h, entries, LEAF_CAPACITY, static_cast<size_t>(it - entries), key,
+                        separator, rightChild, split, newSibling);
+    }
+    BTreeInternalEntry* entries = internalEntries(page);
+    BTreeInternalEntry* it = std::upper_bound(entries + 1, entries + h->count, key,
+        [](const BTreeKey& k, const BTreeInternalEntry& e) { return k < e.key; });
+    BTreeInternalEntry entry;
+    entry.key = key;
+    entry.child = child;
+    entry.pad = 0;
+    return addEntry(cache, page, h, entries, INTERNAL_CAPACITY, static_cast<size_t>(it - entries), entry,
+                    separator, rightChild, split, newSibling);
+}
+
+bool BTreeIndex::insert(int64_t key, const Ctid& ctid) {
+    BTreeKey k;
+    k.key = key;
+    k.ctid = ctid;
+    int32_t child = BTREE_NO_BLOCK;
+    for (uint16_t level = 0;; ++level) {
+        BTreeKey separator;
+        int32_t rightChild;
+        bool split;
+        if (!insertAtLevel(level, k, child, separator, rightChild, split)) {
+            LOG_ERROR("Insert into B-tree index ID " << indexId << " failed at level " << level);
+            return false;
+        }
+        if (!split) {
+            return true;
+        }
+        // the split is already visible through the right link, the separator is a shortcut
+        k = separator;
+        child = rightChild;
+    }
+}
+
+bool BTreeIndex::remove(int64_t key, const Ctid& ctid) {
+    BTreeKey k;
+    k.key = key;
+    k.ctid = ctid;
+    IndexPage page = descend(k, 0, true);
+    if (!page.data) {
+        return false;
+    }
+    BTreeNodeHeader* h = node(page);
+    BTreeKey* entries = leafEntries(page);
+    BTreeKey* it = std::lower_bound(entries, entries + h->count, k);
+    bool found = it != entries + h->count && *it == k;
+    if (found) {
+        memmove(it, it + 1, (entries + h->count - it - 1) * sizeof(BTreeKey));
+        h->count--;
+        cache.markDirty(page);
+    }
+    cache.unlatch(page);
+    cache.unpin(page);
+    return found;
+}
+
+bool BTreeIndex::bulkBuild(std::vector<BTreeKey> entries) {
+    // the metapage stays latched exclusive for the whole build, so nobody descends
+    // meanwhile; an inserter that read the root before is finished with the root
+    // leaf once its latch is taken, and the leaf stays latched until the new tree
+    // is complete, so nothing reaches a half built node through its right link
+    IndexPage meta = cache.pin(BTREE_META_BLOCK);
+    if (!meta.data) {
+        return false;
+    }
+    cache.latch(meta, true);
+    int32_t root = metaOf(meta)->root;
+    uint16_t rootLevel = metaOf(meta)->rootLevel;
+    IndexPage first = cache.pin(root);
+    if (first.data) {
+        cache.latch(first, true);
+    }
+    if (!first.data || rootLevel != 0 || node(first)->count != 0) {
+        if (first.data) {
+            cache.unlatch(first);
+            cache.unpin(first);
+        }
+        cache.unlatch(meta);
+        cache.unpin(meta);
+        LOG_ERROR("Bulk build of B-tree index ID " << indexId << " needs an empty index");
+        return false;
+    }
+    std::sort(entries.begin(), entries.end());
+    entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+
+    // one level at a time: (first key, block) of every node goes up as an entry of the next level
+    std::vector<BTreeInternalEntry> items;
+    size_t leafFill = std::max<size_t>(1, LEAF_CAPACITY * BTREE_FILL_PERCENT / 100);
+    size_t internalFill = std::max<size_t>(2, INTERNAL_CAPACITY * BTREE_FILL_PERCENT / 100);
+    uint16_t level = 0;
+    size_t total = entries.size();
+    IndexPage prev;
+    // the root leaf is let go only at the end, the other new nodes are unreachable until then
+    auto release = [this, &first](const IndexPage& page) {
+        if (page.blockNum != first.blockNum) {
+            cache.unpin(page);
+        }
+    };
+    bool ok = true;
+    while (ok) {
+        size_t fill = level == 0 ? leafFill : internalFill;
+        std::vector<BTreeInternalEntry> upper;
+        for (size_t start = 0; start < total || start == 0; start += fill) {
+            IndexPage page = (level == 0 && start == 0) ? first : cache.allocate();
+            if (!page.data) {
+                ok = false;
+                break;
+            }
+            initNode(page, level);
+            size_t n = std::min(fill, total - start);
+            if (level == 0) {
+                memcpy(leafEntries(page), entries.data() + start, n * sizeof(BTreeKey));
+            } else {
+                memcpy(internalEntries(page), items.data() + start, n * sizeof(BTreeInternalEntry));
+                internalEntries(page)[0].key = minusInfinity();
+            }
+            node(page)->count = static_cast<uint16_t>(n);
+            BTreeInternalEntry up;
+            up.key = level == 0 ? (n > 0 ? entries[start] : minusInfinity()) : items[start].key;
+            up.child = page.blockNum;
+            up.pad = 0;
+            upper.push_back(up);
+            if (prev.data) {
+                node(prev)->rightLink = page.blockNum;
+                node(prev)->highKey = up.key;
+                cache.markDirty(prev);
+                release(prev);
+            }
+            prev = page;
+            if (total == 0) {
+                break;
+            }
+        }
+        if (prev.data) {
+            cache.markDirty(prev);
+            release(prev);
+            prev = IndexPage();
+        }
+        if (!ok || upper.size() == 1) {
+            root = upper.empty() ? root : upper[0].child;
+            break;
+        }
+        items.swap(upper);
+        total = items.size();
+        level++;
+    }
+    if (ok) {
+        metaOf(meta)->root = root;
+        metaOf(meta)->rootLevel = level;
+        cache.markDirty(meta);
+    }
+    cache.unlatch(first);
+    cache.unpin(first);
+    cache.unlatch(meta);
+    cache.unpin(meta);
+    if (!ok) {
+        LOG_ERROR("Bulk build of B-tree index ID " << indexId << " ran out of page frames");
+        return false;
+    }
+    LOG_DEBUG("Bulk built B-tree index ID " << indexId << " with " << entries.size() << " entries, " << (level + 1) << " levels");
+    return cache.flush();
+}
+
+// key of a PAX row from the column's array; false for a null
+static bool paxKeyOf(const PaxPage& pax, size_t column, uint8_t type, int32_t rowIndex, int64_t& key) {
+    if (!((pax.columnNulls(column)[rowIndex / 8] >> (rowIndex % 8)) & 1)) {
+        return false;
+    }
+    switch (type) {
+        case TUPLE_TYPE_INT8: key = pax.columnArray<int8_t>(column)[rowIndex]; break;
+        case TUPLE_TYPE_INT16: key = pax.columnArray<int16_t>(column)[rowIndex]; break;
+        case TUPLE_TYPE_INT32: key = pax.columnArray<int32_t>(column)[rowIndex]; break;
+        default: key = pax.columnArray<int64_t>(column)[rowIndex]; break;
+    }
+    return true;
+}
+
+bool scanColumnKeys(PageFile& table, int32_t tableId, const TupleCodec& codec, size_t column,
+                    const std::function<void(int64_t, const Ctid&)>& onKey) {
+    if (column >= codec.getColumnCount() || codec.getTypes()[column] > TUPLE_TYPE_INT64) {
+        LOG_ERROR("Column " << column << " of table ID " << tableId << " is not an integer column");
+        return false;
+    }
+    uint8_t type = codec.getTypes()[column];
+    std::vector<allVars> row;
+    std::vector<bool> bitmap;
+    // row pages give a slot per tuple, PAX pages a row index; both are the ctid slot
+    auto scanPage = [&](const uint8_t* data, int32_t blockNum) {
+        Ctid ctid;
+        ctid.blockNum = blockNum;
+        SlottedPage sp(const_cast<uint8_t*>(data));
+        if (sp.isValid() && PaxPage::isPax(data)) {
+            PaxPage pax(const_cast<uint8_t*>(data));
+            if (column >= pax.getColumnCount() || pax.getColumnType(column) != type) {
+                LOG_ERROR("Block " << blockNum << " of table ID " << tableId << " does not have the column types of the codec");
+                return false;
+            }
+            for (int32_t r = 0; r < pax.getRowCount(); ++r) {
+                int64_t key = 0;
+                if (paxKeyOf(pax, column, type, r, key)) {
+                    ctid.slot = static_cast<uint16_t>(r);
+                    onKey(key, ctid);
+                }
+            }
+            return true;
+        }
+        if (!sp.isValid() || sp.getFormat() != PAGE_FORMAT_ROW) {
+            // a block8kb file or a page of some other kind, an index over part of it would be wrong
+            LOG_ERROR("Block " << blockNum << " of table ID " << tableId << " is not a row or PAX page");
+            return false;
+        }
+        for (int32_t slot = 0; slot < sp.getSlotCount(); ++slot) {
+            uint16_t length;
+            const uint8_t* tuple = sp.getTuple(slot, &length);
+            if (!tuple) {
+                continue;
+            }
+            int64_t key = 0;
+            bool found = false;
+            switch (type) {
+                case TUPLE_TYPE_INT8: { int8_t v = 0; found = codec.readColumn(tuple, length, column, v); key = v; break; }
+                case TUPLE_TYPE_INT16: { int16_t v = 0; found = codec.readColumn(tuple, length, column, v); key = v; break; }
+                case TUPLE_TYPE_INT32: { int32_t v = 0; found = codec.readColumn(tuple, length, column, v); key = v; break; }
+                default: { int64_t v = 0; found = codec.readColumn(tuple, length, column, v); key = v; break; }
+            }
+            // behind a string or null: decode the tuple, nulls are not indexed
+            if (!found && codec.decode(tuple, length, row, bitmap) && bitmap[column]) {
+                found = indexKeyOf(row[column], key);
+            }
+            if (found) {
+                ctid.slot = static_cast<uint16_t>(slot);
+                onKey(key, ctid);
+            }
+        }
+        return true;
+    };
+
+    TableScan scan(table, tableId);
+    ScanPage page;
+    while (scan.next(page)) {
+        if (!page.data) {
+            // the newer copy is a block8kb in the shared buffers, its rows are not in a
+            // page format this module reads; the writer has to flush it before the build
+            LOG_ERROR("Block " << page.blockNum << " of table ID " << tableId << " is dirty in the shared buffers");
+            return false;
+        }
+        if (!scanPage(page.data, page.blockNum)) {
+            return false;
+        }
+    }
+    return !scan.failed();
+}
+
+bool BTreeIndex::buildFromTable(PageFile& table, int32_t tableId, const TupleCodec& codec, size_t column) {
+    std::vector<BTreeKey> entries;
+    bool scanned = scanColumnKeys(table, tableId, codec, column, [&entries](int64_t key, const Ctid& ctid) {
+        BTreeKey entry;
+        entry.key = key;
+        entry.ctid = ctid;
+        entries.push_back(entry);
+    });
+    return scanned && bulkBuild(std::move(entries));
+}
+
+void BTreeIterator::load(const uint8_t* data) {
+    const BTreeNodeHeader* h = reinterpret_cast<const BTreeNodeHeader*>(data + sizeof(SlottedPageHeader));
+    const BTreeKey* entries = reinterpret_cast<const BTreeKey*>(data + NODE_DATA);
+    batch.clear();
+    pos = 0;
+    for (uint16_t i = 0; i < h->count; ++i) {
+        const BTreeKey& e = entries[i];
+        if (e.key > high) {
+            break;
+        }
+        if (started ? last < e : low <= e) {
+            batch.push_back(e);
+        }
+    }
+    nextLeaf = h->rightLink != BTREE_NO_BLOCK && h->highKey.key <= high ? h->rightLink : BTREE_NO_BLOCK;
+}
+
+bool BTreeIterator::next(BTreeKey& out) {
+    while (pos >= batch.size()) {
+        if (!index || nextLeaf == BTREE_NO_BLOCK) {
+            return false;
+        }
+        IndexPage page = index->cache.pin(nextLeaf);
+        if (!page.data) {
+            nextLeaf = BTREE_NO_BLOCK;
+            return false;
+        }
+        index->cache.latch(page, false);
+        load(page.data);
+        index->cache.unlatch(page);
+        index->cache.unpin(page);
+    }
+    out = batch[pos++];
+    last = out;
+    started = true;
+    return true;
+}
+
+BTreeIterator BTreeIndex::range(int64_t low, int64_t high) {
+    BTreeIterator it;
+    it.index = this;
+    it.low = minusInfinity(low);
+    it.high = high;
+    if (low > high) {
+        return it;
+    }
+    IndexPage page = descend(it.low, 0, false);
+    if (page.data) {
+        it.load(page.data);
+        cache.unlatch(page);
+        cache.unpin(page);
+    }
+    return it;
+}
+
+std::vector<Ctid> BTreeIndex::lookup(int64_t key) {
+    std::vector<Ctid> result;
+    BTreeIterator it = range(key, key);
+    BTreeKey entry;
+    while (it.next(entry)) {
+        result.push_back(entry.ctid);
+    }
+    return result;
+}
@@ -0,0 +1,140 @@
+#ifndef BTREEINDEX_H
+#define BTREEINDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "indexPageCache.h"
+#include "indexRegistry.h"
+#include "pageFile.h"
+#include "slottedPage.h"
+#include "tupleCodec.h"
+
+// B+tree secondary index on an integer column, nodes are 8 KB pages of the
+// index's IndexPageCache. Concurrency follows Lehman and Yao's B-link tree:
+// every node has a right link and a high key (the first key of its right
+// sibling), so a reader that lands on a node split under it just moves right.
+// Readers and inserters hold one latch at a time on the way down, an inserter
+// splitting a node releases it before going up to insert the separator, and
+// latches are only ever taken left to right or down, so there is no deadlock.
+//
+// Entries are (key, ctid) pairs kept unique by ordering on both, so duplicate
+// column values need no special case. Block 0 is the metapage with the root.
+
+constexpr uint8_t PAGE_FORMAT_BTREE = 3;
+constexpr int32_t BTREE_META_BLOCK = 0;
+constexpr int32_t BTREE_NO_BLOCK = -1;
+constexpr int32_t BTREE_FILL_PERCENT = 90;   // leaves of a bulk build, room left for later inserts
+
+struct BTreeKey {
+    int64_t key = 0;
+    Ctid ctid;
+};
+
+inline bool operator<(const BTreeKey& a, const BTreeKey& b) { return a.key != b.key ? a.key < b.key : a.ctid < b.ctid; }
+inline bool operator==(const BTreeKey& a, const BTreeKey& b) { return a.key == b.key && a.ctid == b.ctid; }
+inline bool operator<=(const BTreeKey& a, const BTreeKey& b) { return !(b < a); }
+
+struct BTreeNodeHeader {
+    uint16_t level;      // 0: leaf
+    uint16_t count;
+    int32_t rightLink;   // BTREE_NO_BLOCK for the rightmost node of a level
+    BTreeKey highKey;    // only when there is a right link
+};
+
+struct BTreeInternalEntry {
+    BTreeKey key;        // key of entry 0 is minus infinity
+    int32_t child;
+    int32_t pad;
+};
+
+struct BTreeMeta {
+    uint32_t magic;
+    int32_t root;
+    uint16_t rootLevel;
+    uint16_t pad;
+};
+
+class BTreeIndex;
+
+// Entries of a key range in order. A leaf is copied under its latch and the
+// latch dropped, so a slow consumer holds nothing; entries that moved right in
+// a split in between are skipped by key.
+class BTreeIterator {
+    private:
+        BTreeIndex* index = nullptr;
+        std::vector<BTreeKey> batch;
+        size_t pos = 0;
+        int32_t nextLeaf = BTREE_NO_BLOCK;
+        BTreeKey low;
+        int64_t high = 0;
+        bool started = false;
+        BTreeKey last;
+        friend class BTreeIndex;
+        void load(const uint8_t* node);
+    public:
+        BTreeIterator() = default;
+        bool next(BTreeKey& out);
+};
+
+class BTreeIndex {
+    private:
+        int32_t indexId;
+        IndexPageCache cache;
+        friend class BTreeIterator;
+
+        static BTreeNodeHeader* node(const IndexPage& page);
+        static BTreeKey* leafEntries(const IndexPage& page);
+        static BTreeInternalEntry* internalEntries(const IndexPage& page);
+        void initNode(const IndexPage& page, uint16_t level);
+        bool readMeta(int32_t& root, uint16_t& rootLevel);
+        IndexPage moveRight(IndexPage page, const BTreeKey& key, bool exclusive);
+        IndexPage descend(const BTreeKey& key, uint16_t level, bool exclusive);
+        int32_t growRoot(uint16_t level, const BTreeKey& separator, int32_t rightChild);
+        bool insertAtLevel(uint16_t level, const BTreeKey& key, int32_t child, BTreeKey& separator, int32_t& rightChild, bool& split);
+
+    public:
+        static const size_t LEAF_CAPACITY;
+        static const size_t INTERNAL_CAPACITY;
+
+        explicit BTreeIndex(int32_t indexId, int32_t cacheFrames = INDEX_PAGE_CACHE_DEFAULT_FRAMES);
+
+        // creates the metapage and an empty root leaf in a new file
+        bool open(const std::string& path);
+        void close();
+        bool flush() { return cache.flush(); }
+
+        bool insert(int64_t key, const Ctid& ctid);
+        // takes the entry out of its leaf, false when it is not there; leaves are not merged,
+        // an empty one keeps its place in the chain
+        bool remove(int64_t key, const Ctid& ctid);
+        // builds the tree bottom up from unsorted entries, the index must be empty; inserts
+        // running meanwhile wait for it (or make it fail when they come first)
+        bool bulkBuild(std::vector<BTreeKey> entries);
+        // bulk build over a scan of the table's row pages; column must be an integer column
+        bool buildFromTable(PageFile& table, int32_t tableId, const TupleCodec& codec, size_t column);
+
+        std::vector<Ctid> lookup(int64_t key);
+        // low <= key <= high
+        BTreeIterator range(int64_t low, int64_t high);
+
+        int32_t getIndexId() const { return indexId; }
+        // levels, 1 for a single leaf
+        int32_t getHeight();
+        int64_t getPageReads() { return cache.getReads(); }
+};
+
+// tableId -> B-tree indexes on its columns
+typedef IndexRegistry<BTreeIndex> BTreeIndexRegistry;
+
+extern BTreeIndexRegistry sharedBTreeIndexes;
+
+// calls onKey for every non-null value of an integer column over a scan of the
+// table's row and PAX pages; false for other columns, other page kinds, a block
+// dirty in the shared buffers (nothing is flushed for it) and on read errors
+bool scanColumnKeys(PageFile& table, int32_t tableId, const TupleCodec& codec, size_t column,
+                    const std::function<void(int64_t, const Ctid&)>& onKey);
+
+#endif
@@ -0,0 +1,125 @@
+#include "bufferDesc.h"
+
+BufferDescTable sharedBufferDescs;
+
+BufferDescTable::BufferDescTable() {
+    for (int32_t i = 0; i < BUFFER_DESC_MAX_CHUNKS; ++i) {
+        chunks[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+BufferDescTable::~BufferDescTable() {
+    for (int32_t i = 0; i < BUFFER_DESC_MAX_CHUNKS; ++i) {
+        delete[] chunks[i].load(std::memory_order_relaxed);
+    }
+}
+
+BufferDesc* BufferDescTable::desc(int32_t slot) {
+    if (slot < 0 || slot >= BUFFER_DESC_CHUNK * BUFFER_DESC_MAX_CHUNKS) {
+        return nullptr;
+    }
+    std::atomic<BufferDesc*>& chunk = chunks[slot / BUFFER_DESC_CHUNK];
+    BufferDesc* descs = chunk.load(std::memory_order_acquire);
+    if (descs == nullptr) {
+        BufferDesc* fresh = new BufferDesc[BUFFER_DESC_CHUNK];
+        if (chunk.compare_exchange_strong(descs, fresh, std::memory_order_acq_rel)) {
+            descs = fresh;
+        } else {
+            delete[] fresh;   // another thread was first, descs holds its chunk
+        }
+    }
+    return &descs[slot % BUFFER_DESC_CHUNK];
+}
+
+void BufferDescTable::pin(int32_t slot) {
+    BufferDesc* d = desc(slot);
+    if (d) {
+        d->pinCount.fetch_add(1, std::memory_order_acq_rel);
+    }
+}
+
+void BufferDescTable::unpin(int32_t slot) {
+    BufferDesc* d = desc(slot);
+    if (d) {
+        int32_t before = d->pinCount.fetch_sub(1, std::memory_order_acq_rel);
+        if (before <= 0) {
+            LOG_ERROR("Unpin of buffer slot " << slot << " that was not pinned");
+            d->pinCount.fetch_add(1, std::memory_order_acq_rel);
+        }
+    }
+}
+
+bool BufferDescTable::isPinned(int32_t slot) {
+    return getPinCount(slot) > 0;
+}
+
+int32_t BufferDescTable::getPinCount(int32_t slot) {
+    BufferDesc* d = desc(slot);
+    return d ? d->pinCount.load(std::memory_order_acquire) : 0;
+}
+
+void BufferDescTable::lockContent(int32_t slot, bool exclusive) {
+    BufferDesc* d = desc(slot);
+    if (!d) return;
+    if (exclusive) {
+        pthread_rwlock_wrlock(&d->contentLock);
+    } else {
+        pthread_rwlock_rdlock(&d->contentLock);
+    }
+}
+
+void BufferDescTable::unlockContent(int32_t slot) {
+    BufferDesc* d = desc(slot);
+    if (d) {
+        pthread_rwlock_unlock(&d->contentLock);
+    }
+}
+
+PinnedBuffer pinSharedBuffer(int32_t tableId, int32_t blockNum) {
+    PinnedBuffer pinned;
+    sharedBufferMapping.lookupWith(tableId, blockNum, [&](int32_t slot) {
+        if (buffers == nullptr || static_cast<size_t>(slot) >= buffers->size()) {
+            return;
+        }
+        ShareBuffer* buf = (*buffers)[slot];
+        if (buf == nullptr || buf->tableId != tableId || buf->blockNum != blockNum) {
+            return;
+        }
+        sharedBufferDescs.pin(slot);
+        pinned.buffer = buf;
+        pinned.slot = slot;
+    });
+    return pinned;
+}
+
+void unpinSharedBuffer(const PinnedBuffer& pinned) {
+    if (pinned.slot >= 0) {
+        sharedBufferDescs.unpin(pinned.slot);
+    }
+}
+
+void lockBufferContent(const PinnedBuffer& pinned, bool exclusive) {
+    if (pinned.slot >= 0) {
+        sharedBufferDescs.lockContent(pinned.slot, exclusive);
+    }
+}
+
+void unlockBufferContent(const PinnedBuffer& pinned) {
+    if (pinned.slot >= 0) {
+        sharedBufferDescs.unlockContent(pinned.slot);
+    }
+}
+
+bool flushSharedBuffer(BufferDescTable* descs, int32_t slot, ShareBuffer* buffer) {
+    if (descs) {
+        descs->lockContent(slot, false);
+    }
+    bool dirty = takeBufferDirty(buffer);
+    if (dirty) {
+        addBufferDataToFile(buffer);
+    }
+    if (descs) {
+        descs->unlockContent(slot);
+    }
+    return dirty;
+}
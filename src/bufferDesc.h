@@ -0,0 +1,67 @@
+#ifndef BUFFERDESC_H
+#define BUFFERDESC_H
+
+#include <pthread.h>
+#include <atomic>
+#include <cstdint>
+#include "../../bufforing-stm/src/QuakeSharedBuffers.h"
+#include "bufferFlags.h"
+#include "bufferMapping.h"
+
+// Per-slot state of the shared buffer pool that does not need buffersMutex:
+// a pin count (a pinned buffer is never evicted) and a content lock (shared
+// for readers and for the writer flushing the page, exclusive for sessions
+// changing it). Descriptors are allocated in chunks and never move, so a
+// slot's descriptor can be used without any global lock.
+
+constexpr int32_t BUFFER_DESC_CHUNK = 1024;
+constexpr int32_t BUFFER_DESC_MAX_CHUNKS = 4096;   // 4M slots
+
+struct BufferDesc {
+    std::atomic<int32_t> pinCount{0};
+    pthread_rwlock_t contentLock;
+    BufferDesc() { pthread_rwlock_init(&contentLock, nullptr); }
+    ~BufferDesc() { pthread_rwlock_destroy(&contentLock); }
+};
+
+class BufferDescTable {
+    private:
+        std::atomic<BufferDesc*> chunks[BUFFER_DESC_MAX_CHUNKS];
+    public:
+        BufferDescTable();
+        ~BufferDescTable();
+        BufferDescTable(const BufferDescTable&) = delete;
+        BufferDescTable& operator=(const BufferDescTable&) = delete;
+
+        // descriptor of slot, allocated on first use; nullptr for slots out of range
+        BufferDesc* desc(int32_t slot);
+        void pin(int32_t slot);
+        void unpin(int32_t slot);
+        bool isPinned(int32_t slot);
+        int32_t getPinCount(int32_t slot);
+        void lockContent(int32_t slot, bool exclusive);
+        void unlockContent(int32_t slot);
+};
+
+extern BufferDescTable sharedBufferDescs;
+
+struct PinnedBuffer {
+    ShareBuffer* buffer = nullptr;
+    int32_t slot = -1;
+};
+
+// looks the page up and pins it while the mapping partition is locked, so the
+// evictor (which erases the mapping under the same lock) cannot take it away
+PinnedBuffer pinSharedBuffer(int32_t tableId, int32_t blockNum);
+void unpinSharedBuffer(const PinnedBuffer& pinned);
+
+// shared: read the page, exclusive: modify it (and set isDirty)
+void lockBufferContent(const PinnedBuffer& pinned, bool exclusive);
+void unlockBufferContent(const PinnedBuffer& pinned);
+
+// writes a dirty buffer to its table file with the content lock of slot held
+// shared (descs may be nullptr). isDirty is cleared before the write, so a
+// change made meanwhile leaves the buffer dirty. false if it was clean.
+bool flushSharedBuffer(BufferDescTable* descs, int32_t slot, ShareBuffer* buffer);
+
+#endif
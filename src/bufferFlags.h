@@ -0,0 +1,40 @@
+#ifndef BUFFERFLAGS_H
+#define BUFFERFLAGS_H
+
+#include <cstdint>
+
+// count (usage) and isDirty of a shared buffer are plain fields of ShareBuffer
+// that sessions change without buffersMutex, so the pool, the background
+// writer and the readers only touch them through these atomic accessors.
+//
+// A writer clears isDirty before it writes the page (BM_JUST_DIRTIED in
+// PostgreSQL): a change made while the page is being written sets the flag
+// again and is written next time instead of being lost.
+
+template<typename Buffer>
+inline int32_t bufferUsage(const Buffer* b) {
+    return __atomic_load_n(&b->count, __ATOMIC_RELAXED);
+}
+
+template<typename Buffer>
+inline void setBufferUsage(Buffer* b, int32_t count) {
+    __atomic_store_n(&b->count, count, __ATOMIC_RELAXED);
+}
+
+template<typename Buffer>
+inline bool bufferIsDirty(const Buffer* b) {
+    return __atomic_load_n(&b->isDirty, __ATOMIC_ACQUIRE);
+}
+
+template<typename Buffer>
+inline void setBufferDirty(Buffer* b, bool dirty) {
+    __atomic_store_n(&b->isDirty, dirty, __ATOMIC_RELEASE);
+}
+
+// clears isDirty, true when the buffer was dirty and the caller has to write it
+template<typename Buffer>
+inline bool takeBufferDirty(Buffer* b) {
+    return __atomic_exchange_n(&b->isDirty, false, __ATOMIC_ACQ_REL);
+}
+
+#endif
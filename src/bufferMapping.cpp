@@ -0,0 +1,147 @@
+#include "bufferMapping.h"
+
+BufferMappingTable sharedBufferMapping;
+
+BufferMappingTable::BufferMappingTable(int32_t numPartitions)
+    : partitions(numPartitions > 0 ? numPartitions : 1)
+{
+    for (auto& p : partitions) {
+        pthread_rwlock_init(&p.lock, nullptr);
+    }
+}
+
+BufferMappingTable::~BufferMappingTable() {
+    for (auto& p : partitions) {
+        pthread_rwlock_destroy(&p.lock);
+    }
+}
+
+BufferMappingTable::Partition& BufferMappingTable::partitionOfTag(int64_t tag) {
+    uint64_t h = static_cast<uint64_t>(tag) * 0x9E3779B97F4A7C15ULL;
+    return partitions[(h >> 32) % partitions.size()];
+}
+
+BufferMappingTable::Partition& BufferMappingTable::partitionOfTable(int32_t tableId) {
+    uint64_t h = static_cast<uint64_t>(static_cast<uint32_t>(tableId)) * 0x9E3779B97F4A7C15ULL;
+    return partitions[(h >> 32) % partitions.size()];
+}
+
+int32_t BufferMappingTable::lookup(int32_t tableId, int32_t blockNum) {
+    int64_t tag = tagOf(tableId, blockNum);
+    Partition& p = partitionOfTag(tag);
+    pthread_rwlock_rdlock(&p.lock);
+    auto it = p.slots.find(tag);
+    int32_t slot = it == p.slots.end() ? -1 : it->second;
+    pthread_rwlock_unlock(&p.lock);
+    return slot;
+}
+
+std::vector<int32_t> BufferMappingTable::tableSlots(int32_t tableId) {
+    std::vector<int32_t> result;
+    Partition& p = partitionOfTable(tableId);
+    pthread_rwlock_rdlock(&p.lock);
+    auto it = p.tables.find(tableId);
+    if (it != p.tables.end()) {
+        result.reserve(it->second.size());
+        for (const auto& block : it->second) {
+            result.push_back(block.second);
+        }
+    }
+    pthread_rwlock_unlock(&p.lock);
+    return result;
+}
+
+void BufferMappingTable::insert(int32_t tableId, int32_t blockNum, int32_t slot) {
+    int64_t tag = tagOf(tableId, blockNum);
+    Partition& p = partitionOfTag(tag);
+    pthread_rwlock_wrlock(&p.lock);
+    p.slots[tag] = slot;
+    pthread_rwlock_unlock(&p.lock);
+
+    // per-table index lives in the partition of the table, locks are never nested
+    Partition& t = partitionOfTable(tableId);
+    pthread_rwlock_wrlock(&t.lock);
+    t.tables[tableId][blockNum] = slot;
+    pthread_rwlock_unlock(&t.lock);
+}
+
+bool BufferMappingTable::erase(int32_t tableId, int32_t blockNum, int32_t slot) {
+    int64_t tag = tagOf(tableId, blockNum);
+    Partition& p = partitionOfTag(tag);
+    bool erased = false;
+    pthread_rwlock_wrlock(&p.lock);
+    auto it = p.slots.find(tag);
+    if (it != p.slots.end() && it->second == slot) {
+        p.slots.erase(it);
+        erased = true;
+    }
+    pthread_rwlock_unlock(&p.lock);
+    if (erased) {
+        eraseFromTableIndex(tableId, blockNum, slot);
+    }
+    return erased;
+}
+
+void BufferMappingTable::eraseFromTableIndex(int32_t tableId, int32_t blockNum, int32_t slot) {
+    Partition& t = partitionOfTable(tableId);
+    pthread_rwlock_wrlock(&t.lock);
+    auto table = t.tables.find(tableId);
+    if (table != t.tables.end()) {
+        auto block = table->second.find(blockNum);
+        if (block != table->second.end() && block->second == slot) {
+            table->second.erase(block);
+        }
+        if (table->second.empty()) {
+            t.tables.erase(table);
+        }
+    }
+    pthread_rwlock_unlock(&t.lock);
+}
+
+void BufferMappingTable::clear() {
+    for (auto& p : partitions) {
+        pthread_rwlock_wrlock(&p.lock);
+        p.slots.clear();
+        p.tables.clear();
+        pthread_rwlock_unlock(&p.lock);
+    }
+}
+
+size_t BufferMappingTable::size() {
+    size_t result = 0;
+    for (auto& p : partitions) {
+        pthread_rwlock_rdlock(&p.lock);
+        result += p.slots.size();
+        pthread_rwlock_unlock(&p.lock);
+    }
+    return result;
+}
+
+ShareBuffer* lookupSharedBuffer(int32_t tableId, int32_t blockNum) {
+    int32_t slot = sharedBufferMapping.lookup(tableId, blockNum);
+    if (slot < 0 || buffers == nullptr || static_cast<size_t>(slot) >= buffers->size()) {
+        return nullptr;
+    }
+    ShareBuffer* buf = (*buffers)[slot];
+    if (buf == nullptr || buf->tableId != tableId || buf->blockNum != blockNum) {
+        return nullptr;
+    }
+    return buf;
+}
+
+std::vector<ShareBuffer*> lookupTableBuffers(int32_t tableId) {
+    std::vector<ShareBuffer*> result;
+    if (buffers == nullptr) {
+        return result;
+    }
+    for (int32_t slot : sharedBufferMapping.tableSlots(tableId)) {
+        if (static_cast<size_t>(slot) >= buffers->size()) {
+            continue;
+        }
+        ShareBuffer* buf = (*buffers)[slot];
+        if (buf != nullptr && buf->tableId == tableId) {
+            result.push_back(buf);
+        }
+    }
+    return result;
+}
@@ -0,0 +1,96 @@
+#ifndef BUFFERMAPPING_H
+#define BUFFERMAPPING_H
+
+#include <pthread.h>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "../../bufforing-stm/src/QuakeSharedBuffers.h"
+
+// (tableId, blockNum) -> slot in the shared buffer vector. The table is split
+// into partitions with their own rwlock, like the buffer mapping partitions in
+// PostgreSQL, so lookups of different pages do not wait on each other and
+// never take buffersMutex.
+
+constexpr int32_t NUM_BUFFER_PARTITIONS = 128;
+
+class BufferMappingTable {
+    private:
+        struct Partition {
+            pthread_rwlock_t lock;
+            std::unordered_map<int64_t, int32_t> slots;                           // tag -> slot
+            std::unordered_map<int32_t, std::unordered_map<int32_t, int32_t>> tables; // tableId -> blockNum -> slot
+        };
+        std::vector<Partition> partitions;
+
+        static int64_t tagOf(int32_t tableId, int32_t blockNum) {
+            return (static_cast<int64_t>(tableId) << 32) | static_cast<uint32_t>(blockNum);
+        }
+        Partition& partitionOfTag(int64_t tag);
+        Partition& partitionOfTable(int32_t tableId);
+        void eraseFromTableIndex(int32_t tableId, int32_t blockNum, int32_t slot);
+
+    public:
+        explicit BufferMappingTable(int32_t numPartitions = NUM_BUFFER_PARTITIONS);
+        ~BufferMappingTable();
+        BufferMappingTable(const BufferMappingTable&) = delete;
+        BufferMappingTable& operator=(const BufferMappingTable&) = delete;
+
+        // slot of the page or -1
+        int32_t lookup(int32_t tableId, int32_t blockNum);
+        // slots of all cached pages of the table
+        std::vector<int32_t> tableSlots(int32_t tableId);
+        // maps the page to slot, replaces an older mapping of the same page
+        void insert(int32_t tableId, int32_t blockNum, int32_t slot);
+        // removes the mapping only if the page is still mapped to slot
+        bool erase(int32_t tableId, int32_t blockNum, int32_t slot);
+        void clear();
+        size_t size();
+
+        // calls onFound(slot) with the partition read-locked, returns the slot or -1
+        template<typename F>
+        int32_t lookupWith(int32_t tableId, int32_t blockNum, F onFound) {
+            int64_t tag = tagOf(tableId, blockNum);
+            Partition& p = partitionOfTag(tag);
+            pthread_rwlock_rdlock(&p.lock);
+            auto it = p.slots.find(tag);
+            int32_t slot = -1;
+            if (it != p.slots.end()) {
+                slot = it->second;
+                onFound(slot);
+            }
+            pthread_rwlock_unlock(&p.lock);
+            return slot;
+        }
+        // like erase, but keeps the mapping when canErase(slot) is false with the partition
+        // write-locked; true when the page is no longer mapped to slot
+        template<typename F>
+        bool eraseIf(int32_t tableId, int32_t blockNum, int32_t slot, F canErase) {
+            int64_t tag = tagOf(tableId, blockNum);
+            Partition& p = partitionOfTag(tag);
+            pthread_rwlock_wrlock(&p.lock);
+            auto it = p.slots.find(tag);
+            if (it == p.slots.end() || it->second != slot) {
+                pthread_rwlock_unlock(&p.lock);
+                return true;
+            }
+            if (!canErase(slot)) {
+                pthread_rwlock_unlock(&p.lock);
+                return false;
+            }
+            p.slots.erase(it);
+            pthread_rwlock_unlock(&p.lock);
+            eraseFromTableIndex(tableId, blockNum, slot);
+            return true;
+        }
+        int32_t getPartitionCount() const { return static_cast<int32_t>(partitions.size()); }
+};
+
+extern BufferMappingTable sharedBufferMapping;
+
+// O(1) counterparts of isBufferExist / getTableBuffer, the result is checked
+// against the slot so a stale mapping never returns a foreign buffer
+ShareBuffer* lookupSharedBuffer(int32_t tableId, int32_t blockNum);
+std::vector<ShareBuffer*> lookupTableBuffers(int32_t tableId);
+
+#endif
@@ -7,6 +7,7 @@
 #include <iomanip>
 #include <sstream>
 #include <string>
+#include "sha256.h"
 //#include "../../bufforing-stm/src/buserCache.h"
 
 
@@ -35,43 +36,49 @@ inline int64_t getNextUserId(){
     return result;
 }
 
+class buser;
+// re-keys a renamed user in sharedBuserIndex (buserIndex.cpp)
+void reindexRenamedBuser(buser* user, const std::string& oldName);
+
 class buser{
     private:
         int64_t id;
         std::string username;
-        std::string passwd;
         std::string email;
+        Sha256Digest passwdDigest{};   // of the password as given, the password itself is not kept
     public:
+        // useHashing has no effect and is kept so existing callers still compile:
+        // the password is always hashed and only its digest is kept
         buser(int64_t id, std::string username,std::string passwd,std::string email,bool useHashing = true){
+            (void)useHashing;
             this->id = id;
             this->username = username;
-            if(useHashing){
-                this->passwd =passwd; //sha256(passwd);
-            } else {
-                this->passwd = passwd;
-            }
+            this->passwdDigest = sha256Digest(passwd);
             this->email = email;
         };
         void setId(int64_t id){
             this->id = id;
         }
         void setUsername(std::string username){
-            this->username = username;
+            std::string oldName = std::move(this->username);
+            this->username = std::move(username);
+            reindexRenamedBuser(this, oldName);
         }
+        // useHashing has no effect, as in the constructor
         void setPasswd(std::string passwd,bool useHashing = true){
-            if(useHashing){
-                this->passwd = passwd ;//sha256(passwd);
-            } else {
-                this->passwd = passwd;
-            }
+            (void)useHashing;
+            this->passwdDigest = sha256Digest(passwd);
         }
         void setEmail(std::string email){
             this->email = email;
         }
         int64_t getId() const { return this->id; }
-        std::string getUsername() const { return this->username; }
-        std::string getPasswd() const { return this->passwd; }
-        std::string getEmail() const { return this->email; }
+        const std::string& getUsername() const { return this->username; }
+        const std::string& getEmail() const { return this->email; }
+        const Sha256Digest& getPasswdDigest() const { return this->passwdDigest; }
+        // constant-time compare against a digest from sha256Digest()
+        bool checkPasswdDigest(const Sha256Digest& digest) const { return digestEquals(this->passwdDigest, digest); }
+        bool checkPasswd(const std::string& passwd) const { return checkPasswdDigest(sha256Digest(passwd)); }
 };
 
 
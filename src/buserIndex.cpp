@@ -0,0 +1,153 @@
+#include <functional>
+#include "buserIndex.h"
+
+BuserIndex sharedBuserIndex;
+
+BuserIndex::BuserIndex(int32_t numPartitions)
+    : partitions(numPartitions > 0 ? numPartitions : 1)
+{
+    for (auto& p : partitions) {
+        pthread_rwlock_init(&p.lock, nullptr);
+    }
+}
+
+BuserIndex::~BuserIndex() {
+    for (auto& p : partitions) {
+        pthread_rwlock_destroy(&p.lock);
+    }
+}
+
+BuserIndex::Partition& BuserIndex::partitionOf(const std::string& username) {
+    return partitions[std::hash<std::string>()(username) % partitions.size()];
+}
+
+void BuserIndex::add(buser* user) {
+    if (user == nullptr) {
+        return;
+    }
+    Partition& p = partitionOf(user->getUsername());
+    pthread_rwlock_wrlock(&p.lock);
+    std::vector<buser*>& sameName = p.users[user->getUsername()];
+    bool present = false;
+    for (buser* u : sameName) {
+        present = present || u == user;
+    }
+    if (!present) {
+        sameName.push_back(user);
+    }
+    pthread_rwlock_unlock(&p.lock);
+}
+
+void BuserIndex::addCached(buser* user) {
+    if (user == nullptr) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    addUserToCache(user);
+    add(user);
+    if (indexedCount + 1 == userCache.size()) {
+        indexedCount++;   // nothing else was appended in between, no need to catch up on it
+    }
+}
+
+void BuserIndex::rename(buser* user, const std::string& oldName) {
+    if (user == nullptr || user->getUsername() == oldName) {
+        return;
+    }
+    Partition& p = partitionOf(oldName);
+    bool indexed = false;
+    pthread_rwlock_wrlock(&p.lock);
+    auto it = p.users.find(oldName);
+    if (it != p.users.end()) {
+        std::vector<buser*>& sameName = it->second;
+        for (size_t i = 0; i < sameName.size(); ++i) {
+            if (sameName[i] == user) {
+                sameName.erase(sameName.begin() + i);
+                indexed = true;
+                break;
+            }
+        }
+        if (sameName.empty()) {
+            p.users.erase(it);
+        }
+    }
+    pthread_rwlock_unlock(&p.lock);
+    if (indexed) {
+        add(user);
+    }
+}
+
+void reindexRenamedBuser(buser* user, const std::string& oldName) {
+    sharedBuserIndex.rename(user, oldName);
+}
+
+buser* BuserIndex::find(const std::string& username, const Sha256Digest& digest) {
+    Partition& p = partitionOf(username);
+    buser* result = nullptr;
+    pthread_rwlock_rdlock(&p.lock);
+    auto it = p.users.find(username);
+    if (it != p.users.end()) {
+        for (buser* u : it->second) {
+            // a renamed user stays under its old name, the name check skips it
+            if (u->checkPasswdDigest(digest) && u->getUsername() == username) {
+                result = u;
+                break;
+            }
+        }
+    }
+    pthread_rwlock_unlock(&p.lock);
+    return result;
+}
+
+bool BuserIndex::catchUp() {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    size_t cacheSize = userCache.size();
+    if (cacheSize < indexedCount) {
+        indexedCount = 0;   // the cache was cleared or rebuilt
+    }
+    if (cacheSize == indexedCount) {
+        return false;
+    }
+    for (size_t i = indexedCount; i < cacheSize; ++i) {
+        add(userCache[i]);
+    }
+    indexedCount = cacheSize;
+    return true;
+}
+
+buser* BuserIndex::authenticate(const std::string& username, const std::string& passwd) {
+    Sha256Digest digest = sha256Digest(passwd);
+    buser* user = find(username, digest);
+    // no match may still be a user of this name (or password) that only reached userCache
+    if (user == nullptr && catchUp()) {
+        user = find(username, digest);
+    }
+    return user;
+}
+
+int64_t BuserIndex::findUserId(const std::string& username, const std::string& passwd) {
+    buser* user = authenticate(username, passwd);
+    return user ? user->getId() : -1;
+}
+
+size_t BuserIndex::size() {
+    size_t result = 0;
+    for (auto& p : partitions) {
+        pthread_rwlock_rdlock(&p.lock);
+        for (const auto& entry : p.users) {
+            result += entry.second.size();
+        }
+        pthread_rwlock_unlock(&p.lock);
+    }
+    return result;
+}
+
+void BuserIndex::clear() {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    for (auto& p : partitions) {
+        pthread_rwlock_wrlock(&p.lock);
+        p.users.clear();
+        pthread_rwlock_unlock(&p.lock);
+    }
+    indexedCount = 0;
+}
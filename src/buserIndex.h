@@ -0,0 +1,61 @@
+#ifndef BUSERINDEX_H
+#define BUSERINDEX_H
+
+#include <pthread.h>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "buser.h"
+#include "../../bufforing-stm/src/buserCache.h"
+
+// Hash index username -> users over userCache. Lookups take only the read lock
+// of one partition and compare password digests, so authentication does not
+// scan the cache or copy strings. Users added in this tree go through
+// addCached, which appends to userCache under cacheMutex and indexes them
+// right away. Users loaded into userCache elsewhere (at startup) are picked
+// up by catching up with its tail, under the same mutex, when a lookup finds
+// no match; the catch up only reads the entries added since the last one.
+// buser::setUsername re-keys the user in sharedBuserIndex, other indexes
+// skip a renamed user under its old name.
+
+constexpr int32_t NUM_BUSER_PARTITIONS = 64;
+
+class BuserIndex {
+    private:
+        struct Partition {
+            pthread_rwlock_t lock;
+            std::unordered_map<std::string, std::vector<buser*>> users;   // same name can repeat
+        };
+        std::vector<Partition> partitions;
+        std::mutex cacheMutex;     // taken around every userCache append and read of this module
+        size_t indexedCount = 0;   // userCache entries already indexed, guarded by cacheMutex
+
+        Partition& partitionOf(const std::string& username);
+        buser* find(const std::string& username, const Sha256Digest& digest);
+        // indexes userCache entries added since the last catch up, true if there were any
+        bool catchUp();
+
+    public:
+        explicit BuserIndex(int32_t numPartitions = NUM_BUSER_PARTITIONS);
+        ~BuserIndex();
+        BuserIndex(const BuserIndex&) = delete;
+        BuserIndex& operator=(const BuserIndex&) = delete;
+
+        void add(buser* user);
+        // moves a user indexed under oldName to its current name
+        void rename(buser* user, const std::string& oldName);
+        // addUserToCache and add in one step, the cache takes the user over
+        void addCached(buser* user);
+        // user with this name and password or nullptr
+        buser* authenticate(const std::string& username, const std::string& passwd);
+        // id of the user or -1, like getUserIdFromCache
+        int64_t findUserId(const std::string& username, const std::string& passwd);
+        size_t size();
+        void clear();
+};
+
+extern BuserIndex sharedBuserIndex;
+
+#endif
@@ -0,0 +1,242 @@
+#ifndef COLUMNCODEC_H
+#define COLUMNCODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define COLUMN_CODEC_X86 1
+#endif
+
+// Batch serializers for whole columns. Instead of one value into one fresh
+// buffer, a column array is encoded into a span the caller owns (a page, a
+// WAL record), so there is no allocation and the loops vectorize:
+// - ints in big endian order are byte swapped 16 (SSSE3) or 32 (AVX2) bytes
+//   per shuffle, little endian is a memcpy
+// - a null bitmap is packed from one byte per value with movemask, 16 or 32
+//   values per instruction; bit set = not null, lowest bit first, as in the
+//   tuple format
+// The level is picked once from cpuid. The AVX2 code is compiled with a target
+// attribute, so the rest of the build does not need -mavx2.
+
+enum class ColumnByteOrder : int8_t {
+    LITTLE = 0,   // same as the tuple format, plain copy on x86
+    BIG = 1       // network order
+};
+
+enum class ColumnCodecLevel : int8_t {
+    SCALAR = 0,
+    SSSE3 = 1,
+    AVX2 = 2
+};
+
+inline ColumnCodecLevel detectColumnCodecLevel() {
+#ifdef COLUMN_CODEC_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return ColumnCodecLevel::AVX2;
+    }
+    if (__builtin_cpu_supports("ssse3")) {
+        return ColumnCodecLevel::SSSE3;
+    }
+#endif
+    return ColumnCodecLevel::SCALAR;
+}
+
+// lowered by tests and benchmarks to compare the paths, never raised above what the CPU has
+inline ColumnCodecLevel columnCodecLevel = detectColumnCodecLevel();
+
+namespace columncodec {
+
+template<typename T>
+inline T byteSwap(T value) {
+    if constexpr (sizeof(T) == 1) {
+        return value;
+    } else if constexpr (sizeof(T) == 2) {
+        return static_cast<T>(__builtin_bswap16(static_cast<uint16_t>(value)));
+    } else if constexpr (sizeof(T) == 4) {
+        return static_cast<T>(__builtin_bswap32(static_cast<uint32_t>(value)));
+    } else {
+        return static_cast<T>(__builtin_bswap64(static_cast<uint64_t>(value)));
+    }
+}
+
+template<typename T>
+inline void swapScalar(const uint8_t* in, size_t n, uint8_t* out) {
+    for (size_t i = 0; i < n; ++i) {
+        T v;
+        memcpy(&v, in + i * sizeof(T), sizeof(T));
+        v = byteSwap(v);
+        memcpy(out + i * sizeof(T), &v, sizeof(T));
+    }
+}
+
+#ifdef COLUMN_CODEC_X86
+// pshufb mask reversing every sizeof(T)-byte lane of a 16-byte register
+template<size_t Width>
+inline void swapMask(uint8_t* mask) {
+    for (size_t i = 0; i < 16; ++i) {
+        mask[i] = static_cast<uint8_t>(i - i % Width + (Width - 1 - i % Width));
+    }
+}
+
+template<typename T>
+__attribute__((target("ssse3")))
+inline size_t swapSsse3(const uint8_t* in, size_t n, uint8_t* out) {
+    alignas(16) uint8_t m[16];
+    swapMask<sizeof(T)>(m);
+    __m128i mask = _mm_load_si128(reinterpret_cast<const __m128i*>(m));
+    size_t bytes = n * sizeof(T) / 16 * 16;
+    for (size_t i = 0; i < bytes; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_shuffle_epi8(v, mask));
+    }
+    return bytes / sizeof(T);
+}
+
+template<typename T>
+__attribute__((target("avx2")))
+inline size_t swapAvx2(const uint8_t* in, size_t n, uint8_t* out) {
+    alignas(32) uint8_t m[32];
+    swapMask<sizeof(T)>(m);
+    swapMask<sizeof(T)>(m + 16);
+    __m256i mask = _mm256_load_si256(reinterpret_cast<const __m256i*>(m));
+    size_t bytes = n * sizeof(T) / 32 * 32;
+    for (size_t i = 0; i < bytes; i += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_shuffle_epi8(v, mask));
+    }
+    return bytes / sizeof(T);
+}
+
+__attribute__((target("sse2")))
+inline size_t packSse2(const uint8_t* flags, size_t n, uint8_t* out) {
+    size_t done = n / 16 * 16;
+    __m128i zero = _mm_setzero_si128();
+    for (size_t i = 0; i < done; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(flags + i));
+        // movemask takes the top bit of each byte: set it for every non-zero flag
+        uint32_t bits = ~static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, zero))) & 0xffff;
+        out[i / 8] = static_cast<uint8_t>(bits);
+        out[i / 8 + 1] = static_cast<uint8_t>(bits >> 8);
+    }
+    return done;
+}
+
+__attribute__((target("avx2")))
+inline size_t packAvx2(const uint8_t* flags, size_t n, uint8_t* out) {
+    size_t done = n / 32 * 32;
+    __m256i zero = _mm256_setzero_si256();
+    for (size_t i = 0; i < done; i += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(flags + i));
+        uint32_t bits = ~static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, zero)));
+        memcpy(out + i / 8, &bits, sizeof(bits));
+    }
+    return done;
+}
+#endif
+
+// byte swaps n values of T from in to out, in and out may be the same buffer
+template<typename T>
+inline void swapColumn(const uint8_t* in, size_t n, uint8_t* out) {
+    size_t done = 0;
+#ifdef COLUMN_CODEC_X86
+    if (sizeof(T) > 1) {
+        if (columnCodecLevel == ColumnCodecLevel::AVX2) {
+            done = swapAvx2<T>(in, n, out);
+        }
+        if (columnCodecLevel >= ColumnCodecLevel::SSSE3) {
+            done += swapSsse3<T>(in + done * sizeof(T), n - done, out + done * sizeof(T));
+        }
+    }
+#endif
+    swapScalar<T>(in + done * sizeof(T), n - done, out + done * sizeof(T));
+}
+
+}
+
+// n values into out (n * sizeof(T) bytes), returns the bytes written
+template<typename T>
+inline size_t encodeColumn(const T* values, size_t n, uint8_t* out, ColumnByteOrder order = ColumnByteOrder::LITTLE) {
+    static_assert(std::is_integral<T>::value && !std::is_same<T, bool>::value, "encodeColumn takes ints, bools go through encodeBoolColumn");
+    const uint8_t* in = reinterpret_cast<const uint8_t*>(values);
+    if (order == ColumnByteOrder::LITTLE || sizeof(T) == 1) {
+        memcpy(out, in, n * sizeof(T));
+    } else {
+        columncodec::swapColumn<T>(in, n, out);
+    }
+    return n * sizeof(T);
+}
+
+// reverse of encodeColumn, returns the bytes read
+template<typename T>
+inline size_t decodeColumn(const uint8_t* in, size_t n, T* values, ColumnByteOrder order = ColumnByteOrder::LITTLE) {
+    static_assert(std::is_integral<T>::value && !std::is_same<T, bool>::value, "decodeColumn takes ints");
+    uint8_t* out = reinterpret_cast<uint8_t*>(values);
+    if (order == ColumnByteOrder::LITTLE || sizeof(T) == 1) {
+        memcpy(out, in, n * sizeof(T));
+    } else {
+        columncodec::swapColumn<T>(in, n, out);
+    }
+    return n * sizeof(T);
+}
+
+// one byte per value, 0 or 1
+inline size_t encodeBoolColumn(const bool* values, size_t n, uint8_t* out) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = values[i] ? 1 : 0;
+    }
+    return n;
+}
+
+inline size_t nullBitmapSize(size_t n) { return (n + 7) / 8; }
+
+// one flag byte per value (non-zero = not null) into a bitmap, returns the bytes written
+inline size_t packNullBitmap(const uint8_t* flags, size_t n, uint8_t* out) {
+    size_t done = 0;
+#ifdef COLUMN_CODEC_X86
+    if (columnCodecLevel == ColumnCodecLevel::AVX2) {
+        done = columncodec::packAvx2(flags, n, out);
+    }
+    if (columnCodecLevel >= ColumnCodecLevel::SSSE3) {
+        done += columncodec::packSse2(flags + done, n - done, out + done / 8);
+    }
+#endif
+    // done is a multiple of 8 here, the tail starts on a byte boundary
+    size_t bytes = nullBitmapSize(n);
+    for (size_t b = done / 8; b < bytes; ++b) {
+        uint8_t bits = 0;
+        for (size_t i = b * 8; i < n && i < b * 8 + 8; ++i) {
+            bits |= static_cast<uint8_t>((flags[i] != 0) << (i & 7));
+        }
+        out[b] = bits;
+    }
+    return bytes;
+}
+
+// std::vector<bool> bitmap of a row or a column, eight values per output byte
+inline size_t packNullBitmap(const std::vector<bool>& bitmap, uint8_t* out) {
+    size_t n = bitmap.size();
+    size_t bytes = nullBitmapSize(n);
+    std::vector<bool>::const_iterator it = bitmap.begin();
+    for (size_t b = 0; b < bytes; ++b) {
+        uint8_t bits = 0;
+        for (size_t i = 0; i < 8 && it != bitmap.end(); ++i, ++it) {
+            bits |= static_cast<uint8_t>(*it << i);
+        }
+        out[b] = bits;
+    }
+    return bytes;
+}
+
+// bitmap back to one 0/1 byte per value
+inline void unpackNullBitmap(const uint8_t* bits, size_t n, uint8_t* flags) {
+    for (size_t i = 0; i < n; ++i) {
+        flags[i] = (bits[i >> 3] >> (i & 7)) & 1;
+    }
+}
+
+#endif
@@ -0,0 +1,248 @@
+#ifndef EVICTIONPOLICY_H
+#define EVICTIONPOLICY_H
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "bufferFlags.h"
+
+// Victim selection for the shared buffer pool. Policies work on slot indices
+// of the cache vector and read ShareBuffer::count (usage), isDirty, tableId
+// and blockNum of the residents; count and isDirty through bufferFlags.h.
+
+enum class EvictionPolicyKind : int8_t {
+    CLOCK_SWEEP = 0,   // default, usage counts decay on every pass of the hand
+    TWO_Q = 1,         // scan resistant: A1in FIFO + A1out ghosts + clock over Am
+    LFU = 2            // old behaviour: full scan for the lowest count
+};
+
+// policy used by pools created after initSharedBuffers(size, policy)
+inline EvictionPolicyKind sharedBuffersEvictionPolicy = EvictionPolicyKind::CLOCK_SWEEP;
+
+// usage counts are capped like BM_MAX_USAGE_COUNT in PostgreSQL, so a hot
+// buffer survives at most MAX_USAGE_COUNT passes of the clock hand
+constexpr int32_t MAX_USAGE_COUNT = 5;
+
+template<typename Cache, typename VectorType>
+class EvictionPolicy {
+    protected:
+        // slots the pool cannot give up right now (pinned, being written, kept in the free-slot reserve)
+        std::function<bool(size_t)> unevictable;
+        bool isUnevictable(size_t slot) const { return unevictable && unevictable(slot); }
+    public:
+        virtual ~EvictionPolicy() = default;
+        void setUnevictable(std::function<bool(size_t)> fn) { unevictable = std::move(fn); }
+        // slot the next victim search starts from, the background writer cleans from here on
+        virtual size_t sweepStart() const { return 0; }
+        // element was placed in slot
+        virtual void admitted(Cache& cache, size_t slot) { (void)cache; (void)slot; }
+        // element in slot is going to be removed from the cache
+        virtual void evicted(Cache& cache, size_t slot) { (void)cache; (void)slot; }
+        // slot to evict (an empty slot is returned as is), -1 when there is nothing to evict
+        virtual int32_t victim(Cache& cache) = 0;
+};
+
+// One clock sweep step loop shared by CLOCK_SWEEP and TWO_Q. Slots for which
+// skip(slot) is true are passed over without touching their usage count.
+// Among buffers whose usage dropped to 0 a clean one is preferred; a dirty one
+// is only taken after a full revolution did not find anything clean.
+template<typename Cache, typename Skip>
+int32_t sweepClock(Cache& cache, size_t& hand, Skip skip) {
+    size_t n = cache.size();
+    if (n == 0) {
+        return -1;
+    }
+    int32_t dirtyCandidate = -1;
+    size_t sinceCandidate = 0;
+    for (size_t step = 0; step < n * (MAX_USAGE_COUNT + 2); ++step) {
+        size_t slot = hand % n;
+        hand = (slot + 1) % n;
+        if (dirtyCandidate >= 0 && ++sinceCandidate >= n) {
+            return dirtyCandidate;
+        }
+        if (skip(slot)) {
+            continue;
+        }
+        auto el = cache[slot];
+        if (!el) {
+            return static_cast<int32_t>(slot);
+        }
+        int32_t usage = bufferUsage(el);
+        if (usage > MAX_USAGE_COUNT) {
+            usage = MAX_USAGE_COUNT;
+        }
+        if (usage > 0) {
+            setBufferUsage(el, usage - 1);
+            continue;
+        }
+        if (!bufferIsDirty(el)) {
+            return static_cast<int32_t>(slot);
+        }
+        if (dirtyCandidate < 0) {
+            dirtyCandidate = static_cast<int32_t>(slot);
+            sinceCandidate = 0;
+        }
+    }
+    return dirtyCandidate;
+}
+
+template<typename Cache, typename VectorType>
+class ClockSweepPolicy : public EvictionPolicy<Cache, VectorType> {
+    private:
+        size_t hand = 0;
+    public:
+        size_t sweepStart() const override { return hand; }
+        int32_t victim(Cache& cache) override {
+            return sweepClock(cache, hand, [this](size_t s) { return this->isUnevictable(s); });
+        }
+};
+
+template<typename Cache, typename VectorType>
+class LfuPolicy : public EvictionPolicy<Cache, VectorType> {
+    public:
+        int32_t victim(Cache& cache) override {
+            int32_t indexToDelete = -1;
+            int32_t minCount = INT32_MAX;
+            bool isDirtyMin = true;
+            for (size_t i = 0; i < cache.size(); ++i) {
+                VectorType cacheEl = cache[i];
+                if (this->isUnevictable(i)) {
+                    continue;
+                }
+                if (!cacheEl) {
+                    return static_cast<int32_t>(i);
+                }
+                int32_t count = bufferUsage(cacheEl);
+                bool dirty = bufferIsDirty(cacheEl);
+                if (indexToDelete < 0 || count < minCount ||
+                (count == minCount && !dirty && isDirtyMin)) {
+                    minCount = count;
+                    isDirtyMin = dirty;
+                    indexToDelete = static_cast<int32_t>(i);
+                }
+            }
+            return indexToDelete;
+        }
+};
+
+// 2Q (Johnson & Shasha). New pages go to the A1in FIFO; when A1in holds more
+// than a quarter of the pool its oldest page is evicted and remembered in the
+// A1out ghost list. A page loaded again while its key is still in A1out is
+// hot and goes straight to Am, which is managed by the clock. A single large
+// scan therefore only cycles through A1in and never flushes Am.
+template<typename Cache, typename VectorType>
+class TwoQPolicy : public EvictionPolicy<Cache, VectorType> {
+    private:
+        enum SlotQueue : int8_t { NONE = 0, A1IN = 1, AM = 2 };
+        std::vector<int8_t> queueOf;
+        std::vector<VectorType> residentOf;   // element seen when the slot was admitted
+        std::deque<size_t> a1in;
+        std::deque<std::pair<int64_t, uint64_t>> a1out;
+        std::unordered_map<int64_t, uint64_t> a1outKeys;   // key -> newest sequence in a1out
+        uint64_t ghostSeq = 0;
+        size_t hand = 0;
+
+        static int64_t keyOf(VectorType el) {
+            return (static_cast<int64_t>(el->tableId) << 32) | static_cast<uint32_t>(el->blockNum);
+        }
+        void ensureSize(size_t n) {
+            if (queueOf.size() != n) {
+                queueOf.resize(n, NONE);
+                residentOf.resize(n, nullptr);
+            }
+        }
+        size_t kin() const { return queueOf.size() / 4 > 0 ? queueOf.size() / 4 : 1; }
+        size_t kout() const { return queueOf.size() / 2 > 0 ? queueOf.size() / 2 : 1; }
+        bool inA1in(Cache& cache, size_t slot) const {
+            return queueOf[slot] == A1IN && cache[slot] != nullptr && cache[slot] == residentOf[slot];
+        }
+        void rememberGhost(int64_t key) {
+            a1out.emplace_back(key, ++ghostSeq);
+            a1outKeys[key] = ghostSeq;
+            while (a1out.size() > kout()) {
+                auto it = a1outKeys.find(a1out.front().first);
+                if (it != a1outKeys.end() && it->second == a1out.front().second) {
+                    a1outKeys.erase(it);
+                }
+                a1out.pop_front();
+            }
+        }
+
+    public:
+        size_t sweepStart() const override { return a1in.empty() ? hand : a1in.front(); }
+        void admitted(Cache& cache, size_t slot) override {
+            ensureSize(cache.size());
+            VectorType el = cache[slot];
+            if (!el) {
+                return;
+            }
+            residentOf[slot] = el;
+            auto ghost = a1outKeys.find(keyOf(el));
+            if (ghost != a1outKeys.end()) {
+                a1outKeys.erase(ghost);
+                queueOf[slot] = AM;
+            } else {
+                queueOf[slot] = A1IN;
+                a1in.push_back(slot);
+            }
+        }
+        void evicted(Cache& cache, size_t slot) override {
+            ensureSize(cache.size());
+            if (inA1in(cache, slot)) {
+                if (!a1in.empty() && a1in.front() == slot) {
+                    a1in.pop_front();
+                } else {
+                    for (auto it = a1in.begin(); it != a1in.end(); ++it) {
+                        if (*it == slot) {
+                            a1in.erase(it);
+                            break;
+                        }
+                    }
+                }
+                rememberGhost(keyOf(cache[slot]));
+            }
+            queueOf[slot] = NONE;
+            residentOf[slot] = nullptr;
+        }
+        int32_t victim(Cache& cache) override {
+            ensureSize(cache.size());
+            // drop entries whose slot was reused behind our back
+            while (!a1in.empty() && !inA1in(cache, a1in.front())) {
+                if (queueOf[a1in.front()] == A1IN) {
+                    queueOf[a1in.front()] = NONE;
+                }
+                a1in.pop_front();
+            }
+            if (a1in.size() > kin() && !this->isUnevictable(a1in.front())) {
+                return static_cast<int32_t>(a1in.front());
+            }
+            int32_t slot = sweepClock(cache, hand, [&](size_t s) { return inA1in(cache, s) || this->isUnevictable(s); });
+            if (slot >= 0) {
+                return slot;
+            }
+            for (size_t s : a1in) {
+                if (!this->isUnevictable(s)) {
+                    return static_cast<int32_t>(s);
+                }
+            }
+            return -1;
+        }
+};
+
+template<typename Cache, typename VectorType>
+std::unique_ptr<EvictionPolicy<Cache, VectorType>> makeEvictionPolicy(EvictionPolicyKind kind) {
+    switch (kind) {
+        case EvictionPolicyKind::TWO_Q:
+            return std::make_unique<TwoQPolicy<Cache, VectorType>>();
+        case EvictionPolicyKind::LFU:
+            return std::make_unique<LfuPolicy<Cache, VectorType>>();
+        case EvictionPolicyKind::CLOCK_SWEEP:
+        default:
+            return std::make_unique<ClockSweepPolicy<Cache, VectorType>>();
+    }
+}
+
+#endif
@@ -0,0 +1,97 @@
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "framePool.h"
+#include "../../bufforing-stm/src/log.h"
+
+FramePool::FramePool(int32_t frames) {
+    if (frames <= 0) {
+        return;
+    }
+    mappedSize = static_cast<size_t>(frames) * PAGE_FILE_BLOCK_SIZE;
+    void* p = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) {
+        LOG_ERROR("Cannot map " << frames << " page frames, errno " << errno);
+        mappedSize = 0;
+        return;
+    }
+    base = static_cast<uint8_t*>(p);
+    frameCount = frames;
+    inUse.assign(frames, false);
+    freeFrames.reserve(frames);
+    for (int32_t i = frames; i > 0; --i) {
+        freeFrames.push_back(i - 1);
+    }
+}
+
+FramePool::~FramePool() {
+    if (base) {
+        munmap(base, mappedSize);
+    }
+}
+
+uint8_t* FramePool::acquire() {
+    int32_t index;
+    {
+        std::lock_guard<std::mutex> lock(m);
+        if (freeFrames.empty()) {
+            return nullptr;
+        }
+        index = freeFrames.back();
+        freeFrames.pop_back();
+        inUse[index] = true;
+    }
+    uint8_t* p = frame(index);
+    memset(p, 0, PAGE_FILE_BLOCK_SIZE);
+    return p;
+}
+
+void FramePool::release(uint8_t* p) {
+    int32_t index = indexOf(p);
+    if (index < 0) {
+        LOG_ERROR("Frame " << static_cast<void*>(p) << " does not belong to the pool");
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m);
+    if (!inUse[index]) {
+        return;   // double release
+    }
+    inUse[index] = false;
+    freeFrames.push_back(index);
+}
+
+int32_t FramePool::indexOf(const void* p) const {
+    const uint8_t* q = static_cast<const uint8_t*>(p);
+    if (!base || q < base || q >= base + mappedSize) {
+        return -1;
+    }
+    size_t offset = static_cast<size_t>(q - base);
+    if (offset % PAGE_FILE_BLOCK_SIZE != 0) {
+        return -1;
+    }
+    return static_cast<int32_t>(offset / PAGE_FILE_BLOCK_SIZE);
+}
+
+uint8_t* FramePool::frame(int32_t index) const {
+    if (index < 0 || index >= frameCount) {
+        return nullptr;
+    }
+    return base + static_cast<size_t>(index) * PAGE_FILE_BLOCK_SIZE;
+}
+
+int32_t FramePool::getFreeCount() {
+    std::lock_guard<std::mutex> lock(m);
+    return static_cast<int32_t>(freeFrames.size());
+}
+
+int32_t FramePool::framesForMemory(double fraction) {
+    long pages = sysconf(_SC_PHYS_PAGES);
+    long pageSize = sysconf(_SC_PAGESIZE);
+    if (pages <= 0 || pageSize <= 0 || fraction <= 0) {
+        return 0;
+    }
+    double bytes = static_cast<double>(pages) * static_cast<double>(pageSize) * fraction;
+    double frames = bytes / PAGE_FILE_BLOCK_SIZE;
+    return frames > INT32_MAX ? INT32_MAX : static_cast<int32_t>(frames);
+}
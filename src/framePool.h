@@ -0,0 +1,49 @@
+#ifndef FRAMEPOOL_H
+#define FRAMEPOOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "pageFile.h"
+
+// Page frames for O_DIRECT I/O. All frames come from one anonymous mapping,
+// so every frame is PAGE_FILE_BLOCK_SIZE bytes at a 4 KB aligned address and
+// can be handed to PageFile in direct mode as is. The pool has a fixed size
+// chosen at start: with O_DIRECT the kernel page cache does not hold a second
+// copy of the pages, so the pool can take most of the machine's memory.
+
+constexpr double FRAME_POOL_DEFAULT_MEMORY_FRACTION = 0.75;
+
+class FramePool {
+    private:
+        uint8_t* base = nullptr;
+        size_t mappedSize = 0;
+        int32_t frameCount = 0;
+        std::mutex m;
+        std::vector<int32_t> freeFrames;
+        std::vector<bool> inUse;
+
+    public:
+        explicit FramePool(int32_t frames);
+        ~FramePool();
+        FramePool(const FramePool&) = delete;
+        FramePool& operator=(const FramePool&) = delete;
+
+        // false when the mapping failed, the pool has no frames then
+        bool isReady() const { return base != nullptr; }
+        // zeroed frame, nullptr when every frame is taken (the caller evicts and retries)
+        uint8_t* acquire();
+        void release(uint8_t* frame);
+
+        // index of the frame that holds p, -1 for memory outside the pool
+        int32_t indexOf(const void* p) const;
+        uint8_t* frame(int32_t index) const;
+        int32_t getFrameCount() const { return frameCount; }
+        int32_t getFreeCount();
+
+        // frames that fit in fraction of the physical memory
+        static int32_t framesForMemory(double fraction = FRAME_POOL_DEFAULT_MEMORY_FRACTION);
+};
+
+#endif
@@ -0,0 +1,579 @@
+#include <algorithm>
+#include <cstring>
+#include "btreeIndex.h"
+#include "hashIndex.h"
+#include "../../bufforing-stm/src/log.h"
+
+HashIndexRegistry sharedHashIndexes;
+
+static const uint32_t HASH_MAGIC = 0x48415348;   // "HASH"
+static const size_t BUCKET_DATA = sizeof(SlottedPageHeader) + sizeof(HashBucketHeader);
+static const size_t DIR_PER_PAGE = (PAGE_FILE_BLOCK_SIZE - sizeof(SlottedPageHeader)) / sizeof(int32_t);
+
+const size_t HashIndex::BUCKET_CAPACITY = (PAGE_FILE_BLOCK_SIZE - BUCKET_DATA) / sizeof(HashEntry);
+
+struct HashMeta {
+    uint32_t magic;
+    uint32_t initialBuckets;
+    uint32_t level;
+    uint32_t nextSplit;
+    uint32_t bucketCount;
+    int32_t freeOverflow;
+    int64_t entryCount;
+    uint32_t dirCount;
+    uint32_t pad;
+    // int32_t dirBlocks[] follows
+};
+
+static const size_t MAX_DIR_BLOCKS = (PAGE_FILE_BLOCK_SIZE - sizeof(SlottedPageHeader) - sizeof(HashMeta)) / sizeof(int32_t);
+
+static HashMeta* metaOf(const IndexPage& page) {
+    return reinterpret_cast<HashMeta*>(page.data + sizeof(SlottedPageHeader));
+}
+
+static int32_t* metaDirBlocks(const IndexPage& page) {
+    return reinterpret_cast<int32_t*>(page.data + sizeof(SlottedPageHeader) + sizeof(HashMeta));
+}
+
+static int32_t* dirSlots(const IndexPage& page) {
+    return reinterpret_cast<int32_t*>(page.data + sizeof(SlottedPageHeader));
+}
+
+static HashBucketHeader* bucketHeader(const IndexPage& page) {
+    return reinterpret_cast<HashBucketHeader*>(page.data + sizeof(SlottedPageHeader));
+}
+
+static HashEntry* bucketEntries(const IndexPage& page) {
+    return reinterpret_cast<HashEntry*>(page.data + BUCKET_DATA);
+}
+
+// splitmix64 finalizer, sequential keys spread over all buckets
+static uint64_t hashKey(int64_t key) {
+    uint64_t x = static_cast<uint64_t>(key);
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+static void initIndexPage(const IndexPage& page, int32_t indexId) {
+    memset(page.data, 0, PAGE_FILE_BLOCK_SIZE);
+    SlottedPageHeader* h = reinterpret_cast<SlottedPageHeader*>(page.data);
+    h->tableId = indexId;
+    h->blockNum = page.blockNum;
+    h->format = PAGE_FORMAT_HASH;
+    h->lower = static_cast<uint16_t>(sizeof(SlottedPageHeader));
+    h->upper = static_cast<uint16_t>(PAGE_FILE_BLOCK_SIZE);
+    h->special = static_cast<uint16_t>(PAGE_FILE_BLOCK_SIZE);
+}
+
+HashIndex::HashIndex(int32_t indexId, int32_t cacheFrames) : indexId(indexId), cache(cacheFrames) {
+    pthread_rwlock_init(&splitLock, nullptr);
+}
+
+HashIndex::~HashIndex() {
+    close();
+    pthread_rwlock_destroy(&splitLock);
+}
+
+uint32_t HashIndex::bucketOf(uint64_t hash) const {
+    uint64_t low = static_cast<uint64_t>(initialBuckets) << level;
+    uint64_t bucket = hash & (low - 1);
+    if (bucket < nextSplit) {
+        // already split in this round, one more bit of the hash decides
+        bucket = hash & (low * 2 - 1);
+    }
+    return static_cast<uint32_t>(bucket);
+}
+
+void HashIndex::initBucketPage(const IndexPage& page, uint32_t bucket) {
+    initIndexPage(page, indexId);
+    reinterpret_cast<SlottedPageHeader*>(page.data)->lower = static_cast<uint16_t>(BUCKET_DATA);
+    HashBucketHeader* h = bucketHeader(page);
+    h->bucket = bucket;
+    h->count = 0;
+    h->next = -1;
+}
+
+bool HashIndex::open(const std::string& path, uint32_t buckets) {
+    if (!cache.open(path)) {
+        return false;
+    }
+    if (cache.getBlockCount() > 0) {
+        if (!loadMeta()) {
+            LOG_ERROR("Index file " << path << " is not a hash index");
+            cache.close();
+            return false;
+        }
+        return true;
+    }
+    initialBuckets = 1;
+    while (initialBuckets < buckets) {
+        initialBuckets <<= 1;
+    }
+    level = 0;
+    nextSplit = 0;
+    directory.clear();
+    dirBlocks.clear();
+    freeOverflow = -1;
+    entryCount.store(0);
+    IndexPage meta = cache.allocate();
+    if (!meta.data) {
+        return false;
+    }
+    initIndexPage(meta, indexId);
+    cache.markDirty(meta);
+    cache.unpin(meta);
+    for (uint32_t b = 0; b < initialBuckets; ++b) {
+        if (!addBucket()) {
+            return false;
+        }
+    }
+    LOG_DEBUG("Created hash index ID " << indexId << " in " << path << " with " << initialBuckets << " buckets");
+    return writeMeta() && cache.flush();
+}
+
+void HashIndex::close() {
+    if (cache.isOpen()) {
+        flush();
+        cache.close();
+    }
+}
+
+bool HashIndex::loadMeta() {
+    IndexPage meta = cache.pin(0);
+    if (!meta.data) {
+        return false;
+    }
+    HashMeta* m = metaOf(meta);
+    bool ok = m->magic == HASH_MAGIC && m->dirCount <= MAX_DIR_BLOCKS;
+    if (ok) {
+        initialBuckets = m->initialBuckets;
+        level = m->level;
+        nextSplit = m->nextSplit;
+        freeOverflow = m->freeOverflow;
+        entryCount.store(m->entryCount);
+        dirBlocks.assign(metaDirBlocks(meta), metaDirBlocks(meta) + m->dirCount);
+        directory.resize(m->bucketCount);
+    }
+    cache.unpin(meta);
+    for (size_t b = 0; ok && b < directory.size(); b += DIR_PER_PAGE) {
+        IndexPage dir = cache.pin(dirBlocks[b / DIR_PER_PAGE]);
+        if (!dir.data) {
+            return false;
+        }
+        size_t n = std::min(DIR_PER_PAGE, directory.size() - b);
+        std::copy(dirSlots(dir), dirSlots(dir) + n, directory.begin() + b);
+        cache.unpin(dir);
+    }
+    return ok;
+}
+
+bool HashIndex::writeMeta() {
+    IndexPage meta = cache.pin(0);
+    if (!meta.data) {
+        return false;
+    }
+    cache.latch(meta, true);
+    HashMeta* m = metaOf(meta);
+    m->magic = HASH_MAGIC;
+    m->initialBuckets = initialBuckets;
+    m->level = level;
+    m->nextSplit = nextSplit;
+    m->bucketCount = static_cast<uint32_t>(directory.size());
+    {
+        std::lock_guard<std::mutex> lock(freeMutex);
+        m->freeOverflow = freeOverflow;
+    }
+    m->entryCount = entryCount.load();
+    m->dirCount = static_cast<uint32_t>(dirBlocks.size());
+    std::copy(dirBlocks.begin(), dirBlocks.end(), metaDirBlocks(meta));
+    cache.markDirty(meta);
+    cache.unlatch(meta);
+    cache.unpin(meta);
+    return true;
+}
+
+// primary page of the next bucket, the directory grows by one (splitLock exclusive or open)
+bool HashIndex::addBucket() {
+    size_t bucket = directory.size();
+    if (bucket % DIR_PER_PAGE == 0) {
+        if (dirBlocks.size() >= MAX_DIR_BLOCKS) {
+            LOG_ERROR("Hash index ID " << indexId << " is at its bucket limit");
+            return false;
+        }
+        IndexPage dir = cache.allocate();
+        if (!dir.data) {
+            return false;
+        }
+        initIndexPage(dir, indexId);
+        cache.markDirty(dir);
+        cache.unpin(dir);
+        dirBlocks.push_back(dir.blockNum);
+    }
+    IndexPage page = cache.allocate();
+    if (!page.data) {
+        return false;
+    }
+    initBucketPage(page, static_cast<uint32_t>(bucket));
+    cache.markDirty(page);
+    cache.unpin(page);
+
+    IndexPage dir = cache.pin(dirBlocks[bucket / DIR_PER_PAGE]);
+    if (!dir.data) {
+        return false;
+    }
+    cache.latch(dir, true);
+    dirSlots(dir)[bucket % DIR_PER_PAGE] = page.blockNum;
+    cache.markDirty(dir);
+    cache.unlatch(dir);
+    cache.unpin(dir);
+    directory.push_back(page.blockNum);
+    return true;
+}
+
+// empty overflow page for the bucket, latched exclusive; a page freed by a split is reused first
+IndexPage HashIndex::newOverflow(uint32_t bucket) {
+    IndexPage page;
+    {
+        std::lock_guard<std::mutex> lock(freeMutex);
+        if (freeOverflow >= 0) {
+            page = cache.pin(freeOverflow);
+            if (page.data) {
+                freeOverflow = bucketHeader(page)->next;
+            }
+        }
+    }
+    if (!page.data) {
+        page = cache.allocate();
+        if (!page.data) {
+            return page;
+        }
+    }
+    cache.latch(page, true);
+    initBucketPage(page, bucket);
+    cache.markDirty(page);
+    return page;
+}
+
+// walks the chain of primary (latched exclusive by the caller): 0 when the entry
+// is there already, 1 when it was added to the last page or a new overflow page, -1 on error
+int32_t HashIndex::appendToChain(const IndexPage& primary, const HashEntry& entry) {
+    IndexPage page = primary;
+    while (true) {
+        HashBucketHeader* h = bucketHeader(page);
+        HashEntry* entries = bucketEntries(page);
+        for (uint16_t i = 0; i < h->count; ++i) {
+            if (entries[i].key == entry.key && entries[i].ctid == entry.ctid) {
+                if (page.blockNum != primary.blockNum) {
+                    cache.unlatch(page);
+                    cache.unpin(page);
+                }
+                return 0;
+            }
+        }
+        int32_t result = -2;
+        if (h->next < 0 && h->count < BUCKET_CAPACITY) {
+            entries[h->count++] = entry;
+            cache.markDirty(page);
+            result = 1;
+        } else if (h->next < 0) {
+            IndexPage overflow = newOverflow(h->bucket);
+            result = -1;
+            if (overflow.data) {
+                bucketHeader(overflow)->count = 1;
+                bucketEntries(overflow)[0] = entry;
+                h->next = overflow.blockNum;
+                cache.markDirty(page);
+                cache.unlatch(overflow);
+                cache.unpin(overflow);
+                result = 1;
+            }
+        }
+        int32_t next = h->next;
+        if (page.blockNum != primary.blockNum) {
+            cache.unlatch(page);
+            cache.unpin(page);
+        }
+        if (result != -2) {
+            return result;
+        }
+        page = cache.pin(next);
+        if (!page.data) {
+            LOG_ERROR("Hash index ID " << indexId << " lost overflow block " << next);
+            return -1;
+        }
+        cache.latch(page, true);
+    }
+}
+
+bool HashIndex::needsSplit() const {
+    return static_cast<double>(entryCount.load()) >
+           static_cast<double>(directory.size()) * BUCKET_CAPACITY * HASH_INDEX_FILL_PERCENT / 100;
+}
+
+// splits bucket nextSplit into itself and a new bucket at the end, splitLock exclusive
+bool HashIndex::splitNext() {
+    uint64_t low = static_cast<uint64_t>(initialBuckets) << level;
+    uint32_t oldBucket = nextSplit;
+    uint64_t mask = low * 2 - 1;
+    if (!addBucket()) {
+        return false;
+    }
+    uint32_t newBucket = static_cast<uint32_t>(directory.size() - 1);
+
+    std::vector<HashEntry> keep;
+    std::vector<HashEntry> move;
+    std::vector<int32_t> chain;
+    for (int32_t block = directory[oldBucket]; block >= 0;) {
+        IndexPage page = cache.pin(block);
+        if (!page.data) {
+            return false;
+        }
+        chain.push_back(block);
+        HashBucketHeader* h = bucketHeader(page);
+        HashEntry* entries = bucketEntries(page);
+        for (uint16_t i = 0; i < h->count; ++i) {
+            (hashKey(entries[i].key) & mask) == oldBucket ? keep.push_back(entries[i]) : move.push_back(entries[i]);
+        }
+        block = h->next;
+        cache.unpin(page);
+    }
+
+    // the staying entries are packed into the front of the old chain, the rest of it is freed
+    size_t placed = 0;
+    for (size_t i = 0; i < chain.size(); ++i) {
+        IndexPage page = cache.pin(chain[i]);
+        if (!page.data) {
+            return false;
+        }
+        cache.latch(page, true);
+        HashBucketHeader* h = bucketHeader(page);
+        bool used = i == 0 || placed < keep.size();
+        size_t n = std::min(BUCKET_CAPACITY, keep.size() - placed);
+        if (used) {
+            std::copy(keep.begin() + placed, keep.begin() + placed + n, bucketEntries(page));
+            h->count = static_cast<uint16_t>(n);
+            placed += n;
+            if (placed == keep.size()) {
+                h->next = -1;
+            }
+        } else {
+            std::lock_guard<std::mutex> lock(freeMutex);
+            h->count = 0;
+            h->next = freeOverflow;
+            freeOverflow = chain[i];
+        }
+        cache.markDirty(page);
+        cache.unlatch(page);
+        cache.unpin(page);
+    }
+
+    IndexPage primary = cache.pin(directory[newBucket]);
+    if (!primary.data) {
+        return false;
+    }
+    cache.latch(primary, true);
+    bool ok = true;
+    for (const HashEntry& e : move) {
+        ok = appendToChain(primary, e) >= 0 && ok;
+    }
+    cache.unlatch(primary);
+    cache.unpin(primary);
+
+    nextSplit++;
+    if (nextSplit == low) {
+        level++;
+        nextSplit = 0;
+    }
+    splitCount.fetch_add(1);
+    return writeMeta() && ok;
+}
+
+bool HashIndex::insert(int64_t key, const Ctid& ctid) {
+    HashEntry entry;
+    entry.key = key;
+    entry.ctid = ctid;
+    pthread_rwlock_rdlock(&splitLock);
+    if (directory.empty()) {
+        pthread_rwlock_unlock(&splitLock);
+        return false;
+    }
+    IndexPage primary = cache.pin(directory[bucketOf(hashKey(key))]);
+    int32_t rc = -1;
+    if (primary.data) {
+        cache.latch(primary, true);
+        rc = appendToChain(primary, entry);
+        cache.unlatch(primary);
+        cache.unpin(primary);
+    }
+    if (rc > 0) {
+        entryCount.fetch_add(1);
+    }
+    bool split = rc > 0 && needsSplit();
+    pthread_rwlock_unlock(&splitLock);
+
+    if (split) {
+        // one bucket per insert, another inserter may have split already
+        pthread_rwlock_wrlock(&splitLock);
+        if (needsSplit() && !splitNext()) {
+            LOG_ERROR("Split of hash index ID " << indexId << " failed");
+        }
+        pthread_rwlock_unlock(&splitLock);
+    }
+    if (rc < 0) {
+        LOG_ERROR("Insert into hash index ID " << indexId << " failed");
+    }
+    return rc >= 0;
+}
+
+bool HashIndex::remove(int64_t key, const Ctid& ctid) {
+    bool found = false;
+    pthread_rwlock_rdlock(&splitLock);
+    if (directory.empty()) {
+        pthread_rwlock_unlock(&splitLock);
+        return false;
+    }
+    IndexPage primary = cache.pin(directory[bucketOf(hashKey(key))]);
+    if (primary.data) {
+        cache.latch(primary, true);
+        IndexPage page = primary;
+        while (page.data && !found) {
+            HashBucketHeader* h = bucketHeader(page);
+            HashEntry* entries = bucketEntries(page);
+            for (uint16_t i = 0; i < h->count; ++i) {
+                if (entries[i].key == key && entries[i].ctid == ctid) {
+                    entries[i] = entries[--h->count];
+                    cache.markDirty(page);
+                    found = true;
+                    break;
+                }
+            }
+            int32_t next = h->next;
+            if (page.blockNum != primary.blockNum) {
+                cache.unlatch(page);
+                cache.unpin(page);
+            }
+            page = IndexPage();
+            if (!found && next >= 0) {
+                page = cache.pin(next);
+                cache.latch(page, true);
+            }
+        }
+        cache.unlatch(primary);
+        cache.unpin(primary);
+    }
+    if (found) {
+        entryCount.fetch_sub(1);
+    }
+    pthread_rwlock_unlock(&splitLock);
+    return found;
+}
+
+std::vector<Ctid> HashIndex::lookup(int64_t key) {
+    std::vector<Ctid> result;
+    pthread_rwlock_rdlock(&splitLock);
+    if (directory.empty()) {
+        pthread_rwlock_unlock(&splitLock);
+        return result;
+    }
+    IndexPage primary = cache.pin(directory[bucketOf(hashKey(key))]);
+    if (primary.data) {
+        cache.latch(primary, false);
+        IndexPage page = primary;
+        while (page.data) {
+            HashBucketHeader* h = bucketHeader(page);
+            HashEntry* entries = bucketEntries(page);
+            for (uint16_t i = 0; i < h->count; ++i) {
+                if (entries[i].key == key) {
+                    result.push_back(entries[i].ctid);
+                }
+            }
+            int32_t next = h->next;
+            if (page.blockNum != primary.blockNum) {
+                cache.unlatch(page);
+                cache.unpin(page);
+            }
+            page = IndexPage();
+            if (next >= 0) {
+                page = cache.pin(next);
+                cache.latch(page, false);
+            }
+        }
+        cache.unlatch(primary);
+        cache.unpin(primary);
+    }
+    pthread_rwlock_unlock(&splitLock);
+    return result;
+}
+
+bool HashIndex::buildFromTable(PageFile& table, int32_t tableId, const TupleCodec& codec, size_t column) {
+    bool ok = true;
+    bool scanned = scanColumnKeys(table, tableId, codec, column, [this, &ok](int64_t key, const Ctid& ctid) {
+        ok = insert(key, ctid) && ok;
+    });
+    return scanned && ok && flush();
+}
+
+bool HashIndex::flush() {
+    pthread_rwlock_rdlock(&splitLock);
+    bool ok = !directory.empty() && writeMeta() && cache.flush();
+    pthread_rwlock_unlock(&splitLock);
+    return ok;
+}
+
+uint32_t HashIndex::getBucketCount() {
+    pthread_rwlock_rdlock(&splitLock);
+    uint32_t count = static_cast<uint32_t>(directory.size());
+    pthread_rwlock_unlock(&splitLock);
+    return count;
+}
+
+int32_t addIndexedRow(SlottedPage& page, const TupleCodec& codec, const std::vector<allVars>& row, const std::vector<bool>& bitmap) {
+    int32_t slot = page.addRow(codec, row, bitmap);
+    if (slot < 0) {
+        return slot;
+    }
+    Ctid ctid;
+    ctid.blockNum = page.getBlockNum();
+    ctid.slot = static_cast<uint16_t>(slot);
+    bool hashed = sharedHashIndexes.indexRow(page.getTableId(), row, bitmap, ctid);
+    if (hashed && sharedBTreeIndexes.indexRow(page.getTableId(), row, bitmap, ctid)) {
+        return slot;
+    }
+    // a row an index misses would never be found through it: take out the keys
+    // that did go in and the row itself
+    LOG_ERROR("Indexes of table ID " << page.getTableId() << " did not take the row at block " << ctid.blockNum << " slot " << slot << ", the row is rolled back");
+    sharedHashIndexes.unindexRow(page.getTableId(), row, bitmap, ctid);
+    if (hashed) {
+        sharedBTreeIndexes.unindexRow(page.getTableId(), row, bitmap, ctid);
+    }
+    page.deleteTuple(slot);
+    return INDEXED_ROW_REJECTED;
+}
+
+bool deleteIndexedTuple(SlottedPage& page, const TupleCodec& codec, int32_t slot) {
+    uint16_t length = 0;
+    const uint8_t* tuple = page.getTuple(slot, &length);
+    if (tuple == nullptr) {
+        return false;
+    }
+    std::vector<allVars> row;
+    std::vector<bool> bitmap;
+    Ctid ctid;
+    ctid.blockNum = page.getBlockNum();
+    ctid.slot = static_cast<uint16_t>(slot);
+    if (!codec.decode(tuple, length, row, bitmap)) {
+        LOG_ERROR("Row at block " << ctid.blockNum << " slot " << slot << " of table ID " << page.getTableId() << " does not decode, its index entries stay");
+    } else {
+        if (!sharedHashIndexes.unindexRow(page.getTableId(), row, bitmap, ctid)) {
+            LOG_ERROR("Hash indexes of table ID " << page.getTableId() << " had no entry for the row at block " << ctid.blockNum << " slot " << slot);
+        }
+        if (!sharedBTreeIndexes.unindexRow(page.getTableId(), row, bitmap, ctid)) {
+            LOG_ERROR("B-tree indexes of table ID " << page.getTableId() << " had no entry for the row at block " << ctid.blockNum << " slot " << slot);
+        }
+    }
+    return page.deleteTuple(slot);
+}
@@ -0,0 +1,113 @@
+#ifndef HASHINDEX_H
+#define HASHINDEX_H
+
+#include <pthread.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "indexPageCache.h"
+#include "indexRegistry.h"
+#include "pageFile.h"
+#include "slottedPage.h"
+#include "tupleCodec.h"
+
+// Linear hash index (Litwin) for equality lookups on an integer column. Each
+// bucket is a chain of 8 KB pages of the index's IndexPageCache: a primary
+// page and overflow pages. When the average bucket passes the fill limit the
+// next bucket in line is split in two, one bucket per insert, so the table
+// grows a bucket at a time and no insert pays for a full rehash.
+//
+// Inserts and lookups hold splitLock shared and latch the bucket's primary
+// page (exclusive to change the chain, shared to read it), then its overflow
+// pages in chain order. A split holds splitLock exclusive, it only touches two
+// buckets. Block 0 is the metapage, the bucket -> primary block directory is
+// kept in directory pages listed in the metapage.
+
+constexpr uint8_t PAGE_FORMAT_HASH = 4;
+constexpr uint32_t HASH_INDEX_INITIAL_BUCKETS = 4;      // power of two
+constexpr int32_t HASH_INDEX_FILL_PERCENT = 75;         // of a page, average per bucket before a split
+
+struct HashEntry {
+    int64_t key = 0;
+    Ctid ctid;
+};
+
+struct HashBucketHeader {
+    uint32_t bucket;
+    uint16_t count;
+    uint16_t pad;
+    int32_t next;        // next page of the chain, -1 for the last one
+    int32_t pad2;
+};
+
+class HashIndex {
+    private:
+        int32_t indexId;
+        IndexPageCache cache;
+        pthread_rwlock_t splitLock;
+        std::mutex freeMutex;                    // free list of overflow pages
+        // metapage state, changed under splitLock exclusive
+        uint32_t initialBuckets = HASH_INDEX_INITIAL_BUCKETS;
+        uint32_t level = 0;
+        uint32_t nextSplit = 0;
+        std::vector<int32_t> directory;          // bucket -> primary block
+        std::vector<int32_t> dirBlocks;
+        int32_t freeOverflow = -1;
+        std::atomic<int64_t> entryCount{0};
+        std::atomic<int64_t> splitCount{0};
+
+        uint32_t bucketOf(uint64_t hash) const;
+        void initBucketPage(const IndexPage& page, uint32_t bucket);
+        bool addBucket();
+        bool writeMeta();
+        bool loadMeta();
+        IndexPage newOverflow(uint32_t bucket);
+        int32_t appendToChain(const IndexPage& primary, const HashEntry& entry);
+        bool splitNext();
+        bool needsSplit() const;
+
+    public:
+        static const size_t BUCKET_CAPACITY;
+
+        explicit HashIndex(int32_t indexId, int32_t cacheFrames = INDEX_PAGE_CACHE_DEFAULT_FRAMES);
+        ~HashIndex();
+        HashIndex(const HashIndex&) = delete;
+        HashIndex& operator=(const HashIndex&) = delete;
+
+        // a new file starts with initialBuckets buckets (rounded up to a power of two)
+        bool open(const std::string& path, uint32_t initialBuckets = HASH_INDEX_INITIAL_BUCKETS);
+        void close();
+        bool flush();
+
+        // the same (key, ctid) twice is stored once
+        bool insert(int64_t key, const Ctid& ctid);
+        bool remove(int64_t key, const Ctid& ctid);
+        std::vector<Ctid> lookup(int64_t key);
+        // inserts every non-null value of the column over a scan of the table's row and PAX pages
+        bool buildFromTable(PageFile& table, int32_t tableId, const TupleCodec& codec, size_t column);
+
+        int32_t getIndexId() const { return indexId; }
+        uint32_t getBucketCount();
+        int64_t getEntryCount() const { return entryCount.load(); }
+        int64_t getSplitCount() const { return splitCount.load(); }
+        int64_t getPageReads() { return cache.getReads(); }
+};
+
+// tableId -> hash indexes on its columns
+typedef IndexRegistry<HashIndex> HashIndexRegistry;
+
+extern HashIndexRegistry sharedHashIndexes;
+
+constexpr int32_t INDEXED_ROW_REJECTED = -2;
+
+// SlottedPage::addRow that also updates the table's hash and B-tree indexes with the new ctid;
+// -1 when the row was not stored, INDEXED_ROW_REJECTED when an index failed and it was taken out again
+int32_t addIndexedRow(SlottedPage& page, const TupleCodec& codec, const std::vector<allVars>& row, const std::vector<bool>& bitmap);
+// SlottedPage::deleteTuple that first takes the row's keys out of the table's hash and B-tree indexes
+bool deleteIndexedTuple(SlottedPage& page, const TupleCodec& codec, int32_t slot);
+
+#endif
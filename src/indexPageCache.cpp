@@ -0,0 +1,211 @@
+#include <algorithm>
+#include <cstring>
+#include "indexPageCache.h"
+#include "slottedPage.h"
+#include "walGroupCommit.h"
+#include "../../bufforing-stm/src/log.h"
+
+IndexPageCache::IndexPageCache(int32_t frameCount) : frames(frameCount > 0 ? frameCount : 1) {
+    int32_t n = frames.getFrameCount();
+    frameBlock.assign(n, -1);
+    dirty.assign(n, false);
+    usage.assign(n, 0);
+    io = makeAsyncPageIo(4);
+}
+
+IndexPageCache::~IndexPageCache() {
+    close();
+}
+
+bool IndexPageCache::open(const std::string& path) {
+    close();
+    if (!frames.isReady() || !io || !file.open(path)) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(m);
+    blockCount = file.getBlockCount();
+    return true;
+}
+
+void IndexPageCache::close() {
+    if (!file.isOpen()) {
+        return;
+    }
+    flush();
+    std::lock_guard<std::mutex> lock(m);
+    blockToFrame.clear();
+    std::fill(frameBlock.begin(), frameBlock.end(), -1);
+    std::fill(dirty.begin(), dirty.end(), false);
+    file.close();
+}
+
+bool IndexPageCache::writeFrame(int32_t frame, int32_t blockNum) {
+    // write-ahead rule: the WAL record of the last change goes to disk before the page
+    uint64_t lsn = reinterpret_cast<const SlottedPageHeader*>(frames.frame(frame))->lsn;
+    if (wal && lsn > 0 && !wal->commit(lsn)) {
+        LOG_ERROR("WAL is not durable up to " << lsn << ", block " << blockNum << " of " << file.getPath() << " is not written");
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(ioMutex);
+    std::vector<PageRef> refs{{blockNum, frames.frame(frame)}};
+    std::vector<int32_t> results;
+    writes++;
+    return file.writePages(*io, refs, results) == 0;
+}
+
+bool IndexPageCache::readFrame(int32_t frame, int32_t blockNum) {
+    std::lock_guard<std::mutex> lock(ioMutex);
+    std::vector<PageRef> refs{{blockNum, frames.frame(frame)}};
+    std::vector<int32_t> results;
+    reads++;
+    return file.readPages(*io, refs, results) == 0;
+}
+
+// clock sweep over the unpinned frames, m held; a dirty victim is written first
+int32_t IndexPageCache::victimFrame() {
+    int32_t n = static_cast<int32_t>(frameBlock.size());
+    for (int32_t tries = 0; tries < n * 3; ++tries) {
+        int32_t frame = clockHand;
+        clockHand = (clockHand + 1) % n;
+        if (descs.isPinned(frame)) {
+            continue;
+        }
+        if (frameBlock[frame] >= 0 && usage[frame] > 0) {
+            usage[frame]--;
+            continue;
+        }
+        if (frameBlock[frame] >= 0) {
+            if (dirty[frame] && !writeFrame(frame, frameBlock[frame])) {
+                LOG_ERROR("Cannot write index block " << frameBlock[frame] << " of " << file.getPath());
+                continue;
+            }
+            dirty[frame] = false;
+            blockToFrame.erase(frameBlock[frame]);
+            frameBlock[frame] = -1;
+        }
+        return frame;
+    }
+    return -1;
+}
+
+IndexPage IndexPageCache::pinFrame(int32_t frame, int32_t blockNum) {
+    descs.pin(frame);
+    if (usage[frame] < 5) {
+        usage[frame]++;
+    }
+    IndexPage page;
+    page.blockNum = blockNum;
+    page.frame = frame;
+    page.data = frames.frame(frame);
+    return page;
+}
+
+IndexPage IndexPageCache::pin(int32_t blockNum) {
+    std::lock_guard<std::mutex> lock(m);
+    auto it = blockToFrame.find(blockNum);
+    if (it != blockToFrame.end()) {
+        return pinFrame(it->second, blockNum);
+    }
+    if (!file.isOpen() || blockNum < 0 || blockNum >= blockCount) {
+        return IndexPage();
+    }
+    int32_t frame = victimFrame();
+    if (frame < 0) {
+        LOG_ERROR("Every index page frame of " << file.getPath() << " is pinned");
+        return IndexPage();
+    }
+    if (!readFrame(frame, blockNum)) {
+        LOG_ERROR("Cannot read index block " << blockNum << " of " << file.getPath());
+        return IndexPage();
+    }
+    frameBlock[frame] = blockNum;
+    blockToFrame[blockNum] = frame;
+    return pinFrame(frame, blockNum);
+}
+
+IndexPage IndexPageCache::allocate() {
+    std::lock_guard<std::mutex> lock(m);
+    if (!file.isOpen()) {
+        return IndexPage();
+    }
+    int32_t frame = victimFrame();
+    if (frame < 0) {
+        LOG_ERROR("Every index page frame of " << file.getPath() << " is pinned");
+        return IndexPage();
+    }
+    int32_t blockNum = blockCount++;
+    memset(frames.frame(frame), 0, PAGE_FILE_BLOCK_SIZE);
+    frameBlock[frame] = blockNum;
+    blockToFrame[blockNum] = frame;
+    dirty[frame] = true;
+    return pinFrame(frame, blockNum);
+}
+
+void IndexPageCache::unpin(const IndexPage& page) {
+    if (page.frame >= 0) {
+        descs.unpin(page.frame);
+    }
+}
+
+void IndexPageCache::latch(const IndexPage& page, bool exclusive) {
+    if (page.frame >= 0) {
+        descs.lockContent(page.frame, exclusive);
+    }
+}
+
+void IndexPageCache::unlatch(const IndexPage& page) {
+    if (page.frame >= 0) {
+        descs.unlockContent(page.frame);
+    }
+}
+
+void IndexPageCache::markDirty(const IndexPage& page) {
+    if (page.frame >= 0) {
+        std::lock_guard<std::mutex> lock(m);
+        dirty[page.frame] = true;
+    }
+}
+
+bool IndexPageCache::flush() {
+    // pin the dirty pages and write them without m: a writer holding a latch may be
+    // waiting for m (allocate), so no latch is taken while m is held
+    std::vector<IndexPage> pages;
+    {
+        std::lock_guard<std::mutex> lock(m);
+        for (size_t f = 0; f < frameBlock.size(); ++f) {
+            if (frameBlock[f] >= 0 && dirty[f]) {
+                pages.push_back(pinFrame(static_cast<int32_t>(f), frameBlock[f]));
+            }
+        }
+    }
+    bool ok = true;
+    for (const IndexPage& page : pages) {
+        latch(page, false);
+        if (writeFrame(page.frame, page.blockNum)) {
+            std::lock_guard<std::mutex> lock(m);
+            dirty[page.frame] = false;
+        } else {
+            LOG_ERROR("Cannot write index block " << page.blockNum << " of " << file.getPath());
+            ok = false;
+        }
+        unlatch(page);
+        unpin(page);
+    }
+    std::lock_guard<std::mutex> lock(ioMutex);
+    return file.sync(*io) && ok;
+}
+
+int32_t IndexPageCache::getBlockCount() {
+    std::lock_guard<std::mutex> lock(m);
+    return blockCount;
+}
+
+int64_t IndexPageCache::getReads() {
+    std::lock_guard<std::mutex> lock(ioMutex);
+    return reads;
+}
+
+int64_t IndexPageCache::getWrites() {
+    std::lock_guard<std::mutex> lock(ioMutex);
+    return writes;
+}
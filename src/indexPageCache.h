@@ -0,0 +1,91 @@
+#ifndef INDEXPAGECACHE_H
+#define INDEXPAGECACHE_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "asyncPageIo.h"
+#include "bufferDesc.h"
+#include "framePool.h"
+#include "pageFile.h"
+
+class WalGroupCommit;
+
+// Buffer cache of one index file (or one TableHeap file). The shared
+// `buffers` vector only holds block8kb table blocks, so these pages are cached
+// here, built from the same parts as the shared pool: FramePool frames, pin
+// counts and content locks from a BufferDescTable, clock-sweep replacement
+// and PageFile I/O. A pinned page is never evicted; its content lock is the
+// page latch (shared to read, exclusive to change it, then markDirty).
+//
+// Misses are read with the cache mutex held, index trees are shallow and the
+// upper levels stay resident, so misses are rare once the cache is warm.
+//
+// With a WAL set, a page whose header carries an LSN (the lsn field of
+// SlottedPageHeader) is only written once the WAL is durable up to it.
+
+constexpr int32_t INDEX_PAGE_CACHE_DEFAULT_FRAMES = 256;   // 2 MB
+
+struct IndexPage {
+    int32_t blockNum = -1;
+    int32_t frame = -1;
+    uint8_t* data = nullptr;     // nullptr: the page could not be pinned
+};
+
+class IndexPageCache {
+    private:
+        PageFile file;
+        FramePool frames;
+        BufferDescTable descs;
+        std::unique_ptr<AsyncPageIo> io;
+        WalGroupCommit* wal = nullptr;
+        std::mutex m;
+        std::mutex ioMutex;                      // the engine is not thread safe, taken after m
+        std::unordered_map<int32_t, int32_t> blockToFrame;
+        std::vector<int32_t> frameBlock;         // -1: frame unused
+        std::vector<bool> dirty;
+        std::vector<uint8_t> usage;
+        int32_t clockHand = 0;
+        int32_t blockCount = 0;
+        int64_t reads = 0;
+        int64_t writes = 0;
+
+        int32_t victimFrame();
+        bool writeFrame(int32_t frame, int32_t blockNum);
+        bool readFrame(int32_t frame, int32_t blockNum);
+        IndexPage pinFrame(int32_t frame, int32_t blockNum);
+
+    public:
+        explicit IndexPageCache(int32_t frameCount = INDEX_PAGE_CACHE_DEFAULT_FRAMES);
+        ~IndexPageCache();
+        IndexPageCache(const IndexPageCache&) = delete;
+        IndexPageCache& operator=(const IndexPageCache&) = delete;
+
+        bool open(const std::string& path);
+        // writes the dirty pages back, no page may be pinned
+        void close();
+        bool isOpen() const { return file.isOpen(); }
+        // WAL the page LSNs refer to, nullptr for pages that are never logged
+        void setWal(WalGroupCommit* wal) { this->wal = wal; }
+
+        // page of the file, read in on a miss
+        IndexPage pin(int32_t blockNum);
+        // zeroed page appended to the file (written on flush or eviction)
+        IndexPage allocate();
+        void unpin(const IndexPage& page);
+        void latch(const IndexPage& page, bool exclusive);
+        void unlatch(const IndexPage& page);
+        // called with the exclusive latch held, after changing the page
+        void markDirty(const IndexPage& page);
+        // writes every dirty page and syncs the file
+        bool flush();
+
+        int32_t getBlockCount();
+        int64_t getReads();
+        int64_t getWrites();
+};
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef INDEXREGISTRY_H
+#define INDEXREGISTRY_H
+
+#include <pthread.h>
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "slottedPage.h"
+#include "tupleCodec.h"
+
+// int8..int64 column value as an index key, false for other types
+bool indexKeyOf(const allVars& value, int64_t& key);
+
+// tableId -> indexes on its columns, so the insert and delete paths keep them
+// in step with the table. Index is HashIndex or BTreeIndex, anything with
+// insert(key, ctid) and remove(key, ctid).
+template<typename Index>
+class IndexRegistry {
+    private:
+        struct Attached {
+            size_t column;
+            std::shared_ptr<Index> index;
+        };
+        pthread_rwlock_t lock;
+        std::unordered_map<int32_t, std::vector<Attached>> tables;
+
+        // f(index, key) for every index of the table the row has a non-null key for
+        template<typename F>
+        bool forEachKey(int32_t tableId, const std::vector<allVars>& row, const std::vector<bool>& bitmap, F f) {
+            std::vector<Attached> attached;
+            pthread_rwlock_rdlock(&lock);
+            auto it = tables.find(tableId);
+            if (it != tables.end()) {
+                attached = it->second;
+            }
+            pthread_rwlock_unlock(&lock);
+            // index changes (and splits) run without the registry lock
+            bool ok = true;
+            for (const Attached& a : attached) {
+                int64_t key;
+                if (a.column < row.size() && a.column < bitmap.size() && bitmap[a.column] && indexKeyOf(row[a.column], key)) {
+                    ok = f(*a.index, key) && ok;
+                }
+            }
+            return ok;
+        }
+    public:
+        IndexRegistry() { pthread_rwlock_init(&lock, nullptr); }
+        ~IndexRegistry() { pthread_rwlock_destroy(&lock); }
+        IndexRegistry(const IndexRegistry&) = delete;
+        IndexRegistry& operator=(const IndexRegistry&) = delete;
+
+        void attach(int32_t tableId, size_t column, std::shared_ptr<Index> index) {
+            pthread_rwlock_wrlock(&lock);
+            std::vector<Attached>& attached = tables[tableId];
+            attached.erase(std::remove_if(attached.begin(), attached.end(), [column](const Attached& a) { return a.column == column; }),
+                           attached.end());
+            attached.push_back({column, std::move(index)});
+            pthread_rwlock_unlock(&lock);
+        }
+        void detach(int32_t tableId) {
+            pthread_rwlock_wrlock(&lock);
+            tables.erase(tableId);
+            pthread_rwlock_unlock(&lock);
+        }
+        // index on the column or nullptr
+        std::shared_ptr<Index> get(int32_t tableId, size_t column) {
+            std::shared_ptr<Index> index;
+            pthread_rwlock_rdlock(&lock);
+            auto it = tables.find(tableId);
+            if (it != tables.end()) {
+                for (const Attached& a : it->second) {
+                    if (a.column == column) {
+                        index = a.index;
+                    }
+                }
+            }
+            pthread_rwlock_unlock(&lock);
+            return index;
+        }
+        // adds the row's keys to every index of the table, nulls are not indexed
+        bool indexRow(int32_t tableId, const std::vector<allVars>& row, const std::vector<bool>& bitmap, const Ctid& ctid) {
+            return forEachKey(tableId, row, bitmap, [&ctid](Index& index, int64_t key) {
+                return index.insert(key, ctid);
+            });
+        }
+        // removes the row's keys, called before its slot is freed so a reused slot is not found by old keys
+        bool unindexRow(int32_t tableId, const std::vector<allVars>& row, const std::vector<bool>& bitmap, const Ctid& ctid) {
+            return forEachKey(tableId, row, bitmap, [&ctid](Index& index, int64_t key) {
+                return index.remove(key, ctid);
+            });
+        }
+        void clear() {
+            pthread_rwlock_wrlock(&lock);
+            tables.clear();
+            pthread_rwlock_unlock(&lock);
+        }
+};
+
+#endif
@@ -0,0 +1,140 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "mappedPageFile.h"
+#include "../../bufforing-stm/src/log.h"
+
+MappedPageFile::~MappedPageFile() {
+    close();
+}
+
+bool MappedPageFile::open(const std::string& path, PageAccessHint hint, size_t reserve) {
+    close();
+    fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        LOG_ERROR("Cannot open " << path << " for mapping, errno " << errno);
+        return false;
+    }
+    this->path = path;
+    this->hint = hint;
+    reserve = (reserve + PAGE_FILE_BLOCK_SIZE - 1) / PAGE_FILE_BLOCK_SIZE * PAGE_FILE_BLOCK_SIZE;
+    void* region = mmap(nullptr, reserve, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (region == MAP_FAILED) {
+        LOG_ERROR("Cannot reserve " << reserve << " bytes for " << path << ", errno " << errno);
+        close();
+        return false;
+    }
+    base = static_cast<uint8_t*>(region);
+    reserved = reserve;
+    if (!refresh()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedPageFile::close() {
+    std::lock_guard<std::mutex> lock(remapMutex);
+    mappedSize.store(0, std::memory_order_release);
+    if (base) {
+        munmap(base, reserved);
+        base = nullptr;
+        reserved = 0;
+    }
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+bool MappedPageFile::refresh() {
+    std::lock_guard<std::mutex> lock(remapMutex);
+    if (fd < 0 || !base) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        return false;
+    }
+    // only whole blocks are served, a half written last block is left out
+    size_t size = static_cast<size_t>(st.st_size) / PAGE_FILE_BLOCK_SIZE * PAGE_FILE_BLOCK_SIZE;
+    bool fits = true;
+    if (size > reserved) {
+        LOG_ERROR(path << " outgrew its reserved mapping of " << reserved << " bytes");
+        size = reserved;
+        fits = false;
+    }
+    size_t mapped = mappedSize.load(std::memory_order_relaxed);
+    if (size <= mapped) {
+        return fits;
+    }
+    // the new blocks replace the reserved pages behind the mapped ones, blocks are page aligned
+    void* added = mmap(base + mapped, size - mapped, PROT_READ, MAP_SHARED | MAP_FIXED, fd, static_cast<off_t>(mapped));
+    if (added == MAP_FAILED) {
+        LOG_ERROR("mmap of " << path << " failed, errno " << errno);
+        return false;
+    }
+    applyHint(base + mapped, size - mapped, hint);
+    mappedSize.store(size, std::memory_order_release);
+    return fits;
+}
+
+void MappedPageFile::applyHint(uint8_t* begin, size_t length, PageAccessHint hint) {
+    int advice = MADV_NORMAL;
+    if (hint == PageAccessHint::SEQUENTIAL) {
+        advice = MADV_SEQUENTIAL;
+    } else if (hint == PageAccessHint::RANDOM) {
+        advice = MADV_RANDOM;
+    }
+    if (length > 0 && madvise(begin, length, advice) != 0) {
+        LOG_DEBUG("madvise failed, errno " << errno);
+    }
+}
+
+void MappedPageFile::setAccessHint(PageAccessHint hint) {
+    std::lock_guard<std::mutex> lock(remapMutex);
+    this->hint = hint;
+    applyHint(base, mappedSize.load(std::memory_order_relaxed), hint);
+}
+
+void MappedPageFile::prefetch(int32_t firstBlock, int32_t count) {
+    size_t size = mappedSize.load(std::memory_order_acquire);
+    if (firstBlock < 0 || count <= 0) {
+        return;
+    }
+    size_t begin = static_cast<size_t>(firstBlock) * PAGE_FILE_BLOCK_SIZE;
+    if (begin >= size) {
+        return;
+    }
+    size_t length = static_cast<size_t>(count) * PAGE_FILE_BLOCK_SIZE;
+    if (length > size - begin) {
+        length = size - begin;
+    }
+    madvise(base + begin, length, MADV_WILLNEED);
+}
+
+int32_t MappedPageFile::getBlockCount() const {
+    return static_cast<int32_t>(mappedSize.load(std::memory_order_acquire) / PAGE_FILE_BLOCK_SIZE);
+}
+
+const uint8_t* MappedPageFile::page(int32_t blockNum) const {
+    size_t size = mappedSize.load(std::memory_order_acquire);
+    if (blockNum < 0 || static_cast<size_t>(blockNum) >= size / PAGE_FILE_BLOCK_SIZE) {
+        return nullptr;
+    }
+    return base + static_cast<size_t>(blockNum) * PAGE_FILE_BLOCK_SIZE;
+}
+
+PageView readPageView(const MappedPageFile& file, int32_t tableId, int32_t blockNum) {
+    PageView view;
+    PinnedBuffer pinned = pinSharedBuffer(tableId, blockNum);
+    if (pinned.buffer && bufferIsDirty(pinned.buffer)) {
+        view.buffer = pinned;
+        return view;
+    }
+    unpinSharedBuffer(pinned);
+    view.data = file.page(blockNum);
+    return view;
+}
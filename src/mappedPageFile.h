@@ -0,0 +1,78 @@
+#ifndef MAPPEDPAGEFILE_H
+#define MAPPEDPAGEFILE_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include "bufferDesc.h"
+#include "pageFile.h"
+
+// Read-only mmap of a table data file for tables that fit in the page cache.
+// Clean blocks are read straight from the mapping: no copy into a block8kb
+// and no syscall per block. Writes never go through the mapping, dirty pages
+// are still written back by the shared buffers (pwrite into the same page
+// cache, so the mapping sees them once they are written).
+//
+// open() reserves address space for the file once (PROT_NONE, nothing is
+// mapped yet). When the file grows refresh() maps only the new blocks, in
+// place at the end of what is already mapped, so the base never moves and a
+// page pointer handed out earlier is valid for the lifetime of the open file.
+// A file that outgrows the reservation is served up to the reserved size.
+// Table files only grow; truncating a mapped file would SIGBUS its readers.
+
+// address space reserved by default, only the mapped part costs page tables
+constexpr size_t MAPPED_PAGE_FILE_RESERVE = static_cast<size_t>(64) << 30;
+
+enum class PageAccessHint : int8_t {
+    NORMAL = 0,
+    SEQUENTIAL = 1,   // MADV_SEQUENTIAL: aggressive read-ahead, pages dropped behind the scan
+    RANDOM = 2        // MADV_RANDOM: no read-ahead, for index lookups
+};
+
+class MappedPageFile {
+    private:
+        int fd = -1;
+        std::string path;
+        PageAccessHint hint = PageAccessHint::NORMAL;
+        std::mutex remapMutex;
+        uint8_t* base = nullptr;               // reserved region, fixed while open
+        size_t reserved = 0;
+        std::atomic<size_t> mappedSize{0};     // bytes of the file mapped at base
+
+        static void applyHint(uint8_t* begin, size_t length, PageAccessHint hint);
+
+    public:
+        MappedPageFile() = default;
+        ~MappedPageFile();
+        MappedPageFile(const MappedPageFile&) = delete;
+        MappedPageFile& operator=(const MappedPageFile&) = delete;
+
+        bool open(const std::string& path, PageAccessHint hint = PageAccessHint::NORMAL,
+                  size_t reserve = MAPPED_PAGE_FILE_RESERVE);
+        void close();
+        bool isOpen() const { return fd >= 0; }
+        // maps the blocks the file grew by, false on mmap failure or when the
+        // file outgrew the reservation (what was mapped stays served)
+        bool refresh();
+        void setAccessHint(PageAccessHint hint);
+        // MADV_WILLNEED for a run of blocks, read-ahead without touching them
+        void prefetch(int32_t firstBlock, int32_t count);
+
+        int32_t getBlockCount() const;
+        // PAGE_FILE_BLOCK_SIZE bytes of the block, nullptr past the mapped end
+        const uint8_t* page(int32_t blockNum) const;
+};
+
+// A block as a reader should see it. When the block sits dirty in the shared
+// buffers that copy is newer than the file: the buffer is returned pinned
+// (unpin it with unpinSharedBuffer) and data is nullptr. Otherwise data points
+// into the mapping, or is nullptr past the end of the file.
+struct PageView {
+    const uint8_t* data = nullptr;
+    PinnedBuffer buffer;
+};
+
+PageView readPageView(const MappedPageFile& file, int32_t tableId, int32_t blockNum);
+
+#endif
@@ -0,0 +1,106 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "pageFile.h"
+#include "../../bufforing-stm/src/log.h"
+
+PageFile::~PageFile() {
+    close();
+}
+
+bool PageFile::open(const std::string& path, bool direct) {
+    close();
+    this->direct = false;
+    if (direct) {
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC | O_DIRECT, 0644);
+        if (fd >= 0) {
+            this->direct = true;
+        } else if (errno == EINVAL) {
+            LOG_INFO("O_DIRECT not supported for " << path << ", using buffered I/O");
+        }
+    }
+    if (fd < 0) {
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    }
+    if (fd < 0) {
+        LOG_ERROR("Cannot open page file " << path << ", errno " << errno);
+        return false;
+    }
+    this->path = path;
+    return true;
+}
+
+void PageFile::close() {
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+int32_t PageFile::getBlockCount() const {
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        return 0;
+    }
+    return static_cast<int32_t>(st.st_size / PAGE_FILE_BLOCK_SIZE);
+}
+
+static std::vector<PageIoRequest> pageRequests(int fd, PageIoOp op, const std::vector<PageRef>& pages) {
+    std::vector<PageIoRequest> requests(pages.size());
+    for (size_t i = 0; i < pages.size(); ++i) {
+        requests[i].op = op;
+        requests[i].fd = fd;
+        requests[i].buf = pages[i].page;
+        requests[i].length = PAGE_FILE_BLOCK_SIZE;
+        requests[i].offset = static_cast<uint64_t>(pages[i].blockNum) * PAGE_FILE_BLOCK_SIZE;
+    }
+    return requests;
+}
+
+// O_DIRECT wants aligned buffers; misaligned pages are failed up front and left out of the batch
+static int32_t runDirect(AsyncPageIo& io, std::vector<PageIoRequest>& requests, std::vector<int32_t>& results) {
+    std::vector<size_t> positions;
+    std::vector<PageIoRequest> aligned;
+    for (size_t i = 0; i < requests.size(); ++i) {
+        if (reinterpret_cast<uintptr_t>(requests[i].buf) % PAGE_FILE_IO_ALIGN == 0) {
+            positions.push_back(i);
+            aligned.push_back(requests[i]);
+        }
+    }
+    if (aligned.size() == requests.size()) {
+        return runPageIo(io, requests, results);
+    }
+    std::vector<int32_t> alignedResults;
+    int32_t failed = runPageIo(io, aligned, alignedResults);
+    results.assign(requests.size(), -EINVAL);
+    for (size_t k = 0; k < positions.size(); ++k) {
+        results[positions[k]] = alignedResults[k];
+    }
+    return failed + static_cast<int32_t>(requests.size() - aligned.size());
+}
+
+int32_t PageFile::readPages(AsyncPageIo& io, const std::vector<PageRef>& pages, std::vector<int32_t>& results) {
+    std::vector<PageIoRequest> requests = pageRequests(fd, PageIoOp::READ, pages);
+    int32_t failed = direct ? runDirect(io, requests, results) : runPageIo(io, requests, results);
+    for (size_t i = 0; i < pages.size(); ++i) {
+        if (results[i] >= 0 && results[i] < static_cast<int32_t>(PAGE_FILE_BLOCK_SIZE)) {
+            memset(static_cast<char*>(pages[i].page) + results[i], 0, PAGE_FILE_BLOCK_SIZE - results[i]);
+        }
+    }
+    return failed;
+}
+
+int32_t PageFile::writePages(AsyncPageIo& io, const std::vector<PageRef>& pages, std::vector<int32_t>& results) {
+    std::vector<PageIoRequest> requests = pageRequests(fd, PageIoOp::WRITE, pages);
+    return direct ? runDirect(io, requests, results) : runPageIo(io, requests, results);
+}
+
+bool PageFile::sync(AsyncPageIo& io) {
+    std::vector<PageIoRequest> requests(1);
+    requests[0].op = PageIoOp::FSYNC;
+    requests[0].fd = fd;
+    std::vector<int32_t> results;
+    return runPageIo(io, requests, results) == 0;
+}
@@ -0,0 +1,56 @@
+#ifndef PAGEFILE_H
+#define PAGEFILE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "asyncPageIo.h"
+
+// A table data file seen as an array of 8 KB blocks. Reads and writes come in
+// batches and go through an AsyncPageIo engine owned by the caller, so the
+// evictor can write back all its victims and a loader can fetch a run of
+// blocks with one submit instead of one blocking call per block.
+//
+// In direct mode the file is opened with O_DIRECT: pages bypass the kernel
+// page cache, so they are not cached twice (shared buffers + page cache). The
+// page buffers must then be PAGE_FILE_IO_ALIGN aligned, FramePool frames are.
+
+constexpr uint32_t PAGE_FILE_BLOCK_SIZE = 8192;
+constexpr uint32_t PAGE_FILE_IO_ALIGN = 4096;
+
+struct PageRef {
+    int32_t blockNum = -1;
+    void* page = nullptr;    // PAGE_FILE_BLOCK_SIZE bytes
+};
+
+class PageFile {
+    private:
+        int fd = -1;
+        bool direct = false;
+        std::string path;
+    public:
+        PageFile() = default;
+        ~PageFile();
+        PageFile(const PageFile&) = delete;
+        PageFile& operator=(const PageFile&) = delete;
+
+        // creates the file when it does not exist; direct asks for O_DIRECT and falls
+        // back to buffered I/O on file systems that do not support it
+        bool open(const std::string& path, bool direct = false);
+        void close();
+        bool isOpen() const { return fd >= 0; }
+        bool isDirect() const { return direct; }
+        int getFd() const { return fd; }
+        const std::string& getPath() const { return path; }
+        int32_t getBlockCount() const;
+
+        // results[i] is the byte count for pages[i] or -errno; a block past the end
+        // of the file reads as zeros. In direct mode a misaligned page fails with
+        // -EINVAL without being submitted. Both return the number of failed pages.
+        int32_t readPages(AsyncPageIo& io, const std::vector<PageRef>& pages, std::vector<int32_t>& results);
+        int32_t writePages(AsyncPageIo& io, const std::vector<PageRef>& pages, std::vector<int32_t>& results);
+        // fdatasync through the engine, after the writes it has to cover completed
+        bool sync(AsyncPageIo& io);
+};
+
+#endif
@@ -0,0 +1,125 @@
+#include <pthread.h>
+#include <thread>
+#include "parallelScan.h"
+#include "../../bufforing-stm/src/log.h"
+
+ParallelScanCursor::ParallelScanCursor(int32_t firstBlock, int32_t endBlock, int32_t workers, int32_t chunkBlocks)
+    : nextBlock(firstBlock > 0 ? firstBlock : 0), endBlock(endBlock),
+      chunkBlocks(chunkBlocks > 0 ? chunkBlocks : 1), workers(workers > 0 ? workers : 1) {}
+
+bool ParallelScanCursor::claim(int32_t& first, int32_t& end) {
+    int32_t start = nextBlock.load(std::memory_order_relaxed);
+    while (start < endBlock) {
+        // once fewer than two full rounds are left, each claim takes a share of the rest
+        int32_t remaining = endBlock - start;
+        int32_t chunk = chunkBlocks;
+        if (remaining < chunkBlocks * workers * 2) {
+            chunk = remaining / (workers * 2);
+            if (chunk < 1) {
+                chunk = 1;
+            }
+            if (chunk > chunkBlocks) {
+                chunk = chunkBlocks;
+            }
+        }
+        if (nextBlock.compare_exchange_weak(start, start + chunk, std::memory_order_relaxed)) {
+            first = start;
+            end = start + chunk;
+            return true;
+        }
+    }
+    return false;
+}
+
+int32_t parallelScanWorkers(const ParallelScanOptions& options) {
+    int32_t workers = options.workers;
+    if (workers <= 0) {
+        workers = static_cast<int32_t>(std::thread::hardware_concurrency());
+    }
+    return workers > 0 ? workers : 1;
+}
+
+namespace {
+
+struct ScanShared {
+    PageFile* file;
+    int32_t tableId;
+    const std::function<void(int32_t, const ScanPage&)>* perPage;
+    const ParallelScanOptions* options;
+    ParallelScanCursor* cursor;
+    std::atomic<bool> failed{false};
+};
+
+struct WorkerArg {
+    ScanShared* shared;
+    int32_t index;
+};
+
+void* scanWorker(void* arg) {
+    WorkerArg* w = static_cast<WorkerArg*>(arg);
+    ScanShared* shared = w->shared;
+    TableScanOptions scanOptions = shared->options->scan;
+    scanOptions.endBlock = scanOptions.firstBlock;   // empty until the first claim
+    TableScan scan(*shared->file, shared->tableId, scanOptions);
+    if (!scan.isReady()) {
+        shared->failed.store(true);
+        return nullptr;
+    }
+    int32_t first;
+    int32_t end;
+    ScanPage page;
+    while (!shared->failed.load(std::memory_order_relaxed) && shared->cursor->claim(first, end)) {
+        scan.restart(first, end);
+        while (scan.next(page)) {
+            (*shared->perPage)(w->index, page);
+        }
+        if (scan.failed()) {
+            shared->failed.store(true);
+        }
+    }
+    return nullptr;
+}
+
+}
+
+bool runParallelScan(PageFile& file, int32_t tableId, const std::function<void(int32_t, const ScanPage&)>& perPage,
+                     const ParallelScanOptions& options) {
+    int32_t workers = parallelScanWorkers(options);
+    int32_t firstBlock = options.scan.firstBlock > 0 ? options.scan.firstBlock : 0;
+    int32_t endBlock = options.scan.endBlock >= 0 ? options.scan.endBlock : file.getBlockCount();
+    ParallelScanCursor cursor(firstBlock, endBlock, workers, options.chunkBlocks);
+    ScanShared shared;
+    shared.file = &file;
+    shared.tableId = tableId;
+    shared.perPage = &perPage;
+    shared.options = &options;
+    shared.cursor = &cursor;
+
+    std::vector<pthread_t> threads(workers);
+    std::vector<WorkerArg> args(workers);
+    std::vector<bool> started(workers, false);
+    for (int32_t i = 0; i < workers; ++i) {
+        args[i] = {&shared, i};
+        int rc = pthread_create(&threads[i], nullptr, &scanWorker, &args[i]);
+        if (rc != 0) {
+            // the running workers take over the chunks of the missing ones
+            LOG_ERROR("pthread_create for scan worker failed rc=" << rc);
+            continue;
+        }
+        started[i] = true;
+    }
+    bool anyStarted = false;
+    for (int32_t i = 0; i < workers; ++i) {
+        if (started[i]) {
+            pthread_join(threads[i], nullptr);
+            anyStarted = true;
+        }
+    }
+    if (!anyStarted) {
+        // no thread at all, scan on the caller's thread as worker 0
+        args[0] = {&shared, 0};
+        scanWorker(&args[0]);
+    }
+    LOG_DEBUG("Parallel scan of table ID " << tableId << " with " << workers << " workers done");
+    return !shared.failed.load();
+}
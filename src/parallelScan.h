@@ -0,0 +1,66 @@
+#ifndef PARALLELSCAN_H
+#define PARALLELSCAN_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "pageFile.h"
+#include "tableScan.h"
+
+// Parallel sequential scan. Workers take block ranges from one shared atomic
+// cursor instead of a fixed split, so a worker slowed down by a busy core or
+// a cold part of the file just claims fewer chunks. Each worker owns a
+// TableScan (ring and read-ahead) that restarts on every chunk it claims, runs
+// the filter/aggregate on its own partial result, and the partials are merged
+// once all workers are done - workers share nothing but the cursor.
+
+constexpr int32_t PARALLEL_SCAN_CHUNK_BLOCKS = 64;   // 512 KB per claim
+
+// Hands out [first, end) ranges of a block range. Chunks get smaller at the
+// end of the table (like the chunk ramp-down of PostgreSQL's parallel seqscan)
+// so the workers finish at about the same time.
+class ParallelScanCursor {
+    private:
+        std::atomic<int32_t> nextBlock;
+        int32_t endBlock;
+        int32_t chunkBlocks;
+        int32_t workers;
+    public:
+        ParallelScanCursor(int32_t firstBlock, int32_t endBlock, int32_t workers, int32_t chunkBlocks = PARALLEL_SCAN_CHUNK_BLOCKS);
+        // false when the range is used up
+        bool claim(int32_t& first, int32_t& end);
+};
+
+struct ParallelScanOptions {
+    int32_t workers = 0;                 // 0: one per core
+    int32_t chunkBlocks = PARALLEL_SCAN_CHUNK_BLOCKS;
+    TableScanOptions scan;               // ring, read-ahead, block range and backend of every worker
+};
+
+// Runs perPage(worker, page) on every block of the range, from options.workers
+// threads (worker is 0..workers-1). Returns false when a worker hit a read error;
+// the blocks it did not get to are not scanned.
+bool runParallelScan(PageFile& file, int32_t tableId, const std::function<void(int32_t, const ScanPage&)>& perPage,
+                     const ParallelScanOptions& options = ParallelScanOptions());
+
+int32_t parallelScanWorkers(const ParallelScanOptions& options);
+
+// Same with one Partial per worker (default constructed): scan(partial, page) folds a page into the
+// worker's partial, merge(result, partial) runs on the caller's thread at the end.
+template<typename Partial, typename ScanFn, typename MergeFn>
+bool parallelScan(PageFile& file, int32_t tableId, Partial& result, ScanFn scan, MergeFn merge,
+                  const ParallelScanOptions& options = ParallelScanOptions()) {
+    ParallelScanOptions fixed = options;
+    fixed.workers = parallelScanWorkers(options);
+    std::vector<Partial> partials(fixed.workers);
+    bool ok = runParallelScan(file, tableId, [&](int32_t worker, const ScanPage& page) {
+        scan(partials[worker], page);
+    }, fixed);
+    for (const Partial& partial : partials) {
+        merge(result, partial);
+    }
+    return ok;
+}
+
+#endif
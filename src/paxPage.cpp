@@ -0,0 +1,202 @@
+#include <cstring>
+#include <type_traits>
+#include "paxPage.h"
+
+static size_t align8(size_t value) {
+    return (value + 7) & ~static_cast<size_t>(7);
+}
+
+size_t PaxPage::columnSlotSize(uint8_t type) {
+    size_t size = tupleTypeSize(type);
+    return size > 0 ? size : 2 * sizeof(uint16_t);
+}
+
+const uint16_t* PaxPage::columnOffsets() const {
+    size_t start = align8(sizeof(SlottedPageHeader) + sizeof(PaxPageHeader) + pax()->natts);
+    return reinterpret_cast<const uint16_t*>(frame + start);
+}
+
+bool PaxPage::init(uint8_t* frame, int32_t tableId, int32_t blockNum, const std::vector<uint8_t>& types, uint16_t expectedStringSize) {
+    size_t natts = types.size();
+    size_t fixedStart = align8(align8(sizeof(SlottedPageHeader) + sizeof(PaxPageHeader) + natts) + natts * sizeof(uint16_t));
+    // bytes one row takes: its slot in every column array plus the expected string bytes,
+    // per column 8 more bytes for rounding the bitmap and the array up to 8
+    size_t rowBytes = 0;
+    for (uint8_t type : types) {
+        rowBytes += columnSlotSize(type) + (tupleTypeSize(type) == 0 ? expectedStringSize : 0);
+    }
+    if (natts == 0 || fixedStart + natts * 16 >= PAGE_FILE_BLOCK_SIZE) {
+        return false;
+    }
+    // capacity * (rowBytes + natts / 8) <= space, the bitmap costs 1/8 byte per row and column
+    size_t space = PAGE_FILE_BLOCK_SIZE - fixedStart - natts * 16;
+    size_t capacity = space * 8 / (rowBytes * 8 + natts);
+    if (capacity == 0) {
+        return false;
+    }
+    if (capacity > UINT16_MAX) {
+        capacity = UINT16_MAX;
+    }
+
+    memset(frame, 0, PAGE_FILE_BLOCK_SIZE);
+    SlottedPageHeader* h = reinterpret_cast<SlottedPageHeader*>(frame);
+    h->tableId = tableId;
+    h->blockNum = blockNum;
+    h->format = PAGE_FORMAT_PAX;
+    h->special = static_cast<uint16_t>(PAGE_FILE_BLOCK_SIZE);
+    PaxPageHeader* p = reinterpret_cast<PaxPageHeader*>(frame + sizeof(SlottedPageHeader));
+    p->natts = static_cast<uint16_t>(natts);
+    p->capacity = static_cast<uint16_t>(capacity);
+    memcpy(frame + sizeof(SlottedPageHeader) + sizeof(PaxPageHeader), types.data(), natts);
+    uint16_t* offsets = reinterpret_cast<uint16_t*>(frame + align8(sizeof(SlottedPageHeader) + sizeof(PaxPageHeader) + natts));
+    size_t offset = fixedStart;
+    for (size_t i = 0; i < natts; ++i) {
+        offsets[i] = static_cast<uint16_t>(offset);
+        offset += align8((capacity + 7) / 8) + align8(capacity * columnSlotSize(types[i]));
+    }
+    // lower/upper bound the free space between the column arrays and the string heap
+    h->lower = static_cast<uint16_t>(offset);
+    h->upper = static_cast<uint16_t>(PAGE_FILE_BLOCK_SIZE);
+    return offset <= PAGE_FILE_BLOCK_SIZE;
+}
+
+const uint8_t* PaxPage::columnNulls(size_t column) const {
+    return frame + columnOffsets()[column];
+}
+
+const uint8_t* PaxPage::columnValues(size_t column) const {
+    return frame + columnOffsets()[column] + align8((pax()->capacity + 7) / 8);
+}
+
+int32_t PaxPage::appendRow(const std::vector<allVars>& row, const std::vector<bool>& bitmap) {
+    PaxPageHeader* p = pax();
+    SlottedPageHeader* h = header();
+    size_t natts = p->natts;
+    if (p->rowCount >= p->capacity || row.size() != natts) {
+        return -1;
+    }
+    // check types and the string heap first, a rejected row leaves the page as it was
+    size_t stringBytes = 0;
+    for (size_t i = 0; i < natts; ++i) {
+        if (row[i].index() != types()[i]) {
+            return -1;
+        }
+        const std::string* s = std::get_if<std::string>(&row[i]);
+        if (s && i < bitmap.size() && bitmap[i]) {
+            stringBytes += s->size();
+        }
+    }
+    if (stringBytes > static_cast<size_t>(h->upper - h->lower)) {
+        return -1;
+    }
+    uint16_t r = p->rowCount;
+    for (size_t i = 0; i < natts; ++i) {
+        bool present = i < bitmap.size() && bitmap[i];
+        uint8_t* nulls = const_cast<uint8_t*>(columnNulls(i));
+        uint8_t* values = const_cast<uint8_t*>(columnValues(i));
+        if (present) {
+            nulls[r >> 3] |= static_cast<uint8_t>(1u << (r & 7));
+        }
+        uint8_t type = types()[i];
+        if (type == TUPLE_TYPE_STRING) {
+            const std::string& s = *std::get_if<std::string>(&row[i]);
+            uint16_t ref[2] = {0, 0};
+            if (present) {
+                h->upper = static_cast<uint16_t>(h->upper - s.size());
+                memcpy(frame + h->upper, s.data(), s.size());
+                ref[0] = h->upper;
+                ref[1] = static_cast<uint16_t>(s.size());
+            }
+            memcpy(values + r * sizeof(ref), ref, sizeof(ref));
+            continue;
+        }
+        if (!present) {
+            continue;   // arrays start zeroed
+        }
+        std::visit([values, r](const auto& value) {
+            typedef std::decay_t<decltype(value)> V;
+            if constexpr (std::is_same<V, bool>::value) {
+                values[r] = value ? 1 : 0;
+            } else if constexpr (std::is_arithmetic<V>::value) {
+                memcpy(values + r * sizeof(V), &value, sizeof(V));
+            }
+        }, row[i]);
+    }
+    p->rowCount++;
+    return r;
+}
+
+bool PaxPage::readRow(int32_t rowIndex, std::vector<allVars>& row, std::vector<bool>& bitmap) const {
+    if (rowIndex < 0 || rowIndex >= pax()->rowCount) {
+        return false;
+    }
+    size_t natts = pax()->natts;
+    row.resize(natts);
+    bitmap.resize(natts);
+    for (size_t i = 0; i < natts; ++i) {
+        bitmap[i] = (columnNulls(i)[rowIndex >> 3] >> (rowIndex & 7)) & 1;
+        const uint8_t* v = columnValues(i);
+        switch (types()[i]) {
+            case TUPLE_TYPE_INT8: row[i] = columnArray<int8_t>(i)[rowIndex]; break;
+            case TUPLE_TYPE_INT16: { int16_t x; memcpy(&x, v + rowIndex * 2, 2); row[i] = x; break; }
+            case TUPLE_TYPE_INT32: { int32_t x; memcpy(&x, v + rowIndex * 4, 4); row[i] = x; break; }
+            case TUPLE_TYPE_INT64: { int64_t x; memcpy(&x, v + rowIndex * 8, 8); row[i] = x; break; }
+            case TUPLE_TYPE_BOOL: row[i] = v[rowIndex] != 0; break;
+            default: {
+                std::string s;
+                getString(i, rowIndex, s);
+                row[i] = std::move(s);
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+bool PaxPage::getString(size_t column, int32_t rowIndex, std::string& out) const {
+    if (column >= pax()->natts || types()[column] != TUPLE_TYPE_STRING || rowIndex < 0 || rowIndex >= pax()->rowCount ||
+        !((columnNulls(column)[rowIndex >> 3] >> (rowIndex & 7)) & 1)) {
+        return false;
+    }
+    uint16_t ref[2];
+    memcpy(ref, columnValues(column) + rowIndex * sizeof(ref), sizeof(ref));
+    out.assign(reinterpret_cast<const char*>(frame + ref[0]), ref[1]);
+    return true;
+}
+
+int64_t PaxPage::countNotNull(size_t column) const {
+    const uint8_t* nulls = columnNulls(column);
+    size_t rows = pax()->rowCount;
+    int64_t count = 0;
+    size_t full = rows / 64;
+    for (size_t w = 0; w < full; ++w) {
+        uint64_t word;
+        memcpy(&word, nulls + w * 8, sizeof(word));
+        count += __builtin_popcountll(word);
+    }
+    for (size_t r = full * 64; r < rows; ++r) {
+        count += (nulls[r >> 3] >> (r & 7)) & 1;
+    }
+    return count;
+}
+
+template<typename T>
+static int64_t sumArray(const T* values, size_t rows) {
+    // plain loop over a packed array, the compiler vectorizes it
+    int64_t sum = 0;
+    for (size_t r = 0; r < rows; ++r) {
+        sum += values[r];
+    }
+    return sum;
+}
+
+int64_t PaxPage::sumColumn(size_t column) const {
+    size_t rows = pax()->rowCount;
+    switch (column < pax()->natts ? types()[column] : 0xff) {
+        case TUPLE_TYPE_INT8: return sumArray(columnArray<int8_t>(column), rows);
+        case TUPLE_TYPE_INT16: return sumArray(columnArray<int16_t>(column), rows);
+        case TUPLE_TYPE_INT32: return sumArray(columnArray<int32_t>(column), rows);
+        case TUPLE_TYPE_INT64: return sumArray(columnArray<int64_t>(column), rows);
+        default: return 0;
+    }
+}
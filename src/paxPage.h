@@ -0,0 +1,90 @@
+#ifndef PAXPAGE_H
+#define PAXPAGE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "slottedPage.h"
+#include "tupleCodec.h"
+#include "tupleFormat.h"
+
+// Columnar (PAX) 8 KB page for analytic tables. The rows of the page are
+// stored column by column: each column has its own null bitmap and a packed
+// value array, so a scan of one column reads only that column's bytes and
+// runs over a plain array (null values are stored as zero, a sum does not
+// even look at the bitmap). Strings keep [uint16 offset][uint16 length] in
+// their array and the bytes in a heap growing down from the end of the page.
+//
+// The page starts with the same SlottedPageHeader as a row page, format
+// PAGE_FORMAT_PAX, so both kinds sit in the same shared buffers and files and
+// the header's format byte tells them apart. Layout after it:
+//
+//   [PaxPageHeader][types][column offsets][col 0: nulls|values][col 1 ...] free [string heap]
+
+constexpr uint8_t PAGE_FORMAT_PAX = static_cast<uint8_t>(TableStorage::PAX);
+static_assert(PAGE_FORMAT_ROW == static_cast<uint8_t>(TableStorage::ROW), "table storage is the page format byte");
+constexpr uint16_t PAX_DEFAULT_STRING_SIZE = 16;   // expected bytes per string when sizing the page
+
+struct PaxPageHeader {
+    uint16_t natts;
+    uint16_t capacity;   // rows the column arrays have room for
+    uint16_t rowCount;
+    uint16_t pad;
+};
+
+class PaxPage {
+    private:
+        uint8_t* frame;
+        SlottedPageHeader* header() const { return reinterpret_cast<SlottedPageHeader*>(frame); }
+        PaxPageHeader* pax() const { return reinterpret_cast<PaxPageHeader*>(frame + sizeof(SlottedPageHeader)); }
+        const uint8_t* types() const { return frame + sizeof(SlottedPageHeader) + sizeof(PaxPageHeader); }
+        const uint16_t* columnOffsets() const;
+        static size_t columnSlotSize(uint8_t type);
+
+    public:
+        explicit PaxPage(uint8_t* frame) : frame(frame) {}
+
+        // empty page for a table with these column types (TUPLE_TYPE_*); the row capacity is
+        // chosen so the column arrays and expectedStringSize bytes per string fill the page.
+        // false when one row would not fit
+        static bool init(uint8_t* frame, int32_t tableId, int32_t blockNum, const std::vector<uint8_t>& types,
+                         uint16_t expectedStringSize = PAX_DEFAULT_STRING_SIZE);
+        static bool init(uint8_t* frame, int32_t tableId, int32_t blockNum, const TupleCodec& codec,
+                         uint16_t expectedStringSize = PAX_DEFAULT_STRING_SIZE) {
+            return init(frame, tableId, blockNum, codec.getTypes(), expectedStringSize);
+        }
+        static bool isPax(const uint8_t* frame) { return reinterpret_cast<const SlottedPageHeader*>(frame)->format == PAGE_FORMAT_PAX; }
+
+        uint8_t* data() const { return frame; }
+        int32_t getTableId() const { return header()->tableId; }
+        int32_t getBlockNum() const { return header()->blockNum; }
+        uint64_t getLsn() const { return header()->lsn; }
+        void setLsn(uint64_t lsn) { header()->lsn = lsn; }
+        uint16_t getColumnCount() const { return pax()->natts; }
+        uint16_t getCapacity() const { return pax()->capacity; }
+        uint16_t getRowCount() const { return pax()->rowCount; }
+        uint8_t getColumnType(size_t column) const { return types()[column]; }
+
+        // row number in the page, -1 when the page is full or the row does not match the types
+        int32_t appendRow(const std::vector<allVars>& row, const std::vector<bool>& bitmap);
+        bool readRow(int32_t rowIndex, std::vector<allVars>& row, std::vector<bool>& bitmap) const;
+
+        // bit r set = row r not null
+        const uint8_t* columnNulls(size_t column) const;
+        // getRowCount() packed values of a fixed-width column, nulls are zero
+        const uint8_t* columnValues(size_t column) const;
+        template<typename T>
+        const T* columnArray(size_t column) const {
+            return tupleTypeSize(getColumnType(column)) == sizeof(T) ? reinterpret_cast<const T*>(columnValues(column)) : nullptr;
+        }
+        // string of a row, false for null or non-string columns
+        bool getString(size_t column, int32_t rowIndex, std::string& out) const;
+
+        // column scans, one array each
+        int64_t countNotNull(size_t column) const;
+        // sum of an int column (nulls add zero)
+        int64_t sumColumn(size_t column) const;
+};
+
+#endif
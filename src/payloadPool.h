@@ -0,0 +1,80 @@
+#ifndef PAYLOADPOOL_H
+#define PAYLOADPOOL_H
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Slab pool for task payloads. Objects are carved out of slabs of
+// PAYLOAD_POOL_SLAB and go back to the free list when the task that owned them
+// is destroyed, so a session in steady state does not touch malloc for its
+// payloads and its memory is bounded by the most payloads it ever had in
+// flight. The lock is per pool (per session), not the global malloc one.
+
+constexpr size_t PAYLOAD_POOL_SLAB = 64;
+
+template<typename T>
+class PayloadPool;
+
+// unique_ptr deleter: back to the pool, or plain delete for objects made with new
+template<typename T>
+struct PoolDeleter {
+    PayloadPool<T>* pool = nullptr;
+    void operator()(T* p) const {
+        if (pool) {
+            pool->release(p);
+        } else {
+            delete p;
+        }
+    }
+};
+
+template<typename T>
+using PooledPtr = std::unique_ptr<T, PoolDeleter<T>>;
+
+template<typename T>
+class PayloadPool {
+    private:
+        std::mutex m;
+        std::vector<std::unique_ptr<T[]>> slabs;
+        std::vector<T*> freeList;
+
+    public:
+        PayloadPool() = default;
+        PayloadPool(const PayloadPool&) = delete;
+        PayloadPool& operator=(const PayloadPool&) = delete;
+
+        // object in its default state, owned by the returned pointer
+        PooledPtr<T> acquire() {
+            std::lock_guard<std::mutex> lock(m);
+            if (freeList.empty()) {
+                slabs.emplace_back(new T[PAYLOAD_POOL_SLAB]);
+                T* slab = slabs.back().get();
+                freeList.reserve(slabs.size() * PAYLOAD_POOL_SLAB);
+                for (size_t i = PAYLOAD_POOL_SLAB; i > 0; --i) {
+                    freeList.push_back(&slab[i - 1]);
+                }
+            }
+            T* p = freeList.back();
+            freeList.pop_back();
+            return PooledPtr<T>(p, PoolDeleter<T>{this});
+        }
+
+        void release(T* p) {
+            *p = T();   // drops whatever the task left behind (rows of a task that never ran)
+            std::lock_guard<std::mutex> lock(m);
+            freeList.push_back(p);
+        }
+
+        size_t getCapacity() {
+            std::lock_guard<std::mutex> lock(m);
+            return slabs.size() * PAYLOAD_POOL_SLAB;
+        }
+        size_t getFreeCount() {
+            std::lock_guard<std::mutex> lock(m);
+            return freeList.size();
+        }
+};
+
+#endif
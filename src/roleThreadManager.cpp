@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <random>
+#include <unordered_map>
 #include "roleThreadManager.h"
 
 std::pair<int32_t,Session*> startSession(std::string username, std::string passwd,int32_t ttl,int64_t xactionId,std::string tablePath){
@@ -7,40 +10,64 @@ std::pair<int32_t,Session*> startSession(std::string username, std::string passw
 	return {session->getThreadId(), session};
 }
 
-void addBuser(std::string newUsername, std::string newPasswd, std::string newEmail, bool useHashing, std::string sessionUsername, std::string sessionPasswd){
+TaskHandle addBuser(std::string newUsername, std::string newPasswd, std::string newEmail, bool useHashing, std::string sessionUsername, std::string sessionPasswd){
 	Task t;
 	t.user = new buser(getNextUserId(), newUsername, newPasswd, newEmail, useHashing);
 	pthread_mutex_lock(&processBufferMutex);
 	for (size_t i = 0; i < processBuffer.size(); i++){
 		if(checkUserProcess(sessionUsername, sessionPasswd)){
 			Session* session = processBuffer[i];
-			session->submit(t, 1);
+			TaskHandle handle = session->submit(std::move(t), 1);
 			pthread_mutex_unlock(&processBufferMutex);
-			return;
+			if (!handle.valid()) {
+				delete t.user;   // cancelled, the user was never handed over
+			}
+			return handle;
 		}
 	}
 	pthread_mutex_unlock(&processBufferMutex);
+	delete t.user;
+	return TaskHandle();
 }
 
 
-void addTuple(std::string pathToTablesData, int32_t tableId, std::vector<allVars> data, std::vector<bool> bitmap, std::string sessionUsername, std::string sessionPasswd){
-	Task t;
-	tupleAdd* tupleData = new tupleAdd();
-	tupleData->pathToTablesData = pathToTablesData;
-	tupleData->tableId = tableId;
-	tupleData->data = data;
-	tupleData->bitmap = bitmap;
-	t.tupleData = tupleData;
+TaskHandle addTuple(std::string pathToTablesData, int32_t tableId, std::vector<allVars> data, std::vector<bool> bitmap, std::string sessionUsername, std::string sessionPasswd){
 	for (size_t i = 0; i < processBuffer.size(); i++){
 		if(checkUserProcess(sessionUsername, sessionPasswd)){
 			Session* session = processBuffer[i];
 			pthread_mutex_lock(&processBufferMutex);
-			session->submit(t, 1);
+			TaskHandle handle = session->addTuple(std::move(pathToTablesData), tableId, std::move(data), std::move(bitmap));
 			pthread_mutex_unlock(&processBufferMutex);
-			return;
+			return handle;
 		}
 	}
 	LOG_ERROR("No session found for user "<<sessionUsername<<"\n");
+	return TaskHandle();
+}
+TaskHandle addTuples(std::string pathToTablesData, int32_t tableId, std::vector<std::vector<allVars>> rows, std::vector<std::vector<bool>> bitmaps, std::string sessionUsername, std::string sessionPasswd){
+	if (rows.size() != bitmaps.size()){
+		LOG_ERROR("addTuples: "<<rows.size()<<" rows but "<<bitmaps.size()<<" bitmaps for table ID "<<tableId<<"\n");
+		return TaskHandle();
+	}
+	if (rows.empty()){
+		return TaskHandle();
+	}
+	for (size_t i = 0; i < processBuffer.size(); i++){
+		if(checkUserProcess(sessionUsername, sessionPasswd)){
+			Session* session = processBuffer[i];
+			std::unique_ptr<tuplesAdd> tuplesData(new tuplesAdd());
+			tuplesData->pathToTablesData = std::move(pathToTablesData);
+			tuplesData->tableId = tableId;
+			tuplesData->rows = std::move(rows);
+			tuplesData->bitmaps = std::move(bitmaps);
+			pthread_mutex_lock(&processBufferMutex);
+			TaskHandle handle = session->addTuples(std::move(tuplesData));
+			pthread_mutex_unlock(&processBufferMutex);
+			return handle;
+		}
+	}
+	LOG_ERROR("No session found for user "<<sessionUsername<<"\n");
+	return TaskHandle();
 }
 void waitForAllProcessesToFinish(){
 	pthread_mutex_lock(&processBufferMutex);
@@ -54,28 +81,138 @@ void waitForAllProcessesToFinish(){
 }
 
 
-void addTable(std::string sessionUsername, std::string sessionPasswd,std::vector<int8_t> types,std::vector<int8_t> typesWithAllowNull,std::vector<std::string> columnNames,int32_t tableId){
+static TaskHandle submitTable(Session* session, std::vector<int8_t>& types, std::vector<int8_t>& typesWithAllowNull, std::vector<std::string>& columnNames, int32_t tableId, TaskCallback onComplete = nullptr){
+	tableHeaderAdd* tableAddPtr = new tableHeaderAdd();
+	tableHeader* tableHeaderPtr = new tableHeader();
+	pthread_mutex_lock(&processBufferMutex);
+	int64_t transactionId = getTransactionAndIncrement();
+	pthread_mutex_unlock(&processBufferMutex);
+	LOG_DEBUG("transactionId for table header: "<<transactionId<<"\n");
+	tableHeaderPtr->setData(transactionId,-1,-1,0,static_cast<int32_t>(columnNames.size()),session->getUserId(),0,0,0,0,types,typesWithAllowNull,columnNames);
+	tableAddPtr->tableHeaderData = tableHeaderPtr;
+	//tableAddPtr->tableHeaderData->setData(getTransactionAndIncrement(),-1,-1,0,static_cast<int32_t>(columnNames.size()),session->getUserId(),0,0,0,0,types,typesWithAllowNull,columnNames);
+	tableAddPtr->tableId = tableId;
+	tableAddPtr->types = types;
+	tableAddPtr->typesWithAllowNull = typesWithAllowNull;
+	tableAddPtr->columnNames = columnNames;
+	pthread_mutex_lock(&processBufferMutex);
+	TaskHandle handle = session->addTable(tableAddPtr, std::move(onComplete));
+	pthread_mutex_unlock(&processBufferMutex);
+	return handle;
+}
+
+TaskHandle addTable(std::string sessionUsername, std::string sessionPasswd,std::vector<int8_t> types,std::vector<int8_t> typesWithAllowNull,std::vector<std::string> columnNames,int32_t tableId){
 	LOG_DEBUG("Adding table through session for user "<<sessionUsername<<"\n");
 	for (size_t i = 0; i < processBuffer.size(); i++){
 		if(checkUserProcess(sessionUsername, sessionPasswd)){
 			LOG_DEBUG("Found session for user "<<sessionUsername<<"\n");
 			Session* session = processBuffer[i];
-			tableHeaderAdd* tableAddPtr = new tableHeaderAdd();
-			tableHeader* tableHeaderPtr = new tableHeader();
-			pthread_mutex_lock(&processBufferMutex);
-			int64_t transactionId = getTransactionAndIncrement();
-			pthread_mutex_unlock(&processBufferMutex);
-			LOG_DEBUG("transactionId for table header: "<<transactionId<<"\n");
-			tableHeaderPtr->setData(transactionId,-1,-1,0,static_cast<int32_t>(columnNames.size()),session->getUserId(),0,0,0,0,types,typesWithAllowNull,columnNames);
-			tableAddPtr->tableHeaderData = new tableHeader();
-			tableAddPtr->tableHeaderData = tableHeaderPtr;
-			//tableAddPtr->tableHeaderData->setData(getTransactionAndIncrement(),-1,-1,0,static_cast<int32_t>(columnNames.size()),session->getUserId(),0,0,0,0,types,typesWithAllowNull,columnNames);
-			tableAddPtr->tableId = tableId;
-			pthread_mutex_lock(&processBufferMutex);
-			session->addTable(tableAddPtr);
-			pthread_mutex_unlock(&processBufferMutex);
-			return;
+			return submitTable(session, types, typesWithAllowNull, columnNames, tableId);
 		}
 	}
 	LOG_ERROR("No session found for user "<<sessionUsername<<"\n");
+	return TaskHandle();
+}
+
+static pthread_rwlock_t sessionHandlesLock = PTHREAD_RWLOCK_INITIALIZER;
+static std::unordered_map<SessionHandle, Session*> sessionHandles;
+
+// random so a handle cannot be guessed from another one; called with the write lock held
+static SessionHandle newSessionHandle(){
+	static std::mt19937_64 generator{std::random_device{}()};
+	SessionHandle handle;
+	do {
+		handle = static_cast<SessionHandle>(generator() >> 1);
+	} while (handle == INVALID_SESSION_HANDLE || sessionHandles.count(handle) != 0);
+	return handle;
+}
+
+// returns f(session) with the handle map read-locked, an invalid TaskHandle for an unknown handle
+template<typename F>
+static TaskHandle withSession(SessionHandle handle, F f){
+	pthread_rwlock_rdlock(&sessionHandlesLock);
+	auto it = sessionHandles.find(handle);
+	if (it == sessionHandles.end()){
+		pthread_rwlock_unlock(&sessionHandlesLock);
+		LOG_ERROR("Unknown session handle "<<handle<<"\n");
+		return TaskHandle();
+	}
+	TaskHandle result = f(it->second);
+	pthread_rwlock_unlock(&sessionHandlesLock);
+	return result;
+}
+
+// takes a session of startSession out of processBuffer and frees it; ~Session stops it first
+static void dropSession(Session* session){
+	pthread_mutex_lock(&processBufferMutex);
+	processBuffer.erase(std::remove(processBuffer.begin(), processBuffer.end(), session), processBuffer.end());
+	pthread_mutex_unlock(&processBufferMutex);
+	delete session;
+}
+
+SessionHandle openSession(std::string username, std::string passwd, int32_t ttl, int64_t xactionId, std::string tablePath){
+	std::pair<int32_t,Session*> started = startSession(username, passwd, ttl, xactionId, tablePath);
+	if (started.first != 0){
+		dropSession(started.second);
+		return INVALID_SESSION_HANDLE;
+	}
+	pthread_rwlock_wrlock(&sessionHandlesLock);
+	SessionHandle handle = newSessionHandle();
+	sessionHandles[handle] = started.second;
+	pthread_rwlock_unlock(&sessionHandlesLock);
+	return handle;
+}
+
+void closeSession(SessionHandle handle){
+	Session* session = nullptr;
+	pthread_rwlock_wrlock(&sessionHandlesLock);
+	auto it = sessionHandles.find(handle);
+	if (it != sessionHandles.end()){
+		session = it->second;
+		sessionHandles.erase(it);
+	}
+	pthread_rwlock_unlock(&sessionHandlesLock);
+	if (session != nullptr){
+		dropSession(session);   // no withSession call can still use it, they hold the read lock
+	}
+}
+
+bool isSessionOpen(SessionHandle handle){
+	pthread_rwlock_rdlock(&sessionHandlesLock);
+	bool open = sessionHandles.count(handle) != 0;
+	pthread_rwlock_unlock(&sessionHandlesLock);
+	return open;
+}
+
+TaskHandle addBuser(SessionHandle handle, std::string newUsername, std::string newPasswd, std::string newEmail, bool useHashing, TaskCallback onComplete){
+	return withSession(handle, [&](Session* session){
+		return session->addBuser(new buser(getNextUserId(), newUsername, newPasswd, newEmail, useHashing), std::move(onComplete));
+	});
+}
+
+TaskHandle addTuple(SessionHandle handle, std::string pathToTablesData, int32_t tableId, std::vector<allVars> data, std::vector<bool> bitmap, TaskCallback onComplete){
+	return withSession(handle, [&](Session* session){
+		return session->addTuple(std::move(pathToTablesData), tableId, std::move(data), std::move(bitmap), std::move(onComplete));
+	});
+}
+
+TaskHandle addTuples(SessionHandle handle, std::string pathToTablesData, int32_t tableId, std::vector<std::vector<allVars>> rows, std::vector<std::vector<bool>> bitmaps, TaskCallback onComplete){
+	if (rows.size() != bitmaps.size()){
+		LOG_ERROR("addTuples: "<<rows.size()<<" rows but "<<bitmaps.size()<<" bitmaps for table ID "<<tableId<<"\n");
+		return TaskHandle();
+	}
+	return withSession(handle, [&](Session* session){
+		std::unique_ptr<tuplesAdd> tuplesData(new tuplesAdd());
+		tuplesData->pathToTablesData = std::move(pathToTablesData);
+		tuplesData->tableId = tableId;
+		tuplesData->rows = std::move(rows);
+		tuplesData->bitmaps = std::move(bitmaps);
+		return session->addTuples(std::move(tuplesData), std::move(onComplete));
+	});
+}
+
+TaskHandle addTable(SessionHandle handle, std::vector<int8_t> types, std::vector<int8_t> typesWithAllowNull, std::vector<std::string> columnNames, int32_t tableId, TaskCallback onComplete){
+	return withSession(handle, [&](Session* session){
+		return submitTable(session, types, typesWithAllowNull, columnNames, tableId, std::move(onComplete));
+	});
 }
\ No newline at end of file
@@ -5,14 +5,39 @@
 #include "../../bufforing-stm/src/buserProcess.h"
 #include "../../bufforing-stm/src/mvcc.h"
 
+// Opaque handle of a session opened with openSession. Credentials are checked
+// once when the session is opened; the handle overloads below dispatch through
+// a hash map instead of scanning processBuffer and the user cache per call.
+typedef int64_t SessionHandle;
+constexpr SessionHandle INVALID_SESSION_HANDLE = -1;
+
 std::pair<int32_t,Session*> startSession(std::string username, std::string passwd,int32_t ttl,int64_t xactionId,std::string tablePath);
 
-void addBuser(std::string newUsername, std::string newPasswd, std::string newEmail, bool useHashing, std::string sessionUsername, std::string sessionPasswd);
+TaskHandle addBuser(std::string newUsername, std::string newPasswd, std::string newEmail, bool useHashing, std::string sessionUsername, std::string sessionPasswd);
 
 void waitForAllProcessesToFinish();
 
-void addTuple(std::string pathToTablesData, int32_t tableId, std::vector<allVars> data, std::vector<bool> bitmap, std::string sessionUsername, std::string sessionPasswd);
+TaskHandle addTuple(std::string pathToTablesData, int32_t tableId, std::vector<allVars> data, std::vector<bool> bitmap, std::string sessionUsername, std::string sessionPasswd);
+
+// rows[i] with bitmaps[i]; the whole batch goes to the session as one task
+TaskHandle addTuples(std::string pathToTablesData, int32_t tableId, std::vector<std::vector<allVars>> rows, std::vector<std::vector<bool>> bitmaps, std::string sessionUsername, std::string sessionPasswd);
+
+TaskHandle addTable(std::string sessionUsername, std::string sessionPasswd,std::vector<int8_t> types,std::vector<int8_t> typesWithAllowNull,std::vector<std::string> columnNames,int32_t tableId);
+
+// INVALID_SESSION_HANDLE when the credentials are wrong
+SessionHandle openSession(std::string username, std::string passwd, int32_t ttl, int64_t xactionId, std::string tablePath);
+// stops the session (it drains its queue first), invalidates the handle and frees the
+// session; wait on its TaskHandles before closing it
+void closeSession(SessionHandle handle);
+// the session itself is only reached through the calls below, a pointer to it
+// could outlive closeSession
+bool isSessionOpen(SessionHandle handle);
 
-void addTable(std::string sessionUsername, std::string sessionPasswd,std::vector<int8_t> types,std::vector<int8_t> typesWithAllowNull,std::vector<std::string> columnNames,int32_t tableId);
+// Completion handle of the queued task (wait on it instead of sleeping), invalid
+// when the handle is unknown or closed. onComplete runs on the worker after the task.
+TaskHandle addBuser(SessionHandle handle, std::string newUsername, std::string newPasswd, std::string newEmail, bool useHashing, TaskCallback onComplete = nullptr);
+TaskHandle addTuple(SessionHandle handle, std::string pathToTablesData, int32_t tableId, std::vector<allVars> data, std::vector<bool> bitmap, TaskCallback onComplete = nullptr);
+TaskHandle addTuples(SessionHandle handle, std::string pathToTablesData, int32_t tableId, std::vector<std::vector<allVars>> rows, std::vector<std::vector<bool>> bitmaps, TaskCallback onComplete = nullptr);
+TaskHandle addTable(SessionHandle handle, std::vector<int8_t> types, std::vector<int8_t> typesWithAllowNull, std::vector<std::string> columnNames, int32_t tableId, TaskCallback onComplete = nullptr);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,214 @@
+#include <algorithm>
+#include <thread>
+#include "sessionScheduler.h"
+#include "threadPoolRole.h"
+
+SessionScheduler sharedSessionScheduler;
+
+// worker the current thread belongs to, new work from a worker stays on its deque
+static thread_local SessionScheduler* currentScheduler = nullptr;
+static thread_local int32_t currentWorker = -1;
+
+SessionScheduler::SessionScheduler(int32_t workers) {
+    if (workers <= 0) {
+        workers = static_cast<int32_t>(std::thread::hardware_concurrency());
+    }
+    workerCount = workers > 0 ? workers : 1;
+    for (int32_t i = 0; i < workerCount; ++i) {
+        this->workers.emplace_back(new Worker());
+    }
+    pthread_mutex_init(&idleMutex, nullptr);
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&idleCv, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+SessionScheduler::~SessionScheduler() {
+    stop();
+    pthread_mutex_destroy(&idleMutex);
+    pthread_cond_destroy(&idleCv);
+}
+
+void SessionScheduler::start() {
+    std::call_once(startOnce, [this]() {
+        for (int32_t i = 0; i < workerCount; ++i) {
+            pthread_create(&workers[i]->thread, nullptr, &SessionScheduler::workerEntry, new WorkerArg{this, i});
+        }
+        started.store(true);
+        LOG_DEBUG("Session scheduler started with " << workerCount << " workers");
+    });
+}
+
+void SessionScheduler::stop() {
+    if (!started.load() || stopping.exchange(true)) {
+        return;
+    }
+    pthread_mutex_lock(&idleMutex);
+    pthread_cond_broadcast(&idleCv);
+    pthread_mutex_unlock(&idleMutex);
+    for (auto& w : workers) {
+        pthread_join(w->thread, nullptr);
+    }
+}
+
+void* SessionScheduler::workerEntry(void* arg) {
+    WorkerArg* workerArg = static_cast<WorkerArg*>(arg);
+    SessionScheduler* scheduler = workerArg->scheduler;
+    int32_t index = workerArg->index;
+    delete workerArg;
+    currentScheduler = scheduler;
+    currentWorker = index;
+    scheduler->workerLoop(index);
+    return nullptr;
+}
+
+void SessionScheduler::workerLoop(int32_t index) {
+    while (!stopping.load()) {
+        Session* session = popLocal(index);
+        if (session == nullptr) {
+            session = steal(index);
+        }
+        if (session != nullptr) {
+            session->runSlice();
+            if (earliestDeadline.load(std::memory_order_relaxed) <= monotonicNowNs()) {
+                expireSessions();
+            }
+            continue;
+        }
+        waitForWork();
+        expireSessions();
+    }
+}
+
+Session* SessionScheduler::popLocal(int32_t index) {
+    Worker& w = *workers[index];
+    std::lock_guard<std::mutex> lock(w.m);
+    if (w.sessions.empty()) {
+        return nullptr;
+    }
+    Session* session = w.sessions.back();
+    w.sessions.pop_back();
+    pending.fetch_sub(1);
+    return session;
+}
+
+Session* SessionScheduler::steal(int32_t index) {
+    for (int32_t i = 1; i < workerCount; ++i) {
+        Worker& victim = *workers[(index + i) % workerCount];
+        std::unique_lock<std::mutex> lock(victim.m, std::try_to_lock);
+        if (!lock.owns_lock() || victim.sessions.empty()) {
+            continue;
+        }
+        Session* session = victim.sessions.front();
+        victim.sessions.pop_front();
+        pending.fetch_sub(1);
+        steals.fetch_add(1);
+        return session;
+    }
+    return nullptr;
+}
+
+void SessionScheduler::waitForWork() {
+    int64_t waitNs = static_cast<int64_t>(SESSION_SCHEDULER_IDLE_WAIT_MS) * 1000000;
+    {
+        std::lock_guard<std::mutex> lock(timersMutex);
+        if (!timers.empty()) {
+            int64_t untilDeadline = timers.begin()->first - monotonicNowNs();
+            waitNs = std::max<int64_t>(0, std::min(waitNs, untilDeadline));
+        }
+    }
+    if (waitNs == 0) {
+        return;
+    }
+    timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += waitNs / 1000000000;
+    deadline.tv_nsec += waitNs % 1000000000;
+    if (deadline.tv_nsec >= 1000000000) {
+        deadline.tv_sec += 1;
+        deadline.tv_nsec -= 1000000000;
+    }
+    pthread_mutex_lock(&idleMutex);
+    idle.fetch_add(1);
+    // schedule() bumps pending before it looks at idle, so one of the two sides sees the other
+    if (pending.load() == 0 && !stopping.load()) {
+        pthread_cond_timedwait(&idleCv, &idleMutex, &deadline);
+    }
+    idle.fetch_sub(1);
+    pthread_mutex_unlock(&idleMutex);
+}
+
+void SessionScheduler::expireSessions() {
+    int64_t now = monotonicNowNs();
+    std::lock_guard<std::mutex> lock(timersMutex);
+    while (!timers.empty() && timers.begin()->first <= now) {
+        Session* session = timers.begin()->second;
+        timers.erase(timers.begin());
+        // under timersMutex: a finishing session removes its timer first, so it is still alive here
+        session->expire();
+    }
+    earliestDeadline.store(timers.empty() ? INT64_MAX : timers.begin()->first);
+}
+
+void SessionScheduler::schedule(Session* session) {
+    enqueue(session, false);
+}
+
+void SessionScheduler::requeue(Session* session) {
+    enqueue(session, true);
+}
+
+void SessionScheduler::enqueue(Session* session, bool behindOthers) {
+    start();
+    int32_t target;
+    if (currentScheduler == this && currentWorker >= 0) {
+        target = currentWorker;
+    } else {
+        target = static_cast<int32_t>(nextWorker.fetch_add(1) % static_cast<uint32_t>(workerCount));
+    }
+    {
+        std::lock_guard<std::mutex> lock(workers[target]->m);
+        pending.fetch_add(1);
+        if (behindOthers) {
+            workers[target]->sessions.push_front(session);   // popped from the back, so it waits its turn
+        } else {
+            workers[target]->sessions.push_back(session);
+        }
+    }
+    if (idle.load() > 0) {
+        pthread_mutex_lock(&idleMutex);
+        pthread_cond_signal(&idleCv);
+        pthread_mutex_unlock(&idleMutex);
+    }
+}
+
+void SessionScheduler::addTimer(Session* session, int64_t deadlineNs) {
+    start();
+    bool earliest;
+    {
+        std::lock_guard<std::mutex> lock(timersMutex);
+        earliest = timers.empty() || deadlineNs < timers.begin()->first;
+        timers.insert({deadlineNs, session});
+        earliestDeadline.store(timers.begin()->first);
+    }
+    if (earliest && idle.load() > 0) {
+        // an idle worker may be sleeping past the new deadline
+        pthread_mutex_lock(&idleMutex);
+        pthread_cond_signal(&idleCv);
+        pthread_mutex_unlock(&idleMutex);
+    }
+}
+
+void SessionScheduler::removeTimer(Session* session, int64_t deadlineNs) {
+    std::lock_guard<std::mutex> lock(timersMutex);
+    timers.erase({deadlineNs, session});
+    earliestDeadline.store(timers.empty() ? INT64_MAX : timers.begin()->first);
+}
+
+int64_t SessionScheduler::monotonicNowNs() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<int64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
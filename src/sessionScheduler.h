@@ -0,0 +1,90 @@
+#ifndef SESSIONSCHEDULER_H
+#define SESSIONSCHEDULER_H
+
+#include <pthread.h>
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
+#include <time.h>
+
+class Session;
+
+// Fixed pool of workers that run Sessions. A Session is not a thread any more,
+// it is a task context: when it has work it is put on a worker's deque, the
+// worker drains a batch of its tasks and puts it back if more arrived. A Session
+// is on at most one deque at a time, so its tasks still run one after another.
+// Workers pop their own deque from the back and steal from the front of others
+// when they run dry. Session TTLs are kept in a timer set served by idle workers,
+// and by a busy worker after a slice once the earliest deadline has passed, so
+// sessions still expire when no worker is ever idle.
+
+constexpr int32_t SESSION_SCHEDULER_IDLE_WAIT_MS = 100;
+
+class SessionScheduler {
+    private:
+        struct Worker {
+            pthread_t thread{};
+            std::mutex m;
+            std::deque<Session*> sessions;
+        };
+        int32_t workerCount;
+        std::vector<std::unique_ptr<Worker>> workers;
+        std::once_flag startOnce;
+        std::atomic<bool> started{false};
+        std::atomic<bool> stopping{false};
+
+        std::atomic<int64_t> pending{0};    // sessions sitting on some deque
+        std::atomic<int32_t> idle{0};
+        std::atomic<uint32_t> nextWorker{0};
+        std::atomic<int64_t> steals{0};
+        pthread_mutex_t idleMutex;
+        pthread_cond_t idleCv;
+
+        std::mutex timersMutex;
+        std::set<std::pair<int64_t, Session*>> timers;   // deadline (ns, CLOCK_MONOTONIC) -> session
+        std::atomic<int64_t> earliestDeadline{INT64_MAX}; // of timers, read without timersMutex after a slice
+
+        struct WorkerArg {
+            SessionScheduler* scheduler;
+            int32_t index;
+        };
+        static void* workerEntry(void* arg);
+        void workerLoop(int32_t index);
+        Session* popLocal(int32_t index);
+        Session* steal(int32_t index);
+        void waitForWork();
+        void expireSessions();
+        void enqueue(Session* session, bool behindOthers);
+
+    public:
+        // workers <= 0: one worker per core
+        explicit SessionScheduler(int32_t workers = 0);
+        ~SessionScheduler();
+        SessionScheduler(const SessionScheduler&) = delete;
+        SessionScheduler& operator=(const SessionScheduler&) = delete;
+
+        // starts the workers, called on first schedule() too
+        void start();
+        void stop();
+
+        // puts the session on a deque; the caller must own the session's scheduled flag
+        void schedule(Session* session);
+        // schedule() for a session that just ran a slice and has more work: it goes behind
+        // the sessions already waiting, so sessions sharing a worker take turns
+        void requeue(Session* session);
+        void addTimer(Session* session, int64_t deadlineNs);
+        void removeTimer(Session* session, int64_t deadlineNs);
+
+        static int64_t monotonicNowNs();
+        int32_t getWorkerCount() const { return workerCount; }
+        int64_t getSteals() const { return steals.load(); }
+};
+
+extern SessionScheduler sharedSessionScheduler;
+
+#endif
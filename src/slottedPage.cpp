@@ -0,0 +1,201 @@
+#include <algorithm>
+#include <cstring>
+#include "slottedPage.h"
+
+static uint16_t alignDown(uint16_t value) {
+    return static_cast<uint16_t>(value & ~(PAGE_TUPLE_ALIGN - 1));
+}
+
+void SlottedPage::init(uint8_t* frame, int32_t tableId, int32_t blockNum, uint16_t specialSize, uint8_t format) {
+    memset(frame, 0, PAGE_FILE_BLOCK_SIZE);
+    SlottedPageHeader* h = reinterpret_cast<SlottedPageHeader*>(frame);
+    h->tableId = tableId;
+    h->blockNum = blockNum;
+    h->format = format;
+    h->lower = sizeof(SlottedPageHeader);
+    h->special = alignDown(static_cast<uint16_t>(PAGE_FILE_BLOCK_SIZE - specialSize));
+    h->upper = h->special;
+}
+
+bool SlottedPage::isValid() const {
+    const SlottedPageHeader* h = header();
+    return h->format != 0 && h->lower >= sizeof(SlottedPageHeader) && h->lower <= h->upper &&
+           h->upper <= h->special && h->special <= PAGE_FILE_BLOCK_SIZE &&
+           (h->lower - sizeof(SlottedPageHeader)) % sizeof(LinePointer) == 0;
+}
+
+int32_t SlottedPage::getSlotCount() const {
+    return static_cast<int32_t>((header()->lower - sizeof(SlottedPageHeader)) / sizeof(LinePointer));
+}
+
+uint16_t SlottedPage::getReclaimableSpace() const {
+    const SlottedPageHeader* h = header();
+    int32_t count = getSlotCount();
+    size_t live = 0;
+    for (int32_t i = 0; i < count; ++i) {
+        const LinePointer& lp = linePointers()[i];
+        if (lp.offset != 0) {
+            live += (lp.length + PAGE_TUPLE_ALIGN - 1) & ~static_cast<size_t>(PAGE_TUPLE_ALIGN - 1);
+        }
+    }
+    return static_cast<uint16_t>(h->special - h->upper - live);
+}
+
+uint16_t SlottedPage::getFreeSpace() const {
+    const SlottedPageHeader* h = header();
+    int32_t space = h->upper - h->lower + getReclaimableSpace();
+    if (!(h->flags & PAGE_FLAG_HAS_FREE_LINES)) {
+        space -= sizeof(LinePointer);
+    }
+    return space > 0 ? alignDown(static_cast<uint16_t>(space)) : 0;
+}
+
+int32_t SlottedPage::allocTuple(uint16_t length, uint8_t** out) {
+    if (length == 0 || length > PAGE_MAX_TUPLE_SIZE) {
+        return -1;
+    }
+    SlottedPageHeader* h = header();
+    size_t aligned = (static_cast<size_t>(length) + PAGE_TUPLE_ALIGN - 1) & ~static_cast<size_t>(PAGE_TUPLE_ALIGN - 1);
+    int32_t slot = -1;
+    int32_t count = getSlotCount();
+    if (h->flags & PAGE_FLAG_HAS_FREE_LINES) {
+        for (int32_t i = 0; i < count; ++i) {
+            if (linePointers()[i].offset == 0) {
+                slot = i;
+                break;
+            }
+        }
+        if (slot < 0) {
+            h->flags &= static_cast<uint16_t>(~PAGE_FLAG_HAS_FREE_LINES);
+        }
+    }
+    size_t needed = aligned + (slot < 0 ? sizeof(LinePointer) : 0);
+    if (static_cast<size_t>(h->upper - h->lower) < needed) {
+        // the space of deleted tuples comes back by compacting, which keeps the slots
+        uint16_t reclaimable = getReclaimableSpace();
+        if (reclaimable == 0 || static_cast<size_t>(h->upper - h->lower) + reclaimable < needed) {
+            return -1;
+        }
+        compact();
+        return allocTuple(length, out);
+    }
+    if (slot < 0) {
+        slot = count;
+        h->lower = static_cast<uint16_t>(h->lower + sizeof(LinePointer));
+    } else {
+        bool freeLines = false;
+        for (int32_t i = slot + 1; i < count && !freeLines; ++i) {
+            freeLines = linePointers()[i].offset == 0;
+        }
+        if (!freeLines) {
+            h->flags &= static_cast<uint16_t>(~PAGE_FLAG_HAS_FREE_LINES);   // the last free line was taken
+        }
+    }
+    h->upper = static_cast<uint16_t>(h->upper - aligned);
+    linePointers()[slot] = {h->upper, length};
+    *out = frame + h->upper;
+    return slot;
+}
+
+int32_t SlottedPage::addTuple(const void* data, uint16_t length) {
+    uint8_t* out;
+    int32_t slot = allocTuple(length, &out);
+    if (slot >= 0) {
+        memcpy(out, data, length);
+    }
+    return slot;
+}
+
+int32_t SlottedPage::addRow(const std::vector<allVars>& row, const std::vector<bool>& bitmap) {
+    size_t size = tupleEncodedSize(row, bitmap);
+    if (size == 0 || size > PAGE_MAX_TUPLE_SIZE) {
+        return -1;
+    }
+    uint8_t* out;
+    int32_t slot = allocTuple(static_cast<uint16_t>(size), &out);
+    if (slot >= 0) {
+        encodeTuple(out, row, bitmap);
+    }
+    return slot;
+}
+
+int32_t SlottedPage::addRow(const TupleCodec& codec, const std::vector<allVars>& row, const std::vector<bool>& bitmap) {
+    size_t size = codec.encodedSize(row, bitmap);
+    if (size == 0 || size > PAGE_MAX_TUPLE_SIZE) {
+        return -1;
+    }
+    uint8_t* out;
+    int32_t slot = allocTuple(static_cast<uint16_t>(size), &out);
+    if (slot >= 0 && codec.encode(out, row, bitmap) == 0) {
+        deleteTuple(slot);
+        return -1;
+    }
+    return slot;
+}
+
+const uint8_t* SlottedPage::getTuple(int32_t slot, uint16_t* length) const {
+    if (slot < 0 || slot >= getSlotCount()) {
+        return nullptr;
+    }
+    const LinePointer& lp = linePointers()[slot];
+    if (lp.offset == 0) {
+        return nullptr;
+    }
+    if (length) {
+        *length = lp.length;
+    }
+    return frame + lp.offset;
+}
+
+uint8_t* SlottedPage::getTupleForUpdate(int32_t slot, uint16_t* length) {
+    return const_cast<uint8_t*>(getTuple(slot, length));
+}
+
+bool SlottedPage::deleteTuple(int32_t slot) {
+    if (slot < 0 || slot >= getSlotCount() || linePointers()[slot].offset == 0) {
+        return false;
+    }
+    linePointers()[slot] = {0, 0};
+    header()->flags |= PAGE_FLAG_HAS_FREE_LINES;
+    return true;
+}
+
+void SlottedPage::compact() {
+    SlottedPageHeader* h = header();
+    int32_t count = getSlotCount();
+    // live slots from the highest offset down, so moving towards special never overwrites a tuple not moved yet
+    std::vector<int32_t> live;
+    for (int32_t i = 0; i < count; ++i) {
+        if (linePointers()[i].offset != 0) {
+            live.push_back(i);
+        }
+    }
+    std::sort(live.begin(), live.end(), [this](int32_t a, int32_t b) {
+        return linePointers()[a].offset > linePointers()[b].offset;
+    });
+    uint16_t upper = h->special;
+    for (int32_t slot : live) {
+        LinePointer& lp = linePointers()[slot];
+        uint16_t aligned = static_cast<uint16_t>((lp.length + PAGE_TUPLE_ALIGN - 1) & ~(PAGE_TUPLE_ALIGN - 1));
+        upper = static_cast<uint16_t>(upper - aligned);
+        if (upper != lp.offset) {
+            memmove(frame + upper, frame + lp.offset, lp.length);
+            lp.offset = upper;
+        }
+    }
+    // trailing unused line pointers go back to free space
+    while (count > 0 && linePointers()[count - 1].offset == 0) {
+        count--;
+    }
+    h->lower = static_cast<uint16_t>(sizeof(SlottedPageHeader) + count * sizeof(LinePointer));
+    h->upper = upper;
+    bool freeLines = false;
+    for (int32_t i = 0; i < count; ++i) {
+        freeLines = freeLines || linePointers()[i].offset == 0;
+    }
+    if (freeLines) {
+        h->flags |= PAGE_FLAG_HAS_FREE_LINES;
+    } else {
+        h->flags &= static_cast<uint16_t>(~PAGE_FLAG_HAS_FREE_LINES);
+    }
+}
@@ -0,0 +1,109 @@
+#ifndef SLOTTEDPAGE_H
+#define SLOTTEDPAGE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "pageFile.h"
+#include "tupleCodec.h"
+#include "tupleFormat.h"
+
+// 8 KB page kept in memory in its on-disk layout, so a flush is a write of
+// the frame and a load is a read into one, with no marshalling step. Same
+// shape as a PostgreSQL heap page:
+//
+//   [header][line pointers ->      free      <- tuples][special]
+//
+// Line pointers grow from the header, tuples grow down from the special area
+// (reserved at the end for page types that need it, e.g. index nodes). A
+// tuple is addressed by (blockNum, slot); compact() moves tuples but keeps
+// their slots, so a ctid stays valid. SlottedPage is only a view over a frame
+// owned by someone else (FramePool, a pinned buffer, a mapping).
+
+constexpr uint8_t PAGE_FORMAT_ROW = 1;
+constexpr uint16_t PAGE_FLAG_HAS_FREE_LINES = 1;   // a deleted slot can be reused
+constexpr uint16_t PAGE_TUPLE_ALIGN = 8;
+
+struct SlottedPageHeader {
+    uint64_t lsn;        // WAL position of the last change, the page is not written before it is durable
+    int32_t tableId;
+    int32_t blockNum;
+    uint16_t lower;      // end of the line pointer array
+    uint16_t upper;      // start of the tuple area
+    uint16_t special;    // start of the special area
+    uint8_t format;
+    uint8_t reserved;
+    uint16_t flags;
+    uint16_t pad[3];
+};
+static_assert(sizeof(SlottedPageHeader) == 32, "page header layout is on disk");
+
+// address of a tuple: block of the table file and line pointer in it
+struct Ctid {
+    int32_t blockNum = -1;
+    uint16_t slot = 0;
+    uint16_t pad = 0;
+};
+static_assert(sizeof(Ctid) == 8, "ctids are stored in index pages");
+
+inline bool operator==(const Ctid& a, const Ctid& b) { return a.blockNum == b.blockNum && a.slot == b.slot; }
+inline bool operator!=(const Ctid& a, const Ctid& b) { return !(a == b); }
+inline bool operator<(const Ctid& a, const Ctid& b) { return a.blockNum != b.blockNum ? a.blockNum < b.blockNum : a.slot < b.slot; }
+
+struct LinePointer {
+    uint16_t offset;     // 0: unused slot
+    uint16_t length;
+};
+
+// longest tuple an empty page without a special area can take, tuples are aligned
+constexpr size_t PAGE_MAX_TUPLE_SIZE = (PAGE_FILE_BLOCK_SIZE - sizeof(SlottedPageHeader) - sizeof(LinePointer)) & ~static_cast<size_t>(PAGE_TUPLE_ALIGN - 1);
+
+class SlottedPage {
+    private:
+        uint8_t* frame;
+        SlottedPageHeader* header() const { return reinterpret_cast<SlottedPageHeader*>(frame); }
+        LinePointer* linePointers() const { return reinterpret_cast<LinePointer*>(frame + sizeof(SlottedPageHeader)); }
+        // bytes of the tuple area held by deleted tuples
+        uint16_t getReclaimableSpace() const;
+
+    public:
+        explicit SlottedPage(uint8_t* frame) : frame(frame) {}
+
+        // empty page, specialSize bytes at the end are left to the page type
+        static void init(uint8_t* frame, int32_t tableId, int32_t blockNum, uint16_t specialSize = 0, uint8_t format = PAGE_FORMAT_ROW);
+
+        // header sane (a zeroed frame, e.g. a block past the end of the file, is not)
+        bool isValid() const;
+        uint8_t* data() const { return frame; }
+        uint64_t getLsn() const { return header()->lsn; }
+        void setLsn(uint64_t lsn) { header()->lsn = lsn; }
+        int32_t getTableId() const { return header()->tableId; }
+        int32_t getBlockNum() const { return header()->blockNum; }
+        uint8_t getFormat() const { return header()->format; }
+        // slots handed out so far, deleted ones included
+        int32_t getSlotCount() const;
+        // largest tuple that still fits (with a new line pointer when needed), counting
+        // the space of deleted tuples that allocTuple gets back by compacting
+        uint16_t getFreeSpace() const;
+        uint8_t* getSpecial() const { return frame + header()->special; }
+        uint16_t getSpecialSize() const { return static_cast<uint16_t>(PAGE_FILE_BLOCK_SIZE - header()->special); }
+
+        // room for a tuple of length bytes, written by the caller in place; -1 when it does not fit
+        // (always for length 0 or above PAGE_MAX_TUPLE_SIZE). Compacts the page when only the
+        // space of deleted tuples makes it fit, tuple pointers taken before are then stale.
+        int32_t allocTuple(uint16_t length, uint8_t** out);
+        int32_t addTuple(const void* data, uint16_t length);
+        // encodes the row straight into the frame
+        int32_t addRow(const std::vector<allVars>& row, const std::vector<bool>& bitmap);
+        // same through the table's codec, -1 also when the row does not fit the schema
+        int32_t addRow(const TupleCodec& codec, const std::vector<allVars>& row, const std::vector<bool>& bitmap);
+        // nullptr for unused or out-of-range slots
+        const uint8_t* getTuple(int32_t slot, uint16_t* length) const;
+        uint8_t* getTupleForUpdate(int32_t slot, uint16_t* length);
+        // frees the slot; the tuple's space is given back by compact(), which allocTuple runs when it needs it
+        bool deleteTuple(int32_t slot);
+        // squeezes out the space of deleted tuples, slots stay where they are
+        void compact();
+};
+
+#endif
@@ -4,12 +4,28 @@
 #include <queue>
 #include <iostream>
 #include <vector>
+#include <memory>
+#include <algorithm>
+#include <time.h>
 #include "../../bufforing-stm/src/log.h"
 #include "../../bufforing-stm/src/QuakeSharedBuffers.h"
+#include "evictionPolicy.h"
+#include "bufferMapping.h"
+#include "bufferDesc.h"
 
 
 extern std::vector<int32_t> threadPoolIds;
 
+// background writer defaults, same as bgwriter_delay / bgwriter_lru_maxpages in PostgreSQL
+constexpr int32_t BGWRITER_DEFAULT_DELAY_MS = 200;
+constexpr int32_t BGWRITER_DEFAULT_MAX_PAGES = 100;
+
+// initSharedBuffers with the victim selection policy for the eviction thread
+inline void initSharedBuffers(int32_t size, EvictionPolicyKind policy){
+    sharedBuffersEvictionPolicy = policy;
+    initSharedBuffers(size);
+}
+
 template<typename Cache, typename VectorType>
 class SysThreadPool {
     private:
@@ -19,26 +35,152 @@ class SysThreadPool {
         int32_t threadId=-1;
         bool cacheHintFlag = false;
         bool stopping = false;
-        bool evictionDone = false;
         int32_t blockIndex = -1;
         Cache* cachePtr=nullptr;
-        VectorType cacheEl = nullptr;
-        VectorType elementToAdd = nullptr; 
+        // reserve of free slots kept by the eviction thread between the watermarks
+        pthread_cond_t slotCv{};
+        std::vector<int32_t> freeSlots;
+        std::vector<bool> inFreeSlots;         // per slot, empty slot already held in the reserve
+        bool freeSlotsBuilt = false;
+        int32_t lowWatermark = 0;
+        int32_t highWatermark = 0;
+        int32_t waitingForSlot = 0;
+        int64_t slotWaits = 0;
+        BufferMappingTable* mapping = &sharedBufferMapping;
+        BufferDescTable* descs = &sharedBufferDescs;
+        std::unique_ptr<EvictionPolicy<Cache, VectorType>> policy;
+        // background writer - cleans dirty buffers ahead of the eviction sweep
+        pthread_t bgThread{};
+        pthread_cond_t bgCv{};
+        bool bgWriterEnabled = false;
+        bool bgWriterStarted = false;
+        int32_t bgWriterDelayMs = BGWRITER_DEFAULT_DELAY_MS;
+        int32_t bgWriterMaxPages = BGWRITER_DEFAULT_MAX_PAGES;
+        std::vector<bool> writeInProgress;     // per slot, set while the buffer is written outside m
+        int64_t bgWriterPagesWritten = 0;
+        int64_t evictionPagesWritten = 0;
         static void* thread_entry(void* arg) {
             static_cast<SysThreadPool*>(arg)->run();
             return nullptr;
         }
+        static void* bg_thread_entry(void* arg) {
+            static_cast<SysThreadPool*>(arg)->bgWriterRun();
+            return nullptr;
+        }
+        bool isWriteInProgress(size_t slot) const {
+            return slot < writeInProgress.size() && writeInProgress[slot];
+        }
+        bool isUnevictable(size_t slot) const {
+            return isWriteInProgress(slot) || (slot < inFreeSlots.size() && inFreeSlots[slot]) ||
+                   (descs && descs->isPinned(static_cast<int32_t>(slot)));
+        }
+        // one scan on first use: free slots go to the reserve, residents to the mapping table
+        void rebuildFreeSlots() {
+            freeSlots.clear();
+            inFreeSlots.assign(cachePtr->size(), false);
+            for (size_t i = cachePtr->size(); i-- > 0;) {
+                if ((*cachePtr)[i] == nullptr) {
+                    freeSlots.push_back(static_cast<int32_t>(i));
+                    inFreeSlots[i] = true;
+                } else if (mapping) {
+                    mapping->insert((*cachePtr)[i]->tableId, (*cachePtr)[i]->blockNum, static_cast<int32_t>(i));
+                }
+            }
+            freeSlotsBuilt = true;
+        }
+        // pops a slot from the reserve, -1 when the reserve is empty
+        int32_t takeFreeSlot() {
+            if (!freeSlotsBuilt) {
+                rebuildFreeSlots();
+            }
+            while (!freeSlots.empty()) {
+                int32_t slot = freeSlots.back();
+                freeSlots.pop_back();
+                if (static_cast<size_t>(slot) >= cachePtr->size()) {
+                    continue;
+                }
+                inFreeSlots[slot] = false;
+                if ((*cachePtr)[slot] == nullptr) {
+                    return slot;
+                }
+            }
+            return -1;
+        }
+        static timespec deadlineAfterMs(int32_t ms) {
+            timespec ts;
+            clock_gettime(CLOCK_REALTIME, &ts);
+            ts.tv_sec += ms / 1000;
+            ts.tv_nsec += static_cast<long>(ms % 1000) * 1000000L;
+            if (ts.tv_nsec >= 1000000000L) {
+                ts.tv_sec += 1;
+                ts.tv_nsec -= 1000000000L;
+            }
+            return ts;
+        }
+        // writes the buffer with m released (flushSharedBuffer: content lock shared, isDirty
+        // cleared before the write, so a session changing the page meanwhile dirties it again)
+        void writeBuffer(int32_t slot, VectorType el) {
+            writeInProgress.resize(cachePtr->size(), false);
+            writeInProgress[slot] = true;
+            pthread_mutex_unlock(&m);
+            flushSharedBuffer(descs, slot, el);
+            pthread_mutex_lock(&m);
+            writeInProgress[slot] = false;
+        }
+        // evicts one victim into the reserve. A dirty victim is written first and stays mapped
+        // meanwhile; if it got pinned or dirtied again during the write another victim is taken.
+        bool evictOne() {
+            while (!stopping) {
+                int32_t indexToDelete = policy->victim(*cachePtr);
+                if (indexToDelete < 0) {
+                    if (cachePtr->empty()) return false;
+                    // every candidate is pinned or being written, unpin does not signal us
+                    timespec ts = deadlineAfterMs(1);
+                    pthread_cond_timedwait(&cv, &m, &ts);
+                    continue;
+                }
+                VectorType victim = (*cachePtr)[indexToDelete];
+                if (victim) {
+                    if (bufferIsDirty(victim)) {
+                        evictionPagesWritten++;
+                        writeBuffer(indexToDelete, victim);
+                    }
+                    auto canEvict = [&](int32_t slot) {
+                        return (!descs || !descs->isPinned(slot)) && !bufferIsDirty(victim);
+                    };
+                    bool erased = mapping ? mapping->eraseIf(victim->tableId, victim->blockNum, indexToDelete, canEvict)
+                                          : canEvict(indexToDelete);
+                    if (!erased) {
+                        continue;
+                    }
+                    LOG_DEBUG("Evicting buffer at index " << indexToDelete);
+                    policy->evicted(*cachePtr, indexToDelete);
+                    (*cachePtr)[indexToDelete] = nullptr;
+                }
+                inFreeSlots.resize(cachePtr->size(), false);
+                inFreeSlots[indexToDelete] = true;
+                freeSlots.push_back(indexToDelete);
+                return true;
+            }
+            return false;
+        }
 
     public:
-        SysThreadPool(Cache *cache){
+        SysThreadPool(Cache *cache, EvictionPolicyKind policyKind = sharedBuffersEvictionPolicy){
             cachePtr = cache;
+            policy = makeEvictionPolicy<Cache, VectorType>(policyKind);
+            policy->setUnevictable([this](size_t slot) { return isUnevictable(slot); });
             pthread_mutex_init(&m, nullptr);
             pthread_cond_init(&cv, nullptr);
+            pthread_cond_init(&bgCv, nullptr);
+            pthread_cond_init(&slotCv, nullptr);
         }
         ~SysThreadPool(){
             stop();
             pthread_mutex_destroy(&m);
             pthread_cond_destroy(&cv);
+            pthread_cond_destroy(&bgCv);
+            pthread_cond_destroy(&slotCv);
         }
         
         void start(Cache *cache) {
@@ -50,6 +192,14 @@ class SysThreadPool {
                 LOG_DEBUG("Started thread, pthread_t=" << thread);
                 threadPoolIds.push_back(thread);
             }
+            if (bgWriterEnabled) {
+                rc = pthread_create(&bgThread, nullptr, &SysThreadPool::bg_thread_entry, this);
+                if (rc != 0) {
+                    LOG_ERROR("pthread_create for background writer failed rc=" << rc);
+                } else {
+                    bgWriterStarted = true;
+                }
+            }
             //threadPoolIds.push_back(threadId);
             //LOG_DEBUG("Starting SysThreadPool for thread ID "<<threadId);
         }
@@ -57,8 +207,91 @@ class SysThreadPool {
             pthread_mutex_lock(&m);
             stopping = true;
             pthread_cond_broadcast(&cv);
+            pthread_cond_broadcast(&bgCv);
+            pthread_cond_broadcast(&slotCv);
+            bool joinBgWriter = bgWriterStarted;
+            bgWriterStarted = false;
             pthread_mutex_unlock(&m);
             pthread_join(thread, nullptr);
+            if (joinBgWriter) {
+                pthread_join(bgThread, nullptr);
+            }
+        }
+        // must be called before start(); delayMs between rounds, at most maxPages written per round
+        void enableBgWriter(int32_t delayMs = BGWRITER_DEFAULT_DELAY_MS, int32_t maxPages = BGWRITER_DEFAULT_MAX_PAGES) {
+            pthread_mutex_lock(&m);
+            bgWriterEnabled = true;
+            bgWriterDelayMs = delayMs > 0 ? delayMs : 1;
+            bgWriterMaxPages = maxPages > 0 ? maxPages : 1;
+            pthread_mutex_unlock(&m);
+        }
+        // one round of the background writer: dirty buffers with usage 0 or 1 (the ones
+        // the sweep reaches next) are written outside m, eviction skips them meanwhile
+        int32_t cleanAheadOfSweep(int32_t maxPages) {
+            pthread_mutex_lock(&m);
+            if (!cachePtr || cachePtr->empty()) {
+                pthread_mutex_unlock(&m);
+                return 0;
+            }
+            size_t n = cachePtr->size();
+            writeInProgress.resize(n, false);
+            std::vector<size_t> batch;
+            size_t start = policy->sweepStart() % n;
+            for (size_t i = 0; i < n && static_cast<int32_t>(batch.size()) < maxPages; ++i) {
+                size_t slot = (start + i) % n;
+                VectorType el = (*cachePtr)[slot];
+                if (el && bufferIsDirty(el) && bufferUsage(el) <= 1 && !writeInProgress[slot]) {
+                    writeInProgress[slot] = true;
+                    batch.push_back(slot);
+                }
+            }
+            std::vector<VectorType> toWrite;
+            for (size_t slot : batch) {
+                toWrite.push_back((*cachePtr)[slot]);
+            }
+            pthread_mutex_unlock(&m);
+
+            for (size_t i = 0; i < batch.size(); ++i) {
+                flushSharedBuffer(descs, static_cast<int32_t>(batch[i]), toWrite[i]);
+            }
+
+            pthread_mutex_lock(&m);
+            for (size_t slot : batch) {
+                writeInProgress[slot] = false;
+            }
+            bgWriterPagesWritten += static_cast<int64_t>(batch.size());
+            pthread_cond_broadcast(&cv);
+            pthread_mutex_unlock(&m);
+            if (!batch.empty()) {
+                LOG_DEBUG("Background writer cleaned " << batch.size() << " buffers");
+            }
+            return static_cast<int32_t>(batch.size());
+        }
+        void bgWriterRun() {
+            pthread_mutex_lock(&m);
+            while (!stopping) {
+                timespec ts = deadlineAfterMs(bgWriterDelayMs);
+                pthread_cond_timedwait(&bgCv, &m, &ts);
+                if (stopping) break;
+                int32_t maxPages = bgWriterMaxPages;
+                pthread_mutex_unlock(&m);
+                cleanAheadOfSweep(maxPages);
+                pthread_mutex_lock(&m);
+            }
+            pthread_mutex_unlock(&m);
+        }
+        int64_t getBgWriterPagesWritten() {
+            pthread_mutex_lock(&m);
+            int64_t result = bgWriterPagesWritten;
+            pthread_mutex_unlock(&m);
+            return result;
+        }
+        // dirty victims the eviction thread had to write itself
+        int64_t getEvictionPagesWritten() {
+            pthread_mutex_lock(&m);
+            int64_t result = evictionPagesWritten;
+            pthread_mutex_unlock(&m);
+            return result;
         }
         /*
         void run(){
@@ -111,30 +344,68 @@ class SysThreadPool {
                 if (stopping || !cachePtr) break;
 
                 cacheHintFlag = false;            // zużywamy sygnał
-                int32_t indexToDelete = 0;
-                int32_t minCount = (*cachePtr)[0] ? (*cachePtr)[0]->count : INT32_MAX;
-                bool isDirtyMin = (*cachePtr)[0] ? (*cachePtr)[0]->isDirty : false;
-
-                for (size_t i = 1; i < cachePtr->size(); ++i) {
-                    cacheEl = (*cachePtr)[i];
-                    if (!cacheEl) continue;
-                    if (cacheEl->count < minCount ||
-                    (cacheEl->count == minCount && !cacheEl->isDirty && isDirtyMin)) {
-                        minCount = cacheEl->count;
-                        isDirtyMin = cacheEl->isDirty;
-                        indexToDelete = i;
-                    }
+                if (!freeSlotsBuilt) {
+                    rebuildFreeSlots();
                 }
-                LOG_DEBUG("Evicting buffer at index " << indexToDelete);
-                addBufferDataToFile((*cachePtr)[indexToDelete]);
-                (*cachePtr)[indexToDelete] = nullptr;
-                addToFreeSlot(elementToAdd);
-                evictionDone = true;
-                pthread_cond_broadcast(&cv);
+                // refill the reserve up to the high watermark, but always at least one slot per waiter
+                size_t target = static_cast<size_t>(std::max(highWatermark, waitingForSlot));
+                target = std::min(target, cachePtr->size());
+                while (freeSlots.size() < target && !stopping) {
+                    if (!evictOne()) break;
+                }
+                pthread_cond_broadcast(&slotCv);
             }
+            pthread_cond_broadcast(&slotCv);
             pthread_mutex_unlock(&m);
         }
         int32_t getThreadId(){return threadId; };
+        void setEvictionPolicy(EvictionPolicyKind policyKind){
+            pthread_mutex_lock(&m);
+            policy = makeEvictionPolicy<Cache, VectorType>(policyKind);
+            policy->setUnevictable([this](size_t slot) { return isUnevictable(slot); });
+            pthread_mutex_unlock(&m);
+        }
+        // mapping table kept in sync on load and eviction, nullptr turns it off
+        void setBufferMapping(BufferMappingTable* mappingTable){
+            pthread_mutex_lock(&m);
+            mapping = mappingTable;
+            pthread_mutex_unlock(&m);
+        }
+        // pin counts and content locks of the slots, nullptr turns them off
+        void setBufferDescs(BufferDescTable* descTable){
+            pthread_mutex_lock(&m);
+            descs = descTable;
+            pthread_mutex_unlock(&m);
+        }
+        // evictor wakes up when fewer than lowFree slots are free and evicts in one batch until highFree are free
+        void setFreeSlotWatermarks(int32_t lowFree, int32_t highFree){
+            pthread_mutex_lock(&m);
+            lowWatermark = lowFree > 0 ? lowFree : 0;
+            highWatermark = highFree > lowWatermark ? highFree : lowWatermark;
+            if (cachePtr && static_cast<size_t>(highWatermark) > cachePtr->size()) {
+                highWatermark = static_cast<int32_t>(cachePtr->size());
+            }
+            if (lowWatermark > highWatermark) {
+                lowWatermark = highWatermark;
+            }
+            pthread_mutex_unlock(&m);
+        }
+        int32_t getFreeSlotCount(){
+            pthread_mutex_lock(&m);
+            if (!freeSlotsBuilt) {
+                rebuildFreeSlots();
+            }
+            int32_t result = static_cast<int32_t>(freeSlots.size());
+            pthread_mutex_unlock(&m);
+            return result;
+        }
+        // cacheHint calls that had to wait for the evictor
+        int64_t getSlotWaits(){
+            pthread_mutex_lock(&m);
+            int64_t result = slotWaits;
+            pthread_mutex_unlock(&m);
+            return result;
+        }
         bool isFull(){
             if (!cachePtr){
                 LOG_DEBUG("cachePtr is null in SysThreadPool for thread ID "<<threadId);
@@ -151,20 +422,37 @@ class SysThreadPool {
         }
         void cacheHint(VectorType elementToAdd){
             pthread_mutex_lock(&m);
-            if(isFull()){
-                LOG_DEBUG("Cache full, signaling SysThreadPool to evict an element");
-                this->elementToAdd = elementToAdd;
-                cacheHintFlag = true;
-                evictionDone = false;
-                pthread_cond_signal(&cv);
-                while (!evictionDone) {
-                    // Wait until eviction thread finishes and signals
-                    pthread_cond_wait(&cv, &m);
+            if (!cachePtr) {
+                addToFreeSlot(elementToAdd);
+                pthread_mutex_unlock(&m);
+                return;
+            }
+            int32_t slot = takeFreeSlot();
+            if (slot < 0) {
+                LOG_DEBUG("No free slot in reserve, waiting for SysThreadPool to evict");
+                slotWaits++;
+                waitingForSlot++;
+                while (slot < 0 && !stopping) {
+                    cacheHintFlag = true;
+                    pthread_cond_signal(&cv);
+                    pthread_cond_wait(&slotCv, &m);
+                    slot = takeFreeSlot();
                 }
+                waitingForSlot--;
             }
-            else{
-                LOG_DEBUG("Cache not full, adding element directly without eviction");
-                addToFreeSlot(elementToAdd);
+            if (slot >= 0) {
+                (*cachePtr)[slot] = elementToAdd;
+                policy->admitted(*cachePtr, slot);
+                if (mapping && elementToAdd) {
+                    mapping->insert(elementToAdd->tableId, elementToAdd->blockNum, slot);
+                }
+            } else {
+                LOG_ERROR("SysThreadPool stopped before a slot was freed, buffer not cached");
+            }
+            if (freeSlots.size() < static_cast<size_t>(lowWatermark) && !cacheHintFlag) {
+                // below the low watermark - refill in the background, nobody waits for it
+                cacheHintFlag = true;
+                pthread_cond_signal(&cv);
             }
             pthread_mutex_unlock(&m);
             
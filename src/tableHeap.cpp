@@ -0,0 +1,235 @@
+#include <utility>
+#include "tableHeap.h"
+#include "hashIndex.h"
+#include "walGroupCommit.h"
+#include "../../bufforing-stm/src/log.h"
+
+TableHeapRegistry sharedTableHeaps;
+
+TableHeap::TableHeap(int32_t tableId, int32_t cacheFrames) : tableId(tableId), cache(cacheFrames) {
+    cache.setWal(&sharedWal);
+}
+
+TableHeap::~TableHeap() {
+    close();
+}
+
+bool TableHeap::open(const std::string& path) {
+    if (!cache.open(path)) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(tailMutex);
+    tailBlock = cache.getBlockCount() - 1;
+    return true;
+}
+
+void TableHeap::close() {
+    cache.close();
+}
+
+// empty page appended to the file, returned pinned and latched exclusive (tailMutex held)
+IndexPage TableHeap::newTailPage() {
+    IndexPage page = cache.allocate();
+    if (!page.data) {
+        return page;
+    }
+    cache.latch(page, true);
+    SlottedPage::init(page.data, tableId, page.blockNum);
+    cache.markDirty(page);
+    tailBlock = page.blockNum;
+    return page;
+}
+
+template<typename RowAt>
+size_t TableHeap::insertEach(const TupleCodec& codec, size_t n, RowAt rowAt, uint64_t lsn, std::vector<Ctid>& ctids) {
+    std::lock_guard<std::mutex> lock(tailMutex);
+    IndexPage page;
+    if (tailBlock >= 0) {
+        page = cache.pin(tailBlock);
+        if (page.data) {
+            cache.latch(page, true);
+        }
+    }
+    bool changed = false;
+    size_t stored = 0;
+    while (stored < n) {
+        if (!page.data) {
+            page = newTailPage();
+            if (!page.data) {
+                LOG_ERROR("No page for new rows of table ID " << tableId);
+                break;
+            }
+            changed = false;
+        }
+        std::pair<const std::vector<allVars>*, const std::vector<bool>*> row = rowAt(stored);
+        size_t size = codec.encodedSize(*row.first, *row.second);
+        if (size == 0 || size > PAGE_MAX_TUPLE_SIZE) {
+            LOG_ERROR("Row " << stored << " does not fit a page of table ID " << tableId);
+            break;
+        }
+        SlottedPage slotted(page.data);
+        if (!slotted.isValid() || slotted.getFreeSpace() < size) {
+            // the tail is full, the rest of the batch goes to a new page
+            if (changed) {
+                cache.markDirty(page);
+            }
+            cache.unlatch(page);
+            cache.unpin(page);
+            page = IndexPage();
+            continue;
+        }
+        if (!changed && lsn > slotted.getLsn()) {
+            slotted.setLsn(lsn);   // before the change, under the same latch
+        }
+        int32_t slot = addIndexedRow(slotted, codec, *row.first, *row.second);
+        if (slot == INDEXED_ROW_REJECTED) {
+            LOG_ERROR("Row " << stored << " was rolled back, the indexes of table ID " << tableId << " did not take it");
+            break;
+        }
+        if (slot < 0 && slotted.getFreeSpace() < size) {
+            // did not fit after all, the row goes to a new page like above
+            if (changed) {
+                cache.markDirty(page);
+            }
+            cache.unlatch(page);
+            cache.unpin(page);
+            page = IndexPage();
+            changed = false;
+            continue;
+        }
+        if (slot < 0) {
+            LOG_ERROR("Row " << stored << " does not match the schema of table ID " << tableId);
+            break;
+        }
+        Ctid ctid;
+        ctid.blockNum = page.blockNum;
+        ctid.slot = static_cast<uint16_t>(slot);
+        ctids.push_back(ctid);
+        changed = true;
+        stored++;
+    }
+    if (page.data) {
+        if (changed) {
+            cache.markDirty(page);
+        }
+        cache.unlatch(page);
+        cache.unpin(page);
+    }
+    return stored;
+}
+
+size_t TableHeap::insertRows(const TupleCodec& codec, const std::vector<std::vector<allVars>>& rows,
+                             const std::vector<std::vector<bool>>& bitmaps, uint64_t lsn, std::vector<Ctid>& ctids) {
+    size_t n = rows.size() < bitmaps.size() ? rows.size() : bitmaps.size();
+    ctids.reserve(ctids.size() + n);
+    return insertEach(codec, n, [&rows, &bitmaps](size_t i) {
+        return std::make_pair(&rows[i], &bitmaps[i]);
+    }, lsn, ctids);
+}
+
+bool TableHeap::insertRow(const TupleCodec& codec, const std::vector<allVars>& row, const std::vector<bool>& bitmap, uint64_t lsn, Ctid& ctid) {
+    std::vector<Ctid> ctids;
+    if (insertEach(codec, 1, [&row, &bitmap](size_t) { return std::make_pair(&row, &bitmap); }, lsn, ctids) != 1) {
+        return false;
+    }
+    ctid = ctids[0];
+    return true;
+}
+
+bool TableHeap::readRow(const TupleCodec& codec, const Ctid& ctid, std::vector<allVars>& row, std::vector<bool>& bitmap) {
+    IndexPage page = cache.pin(ctid.blockNum);
+    if (!page.data) {
+        return false;
+    }
+    cache.latch(page, false);
+    SlottedPage slotted(page.data);
+    uint16_t length = 0;
+    const uint8_t* tuple = slotted.isValid() ? slotted.getTuple(ctid.slot, &length) : nullptr;
+    bool ok = tuple != nullptr && codec.decode(tuple, length, row, bitmap);
+    cache.unlatch(page);
+    cache.unpin(page);
+    return ok;
+}
+
+bool TableHeap::deleteRow(const TupleCodec& codec, const Ctid& ctid) {
+    IndexPage page = cache.pin(ctid.blockNum);
+    if (!page.data) {
+        return false;
+    }
+    cache.latch(page, true);
+    SlottedPage slotted(page.data);
+    bool ok = slotted.isValid() && deleteIndexedTuple(slotted, codec, ctid.slot);
+    if (ok) {
+        cache.markDirty(page);
+    }
+    cache.unlatch(page);
+    cache.unpin(page);
+    return ok;
+}
+
+TableHeapRegistry::TableHeapRegistry() {
+    pthread_rwlock_init(&lock, nullptr);
+}
+
+TableHeapRegistry::~TableHeapRegistry() {
+    pthread_rwlock_destroy(&lock);
+}
+
+void TableHeapRegistry::attach(std::shared_ptr<TableHeap> heap) {
+    if (!heap) {
+        return;
+    }
+    int32_t tableId = heap->getTableId();
+    pthread_rwlock_wrlock(&lock);
+    heaps[tableId] = std::move(heap);
+    pthread_rwlock_unlock(&lock);
+}
+
+void TableHeapRegistry::detach(int32_t tableId) {
+    pthread_rwlock_wrlock(&lock);
+    heaps.erase(tableId);
+    pthread_rwlock_unlock(&lock);
+}
+
+std::shared_ptr<TableHeap> TableHeapRegistry::get(int32_t tableId) {
+    std::shared_ptr<TableHeap> heap;
+    pthread_rwlock_rdlock(&lock);
+    auto it = heaps.find(tableId);
+    if (it != heaps.end()) {
+        heap = it->second;
+    }
+    pthread_rwlock_unlock(&lock);
+    return heap;
+}
+
+void TableHeapRegistry::setDirectory(const std::string& dir) {
+    pthread_rwlock_wrlock(&lock);
+    directory = dir;
+    pthread_rwlock_unlock(&lock);
+}
+
+std::shared_ptr<TableHeap> TableHeapRegistry::openInDirectory(int32_t tableId) {
+    pthread_rwlock_wrlock(&lock);
+    std::shared_ptr<TableHeap> heap;
+    auto it = heaps.find(tableId);
+    if (it != heaps.end()) {
+        heap = it->second;
+    } else if (!directory.empty()) {
+        std::string path = directory + "/table_" + std::to_string(tableId) + ".heap";
+        heap = std::make_shared<TableHeap>(tableId);
+        if (heap->open(path)) {
+            heaps[tableId] = heap;
+        } else {
+            LOG_ERROR("Cannot open the heap of table ID " << tableId << " in " << path);
+            heap.reset();
+        }
+    }
+    pthread_rwlock_unlock(&lock);
+    return heap;
+}
+
+void TableHeapRegistry::clear() {
+    pthread_rwlock_wrlock(&lock);
+    heaps.clear();
+    pthread_rwlock_unlock(&lock);
+}
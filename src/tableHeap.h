@@ -0,0 +1,103 @@
+#ifndef TABLEHEAP_H
+#define TABLEHEAP_H
+
+#include <pthread.h>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "indexPageCache.h"
+#include "slottedPage.h"
+#include "tupleCodec.h"
+
+// Row pages of one table in its own file, slotted pages (PAGE_FORMAT_ROW)
+// cached in an IndexPageCache. It is the in-tree insert path next to
+// addTupleToBuffer: a batch fills the tail page with addRow until it is full
+// and only then takes the next page, so it costs one page lookup and one
+// exclusive latch per page instead of per row, and the caller gets the ctid
+// of every row it stored.
+//
+// Rows go in and out through addIndexedRow and deleteIndexedTuple, so the
+// table's hash and B-tree indexes follow every insert and delete; a row an
+// index does not take is rolled back and ends the batch.
+//
+// One inserter fills the tail at a time (tailMutex). Readers and deletes
+// latch the page they touch, a change is made under the exclusive latch.
+// A logged change stamps its WAL LSN on the page before the rows go in, and
+// the cache writes a page only once the WAL is durable up to that LSN.
+
+constexpr int32_t TABLE_HEAP_DEFAULT_FRAMES = 256;   // 2 MB
+
+class TableHeap {
+    private:
+        int32_t tableId;
+        IndexPageCache cache;
+        std::mutex tailMutex;
+        int32_t tailBlock = -1;     // guarded by tailMutex, -1 for an empty file
+
+        IndexPage newTailPage();
+        template<typename RowAt>
+        size_t insertEach(const TupleCodec& codec, size_t n, RowAt rowAt, uint64_t lsn, std::vector<Ctid>& ctids);
+
+    public:
+        // pages follow the write-ahead rule against sharedWal
+        explicit TableHeap(int32_t tableId, int32_t cacheFrames = TABLE_HEAP_DEFAULT_FRAMES);
+        ~TableHeap();
+        TableHeap(const TableHeap&) = delete;
+        TableHeap& operator=(const TableHeap&) = delete;
+
+        bool open(const std::string& path);
+        void close();
+        bool isOpen() const { return cache.isOpen(); }
+        // writes the dirty pages and syncs the file
+        bool flush() { return cache.flush(); }
+        // the log the stamped LSNs come from, nullptr turns the write-ahead check off
+        void setWal(WalGroupCommit* wal) { cache.setWal(wal); }
+
+        // rows[i] with bitmaps[i], ctids gets the address of every row stored. Stops at
+        // the first row that does not fit the codec; returns the number of rows stored.
+        // lsn is the WAL record of the insert, 0 when it is not logged.
+        size_t insertRows(const TupleCodec& codec, const std::vector<std::vector<allVars>>& rows,
+                          const std::vector<std::vector<bool>>& bitmaps, uint64_t lsn, std::vector<Ctid>& ctids);
+        bool insertRow(const TupleCodec& codec, const std::vector<allVars>& row, const std::vector<bool>& bitmap, uint64_t lsn, Ctid& ctid);
+        bool readRow(const TupleCodec& codec, const Ctid& ctid, std::vector<allVars>& row, std::vector<bool>& bitmap);
+        // frees the slot, a later insert into the page may reuse it; codec decodes the index keys
+        bool deleteRow(const TupleCodec& codec, const Ctid& ctid);
+
+        int32_t getTableId() const { return tableId; }
+        int32_t getBlockCount() { return cache.getBlockCount(); }
+};
+
+// tableId -> heap of the table. Sessions insert into the heap when the table
+// has one and a codec, and fall back to addTupleToBuffer otherwise. A session
+// that creates a table defines its codec and, with a directory set, its heap.
+class TableHeapRegistry {
+    private:
+        pthread_rwlock_t lock;
+        std::unordered_map<int32_t, std::shared_ptr<TableHeap>> heaps;
+        std::string directory;   // guarded by lock
+    public:
+        TableHeapRegistry();
+        ~TableHeapRegistry();
+        TableHeapRegistry(const TableHeapRegistry&) = delete;
+        TableHeapRegistry& operator=(const TableHeapRegistry&) = delete;
+
+        void attach(std::shared_ptr<TableHeap> heap);
+        void detach(int32_t tableId);
+        // nullptr for tables without a heap
+        std::shared_ptr<TableHeap> get(int32_t tableId);
+        // tables created from now on get a heap in dir; empty (the default) leaves
+        // their rows to addTupleToBuffer
+        void setDirectory(const std::string& dir);
+        // the table's heap, opened from <directory>/table_<id>.heap and attached when it
+        // has none yet; nullptr without a directory or when the file does not open
+        std::shared_ptr<TableHeap> openInDirectory(int32_t tableId);
+        void clear();
+};
+
+extern TableHeapRegistry sharedTableHeaps;
+
+#endif
@@ -0,0 +1,150 @@
+#include <algorithm>
+#include <cstring>
+#include "tableScan.h"
+#include "../../bufforing-stm/src/log.h"
+
+static int32_t clampRing(int32_t frames) {
+    return frames > 0 ? frames : 1;
+}
+
+TableScan::TableScan(PageFile& file, int32_t tableId, const TableScanOptions& options)
+    : file(file), tableId(tableId), ring(clampRing(options.ringFrames))
+{
+    firstBlock = options.firstBlock > 0 ? options.firstBlock : 0;
+    endBlock = options.endBlock >= 0 ? options.endBlock : file.getBlockCount();
+    if (endBlock < firstBlock) {
+        endBlock = firstBlock;
+    }
+    window = options.readAhead > 0 ? options.readAhead : 1;
+    if (window > ring.getFrameCount()) {
+        window = ring.getFrameCount();
+    }
+    io = makeAsyncPageIo(static_cast<uint32_t>(window), options.backend);
+    if (io && static_cast<int32_t>(io->depth()) < window) {
+        window = static_cast<int32_t>(io->depth());
+    }
+    states.assign(ring.getFrameCount(), SlotState::FREE);
+    results.assign(ring.getFrameCount(), 0);
+    nextBlock = firstBlock;
+    issuedBlock = firstBlock;
+    if (!ring.isReady() || !io) {
+        LOG_ERROR("Cannot set up scan of table ID " << tableId);
+        error = true;
+    }
+}
+
+TableScan::~TableScan() {
+    releaseCurrent();
+    drain();
+}
+
+void TableScan::drain() {
+    // the frames still being read belong to the kernel until their completions are in
+    while (io && io->inFlight() > 0) {
+        PageIoCompletion done[TABLE_SCAN_READ_AHEAD];
+        if (io->reap(done, TABLE_SCAN_READ_AHEAD, 1) <= 0) {
+            break;
+        }
+    }
+    std::fill(states.begin(), states.end(), SlotState::FREE);
+}
+
+bool TableScan::restart(int32_t first, int32_t end) {
+    releaseCurrent();
+    drain();
+    firstBlock = first > 0 ? first : 0;
+    endBlock = end > firstBlock ? end : firstBlock;
+    nextBlock = firstBlock;
+    issuedBlock = firstBlock;
+    return !error;
+}
+
+void TableScan::releaseCurrent() {
+    unpinSharedBuffer(current);
+    current = PinnedBuffer();
+    heldBlock = -1;
+}
+
+void TableScan::readAhead() {
+    int32_t prepared = 0;
+    // never wrap around onto the frame the caller still reads
+    int32_t limit = heldBlock >= 0 ? heldBlock + ring.getFrameCount() : endBlock;
+    while (issuedBlock < endBlock && issuedBlock < limit && issuedBlock - nextBlock < window) {
+        int32_t slot = slotOf(issuedBlock);
+        PageIoRequest r;
+        r.op = PageIoOp::READ;
+        r.fd = file.getFd();
+        r.buf = ring.frame(slot);
+        r.length = PAGE_FILE_BLOCK_SIZE;
+        r.offset = static_cast<uint64_t>(issuedBlock) * PAGE_FILE_BLOCK_SIZE;
+        r.userData = static_cast<uint64_t>(issuedBlock);
+        if (!io->prepare(r)) {
+            break;
+        }
+        states[slot] = SlotState::READING;
+        issuedBlock++;
+        prepared++;
+    }
+    if (prepared > 0) {
+        io->submit();
+    }
+}
+
+bool TableScan::waitFor(int32_t blockNum) {
+    int32_t slot = slotOf(blockNum);
+    PageIoCompletion done[TABLE_SCAN_READ_AHEAD];
+    while (states[slot] != SlotState::READY) {
+        int32_t got = io->reap(done, TABLE_SCAN_READ_AHEAD, 1);
+        if (got <= 0) {
+            LOG_ERROR("Scan of table ID " << tableId << " lost its reads at block " << blockNum);
+            return false;
+        }
+        for (int32_t i = 0; i < got; ++i) {
+            int32_t s = slotOf(static_cast<int32_t>(done[i].userData));
+            states[s] = SlotState::READY;
+            results[s] = done[i].result;
+        }
+    }
+    int32_t result = results[slot];
+    if (result < 0) {
+        LOG_ERROR("Scan of table ID " << tableId << " failed to read block " << blockNum << ", errno " << -result);
+        return false;
+    }
+    if (result < static_cast<int32_t>(PAGE_FILE_BLOCK_SIZE)) {
+        // the file was cut short under the scan, the rest reads as zeros like past the end
+        memset(ring.frame(slot) + result, 0, PAGE_FILE_BLOCK_SIZE - result);
+    }
+    return true;
+}
+
+bool TableScan::next(ScanPage& page) {
+    releaseCurrent();
+    page = ScanPage();
+    if (error || nextBlock >= endBlock) {
+        return false;
+    }
+    readAhead();
+    int32_t blockNum = nextBlock;
+    if (!waitFor(blockNum)) {
+        error = true;
+        return false;
+    }
+    int32_t slot = slotOf(blockNum);
+    states[slot] = SlotState::FREE;   // reused once the caller moves on
+    nextBlock++;
+    blocksRead++;
+    page.blockNum = blockNum;
+    PinnedBuffer pinned = pinSharedBuffer(tableId, blockNum);
+    if (pinned.buffer && bufferIsDirty(pinned.buffer)) {
+        current = pinned;
+        page.buffer = pinned;
+        blocksFromShared++;
+        return true;
+    }
+    unpinSharedBuffer(pinned);
+    page.data = ring.frame(slot);
+    heldBlock = blockNum;
+    // refill right away, the reads run while the caller works on this page
+    readAhead();
+    return true;
+}
@@ -0,0 +1,89 @@
+#ifndef TABLESCAN_H
+#define TABLESCAN_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "asyncPageIo.h"
+#include "bufferDesc.h"
+#include "framePool.h"
+#include "pageFile.h"
+
+// Sequential scan over the blocks of a table file. Blocks are read into a
+// small private ring of frames instead of the shared buffers, the same idea
+// as PostgreSQL's BAS_BULKREAD strategy: a scan of a table much larger than
+// the pool reuses its own 256 KB over and over and leaves the hot pages of
+// other sessions in `buffers`. The blocks after the current one are read
+// ahead through the scan's own AsyncPageIo engine, so the disk always has
+// readAhead requests queued while the caller works on the current page.
+//
+// The shared buffers are only looked at, never filled: a block that sits
+// dirty in them is newer than the file and is returned pinned, as in
+// readPageView (lock its content shared to read it).
+
+constexpr int32_t TABLE_SCAN_RING_FRAMES = 32;   // 256 KB, BAS_BULKREAD size
+constexpr int32_t TABLE_SCAN_READ_AHEAD = 16;
+
+struct TableScanOptions {
+    int32_t ringFrames = TABLE_SCAN_RING_FRAMES;
+    int32_t readAhead = TABLE_SCAN_READ_AHEAD;   // at most ringFrames
+    int32_t firstBlock = 0;
+    int32_t endBlock = -1;                       // -1: block count of the file when the scan starts
+    PageIoBackend backend = PageIoBackend::AUTO;
+};
+
+// the current block of a scan, valid until the next call of next() or the end of the scan
+struct ScanPage {
+    int32_t blockNum = -1;
+    const uint8_t* data = nullptr;   // nullptr when the block comes from the shared buffers
+    PinnedBuffer buffer;
+};
+
+class TableScan {
+    private:
+        enum class SlotState : uint8_t { FREE, READING, READY };
+        PageFile& file;
+        int32_t tableId;
+        int32_t firstBlock;
+        int32_t endBlock;
+        int32_t window;
+        FramePool ring;
+        std::unique_ptr<AsyncPageIo> io;
+        std::vector<SlotState> states;
+        std::vector<int32_t> results;
+        int32_t nextBlock;       // next block returned by next()
+        int32_t issuedBlock;     // next block to read ahead
+        int32_t heldBlock = -1;  // block of the frame the caller is reading, -1 for none
+        PinnedBuffer current;
+        bool error = false;
+        int64_t blocksRead = 0;
+        int64_t blocksFromShared = 0;
+
+        int32_t slotOf(int32_t blockNum) const { return (blockNum - firstBlock) % ring.getFrameCount(); }
+        void readAhead();
+        bool waitFor(int32_t blockNum);
+        void releaseCurrent();
+        void drain();
+
+    public:
+        TableScan(PageFile& file, int32_t tableId, const TableScanOptions& options = TableScanOptions());
+        ~TableScan();
+        TableScan(const TableScan&) = delete;
+        TableScan& operator=(const TableScan&) = delete;
+
+        // false when the ring or the I/O engine could not be set up
+        bool isReady() const { return ring.isReady() && io != nullptr; }
+        // moves to the next block, false at the end of the range or after a read error
+        bool next(ScanPage& page);
+        bool failed() const { return error; }
+        // starts over on another range with the same ring and engine (a parallel scan
+        // worker moving to its next chunk); false after a read error
+        bool restart(int32_t firstBlock, int32_t endBlock);
+
+        int32_t getFirstBlock() const { return firstBlock; }
+        int32_t getEndBlock() const { return endBlock; }
+        int64_t getBlocksRead() const { return blocksRead; }
+        int64_t getBlocksFromShared() const { return blocksFromShared; }
+};
+
+#endif
@@ -0,0 +1,171 @@
+#ifndef TASKQUEUE_H
+#define TASKQUEUE_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <thread>
+#include <time.h>
+#include <sched.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+// Bounded multi-producer / single-consumer ring (Vyukov's per-cell sequence
+// scheme). Producers claim a cell with one CAS on the tail, the consumer
+// never takes a lock. When the consumer runs dry it spins for a while and
+// then parks on a futex; producers only make the wake syscall when the
+// consumer is actually parked.
+
+constexpr int32_t TASK_QUEUE_SPIN_ITERATIONS = 2000;
+
+// spinning only helps when a producer can run at the same time
+inline int32_t taskQueueSpinIterations() {
+    static const int32_t iterations = std::thread::hardware_concurrency() > 1 ? TASK_QUEUE_SPIN_ITERATIONS : 0;
+    return iterations;
+}
+
+inline long futexWait(std::atomic<uint32_t>* addr, uint32_t expected, const timespec* timeout) {
+    return syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAIT_PRIVATE, expected, timeout, nullptr, 0);
+}
+
+inline long futexWake(std::atomic<uint32_t>* addr, int32_t count) {
+    return syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+}
+
+template<typename T>
+class MpscRing {
+    private:
+        struct Cell {
+            std::atomic<size_t> sequence;
+            T value;
+        };
+        size_t mask;
+        std::unique_ptr<Cell[]> cells;
+        alignas(64) std::atomic<size_t> tail{0};     // producers
+        alignas(64) size_t head = 0;                  // consumer only
+        alignas(64) std::atomic<uint32_t> wakeSeq{0};
+        std::atomic<bool> consumerParked{false};
+
+        static size_t roundUpPow2(size_t n) {
+            size_t result = 2;
+            while (result < n) {
+                result <<= 1;
+            }
+            return result;
+        }
+
+    public:
+        explicit MpscRing(size_t capacity) : mask(roundUpPow2(capacity) - 1), cells(new Cell[mask + 1]) {
+            for (size_t i = 0; i <= mask; ++i) {
+                cells[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+        MpscRing(const MpscRing&) = delete;
+        MpscRing& operator=(const MpscRing&) = delete;
+
+        size_t capacity() const { return mask + 1; }
+
+        // false when the ring is full; value is moved from only when it was pushed.
+        // position (optional) gets the value's place in the ring's total order.
+        template<typename U>
+        bool tryPush(U&& value, size_t* position = nullptr) {
+            size_t pos = tail.load(std::memory_order_relaxed);
+            for (;;) {
+                Cell& cell = cells[pos & mask];
+                size_t seq = cell.sequence.load(std::memory_order_acquire);
+                intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+                if (diff == 0) {
+                    if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        cell.value = std::forward<U>(value);
+                        cell.sequence.store(pos + 1, std::memory_order_release);
+                        if (position) {
+                            *position = pos;
+                        }
+                        notify();
+                        return true;
+                    }
+                } else if (diff < 0) {
+                    return false;
+                } else {
+                    pos = tail.load(std::memory_order_relaxed);
+                }
+            }
+        }
+        // waits (yielding) while the ring is full, returns the value's position
+        template<typename U>
+        size_t push(U&& value) {
+            size_t position = 0;
+            while (!tryPush(std::forward<U>(value), &position)) {
+                sched_yield();
+            }
+            return position;
+        }
+        bool tryPop(T& out) {
+            Cell& cell = cells[head & mask];
+            size_t seq = cell.sequence.load(std::memory_order_acquire);
+            if (static_cast<intptr_t>(seq) - static_cast<intptr_t>(head + 1) < 0) {
+                return false;
+            }
+            out = std::move(cell.value);
+            cell.value = T();
+            cell.sequence.store(head + mask + 1, std::memory_order_release);
+            head++;
+            return true;
+        }
+        // consumer side: position of the next value tryPop returns
+        size_t popPosition() const { return head; }
+        // takes up to maxCount values at once, returns how many were taken
+        size_t popBatch(T* out, size_t maxCount) {
+            size_t n = 0;
+            while (n < maxCount && tryPop(out[n])) {
+                n++;
+            }
+            return n;
+        }
+        bool empty() const {
+            const Cell& cell = cells[head & mask];
+            return static_cast<intptr_t>(cell.sequence.load(std::memory_order_acquire)) - static_cast<intptr_t>(head + 1) < 0;
+        }
+        // consumer side: spin, then park until something is pushed, wakeConsumer() is called,
+        // cancel becomes true or timeout (relative, nullptr = no timeout) passes.
+        // True when the ring is not empty.
+        bool waitForData(const timespec* timeout, const std::atomic<bool>* cancel = nullptr) {
+            for (int32_t i = 0, spins = taskQueueSpinIterations(); i < spins; ++i) {
+                if (!empty() || (cancel && cancel->load(std::memory_order_acquire))) {
+                    return !empty();
+                }
+#if defined(__x86_64__) || defined(__i386__)
+                __builtin_ia32_pause();
+#endif
+            }
+            uint32_t seq = wakeSeq.load(std::memory_order_acquire);
+            consumerParked.store(true, std::memory_order_seq_cst);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            // cancel is checked after seq was read: a wakeConsumer() after this point changes seq
+            if (empty() && !(cancel && cancel->load(std::memory_order_acquire))) {
+                futexWait(&wakeSeq, seq, timeout);
+            }
+            consumerParked.store(false, std::memory_order_relaxed);
+            return !empty();
+        }
+        // wakes a parked consumer after a push
+        void notify() {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            // the first producer that sees the parked consumer clears the flag, so
+            // one park costs one wake syscall no matter how many pushes follow
+            if (consumerParked.load(std::memory_order_seq_cst) && consumerParked.exchange(false, std::memory_order_seq_cst)) {
+                wakeSeq.fetch_add(1, std::memory_order_release);
+                futexWake(&wakeSeq, 1);
+            }
+        }
+        // unconditional wake, for stop requests
+        void wakeConsumer() {
+            wakeSeq.fetch_add(1, std::memory_order_release);
+            futexWake(&wakeSeq, 1);
+        }
+};
+
+#endif
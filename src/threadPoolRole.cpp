@@ -1,21 +1,32 @@
 #include <iostream>
+#include <errno.h>
+#include <cstring>
 #include "threadPoolRole.h"
+#include "tableHeap.h"
+#include "tupleCodec.h"
 
 
-Session::Session(int ttl,int64_t xactionId)
+Session::Session(int ttl,int64_t xactionId, SessionScheduler* scheduler)
 {
     this->ttl = ttl;
     this->xactionId = xactionId;
+    this->scheduler = scheduler;
     //check user credentials
     pthread_mutex_init(&m, nullptr);
-    pthread_cond_init(&cv, nullptr);
+    pthread_cond_init(&finishedCv, nullptr);
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&completedCv, &attr);
+    pthread_condattr_destroy(&attr);
     
 }
 
 Session::~Session() {
     stop();
     pthread_mutex_destroy(&m);
-    pthread_cond_destroy(&cv);
+    pthread_cond_destroy(&finishedCv);
+    pthread_cond_destroy(&completedCv);
 }
 
 
@@ -26,29 +37,65 @@ void Session::start(std::string username, std::string passwd,std::string tablePa
         return;
     }
     else{
-        userId = getUserIdFromCache(username,passwd);
         stopping.store(false);
-        threadId = pthread_create(&thread, nullptr, &Session::thread_entry, this);
+        started = true;
+        threadId = 0;
+        deadlineNs = SessionScheduler::monotonicNowNs() + static_cast<int64_t>(ttl) * 1000000000;
+        scheduler->addTimer(this, deadlineNs);
+        scheduleIfIdle();   // tasks submitted before start
     }
     
 }
 
-void Session::submit(Task t,int32_t userIp) {
-    pthread_mutex_lock(&m);
+TaskHandle Session::submit(Task&& t,int32_t userIp) {
+    // a stopping session takes nothing new, and a full ring is not waited on:
+    // the task is cancelled right away and the caller gets an invalid handle
+    if (stopping.load()) {
+        cancel(t);
+        return TaskHandle();
+    }
     t.userIp = userIp;
-    LOG_DEBUG("Submitting task to session for user ID "<<userId);
-    q.push(t);
-    pthread_cond_signal(&cv);
-    pthread_mutex_unlock(&m);
+    size_t position = 0;
+    if (!q.tryPush(std::move(t), &position)) {   // lock-free, the ring position is the run order
+        LOG_ERROR("Session queue is full for user ID " << userId);
+        cancel(t);
+        return TaskHandle();
+    }
+    uint64_t seq = position + 1;
+    queued.fetch_add(1);
+    if (started) {
+        scheduleIfIdle();
+    }
+    return TaskHandle(this, seq);
+}
+
+void Session::scheduleIfIdle() {
+    if (!scheduled.exchange(true)) {
+        scheduler->schedule(this);
+    }
 }
 
 void Session::stop() {
-    if (!stopping.exchange(true)) {
+    if (!started) {
+        stopping.store(true);
         pthread_mutex_lock(&m);
-        pthread_cond_signal(&cv);
+        finished = true;   // queued tasks will never run, their handles report CANCELLED
+        pthread_cond_broadcast(&completedCv);
+        std::vector<Task> leftovers = takeQueued();
         pthread_mutex_unlock(&m);
-        pthread_join(thread, nullptr);
+        cancelAll(leftovers);
+        return;
+    }
+    if (!stopping.exchange(true)) {
+        scheduleIfIdle();
+    }
+    pthread_mutex_lock(&m);
+    while (!finished) {
+        pthread_cond_wait(&finishedCv, &m);
     }
+    std::vector<Task> leftovers = takeQueued();   // pushed by a submit that raced with the stop
+    pthread_mutex_unlock(&m);
+    cancelAll(leftovers);
     
     /*
     pthread_mutex_lock(&m);
@@ -58,25 +105,68 @@ void Session::stop() {
     */
 }
 
-void* Session::thread_entry(void* arg) {
-    static_cast<Session*>(arg)->run();
-    return nullptr;
+void Session::expire() {
+    LOG_DEBUG("Session TTL expired for user ID "<<userId);
+    stopping.store(true);
+    //removeProcessFromBuffer(this);  // Usuń z bufora po upływie TTL
+    scheduleIfIdle();
 }
 
-
-bool Session::checkUser(std::string username, std::string passwd){
+void Session::finish() {
+    scheduler->removeTimer(this, deadlineNs);
+    LOG_DEBUG("EXIT SESSION for user ID "<<userId);
     pthread_mutex_lock(&m);
-    for (int i=0; i<userCache.size(); i++){
-        buser* cachedUser = userCache[i];
-        if(cachedUser->getUsername() == username && cachedUser->getPasswd() == passwd){
-            pthread_mutex_unlock(&m);
-            return true;
+    finished = true;
+    pthread_cond_broadcast(&finishedCv);
+    pthread_cond_broadcast(&completedCv);
+    pthread_mutex_unlock(&m);
+    // the session may be deleted from here on
+}
+
+void Session::cancel(Task& t) {
+    if (t.onComplete) {
+        t.onComplete(TaskStatus::CANCELLED);
+    }
+    buser* user = t.user;
+    t = Task();   // payloads go back now, not when the session is deleted
+    t.user = user;
+}
+
+std::vector<Task> Session::takeQueued() {
+    // no worker drains a finished session, the caller (holding m) is the only consumer
+    std::vector<Task> leftovers;
+    Task batch[SESSION_TASK_BATCH];
+    size_t n;
+    while ((n = q.popBatch(batch, SESSION_TASK_BATCH)) > 0) {
+        queued.fetch_sub(static_cast<int64_t>(n));
+        for (size_t i = 0; i < n; ++i) {
+            leftovers.push_back(std::move(batch[i]));
         }
     }
-    LOG_ERROR("Authentication failed for user: " << username);
-    
-    
+    return leftovers;
+}
+
+void Session::cancelAll(std::vector<Task>& tasks) {
+    for (Task& t : tasks) {
+        cancel(t);
+    }
+}
+
+bool Session::isFinished() {
+    pthread_mutex_lock(&m);
+    bool result = finished;
     pthread_mutex_unlock(&m);
+    return result;
+}
+
+
+bool Session::checkUser(std::string username, std::string passwd){
+    buser* cachedUser = sharedBuserIndex.authenticate(username, passwd);
+    if(cachedUser != nullptr){
+        userId = cachedUser->getId();
+        return true;
+    }
+    LOG_ERROR("Authentication failed for user: " << username);
     return false;
 }
 
@@ -118,66 +208,333 @@ void Session::run() {
     */
 
 
-void Session::run() {
-    timespec end;
-    clock_gettime(CLOCK_MONOTONIC, &end);
-    end.tv_sec += ttl;
+void Session::runSlice() {
+    Task batch[SESSION_TASK_BATCH];
+    uint64_t firstSeq = q.popPosition() + 1;
+    size_t n = q.popBatch(batch, SESSION_TASK_BATCH);
+    if (n == 0 && stopping.load() && queued.load() == 0) {
+        finish();   // scheduled stays set, nobody schedules a finished session again
+        return;
+    }
+    queued.fetch_sub(static_cast<int64_t>(n));
 
-    while (true) {
+    // run the batch; with the WAL open every task's record is appended before
+    // the change is made (write-ahead), and the whole batch is made durable by
+    // one group commit before it completes
+    TaskStatus statuses[SESSION_TASK_BATCH];
+    bool logged[SESSION_TASK_BATCH];
+    bool logging = wal != nullptr && wal->isOpen();
+    uint64_t lastLsn = 0;
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t lsn = 0;
+        if (logging) {
+            walRecord.clear();
+            encodeWalRecord(batch[i], walRecord);   // before execute, it moves the rows out
+            if (!walRecord.empty()) {
+                lsn = wal->append(walRecord.data(), static_cast<uint32_t>(walRecord.size()));
+            }
+        }
+        inserted[i].clear();
+        statuses[i] = execute(batch[i], lsn, inserted[i]);
+        logged[i] = lsn > 0 && statuses[i] == TaskStatus::DONE;
+        if (lsn > 0) {
+            lastLsn = lsn;
+        }
+        if (lsn > 0 && statuses[i] != TaskStatus::DONE) {
+            // the record is already in the log, tell redo the change never happened
+            walRecord.clear();
+            walPutHeader(walRecord, WalRecordKind::ABORT, xactionId, -1);
+            walPutValue<uint64_t>(walRecord, lsn);
+            uint64_t abortLsn = wal->append(walRecord.data(), static_cast<uint32_t>(walRecord.size()));
+            if (abortLsn > 0) {
+                lastLsn = abortLsn;
+            }
+        }
+    }
+    if (lastLsn > 0 && !wal->commit(lastLsn)) {
+        // the batch is not durable and the log cannot take more: heap rows are
+        // deleted again and their tasks fail, the other changes are already
+        // visible and stay DONE; the session stops and what is queued is cancelled
+        LOG_ERROR("WAL commit failed, session for user ID " << userId << " stops");
+        for (size_t i = 0; i < n; ++i) {
+            if (logged[i] && !inserted[i].empty() && undoInserts(batch[i], inserted[i])) {
+                statuses[i] = TaskStatus::FAILED;
+            }
+        }
+        stopping.store(true);
         pthread_mutex_lock(&m);
+        std::vector<Task> leftovers = takeQueued();
+        pthread_mutex_unlock(&m);
+        cancelAll(leftovers);
+    }
 
-        while (q.empty() && !stopping.load()) {
-            int rc = pthread_cond_timedwait(&cv, &m, &end);
+    for (size_t i = 0; i < n; ++i) {
+        TaskStatus status = statuses[i];
+        if (status != TaskStatus::DONE) {
+            pthread_mutex_lock(&m);
+            failedTasks[firstSeq + i] = status;
+            if (failedTasks.size() > SESSION_FAILED_TASKS_KEPT) {
+                forgottenSeq = failedTasks.begin()->first;
+                failedTasks.erase(failedTasks.begin());
+            }
+            pthread_mutex_unlock(&m);
+        }
+        completedSeq.store(firstSeq + i);
+        if (batch[i].onComplete) {
+            batch[i].onComplete(status);
+        }
+        batch[i] = Task();   // payloads back to the pool while the session is still ours
+    }
+    // waiters bump completionWaiters before they look at completedSeq, so one side sees the other
+    if (n > 0 && completionWaiters.load() > 0) {
+        pthread_mutex_lock(&m);
+        pthread_cond_broadcast(&completedCv);
+        pthread_mutex_unlock(&m);
+    }
 
+    // give the session back; a submit that raced with us either sees the flag
+    // cleared and schedules it itself, or left queued > 0 for the check below
+    scheduled.store(false);
+    if ((queued.load() > 0 || stopping.load()) && !scheduled.exchange(true)) {
+        scheduler->requeue(this);
+    }
+}
 
-            timespec now;
-            clock_gettime(CLOCK_MONOTONIC, &now);
-            if (now.tv_sec >=end.tv_sec) {
-                LOG_DEBUG("Session TTL expired for user ID "<<userId);
-                stopping.store(true);
-                //removeProcessFromBuffer(this);  // Usuń z bufora po upływie TTL
-                break;
+// [uint32 length][tuple] straight into the record, false when the row does not fit the codec's schema
+static bool walPutEncodedRow(std::vector<uint8_t>& out, const TupleCodec& codec, const std::vector<allVars>& row, const std::vector<bool>& bitmap) {
+    size_t size = codec.encodedSize(row, bitmap);
+    if (size == 0) {
+        return false;
+    }
+    size_t start = out.size();
+    out.resize(start + sizeof(uint32_t) + size);
+    uint32_t length = static_cast<uint32_t>(size);
+    memcpy(out.data() + start, &length, sizeof(length));
+    return codec.encode(out.data() + start + sizeof(uint32_t), row, bitmap) == size;
+}
+
+void Session::encodeWalRecord(const Task& t, std::vector<uint8_t>& out) {
+    if (t.user != nullptr) {
+        walPutHeader(out, WalRecordKind::USER, xactionId, -1);
+        walPutValue<int64_t>(out, t.user->getId());
+        walPutString(out, t.user->getUsername());
+        walPutString(out, t.user->getEmail());
+        const Sha256Digest& digest = t.user->getPasswdDigest();
+        walPut(out, digest.data(), digest.size());   // the password itself is never logged
+    }
+    else if(t.tupleData != nullptr){
+        std::shared_ptr<const TupleCodec> codec = sharedTupleCodecs.get(t.tupleData->tableId);
+        if (codec) {
+            walPutHeader(out, WalRecordKind::TUPLE_ENCODED, xactionId, t.tupleData->tableId);
+            if (walPutEncodedRow(out, *codec, t.tupleData->data, t.tupleData->bitmap)) {
+                return;
             }
+            out.clear();   // row does not match the schema, log it as is
         }
-
-        if (stopping.load() && q.empty()) {
-            pthread_mutex_unlock(&m);
-            LOG_DEBUG("EXIT SESSION for user ID "<<userId);
-            break;
+        walPutHeader(out, WalRecordKind::TUPLE, xactionId, t.tupleData->tableId);
+        walPutRow(out, t.tupleData->data, t.tupleData->bitmap);
+    }
+    else if(t.tuplesData != nullptr){
+        std::shared_ptr<const TupleCodec> codec = sharedTupleCodecs.get(t.tuplesData->tableId);
+        if (codec) {
+            walPutHeader(out, WalRecordKind::TUPLES_ENCODED, xactionId, t.tuplesData->tableId);
+            walPutValue<uint32_t>(out, static_cast<uint32_t>(t.tuplesData->rows.size()));
+            bool encoded = true;
+            for (size_t i = 0; encoded && i < t.tuplesData->rows.size() && i < t.tuplesData->bitmaps.size(); ++i) {
+                encoded = walPutEncodedRow(out, *codec, t.tuplesData->rows[i], t.tuplesData->bitmaps[i]);
+            }
+            if (encoded) {
+                return;
+            }
+            out.clear();
+        }
+        walPutHeader(out, WalRecordKind::TUPLES, xactionId, t.tuplesData->tableId);
+        walPutValue<uint32_t>(out, static_cast<uint32_t>(t.tuplesData->rows.size()));
+        for (size_t i = 0; i < t.tuplesData->rows.size() && i < t.tuplesData->bitmaps.size(); ++i) {
+            walPutRow(out, t.tuplesData->rows[i], t.tuplesData->bitmaps[i]);
+        }
+    }
+    else if(t.tableHeaderData != nullptr){
+        // [uint32 columns] then per column [int8 type][int8 allow null][name]
+        const tableHeaderAdd* table = t.tableHeaderData.get();
+        walPutHeader(out, WalRecordKind::TABLE, xactionId, table->tableId);
+        walPutValue<uint32_t>(out, static_cast<uint32_t>(table->columnNames.size()));
+        for (size_t i = 0; i < table->columnNames.size(); ++i) {
+            walPutValue<int8_t>(out, i < table->types.size() ? table->types[i] : 0);
+            walPutValue<int8_t>(out, i < table->typesWithAllowNull.size() ? table->typesWithAllowNull[i] : 0);
+            walPutString(out, table->columnNames[i]);
         }
+    }
+}
 
-        Task t = q.front();
-        q.pop();
-        pthread_mutex_unlock(&m);
+bool Session::undoInserts(const Task& t, const std::vector<Ctid>& inserted) {
+    int32_t tableId = t.tupleData != nullptr ? t.tupleData->tableId : t.tuplesData->tableId;
+    std::shared_ptr<TableHeap> heap = sharedTableHeaps.get(tableId);
+    std::shared_ptr<const TupleCodec> codec = sharedTupleCodecs.get(tableId);
+    bool ok = heap && codec;
+    for (size_t i = 0; ok && i < inserted.size(); ++i) {
+        ok = heap->deleteRow(*codec, inserted[i]);
+    }
+    if (!ok) {
+        LOG_ERROR("Rows of table ID " << tableId << " could not be taken out again");
+    }
+    return ok;
+}
 
+TaskStatus Session::execute(Task& t, uint64_t lsn, std::vector<Ctid>& inserted) {
+    try {
         if (t.user != nullptr) {
-            addUserToCache(t.user);
+            sharedBuserIndex.addCached(t.user);
             LOG_INFO("User was created " << t.user->getUsername());
             LOG_DEBUG("User was created " << t.user->getUsername());
 
         }
         else if(t.tupleData != nullptr){
-            addTupleToBuffer(t.tupleData->pathToTablesData, t.tupleData->tableId, t.tupleData->data, t.tupleData->bitmap,xactionId);
+            std::shared_ptr<TableHeap> heap = sharedTableHeaps.get(t.tupleData->tableId);
+            if (heap) {
+                std::shared_ptr<const TupleCodec> codec = sharedTupleCodecs.get(t.tupleData->tableId);
+                Ctid ctid;
+                if (!codec || !heap->insertRow(*codec, t.tupleData->data, t.tupleData->bitmap, lsn, ctid)) {
+                    LOG_ERROR("Tuple was not added to table ID " << t.tupleData->tableId);
+                    return TaskStatus::FAILED;
+                }
+                inserted.push_back(ctid);
+            } else {
+                addTupleToBuffer(t.tupleData->pathToTablesData, t.tupleData->tableId, std::move(t.tupleData->data), std::move(t.tupleData->bitmap),xactionId);
+            }
             LOG_DEBUG("Tuple was added to table ID " << t.tupleData->tableId);
             LOG_INFO("Tuple was added to table ID " << t.tupleData->tableId);
         }
+        else if(t.tuplesData != nullptr){
+            tuplesAdd* batch = t.tuplesData.get();
+            if (batch->rows.size() != batch->bitmaps.size()) {
+                LOG_ERROR(batch->rows.size() << " rows but " << batch->bitmaps.size() << " bitmaps for table ID " << batch->tableId);
+                return TaskStatus::FAILED;
+            }
+            std::shared_ptr<TableHeap> heap = sharedTableHeaps.get(batch->tableId);
+            if (heap) {
+                // page by page: each page is filled with as many rows as fit under one latch
+                std::shared_ptr<const TupleCodec> codec = sharedTupleCodecs.get(batch->tableId);
+                size_t stored = codec ? heap->insertRows(*codec, batch->rows, batch->bitmaps, lsn, inserted) : 0;
+                if (stored != batch->rows.size()) {
+                    // all or nothing, the task's WAL record gets an ABORT
+                    for (const Ctid& ctid : inserted) {
+                        heap->deleteRow(*codec, ctid);
+                    }
+                    inserted.clear();
+                    LOG_ERROR(stored << " of " << batch->rows.size() << " tuples were added to table ID " << batch->tableId);
+                    return TaskStatus::FAILED;
+                }
+            } else {
+                for (size_t i = 0; i < batch->rows.size(); ++i) {
+                    addTupleToBuffer(batch->pathToTablesData, batch->tableId, std::move(batch->rows[i]), std::move(batch->bitmaps[i]), xactionId);
+                }
+            }
+            LOG_DEBUG(batch->rows.size() << " tuples were added to table ID " << batch->tableId);
+            LOG_INFO(batch->rows.size() << " tuples were added to table ID " << batch->tableId);
+        }
         else if(t.tableHeaderData != nullptr){
             LOG_DEBUG("Table header added for table ID "<<t.tableHeaderData->tableId);
             LOG_INFO("Table header added for table ID "<<t.tableHeaderData->tableId);
             addTableToBuffer(tablePath, t.tableHeaderData->tableId, t.tableHeaderData->tableHeaderData);
+            // the codec (and a heap, when heaps are kept) of the new table: its rows take
+            // the TableHeap path and its WAL records are encoded from here on
+            const tableHeaderAdd* table = t.tableHeaderData.get();
+            std::vector<uint8_t> types(table->types.begin(), table->types.end());
+            sharedTupleCodecs.define(table->tableId, types, table->typesWithAllowNull);
+            sharedTableHeaps.openInDirectory(table->tableId);
         }
         //t.promise.set_value();  // Sygnalizuj zakończenie zadania
     }
+    catch (const std::exception& e) {
+        LOG_ERROR("Task failed in session for user ID " << userId << ": " << e.what());
+        return TaskStatus::FAILED;
+    }
+    return TaskStatus::DONE;
+}
+
+TaskStatus Session::taskStatus(uint64_t seq) {
+    pthread_mutex_lock(&m);
+    bool wasFinished = finished;   // read first: nothing completes after finish
+    TaskStatus status = TaskStatus::PENDING;
+    if (seq <= completedSeq.load()) {
+        auto it = failedTasks.find(seq);
+        if (it != failedTasks.end()) {
+            status = it->second;
+        } else {
+            status = seq <= forgottenSeq ? TaskStatus::UNKNOWN : TaskStatus::DONE;
+        }
+    } else if (wasFinished) {
+        status = TaskStatus::CANCELLED;
+    }
+    pthread_mutex_unlock(&m);
+    return status;
+}
+
+TaskStatus Session::waitForTask(uint64_t seq, int64_t timeoutMs) {
+    timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    if (timeoutMs >= 0) {
+        deadline.tv_sec += timeoutMs / 1000;
+        deadline.tv_nsec += (timeoutMs % 1000) * 1000000;
+        if (deadline.tv_nsec >= 1000000000) {
+            deadline.tv_sec += 1;
+            deadline.tv_nsec -= 1000000000;
+        }
+    }
+    pthread_mutex_lock(&m);
+    completionWaiters.fetch_add(1);
+    while (completedSeq.load() < seq && !finished) {
+        if (timeoutMs < 0) {
+            pthread_cond_wait(&completedCv, &m);
+        } else if (pthread_cond_timedwait(&completedCv, &m, &deadline) == ETIMEDOUT) {
+            break;
+        }
+    }
+    completionWaiters.fetch_sub(1);
+    pthread_mutex_unlock(&m);
+    return taskStatus(seq);
+}
+
+TaskStatus TaskHandle::status() const {
+    return session ? session->taskStatus(seq) : TaskStatus::CANCELLED;
+}
+
+TaskStatus TaskHandle::wait() const {
+    return session ? session->waitForTask(seq) : TaskStatus::CANCELLED;
 }
-void Session::addBuser(buser* user){
+
+TaskStatus TaskHandle::waitFor(int64_t timeoutMs) const {
+    return session ? session->waitForTask(seq, timeoutMs < 0 ? 0 : timeoutMs) : TaskStatus::CANCELLED;
+}
+
+TaskHandle Session::addBuser(buser* user, TaskCallback onComplete){
     Task task;
     task.user=user;
-    submit(task, -1);
+    task.onComplete = std::move(onComplete);
+    return submit(std::move(task), -1);
 }
-void Session::addTable(tableHeaderAdd* tableHeaderData){
+TaskHandle Session::addTable(tableHeaderAdd* tableHeaderData, TaskCallback onComplete){
     Task task;
     tableHeaderData->tableHeaderData->setXmin(xactionId);
-    task.tableHeaderData = tableHeaderData;
-    submit(task, -1);
+    task.tableHeaderData.reset(tableHeaderData);
+    task.onComplete = std::move(onComplete);
+    return submit(std::move(task), -1);
+}
+//
+TaskHandle Session::addTuple(std::string pathToTablesData, int32_t tableId, std::vector<allVars> data, std::vector<bool> bitmap, TaskCallback onComplete){
+    Task task;
+    task.tupleData = tuplePool.acquire();
+    task.tupleData->pathToTablesData = std::move(pathToTablesData);
+    task.tupleData->tableId = tableId;
+    task.tupleData->data = std::move(data);
+    task.tupleData->bitmap = std::move(bitmap);
+    task.onComplete = std::move(onComplete);
+    return submit(std::move(task), 1);
+}
+TaskHandle Session::addTuples(std::unique_ptr<tuplesAdd> tuplesData, TaskCallback onComplete){
+    Task task;
+    task.tuplesData = std::move(tuplesData);
+    task.onComplete = std::move(onComplete);
+    return submit(std::move(task), -1);
 }
-//
\ No newline at end of file
@@ -4,11 +4,20 @@
 #include <pthread.h>
 #include <queue>
 #include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
 #include <time.h>
 #include "../../bufforing-stm/src/buserCache.h"
 #include "buser.h"
+#include "buserIndex.h"
 #include "../../bufforing-stm/src/QuakeSharedBuffers.h"
 #include "../../bufforing-stm/src/log.h"
+#include "taskQueue.h"
+#include "sessionScheduler.h"
+#include "payloadPool.h"
+#include "slottedPage.h"
+#include "walGroupCommit.h"
 
 
 struct tupleAdd {
@@ -18,44 +27,130 @@ struct tupleAdd {
         std::vector<bool> bitmap;
 };
 
+// many rows of one table in one task: one allocation and one queue handoff per batch
+struct tuplesAdd {
+        std::string pathToTablesData;
+        int32_t tableId;
+        std::vector<std::vector<allVars>> rows;
+        std::vector<std::vector<bool>> bitmaps;
+};
+
 struct tableHeaderAdd {
     tableHeader* tableHeaderData;
     int32_t tableId;
+    // the schema again, for the WAL record of the table
+    std::vector<int8_t> types;
+    std::vector<int8_t> typesWithAllowNull;
+    std::vector<std::string> columnNames;
+};
+
+constexpr size_t SESSION_QUEUE_CAPACITY = 4096;
+constexpr size_t SESSION_TASK_BATCH = 64;
+// failures a session remembers; past this the oldest is forgotten, and tasks up to it read UNKNOWN
+constexpr size_t SESSION_FAILED_TASKS_KEPT = SESSION_QUEUE_CAPACITY;
+
+enum class TaskStatus : int8_t {
+    PENDING,
+    DONE,
+    FAILED,
+    CANCELLED,  // the session finished before the task ran
+    UNKNOWN     // ran, but the outcome was forgotten (SESSION_FAILED_TASKS_KEPT)
 };
 
+// called on the worker right after the task ran, must not block
+typedef std::function<void(TaskStatus)> TaskCallback;
+
+// Move-only: payloads are owned by the task and travel through the session
+// queue without being copied, they are freed after the task ran.
 struct Task {
     int32_t userIp=-1; // answer to ip adress
-    buser *user=nullptr; // adding buser trough the task
-    tupleAdd *tupleData=nullptr; // adding tuple task
-    tableHeaderAdd *tableHeaderData=nullptr; // adding table task
-    
+    buser *user=nullptr; // adding buser trough the task, the user cache takes it over
+    PooledPtr<tupleAdd> tupleData; // adding tuple task, from the session's pool
+    std::unique_ptr<tuplesAdd> tuplesData; // adding many tuples task
+    std::unique_ptr<tableHeaderAdd> tableHeaderData; // adding table task
+    TaskCallback onComplete; // optional
 
 };
 
+class Session;
+
+// Completion handle of a submitted task. Tasks of a session run in the order
+// they were queued, so a handle is just the session and the task's position
+// in that order: no allocation per task, and waiting on the last handle of a
+// pipeline waits for all tasks before it. It must not outlive its session.
+// The outcome lives in the session, so copies of a handle read the same status.
+class TaskHandle {
+    private:
+        Session* session = nullptr;
+        uint64_t seq = 0;
+    public:
+        TaskHandle() = default;
+        TaskHandle(Session* session, uint64_t seq) : session(session), seq(seq) {}
+        bool valid() const { return session != nullptr; }
+        explicit operator bool() const { return valid(); }
+        uint64_t getSequence() const { return seq; }
+        // does not block; CANCELLED for an invalid handle
+        TaskStatus status() const;
+        TaskStatus wait() const;
+        // PENDING when the task did not complete within timeoutMs
+        TaskStatus waitFor(int64_t timeoutMs) const;
+};
+
+// A Session is a task context run by the SessionScheduler workers, not a
+// thread of its own. The scheduled flag makes sure only one worker drains it.
 class Session {
 public:
-    explicit Session(int ttl,int64_t xactionId);
+    explicit Session(int ttl,int64_t xactionId, SessionScheduler* scheduler = &sharedSessionScheduler);
     ~Session();
     
     void start(std::string username, std::string passwd,std::string tablePath);
-    void submit(Task t,int32_t userIp);
+    TaskHandle submit(Task&& t,int32_t userIp);
     void stop();
-    void addBuser(buser* user);
-    void addTable(tableHeaderAdd* tableHeaderData);
+    TaskHandle addBuser(buser* user, TaskCallback onComplete = nullptr);
+    TaskHandle addTable(tableHeaderAdd* tableHeaderData, TaskCallback onComplete = nullptr);
+    // the row is moved into the task, pass it with std::move to avoid any copy
+    TaskHandle addTuple(std::string pathToTablesData, int32_t tableId, std::vector<allVars> data, std::vector<bool> bitmap, TaskCallback onComplete = nullptr);
+    TaskHandle addTuples(std::unique_ptr<tuplesAdd> tuplesData, TaskCallback onComplete = nullptr);
+    TaskStatus taskStatus(uint64_t seq);
+    // blocks until the task ran or the session finished; timeoutMs < 0 waits forever
+    TaskStatus waitForTask(uint64_t seq, int64_t timeoutMs = -1);
+    size_t getTuplePoolCapacity() { return tuplePool.getCapacity(); }
     //bool checkUserProcess(std::string username,std::string passwd);
-    void run();
+    // called by a worker: runs up to SESSION_TASK_BATCH tasks and gives the session back
+    void runSlice();
+    // TTL expired, the session drains what it has and finishes
+    void expire();
+    bool isFinished();
     int64_t getUserId(){return userId; };
     int32_t getThreadId(){return threadId; };
     void setXactionId(int64_t xactionId){ this->xactionId = xactionId; }
+    void setWal(WalGroupCommit* wal){ this->wal = wal; }
 
 private:
-    static void* thread_entry(void* arg);
+    // lsn of the task's WAL record, 0 when it is not logged; inserted gets the ctids of the
+    // rows the task stored in a TableHeap
+    TaskStatus execute(Task& t, uint64_t lsn, std::vector<Ctid>& inserted);
+    // deletes the heap rows of a task again, false when some could not be deleted
+    bool undoInserts(const Task& t, const std::vector<Ctid>& inserted);
+    void encodeWalRecord(const Task& t, std::vector<uint8_t>& out);
+    void scheduleIfIdle();
+    void finish();
+    // a task that will not run: its callback gets CANCELLED and its payloads are
+    // freed, a buser stays the caller's
+    void cancel(Task& t);
+    void cancelAll(std::vector<Task>& tasks);
+    // empties the ring of a finished session, called with m held
+    std::vector<Task> takeQueued();
     bool checkUser(std::string username, std::string passwd);
     void setTtl(int seconds) { ttl = seconds; }
 private:
-    pthread_t thread{}; 
+    SessionScheduler* scheduler=nullptr;
+    WalGroupCommit* wal=&sharedWal;        // records are written only while it is open
+    std::vector<uint8_t> walRecord;        // scratch, used by the worker running the session
+    std::vector<Ctid> inserted[SESSION_TASK_BATCH];   // same, heap rows of each task of the slice
     pthread_mutex_t m{};
-    pthread_cond_t cv{};
+    pthread_cond_t finishedCv{};
+    pthread_cond_t completedCv{};          // CLOCK_MONOTONIC
 
     int32_t threadId=-1;
     int64_t userId=-1;
@@ -63,8 +158,20 @@ private:
     int64_t xactionId=-1;
     std::string tablePath="";
 
-    std::queue<Task> q;
+    int64_t deadlineNs=0;
+
+    PayloadPool<tupleAdd> tuplePool;   // declared before q: queued tasks return their payloads first
+    MpscRing<Task> q{SESSION_QUEUE_CAPACITY};
+    std::atomic<int64_t> queued{0};        // pushed and not yet taken by a worker
+    std::atomic<bool> scheduled{false};    // on a deque or being run by a worker
     std::atomic<bool> stopping{false};
+    bool started=false;
+    bool finished=false;                   // guarded by m
+
+    std::atomic<uint64_t> completedSeq{0};  // tasks 1..completedSeq have run
+    std::atomic<int32_t> completionWaiters{0};
+    std::map<uint64_t, TaskStatus> failedTasks;   // guarded by m, only tasks that did not succeed
+    uint64_t forgottenSeq = 0;                     // guarded by m, outcomes up to it are UNKNOWN
 };
 
 #endif
@@ -0,0 +1,284 @@
+#include <string>
+#include <type_traits>
+#include "tupleCodec.h"
+
+TupleCodecRegistry sharedTupleCodecs;
+
+TupleCodec::TupleCodec(const std::vector<uint8_t>& types, const std::vector<int8_t>& allowNull, TableStorage storage)
+    : types(types), offsets(types.size(), 0), storage(storage)
+{
+    size_t natts = types.size();
+    bitmapBytes = tupleBitmapSize(natts);
+    allPresent.assign(bitmapBytes, 0);
+    required.assign(bitmapBytes, 0);
+    std::vector<bool> nullable(natts, false);
+    for (size_t i = 0; i < natts; ++i) {
+        uint8_t bit = static_cast<uint8_t>(1u << (i & 7));
+        allPresent[i >> 3] |= bit;
+        nullable[i] = i < allowNull.size() && allowNull[i] != 0;
+        if (nullable[i]) {
+            noNulls = false;
+        } else {
+            required[i >> 3] |= bit;
+        }
+    }
+    size_t offset = TUPLE_HEADER_SIZE + bitmapBytes;
+    firstVarColumn = natts;
+    for (size_t i = 0; i < natts; ++i) {
+        size_t size = tupleTypeSize(types[i]);
+        if (size == 0) {
+            firstVarColumn = i;
+            allFixed = false;
+            break;
+        }
+        offsets[i] = static_cast<uint16_t>(offset);
+        FixedColumn fixed{static_cast<uint16_t>(i), static_cast<uint16_t>(offset)};
+        groups[types[i]].push_back(fixed);
+        if (nullable[i]) {
+            nullableFixed.push_back(fixed);
+        }
+        offset += size;
+    }
+    fixedEnd = offset;
+    if (allFixed) {
+        encodeFn = noNulls ? &encodeImpl<true, true> : &encodeImpl<true, false>;
+        decodeFn = &decodeImpl<true>;
+    } else {
+        encodeFn = noNulls ? &encodeImpl<false, true> : &encodeImpl<false, false>;
+        decodeFn = &decodeImpl<false>;
+    }
+}
+
+size_t TupleCodec::encodedSize(const std::vector<allVars>& row, const std::vector<bool>& bitmap) const {
+    if (row.size() != types.size()) {
+        return 0;
+    }
+    if (allFixed) {
+        return fixedEnd;
+    }
+    size_t size = fixedEnd;
+    for (size_t i = firstVarColumn; i < types.size(); ++i) {
+        if (row[i].index() != types[i]) {
+            return 0;
+        }
+        if (const std::string* s = std::get_if<std::string>(&row[i])) {
+            bool present = noNulls || (i < bitmap.size() && bitmap[i]);
+            size += sizeof(uint16_t) + (present ? s->size() : 0);
+        } else {
+            size += tupleTypeSize(types[i]);
+        }
+    }
+    return size;
+}
+
+template<typename T>
+static constexpr uint8_t tupleTypeOf() {
+    if constexpr (std::is_same<T, int8_t>::value) {
+        return TUPLE_TYPE_INT8;
+    } else if constexpr (std::is_same<T, int16_t>::value) {
+        return TUPLE_TYPE_INT16;
+    } else if constexpr (std::is_same<T, int32_t>::value) {
+        return TUPLE_TYPE_INT32;
+    } else if constexpr (std::is_same<T, int64_t>::value) {
+        return TUPLE_TYPE_INT64;
+    } else {
+        return TUPLE_TYPE_BOOL;
+    }
+}
+
+// one type group, no switch: get_if is the only check against the schema
+template<typename T>
+bool TupleCodec::putGroup(uint8_t* out, const std::vector<allVars>& row) const {
+    for (const FixedColumn& f : groups[tupleTypeOf<T>()]) {
+        const T* value = std::get_if<T>(&row[f.column]);
+        if (value == nullptr) {
+            return false;
+        }
+        if constexpr (std::is_same<T, bool>::value) {
+            out[f.offset] = *value ? 1 : 0;
+        } else {
+            memcpy(out + f.offset, value, sizeof(T));
+        }
+    }
+    return true;
+}
+
+// a column behind the first string, the caller checked its type
+static inline size_t putColumn(uint8_t* p, uint8_t type, const allVars& value, bool present) {
+    switch (type) {
+        case TUPLE_TYPE_INT8: { int8_t v = present ? *std::get_if<int8_t>(&value) : 0; memcpy(p, &v, 1); return 1; }
+        case TUPLE_TYPE_INT16: { int16_t v = present ? *std::get_if<int16_t>(&value) : 0; memcpy(p, &v, 2); return 2; }
+        case TUPLE_TYPE_INT32: { int32_t v = present ? *std::get_if<int32_t>(&value) : 0; memcpy(p, &v, 4); return 4; }
+        case TUPLE_TYPE_INT64: { int64_t v = present ? *std::get_if<int64_t>(&value) : 0; memcpy(p, &v, 8); return 8; }
+        case TUPLE_TYPE_BOOL: *p = present && *std::get_if<bool>(&value) ? 1 : 0; return 1;
+        default: {
+            const std::string& s = *std::get_if<std::string>(&value);
+            uint16_t length = present ? static_cast<uint16_t>(s.size()) : 0;
+            memcpy(p, &length, sizeof(length));
+            memcpy(p + sizeof(length), s.data(), length);
+            return sizeof(length) + length;
+        }
+    }
+}
+
+template<bool AllFixed, bool NoNulls>
+size_t TupleCodec::encodeImpl(const TupleCodec& c, uint8_t* out, const std::vector<allVars>& row, const std::vector<bool>& bitmap) {
+    size_t natts = c.types.size();
+    if (row.size() != natts || (!NoNulls && bitmap.size() < natts)) {
+        return 0;
+    }
+    uint16_t count = static_cast<uint16_t>(natts);
+    memcpy(out, &count, sizeof(count));
+    uint8_t* nulls = out + TUPLE_HEADER_SIZE;
+    if (NoNulls) {
+        memcpy(nulls, c.allPresent.data(), c.bitmapBytes);
+    } else {
+        // pack once, then the not null constraint is a mask test per byte
+        std::vector<bool>::const_iterator it = bitmap.begin();
+        for (size_t b = 0; b < c.bitmapBytes; ++b) {
+            uint8_t bits = 0;
+            for (size_t i = b * 8; i < natts && i < b * 8 + 8; ++i, ++it) {
+                bits |= static_cast<uint8_t>(*it << (i & 7));
+            }
+            if ((bits & c.required[b]) != c.required[b]) {
+                return 0;
+            }
+            nulls[b] = bits;
+        }
+    }
+    if (!c.putGroup<int64_t>(out, row) || !c.putGroup<int32_t>(out, row) || !c.putGroup<int16_t>(out, row) ||
+        !c.putGroup<int8_t>(out, row) || !c.putGroup<bool>(out, row)) {
+        return 0;
+    }
+    if (!NoNulls) {
+        for (const FixedColumn& f : c.nullableFixed) {
+            if (!((nulls[f.column >> 3] >> (f.column & 7)) & 1)) {
+                memset(out + f.offset, 0, tupleTypeSize(c.types[f.column]));
+            }
+        }
+    }
+    if (AllFixed) {
+        return c.fixedEnd;
+    }
+    uint8_t* p = out + c.fixedEnd;
+    for (size_t i = c.firstVarColumn; i < natts; ++i) {
+        if (row[i].index() != c.types[i]) {
+            return 0;
+        }
+        bool present = NoNulls || ((nulls[i >> 3] >> (i & 7)) & 1);
+        p += putColumn(p, c.types[i], row[i], present);
+    }
+    return static_cast<size_t>(p - out);
+}
+
+template<typename T>
+void TupleCodec::getGroup(const uint8_t* in, std::vector<allVars>& row) const {
+    for (const FixedColumn& f : groups[tupleTypeOf<T>()]) {
+        T value;
+        if constexpr (std::is_same<T, bool>::value) {
+            value = in[f.offset] != 0;
+        } else {
+            memcpy(&value, in + f.offset, sizeof(T));
+        }
+        row[f.column] = value;
+    }
+}
+
+static inline allVars getColumn(const uint8_t* p, uint8_t type) {
+    switch (type) {
+        case TUPLE_TYPE_INT8: { int8_t v; memcpy(&v, p, 1); return allVars(v); }
+        case TUPLE_TYPE_INT16: { int16_t v; memcpy(&v, p, 2); return allVars(v); }
+        case TUPLE_TYPE_INT32: { int32_t v; memcpy(&v, p, 4); return allVars(v); }
+        case TUPLE_TYPE_INT64: { int64_t v; memcpy(&v, p, 8); return allVars(v); }
+        default: return allVars(*p != 0);
+    }
+}
+
+template<bool AllFixed>
+bool TupleCodec::decodeImpl(const TupleCodec& c, const uint8_t* in, size_t length, std::vector<allVars>& row, std::vector<bool>& bitmap) {
+    size_t natts = c.types.size();
+    uint16_t count;
+    // one length check covers the whole fixed-offset prefix
+    if (length < c.fixedEnd || (memcpy(&count, in, sizeof(count)), count != natts)) {
+        return false;
+    }
+    const uint8_t* nulls = in + TUPLE_HEADER_SIZE;
+    row.resize(natts);
+    bitmap.resize(natts);
+    for (size_t i = 0; i < natts; ++i) {
+        bitmap[i] = (nulls[i >> 3] >> (i & 7)) & 1;
+    }
+    c.getGroup<int64_t>(in, row);
+    c.getGroup<int32_t>(in, row);
+    c.getGroup<int16_t>(in, row);
+    c.getGroup<int8_t>(in, row);
+    c.getGroup<bool>(in, row);
+    if (AllFixed) {
+        return true;
+    }
+    const uint8_t* p = in + c.fixedEnd;
+    const uint8_t* end = in + length;
+    for (size_t i = c.firstVarColumn; i < natts; ++i) {
+        if (c.types[i] == TUPLE_TYPE_STRING) {
+            uint16_t len;
+            if (end - p < static_cast<ptrdiff_t>(sizeof(len))) {
+                return false;
+            }
+            memcpy(&len, p, sizeof(len));
+            p += sizeof(len);
+            if (end - p < len) {
+                return false;
+            }
+            row[i] = std::string(reinterpret_cast<const char*>(p), len);
+            p += len;
+            continue;
+        }
+        size_t size = tupleTypeSize(c.types[i]);
+        if (end - p < static_cast<ptrdiff_t>(size)) {
+            return false;
+        }
+        row[i] = getColumn(p, c.types[i]);
+        p += size;
+    }
+    return true;
+}
+
+TupleCodecRegistry::TupleCodecRegistry() {
+    pthread_rwlock_init(&lock, nullptr);
+}
+
+TupleCodecRegistry::~TupleCodecRegistry() {
+    pthread_rwlock_destroy(&lock);
+}
+
+std::shared_ptr<const TupleCodec> TupleCodecRegistry::define(int32_t tableId, const std::vector<uint8_t>& types, const std::vector<int8_t>& allowNull,
+                                                             TableStorage storage) {
+    std::shared_ptr<const TupleCodec> codec = std::make_shared<const TupleCodec>(types, allowNull, storage);
+    pthread_rwlock_wrlock(&lock);
+    codecs[tableId] = codec;
+    pthread_rwlock_unlock(&lock);
+    return codec;
+}
+
+std::shared_ptr<const TupleCodec> TupleCodecRegistry::get(int32_t tableId) {
+    std::shared_ptr<const TupleCodec> codec;
+    pthread_rwlock_rdlock(&lock);
+    auto it = codecs.find(tableId);
+    if (it != codecs.end()) {
+        codec = it->second;
+    }
+    pthread_rwlock_unlock(&lock);
+    return codec;
+}
+
+void TupleCodecRegistry::erase(int32_t tableId) {
+    pthread_rwlock_wrlock(&lock);
+    codecs.erase(tableId);
+    pthread_rwlock_unlock(&lock);
+}
+
+void TupleCodecRegistry::clear() {
+    pthread_rwlock_wrlock(&lock);
+    codecs.clear();
+    pthread_rwlock_unlock(&lock);
+}
@@ -0,0 +1,124 @@
+#ifndef TUPLECODEC_H
+#define TUPLECODEC_H
+
+#include <pthread.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "tupleFormat.h"
+
+// Encoder/decoder of one table's tuples, built once from the table's column
+// types when the table is created or loaded. The layout is worked out up
+// front: every column before the first string has a fixed offset and those
+// columns are grouped by type, so a row is written one type group at a time
+// with a plain loop per group instead of a type switch (or std::visit) per
+// column. The encode/decode loops are template instances picked for the
+// schema's shape: all fixed width or not, nullable columns or not. Without
+// nullable columns the prebuilt all-present bitmap is copied and the caller's
+// bitmap is not read at all. Output is the tuple format of tupleFormat.h,
+// byte for byte what encodeTuple writes.
+
+// page layout of a table's data, the value is the format byte of its pages
+enum class TableStorage : uint8_t {
+    ROW = 1,    // slotted pages of encoded tuples (slottedPage.h)
+    PAX = 2     // column by column pages for analytic tables (paxPage.h)
+};
+
+class TupleCodec {
+    private:
+        typedef size_t (*EncodeFn)(const TupleCodec&, uint8_t*, const std::vector<allVars>&, const std::vector<bool>&);
+        typedef bool (*DecodeFn)(const TupleCodec&, const uint8_t*, size_t, std::vector<allVars>&, std::vector<bool>&);
+
+        struct FixedColumn {
+            uint16_t column;
+            uint16_t offset;
+        };
+        std::vector<uint8_t> types;
+        std::vector<uint16_t> offsets;       // fixed offset of each column before the first string
+        std::vector<FixedColumn> groups[TUPLE_TYPE_STRING];   // fixed-offset columns by type
+        std::vector<FixedColumn> nullableFixed;
+        std::vector<uint8_t> allPresent;     // bitmap with every column not null
+        std::vector<uint8_t> required;       // bitmap of the not null columns
+        size_t bitmapBytes = 0;
+        size_t fixedEnd = 0;                 // end of the fixed-offset prefix
+        size_t firstVarColumn = 0;           // == column count when there are no strings
+        bool allFixed = true;
+        bool noNulls = true;
+        TableStorage storage = TableStorage::ROW;
+        EncodeFn encodeFn = nullptr;
+        DecodeFn decodeFn = nullptr;
+
+        template<typename T>
+        bool putGroup(uint8_t* out, const std::vector<allVars>& row) const;
+        template<typename T>
+        void getGroup(const uint8_t* in, std::vector<allVars>& row) const;
+        template<bool AllFixed, bool NoNulls>
+        static size_t encodeImpl(const TupleCodec& c, uint8_t* out, const std::vector<allVars>& row, const std::vector<bool>& bitmap);
+        template<bool AllFixed>
+        static bool decodeImpl(const TupleCodec& c, const uint8_t* in, size_t length, std::vector<allVars>& row, std::vector<bool>& bitmap);
+
+    public:
+        // types are TUPLE_TYPE_*, allowNull[i] != 0 lets column i be null (missing entries: not null)
+        TupleCodec(const std::vector<uint8_t>& types, const std::vector<int8_t>& allowNull, TableStorage storage = TableStorage::ROW);
+
+        size_t getColumnCount() const { return types.size(); }
+        const std::vector<uint8_t>& getTypes() const { return types; }
+        TableStorage getStorage() const { return storage; }
+        bool isAllFixed() const { return allFixed; }
+        bool hasNullable() const { return !noNulls; }
+        // size of every tuple when the schema is all fixed width
+        size_t getFixedSize() const { return fixedEnd; }
+
+        // 0 when the row cannot fit the schema; encode() does the full check.
+        // A null string only takes its length, as encode() writes it.
+        size_t encodedSize(const std::vector<allVars>& row, const std::vector<bool>& bitmap) const;
+        // out must have encodedSize(row, bitmap) bytes; returns the bytes written, 0 when the row
+        // does not fit the schema (column count, a type, null in a not null column).
+        // A schema without nullable columns ignores bitmap, every value is stored.
+        size_t encode(uint8_t* out, const std::vector<allVars>& row, const std::vector<bool>& bitmap) const {
+            return encodeFn(*this, out, row, bitmap);
+        }
+        bool decode(const uint8_t* in, size_t length, std::vector<allVars>& row, std::vector<bool>& bitmap) const {
+            return decodeFn(*this, in, length, row, bitmap);
+        }
+
+        // one fixed-offset column straight from the tuple, no decoding of the others;
+        // false for columns behind a string, other types or a null value
+        template<typename T>
+        bool readColumn(const uint8_t* tuple, size_t length, size_t column, T& value) const {
+            if (column >= firstVarColumn || tupleTypeSize(types[column]) != sizeof(T) ||
+                length < static_cast<size_t>(offsets[column]) + sizeof(T) ||
+                !((tuple[TUPLE_HEADER_SIZE + (column >> 3)] >> (column & 7)) & 1)) {
+                return false;
+            }
+            memcpy(&value, tuple + offsets[column], sizeof(T));
+            return true;
+        }
+};
+
+// tableId -> codec of the table. Codecs are immutable, a reader keeps its
+// shared_ptr while a redefinition (ALTER, reload) swaps the entry.
+class TupleCodecRegistry {
+    private:
+        pthread_rwlock_t lock;
+        std::unordered_map<int32_t, std::shared_ptr<const TupleCodec>> codecs;
+    public:
+        TupleCodecRegistry();
+        ~TupleCodecRegistry();
+        TupleCodecRegistry(const TupleCodecRegistry&) = delete;
+        TupleCodecRegistry& operator=(const TupleCodecRegistry&) = delete;
+
+        std::shared_ptr<const TupleCodec> define(int32_t tableId, const std::vector<uint8_t>& types, const std::vector<int8_t>& allowNull,
+                                                 TableStorage storage = TableStorage::ROW);
+        // nullptr for tables without a codec
+        std::shared_ptr<const TupleCodec> get(int32_t tableId);
+        void erase(int32_t tableId);
+        void clear();
+};
+
+extern TupleCodecRegistry sharedTupleCodecs;
+
+#endif
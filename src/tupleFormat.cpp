@@ -0,0 +1,117 @@
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include "tupleFormat.h"
+
+size_t tupleTypeSize(uint8_t type) {
+    switch (type) {
+        case TUPLE_TYPE_INT8: return sizeof(int8_t);
+        case TUPLE_TYPE_INT16: return sizeof(int16_t);
+        case TUPLE_TYPE_INT32: return sizeof(int32_t);
+        case TUPLE_TYPE_INT64: return sizeof(int64_t);
+        case TUPLE_TYPE_BOOL: return 1;
+        default: return 0;
+    }
+}
+
+size_t tupleEncodedSize(const std::vector<allVars>& row, const std::vector<bool>& bitmap) {
+    size_t size = TUPLE_HEADER_SIZE + tupleBitmapSize(row.size());
+    for (size_t i = 0; i < row.size(); ++i) {
+        if (const std::string* s = std::get_if<std::string>(&row[i])) {
+            bool present = i < bitmap.size() && bitmap[i];
+            size += sizeof(uint16_t) + (present ? s->size() : 0);
+        } else {
+            size += tupleTypeSize(static_cast<uint8_t>(row[i].index()));
+        }
+    }
+    return size;
+}
+
+size_t encodeTuple(uint8_t* out, const std::vector<allVars>& row, const std::vector<bool>& bitmap) {
+    uint8_t* p = out;
+    uint16_t natts = static_cast<uint16_t>(row.size());
+    memcpy(p, &natts, sizeof(natts));
+    p += sizeof(natts);
+    uint8_t* nulls = p;
+    memset(nulls, 0, tupleBitmapSize(row.size()));
+    p += tupleBitmapSize(row.size());
+    for (size_t i = 0; i < row.size(); ++i) {
+        bool present = i < bitmap.size() && bitmap[i];
+        if (present) {
+            nulls[i >> 3] |= static_cast<uint8_t>(1u << (i & 7));
+        }
+        std::visit([&p, present](const auto& value) {
+            typedef std::decay_t<decltype(value)> V;
+            if constexpr (std::is_same<V, std::string>::value) {
+                uint16_t length = present ? static_cast<uint16_t>(value.size()) : 0;
+                memcpy(p, &length, sizeof(length));
+                p += sizeof(length);
+                memcpy(p, value.data(), length);
+                p += length;
+            } else if constexpr (std::is_same<V, bool>::value) {
+                *p++ = present && value ? 1 : 0;
+            } else {
+                V v = present ? value : V();
+                memcpy(p, &v, sizeof(V));
+                p += sizeof(V);
+            }
+        }, row[i]);
+    }
+    return static_cast<size_t>(p - out);
+}
+
+template<typename T>
+static allVars readFixed(const uint8_t* p) {
+    T v;
+    memcpy(&v, p, sizeof(T));
+    return allVars(v);
+}
+
+bool decodeTuple(const uint8_t* in, size_t length, const std::vector<uint8_t>& types,
+                 std::vector<allVars>& row, std::vector<bool>& bitmap) {
+    if (length < TUPLE_HEADER_SIZE) {
+        return false;
+    }
+    uint16_t natts;
+    memcpy(&natts, in, sizeof(natts));
+    if (natts != types.size() || length < TUPLE_HEADER_SIZE + tupleBitmapSize(natts)) {
+        return false;
+    }
+    const uint8_t* nulls = in + TUPLE_HEADER_SIZE;
+    const uint8_t* p = nulls + tupleBitmapSize(natts);
+    const uint8_t* end = in + length;
+    row.clear();
+    row.reserve(natts);
+    bitmap.assign(natts, false);
+    for (size_t i = 0; i < natts; ++i) {
+        bitmap[i] = (nulls[i >> 3] >> (i & 7)) & 1;
+        uint8_t type = types[i];
+        if (type == TUPLE_TYPE_STRING) {
+            uint16_t len;
+            if (end - p < static_cast<ptrdiff_t>(sizeof(len))) {
+                return false;
+            }
+            memcpy(&len, p, sizeof(len));
+            p += sizeof(len);
+            if (end - p < len) {
+                return false;
+            }
+            row.emplace_back(std::string(reinterpret_cast<const char*>(p), len));
+            p += len;
+            continue;
+        }
+        size_t size = tupleTypeSize(type);
+        if (size == 0 || end - p < static_cast<ptrdiff_t>(size)) {
+            return false;
+        }
+        switch (type) {
+            case TUPLE_TYPE_INT8: row.push_back(readFixed<int8_t>(p)); break;
+            case TUPLE_TYPE_INT16: row.push_back(readFixed<int16_t>(p)); break;
+            case TUPLE_TYPE_INT32: row.push_back(readFixed<int32_t>(p)); break;
+            case TUPLE_TYPE_INT64: row.push_back(readFixed<int64_t>(p)); break;
+            default: row.push_back(allVars(*p != 0)); break;
+        }
+        p += size;
+    }
+    return true;
+}
@@ -0,0 +1,42 @@
+#ifndef TUPLEFORMAT_H
+#define TUPLEFORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "../../bufforing-stm/src/QuakeSharedBuffers.h"
+
+// On-page layout of a row, written straight into the page frame:
+//
+//   [uint16 natts][null bitmap, (natts + 7) / 8 bytes, bit set = not null][values]
+//
+// Values follow in column order, little endian: int8/16/32/64 take their
+// size, bool one byte, string [uint16 length][bytes]. A null fixed-width
+// column still takes its size (zeros) and a null string has length 0, so in a
+// schema without strings every column sits at the same offset in every tuple.
+// The type of a column is its allVars index (TUPLE_TYPE_*); the tuple does
+// not store types, the reader brings the table's.
+
+constexpr uint8_t TUPLE_TYPE_INT8 = 0;
+constexpr uint8_t TUPLE_TYPE_INT16 = 1;
+constexpr uint8_t TUPLE_TYPE_INT32 = 2;
+constexpr uint8_t TUPLE_TYPE_INT64 = 3;
+constexpr uint8_t TUPLE_TYPE_BOOL = 4;
+constexpr uint8_t TUPLE_TYPE_STRING = 5;
+
+constexpr size_t TUPLE_HEADER_SIZE = sizeof(uint16_t);
+
+inline size_t tupleBitmapSize(size_t natts) { return (natts + 7) / 8; }
+
+// fixed size of a column type, 0 for strings
+size_t tupleTypeSize(uint8_t type);
+
+// a null string takes only its length, like encodeTuple writes it
+size_t tupleEncodedSize(const std::vector<allVars>& row, const std::vector<bool>& bitmap);
+// out must have tupleEncodedSize(row, bitmap) bytes, returns the bytes written
+size_t encodeTuple(uint8_t* out, const std::vector<allVars>& row, const std::vector<bool>& bitmap);
+// false when the tuple is shorter than the types say or has another column count
+bool decodeTuple(const uint8_t* in, size_t length, const std::vector<uint8_t>& types,
+                 std::vector<allVars>& row, std::vector<bool>& bitmap);
+
+#endif
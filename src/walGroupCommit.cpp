@@ -0,0 +1,161 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include "walGroupCommit.h"
+#include "../../bufforing-stm/src/log.h"
+
+WalGroupCommit sharedWal;
+
+WalGroupCommit::WalGroupCommit() {
+    pthread_mutex_init(&m, nullptr);
+    pthread_cond_init(&flushedCv, nullptr);
+}
+
+WalGroupCommit::~WalGroupCommit() {
+    close();
+    pthread_mutex_destroy(&m);
+    pthread_cond_destroy(&flushedCv);
+}
+
+bool WalGroupCommit::open(const std::string& path) {
+    close();
+    int newFd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (newFd < 0) {
+        LOG_ERROR("Cannot open WAL " << path << ", errno " << errno);
+        return false;
+    }
+    struct stat st;
+    uint64_t size = fstat(newFd, &st) == 0 ? static_cast<uint64_t>(st.st_size) : 0;
+    pthread_mutex_lock(&m);
+    fd = newFd;
+    this->path = path;
+    appendedLsn = size;
+    flushedLsn = size;
+    ioError = false;
+    buffer.clear();
+    pthread_mutex_unlock(&m);
+    LOG_DEBUG("WAL opened " << path << " at LSN " << size);
+    return true;
+}
+
+void WalGroupCommit::close() {
+    pthread_mutex_lock(&m);
+    if (fd < 0) {
+        pthread_mutex_unlock(&m);
+        return;
+    }
+    uint64_t lsn = appendedLsn;
+    pthread_mutex_unlock(&m);
+    commit(lsn);
+
+    pthread_mutex_lock(&m);
+    while (flushing) {
+        pthread_cond_wait(&flushedCv, &m);
+    }
+    ::close(fd);
+    fd = -1;
+    buffer.clear();
+    pthread_cond_broadcast(&flushedCv);
+    pthread_mutex_unlock(&m);
+}
+
+bool WalGroupCommit::isOpen() {
+    pthread_mutex_lock(&m);
+    bool result = fd >= 0;
+    pthread_mutex_unlock(&m);
+    return result;
+}
+
+uint64_t WalGroupCommit::append(const void* data, uint32_t length) {
+    pthread_mutex_lock(&m);
+    if (fd < 0) {
+        pthread_mutex_unlock(&m);
+        return 0;
+    }
+    walPutValue<uint32_t>(buffer, length);
+    walPut(buffer, data, length);
+    appendedLsn += sizeof(uint32_t) + length;
+    uint64_t lsn = appendedLsn;
+    pthread_mutex_unlock(&m);
+    return lsn;
+}
+
+bool WalGroupCommit::writeAll(const std::vector<uint8_t>& data) {
+    size_t done = 0;
+    while (done < data.size()) {
+        ssize_t rc = ::write(fd, data.data() + done, data.size() - done);
+        if (rc < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG_ERROR("WAL write failed, errno " << errno);
+            return false;
+        }
+        done += static_cast<size_t>(rc);
+    }
+    return true;
+}
+
+bool WalGroupCommit::commit(uint64_t lsn) {
+    activeCommitters.fetch_add(1);
+    commitCount.fetch_add(1);
+    bool ok = true;
+    pthread_mutex_lock(&m);
+    while (flushedLsn < lsn) {
+        if (ioError || fd < 0) {
+            ok = false;
+            break;
+        }
+        if (flushing) {
+            pthread_cond_wait(&flushedCv, &m);
+            continue;
+        }
+        // leader of the next group
+        flushing = true;
+        if (commitDelayUs > 0 && activeCommitters.load() - 1 >= commitSiblings) {
+            pthread_mutex_unlock(&m);
+            usleep(static_cast<useconds_t>(commitDelayUs));
+            pthread_mutex_lock(&m);
+        }
+        writing.swap(buffer);
+        uint64_t target = appendedLsn;
+        pthread_mutex_unlock(&m);
+
+        bool written = writeAll(writing) && fdatasync(fd) == 0;
+        writing.clear();
+        fsyncCount.fetch_add(1);
+
+        pthread_mutex_lock(&m);
+        flushing = false;
+        if (written) {
+            flushedLsn = target;
+        } else {
+            ioError = true;
+            LOG_ERROR("WAL flush of " << path << " failed, later commits fail too");
+        }
+        pthread_cond_broadcast(&flushedCv);
+    }
+    pthread_mutex_unlock(&m);
+    activeCommitters.fetch_sub(1);
+    return ok;
+}
+
+void WalGroupCommit::setCommitDelay(int32_t microseconds) {
+    pthread_mutex_lock(&m);
+    commitDelayUs = microseconds > 0 ? microseconds : 0;
+    pthread_mutex_unlock(&m);
+}
+
+void WalGroupCommit::setCommitSiblings(int32_t siblings) {
+    pthread_mutex_lock(&m);
+    commitSiblings = siblings > 0 ? siblings : 0;
+    pthread_mutex_unlock(&m);
+}
+
+uint64_t WalGroupCommit::getFlushedLsn() {
+    pthread_mutex_lock(&m);
+    uint64_t result = flushedLsn;
+    pthread_mutex_unlock(&m);
+    return result;
+}
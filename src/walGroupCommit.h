@@ -0,0 +1,126 @@
+#ifndef WALGROUPCOMMIT_H
+#define WALGROUPCOMMIT_H
+
+#include <pthread.h>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "../../bufforing-stm/src/QuakeSharedBuffers.h"
+
+// Group commit for the write-ahead log. Every session appends its records to
+// one shared buffer (under a short mutex, no I/O) and then calls commit(lsn).
+// The first committer that finds no flush running becomes the leader: it
+// writes everything appended so far and calls fdatasync once, the others just
+// wait until flushedLsn covers their record. Knobs follow PostgreSQL:
+// commitDelay (us) is how long a leader waits for more records to join the
+// group, and it only waits when at least commitSiblings other commits are in
+// progress.
+//
+// Record layout: [uint32 payload length][payload], LSN = file offset after it.
+// A session appends a task's record before it makes the change and stamps the
+// LSN on the pages it touches; a task that then fails appends an ABORT record.
+
+constexpr int32_t WAL_DEFAULT_COMMIT_DELAY_US = 0;
+constexpr int32_t WAL_DEFAULT_COMMIT_SIBLINGS = 5;
+
+enum class WalRecordKind : uint8_t {
+    USER = 1,
+    TUPLE = 2,
+    TUPLES = 3,
+    TABLE = 4,
+    TUPLE_ENCODED = 5,    // rows in the tuple format of the table's codec: [uint32 length][tuple]
+    TUPLES_ENCODED = 6,
+    ABORT = 7             // [uint64 lsn]: the change of that record was not made, redo skips it
+};
+
+class WalGroupCommit {
+    private:
+        pthread_mutex_t m;
+        pthread_cond_t flushedCv;
+        int fd = -1;
+        std::string path;
+        std::vector<uint8_t> buffer;    // appended, not written yet
+        std::vector<uint8_t> writing;   // owned by the flushing leader
+        uint64_t appendedLsn = 0;
+        uint64_t flushedLsn = 0;
+        bool flushing = false;
+        bool ioError = false;
+        int32_t commitDelayUs = WAL_DEFAULT_COMMIT_DELAY_US;
+        int32_t commitSiblings = WAL_DEFAULT_COMMIT_SIBLINGS;
+        std::atomic<int32_t> activeCommitters{0};
+        std::atomic<int64_t> fsyncCount{0};
+        std::atomic<int64_t> commitCount{0};
+
+        bool writeAll(const std::vector<uint8_t>& data);
+
+    public:
+        WalGroupCommit();
+        ~WalGroupCommit();
+        WalGroupCommit(const WalGroupCommit&) = delete;
+        WalGroupCommit& operator=(const WalGroupCommit&) = delete;
+
+        // appends to an existing log, LSNs continue from its size
+        bool open(const std::string& path);
+        // flushes what is left and closes the file
+        void close();
+        bool isOpen();
+
+        // copies the record into the group buffer, returns its LSN (0 when closed)
+        uint64_t append(const void* data, uint32_t length);
+        // returns once everything up to lsn is on disk, false after an I/O error
+        bool commit(uint64_t lsn);
+
+        void setCommitDelay(int32_t microseconds);
+        void setCommitSiblings(int32_t siblings);
+        uint64_t getFlushedLsn();
+        int64_t getFsyncCount() const { return fsyncCount.load(); }
+        int64_t getCommitCount() const { return commitCount.load(); }
+};
+
+extern WalGroupCommit sharedWal;
+
+// ---- record encoding, little endian ----
+
+inline void walPut(std::vector<uint8_t>& out, const void* data, size_t length) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    out.insert(out.end(), p, p + length);
+}
+
+template<typename T>
+inline void walPutValue(std::vector<uint8_t>& out, T value) {
+    static_assert(std::is_arithmetic<T>::value, "walPutValue takes numbers");
+    walPut(out, &value, sizeof(T));
+}
+
+inline void walPutString(std::vector<uint8_t>& out, const std::string& value) {
+    walPutValue<uint32_t>(out, static_cast<uint32_t>(value.size()));
+    walPut(out, value.data(), value.size());
+}
+
+// [uint32 columns] then per column [uint8 variant index][uint8 not null][value]
+inline void walPutRow(std::vector<uint8_t>& out, const std::vector<allVars>& row, const std::vector<bool>& bitmap) {
+    walPutValue<uint32_t>(out, static_cast<uint32_t>(row.size()));
+    for (size_t i = 0; i < row.size(); ++i) {
+        walPutValue<uint8_t>(out, static_cast<uint8_t>(row[i].index()));
+        walPutValue<uint8_t>(out, i < bitmap.size() && bitmap[i] ? 1 : 0);
+        std::visit([&out](const auto& value) {
+            typedef std::decay_t<decltype(value)> V;
+            if constexpr (std::is_arithmetic<V>::value) {
+                walPutValue<V>(out, value);
+            } else if constexpr (std::is_same<V, std::string>::value) {
+                walPutString(out, value);
+            }
+        }, row[i]);
+    }
+}
+
+// record header: [uint8 kind][int64 xactionId][int32 tableId]
+inline void walPutHeader(std::vector<uint8_t>& out, WalRecordKind kind, int64_t xactionId, int32_t tableId) {
+    walPutValue<uint8_t>(out, static_cast<uint8_t>(kind));
+    walPutValue<int64_t>(out, xactionId);
+    walPutValue<int32_t>(out, tableId);
+}
+
+#endif
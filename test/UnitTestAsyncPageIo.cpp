@@ -0,0 +1,184 @@
+#include <gtest/gtest.h>
+#include <errno.h>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "../src/asyncPageIo.h"
+#include "../src/pageFile.h"
+#include "testHelpers.h"
+
+// ==================== TESTY ASYNC PAGE IO ====================
+
+class AsyncPageIoTest : public TempFileTest<::testing::TestWithParam<PageIoBackend>> {
+protected:
+    std::unique_ptr<AsyncPageIo> io;
+
+    AsyncPageIoTest() : TempFileTest("pageio", ".dat") {}
+    void SetUp() override {
+        io = makeAsyncPageIo(8, GetParam());
+        if (!io) {
+            GTEST_SKIP() << "io_uring not available";
+        }
+    }
+    void TearDown() override {
+        io.reset();
+    }
+
+    static void fillPage(std::vector<char>& page, int32_t blockNum) {
+        for (size_t i = 0; i < page.size(); ++i) {
+            page[i] = static_cast<char>((blockNum * 31 + i) & 0xff);
+        }
+    }
+};
+
+TEST_P(AsyncPageIoTest, BackendIsTheOneAskedFor) {
+    EXPECT_EQ(io->backend(), GetParam());
+    EXPECT_EQ(io->inFlight(), 0);
+}
+
+TEST_P(AsyncPageIoTest, PrepareStopsAtDepth) {
+    PageFile file;
+    ASSERT_TRUE(file.open(filePath));
+    std::vector<char> page(PAGE_FILE_BLOCK_SIZE, 'a');
+    PageIoRequest r;
+    r.op = PageIoOp::WRITE;
+    r.fd = file.getFd();
+    r.buf = page.data();
+    r.length = PAGE_FILE_BLOCK_SIZE;
+    int32_t prepared = 0;
+    while (io->prepare(r)) {
+        r.offset += PAGE_FILE_BLOCK_SIZE;
+        r.userData++;
+        prepared++;
+    }
+    EXPECT_EQ(prepared, static_cast<int32_t>(io->depth()));
+    EXPECT_EQ(io->submit(), prepared);
+
+    // completions come back in batches, every request exactly once
+    std::vector<PageIoCompletion> out(prepared);
+    std::vector<bool> seen(prepared, false);
+    int32_t reaped = 0;
+    while (reaped < prepared) {
+        int32_t got = io->reap(out.data(), prepared, 1);
+        ASSERT_GT(got, 0);
+        for (int32_t i = 0; i < got; ++i) {
+            EXPECT_EQ(out[i].result, static_cast<int32_t>(PAGE_FILE_BLOCK_SIZE));
+            ASSERT_LT(out[i].userData, static_cast<uint64_t>(prepared));
+            EXPECT_FALSE(seen[out[i].userData]);
+            seen[out[i].userData] = true;
+        }
+        reaped += got;
+    }
+    EXPECT_EQ(io->inFlight(), 0);
+    EXPECT_EQ(file.getBlockCount(), prepared);
+}
+
+TEST_P(AsyncPageIoTest, WriteAndReadBackManyPages) {
+    PageFile file;
+    ASSERT_TRUE(file.open(filePath));
+    const int32_t BLOCKS = 100;   // more than the depth, the batch is refilled as pages complete
+    std::vector<std::vector<char>> pages(BLOCKS, std::vector<char>(PAGE_FILE_BLOCK_SIZE));
+    std::vector<PageRef> refs;
+    for (int32_t b = 0; b < BLOCKS; ++b) {
+        // scattered block numbers, written out of order
+        int32_t blockNum = (b * 37) % BLOCKS;
+        fillPage(pages[b], blockNum);
+        refs.push_back({blockNum, pages[b].data()});
+    }
+    std::vector<int32_t> results;
+    EXPECT_EQ(file.writePages(*io, refs, results), 0);
+    for (int32_t r : results) {
+        EXPECT_EQ(r, static_cast<int32_t>(PAGE_FILE_BLOCK_SIZE));
+    }
+    EXPECT_TRUE(file.sync(*io));
+    EXPECT_EQ(file.getBlockCount(), BLOCKS);
+
+    std::vector<std::vector<char>> readBack(BLOCKS, std::vector<char>(PAGE_FILE_BLOCK_SIZE, 0));
+    std::vector<PageRef> readRefs;
+    for (int32_t b = 0; b < BLOCKS; ++b) {
+        readRefs.push_back({b, readBack[b].data()});
+    }
+    EXPECT_EQ(file.readPages(*io, readRefs, results), 0);
+    std::vector<char> expected(PAGE_FILE_BLOCK_SIZE);
+    for (int32_t b = 0; b < BLOCKS; ++b) {
+        fillPage(expected, b);
+        EXPECT_EQ(std::memcmp(readBack[b].data(), expected.data(), PAGE_FILE_BLOCK_SIZE), 0) << "block " << b;
+    }
+}
+
+TEST_P(AsyncPageIoTest, ReadPastEndIsZeroFilled) {
+    PageFile file;
+    ASSERT_TRUE(file.open(filePath));
+    std::vector<char> page(PAGE_FILE_BLOCK_SIZE, 'x');
+    std::vector<PageRef> refs{{5, page.data()}};
+    std::vector<int32_t> results;
+    EXPECT_EQ(file.readPages(*io, refs, results), 0);
+    EXPECT_EQ(results[0], 0);
+    EXPECT_EQ(page, std::vector<char>(PAGE_FILE_BLOCK_SIZE, 0));
+}
+
+TEST_P(AsyncPageIoTest, ErrorsAreReportedPerRequest) {
+    PageFile file;
+    ASSERT_TRUE(file.open(filePath));
+    std::vector<char> page(PAGE_FILE_BLOCK_SIZE, 'a');
+    std::vector<PageIoRequest> requests(2);
+    requests[0].op = PageIoOp::WRITE;
+    requests[0].fd = file.getFd();
+    requests[0].buf = page.data();
+    requests[0].length = PAGE_FILE_BLOCK_SIZE;
+    requests[1] = requests[0];
+    requests[1].fd = -1;
+    std::vector<int32_t> results;
+    EXPECT_EQ(runPageIo(*io, requests, results), 1);
+    EXPECT_EQ(results[0], static_cast<int32_t>(PAGE_FILE_BLOCK_SIZE));
+    EXPECT_EQ(results[1], -EBADF);
+}
+
+// submits to the real engine, then reports the engine as stopped
+class StoppedPageIo : public AsyncPageIo {
+    public:
+        AsyncPageIo& inner;
+        explicit StoppedPageIo(AsyncPageIo& inner) : inner(inner) {}
+        bool prepare(const PageIoRequest& request) override { return inner.prepare(request); }
+        int32_t submit() override { return inner.submit(); }
+        int32_t reap(PageIoCompletion*, int32_t, int32_t) override { return -1; }
+        void drain() override { inner.drain(); }
+        int32_t inFlight() const override { return inner.inFlight(); }
+        uint32_t depth() const override { return inner.depth(); }
+        PageIoBackend backend() const override { return inner.backend(); }
+};
+
+TEST_P(AsyncPageIoTest, StoppedEngineIsDrainedBeforeRequestsFail) {
+    PageFile file;
+    ASSERT_TRUE(file.open(filePath));
+    std::vector<char> page(PAGE_FILE_BLOCK_SIZE, 'a');
+    std::vector<PageIoRequest> requests(3);
+    for (size_t i = 0; i < requests.size(); ++i) {
+        requests[i].op = PageIoOp::WRITE;
+        requests[i].fd = file.getFd();
+        requests[i].buf = page.data();
+        requests[i].length = PAGE_FILE_BLOCK_SIZE;
+        requests[i].offset = i * PAGE_FILE_BLOCK_SIZE;
+    }
+    StoppedPageIo stopped(*io);
+    std::vector<int32_t> results;
+    EXPECT_EQ(runPageIo(stopped, requests, results), 3);
+    EXPECT_EQ(results, std::vector<int32_t>(3, -EIO));
+    // nothing is left that could still use the buffers
+    EXPECT_EQ(io->inFlight(), 0);
+
+    // a request prepared but never submitted is dropped as well
+    ASSERT_TRUE(io->prepare(requests[0]));
+    io->drain();
+    EXPECT_EQ(io->inFlight(), 0);
+}
+
+INSTANTIATE_TEST_SUITE_P(Backends, AsyncPageIoTest,
+                         ::testing::Values(PageIoBackend::SYNC, PageIoBackend::IO_URING));
+
+TEST(AsyncPageIoFactoryTest, AutoAlwaysGivesAnEngine) {
+    std::unique_ptr<AsyncPageIo> io = makeAsyncPageIo(4);
+    ASSERT_NE(io, nullptr);
+    EXPECT_NE(io->backend(), PageIoBackend::AUTO);
+    EXPECT_GE(io->depth(), 1u);
+}
@@ -0,0 +1,376 @@
+#include <gtest/gtest.h>
+#include <pthread.h>
+#include <algorithm>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+#include "../src/btreeIndex.h"
+#include "../src/indexPageCache.h"
+#include "../src/paxPage.h"
+#include "testHelpers.h"
+
+// ==================== TESTY INDEX PAGE CACHE ====================
+
+class IndexPageCacheTest : public TempFileTest<> {
+protected:
+    IndexPageCacheTest() : TempFileTest("ipc", ".idx") {}
+};
+
+TEST_F(IndexPageCacheTest, EvictsAndReadsBackMoreBlocksThanFrames) {
+    IndexPageCache cache(4);
+    ASSERT_TRUE(cache.open(filePath));
+    for (int32_t b = 0; b < 20; ++b) {
+        IndexPage page = cache.allocate();
+        ASSERT_NE(page.data, nullptr);
+        EXPECT_EQ(page.blockNum, b);
+        page.data[100] = static_cast<uint8_t>(b + 1);
+        cache.markDirty(page);
+        cache.unpin(page);
+    }
+    EXPECT_EQ(cache.getBlockCount(), 20);
+    for (int32_t b = 0; b < 20; ++b) {
+        IndexPage page = cache.pin(b);
+        ASSERT_NE(page.data, nullptr);
+        EXPECT_EQ(page.data[100], b + 1);
+        cache.unpin(page);
+    }
+    EXPECT_EQ(cache.pin(20).data, nullptr);
+
+    // pinned frames are never taken
+    std::vector<IndexPage> pinned;
+    for (int32_t b = 0; b < 4; ++b) {
+        pinned.push_back(cache.pin(b));
+    }
+    EXPECT_EQ(cache.pin(10).data, nullptr);
+    for (const IndexPage& page : pinned) {
+        cache.unpin(page);
+    }
+    cache.close();
+
+    IndexPageCache reopened(4);
+    ASSERT_TRUE(reopened.open(filePath));
+    IndexPage page = reopened.pin(19);
+    ASSERT_NE(page.data, nullptr);
+    EXPECT_EQ(page.data[100], 20);
+    reopened.unpin(page);
+}
+
+// ==================== TESTY BTREE INDEX ====================
+
+class BTreeIndexTest : public TempFileTest<> {
+protected:
+    BTreeIndexTest() : TempFileTest("btree", ".idx") {}
+    static Ctid ctid(int32_t block, uint16_t slot) {
+        Ctid c;
+        c.blockNum = block;
+        c.slot = slot;
+        return c;
+    }
+};
+
+TEST_F(BTreeIndexTest, RandomInsertsSplitAndStaySorted) {
+    BTreeIndex index(1);
+    ASSERT_TRUE(index.open(filePath));
+    EXPECT_EQ(index.getHeight(), 1);
+    const int32_t N = 20000;
+    std::vector<int64_t> keys(N);
+    for (int32_t i = 0; i < N; ++i) {
+        keys[i] = static_cast<int64_t>(i) * 3 - 5000;
+    }
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(7));
+    for (int64_t key : keys) {
+        ASSERT_TRUE(index.insert(key, ctid(static_cast<int32_t>(key & 0xffff), 1)));
+    }
+    EXPECT_GE(index.getHeight(), 2);
+
+    for (int32_t i = 0; i < N; i += 97) {
+        int64_t key = static_cast<int64_t>(i) * 3 - 5000;
+        std::vector<Ctid> found = index.lookup(key);
+        ASSERT_EQ(found.size(), 1u) << key;
+        EXPECT_EQ(found[0], ctid(static_cast<int32_t>(key & 0xffff), 1));
+    }
+    EXPECT_TRUE(index.lookup(0).empty());   // -5000 + 3i never hits 0
+
+    BTreeIterator it = index.range(-100, 3000);
+    BTreeKey entry;
+    int64_t expected = -98;   // first key >= -100
+    int32_t count = 0;
+    while (it.next(entry)) {
+        EXPECT_EQ(entry.key, expected);
+        expected += 3;
+        count++;
+    }
+    EXPECT_EQ(count, (2998 + 98) / 3 + 1);
+}
+
+TEST_F(BTreeIndexTest, DuplicateKeysKeepEveryCtid) {
+    BTreeIndex index(1);
+    ASSERT_TRUE(index.open(filePath));
+    for (int32_t i = 0; i < 1500; ++i) {
+        ASSERT_TRUE(index.insert(i % 3, ctid(i, static_cast<uint16_t>(i % 7))));
+    }
+    // the same entry twice is stored once
+    ASSERT_TRUE(index.insert(0, ctid(0, 0)));
+    std::vector<Ctid> found = index.lookup(1);
+    ASSERT_EQ(found.size(), 500u);
+    EXPECT_TRUE(std::is_sorted(found.begin(), found.end()));
+    EXPECT_EQ(index.lookup(0).size(), 500u);
+    EXPECT_TRUE(index.lookup(3).empty());
+}
+
+TEST_F(BTreeIndexTest, RemoveTakesOutOneEntry) {
+    BTreeIndex index(1);
+    ASSERT_TRUE(index.open(filePath));
+    for (int32_t i = 0; i < 3000; ++i) {
+        ASSERT_TRUE(index.insert(i / 2, ctid(i, 1)));
+    }
+    EXPECT_TRUE(index.remove(700, ctid(1400, 1)));
+    EXPECT_FALSE(index.remove(700, ctid(1400, 1)));
+    EXPECT_FALSE(index.remove(5000, ctid(0, 1)));
+    EXPECT_EQ(index.lookup(700), std::vector<Ctid>{ctid(1401, 1)});
+    // a leaf emptied by removes stays in the chain, ranges pass over it
+    for (int32_t i = 0; i < 1000; ++i) {
+        ASSERT_TRUE(index.remove(i / 2, ctid(i, 1)));
+    }
+    EXPECT_TRUE(index.lookup(100).empty());
+    BTreeIterator it = index.range(0, 600);
+    BTreeKey entry;
+    int32_t count = 0;
+    while (it.next(entry)) {
+        count++;
+    }
+    EXPECT_EQ(count, 2 * (600 - 500 + 1));
+}
+
+struct InsertArg {
+    BTreeIndex* index;
+    int32_t worker;
+    int32_t count;
+    bool ok;
+};
+
+static void* insertWorker(void* p) {
+    InsertArg* arg = static_cast<InsertArg*>(p);
+    arg->ok = true;
+    for (int32_t i = 0; i < arg->count; ++i) {
+        // interleaved keys, so the workers split the same leaves
+        int64_t key = static_cast<int64_t>(i) * 4 + arg->worker;
+        Ctid c;
+        c.blockNum = arg->worker;
+        c.slot = static_cast<uint16_t>(i);
+        if (!arg->index->insert(key, c)) {
+            arg->ok = false;
+        }
+    }
+    return nullptr;
+}
+
+TEST_F(BTreeIndexTest, ConcurrentInsertsLoseNothing) {
+    BTreeIndex index(1);
+    ASSERT_TRUE(index.open(filePath));
+    const int32_t WORKERS = 4;
+    const int32_t PER_WORKER = 6000;
+    std::vector<pthread_t> threads(WORKERS);
+    std::vector<InsertArg> args(WORKERS);
+    for (int32_t w = 0; w < WORKERS; ++w) {
+        args[w] = {&index, w, PER_WORKER, false};
+        ASSERT_EQ(pthread_create(&threads[w], nullptr, &insertWorker, &args[w]), 0);
+    }
+    for (int32_t w = 0; w < WORKERS; ++w) {
+        pthread_join(threads[w], nullptr);
+        EXPECT_TRUE(args[w].ok);
+    }
+    BTreeIterator it = index.range(INT64_MIN, INT64_MAX);
+    BTreeKey entry;
+    int64_t expected = 0;
+    while (it.next(entry)) {
+        ASSERT_EQ(entry.key, expected);
+        EXPECT_EQ(entry.ctid.blockNum, static_cast<int32_t>(expected % 4));
+        expected++;
+    }
+    EXPECT_EQ(expected, WORKERS * PER_WORKER);
+}
+
+TEST_F(BTreeIndexTest, InsertsDuringBulkBuildAreNotLost) {
+    BTreeIndex index(1);
+    ASSERT_TRUE(index.open(filePath));
+    const int32_t N = 50000;
+    std::vector<BTreeKey> entries;
+    for (int32_t i = 0; i < N; ++i) {
+        BTreeKey e;
+        e.key = static_cast<int64_t>(i) * 4 + 2;
+        e.ctid = ctid(100, 0);
+        entries.push_back(e);
+    }
+    pthread_t thread;
+    InsertArg arg{&index, 1, 3000, false};
+    ASSERT_EQ(pthread_create(&thread, nullptr, &insertWorker, &arg), 0);
+    // fails when an insert got in first, otherwise the inserts land in the built tree
+    bool built = index.bulkBuild(entries);
+    pthread_join(thread, nullptr);
+    EXPECT_TRUE(arg.ok);
+
+    BTreeIterator it = index.range(INT64_MIN, INT64_MAX);
+    BTreeKey entry;
+    int32_t inserted = 0;
+    int32_t bulk = 0;
+    while (it.next(entry)) {
+        if (entry.ctid.blockNum == 100) {
+            bulk++;
+        } else {
+            inserted++;
+        }
+    }
+    EXPECT_EQ(inserted, arg.count);
+    EXPECT_EQ(bulk, built ? N : 0);
+}
+
+TEST_F(BTreeIndexTest, BulkBuildThenInsertAndReopen) {
+    const int32_t N = 100000;
+    {
+        BTreeIndex index(1);
+        ASSERT_TRUE(index.open(filePath));
+        std::vector<BTreeKey> entries;
+        for (int32_t i = N; i > 0; --i) {
+            BTreeKey e;
+            e.key = i * 2;
+            e.ctid = ctid(i, 0);
+            entries.push_back(e);
+        }
+        ASSERT_TRUE(index.bulkBuild(entries));
+        EXPECT_EQ(index.getHeight(), 2);   // about 220 leaves under one root
+        EXPECT_FALSE(index.bulkBuild(entries));   // only into an empty index
+        ASSERT_TRUE(index.insert(3, ctid(7, 7)));
+        ASSERT_TRUE(index.flush());
+    }
+    // a cold cache reads one page per level (plus the metapage) for a point lookup
+    BTreeIndex index(1, 16);
+    ASSERT_TRUE(index.open(filePath));
+    int64_t before = index.getPageReads();
+    std::vector<Ctid> found = index.lookup(N);
+    ASSERT_EQ(found.size(), 1u);
+    EXPECT_EQ(found[0], ctid(N / 2, 0));
+    EXPECT_LE(index.getPageReads() - before, index.getHeight() + 1);
+    EXPECT_EQ(index.lookup(3).size(), 1u);
+    EXPECT_TRUE(index.lookup(5).empty());
+
+    int32_t count = 0;
+    BTreeIterator it = index.range(0, INT64_MAX);
+    BTreeKey entry;
+    BTreeKey prev;
+    while (it.next(entry)) {
+        if (count > 0) {
+            EXPECT_TRUE(prev < entry);
+        }
+        prev = entry;
+        count++;
+    }
+    EXPECT_EQ(count, N + 1);
+}
+
+TEST_F(BTreeIndexTest, BuildFromTableIndexesRowPages) {
+    std::string tablePath = filePath + ".tab";
+    std::filesystem::remove(tablePath);
+    std::vector<uint8_t> types{TUPLE_TYPE_STRING, TUPLE_TYPE_INT32};
+    TupleCodec codec(types, {0, 1});
+    {
+        PageFile table;
+        ASSERT_TRUE(table.open(tablePath));
+        std::vector<std::vector<uint8_t>> pages(3, std::vector<uint8_t>(PAGE_FILE_BLOCK_SIZE));
+        std::vector<PageRef> refs;
+        int32_t value = 0;
+        for (int32_t b = 0; b < 3; ++b) {
+            SlottedPage::init(pages[b].data(), 9, b);
+            SlottedPage page(pages[b].data());
+            for (int32_t i = 0; i < 50; ++i, ++value) {
+                std::vector<allVars> row{std::string("name"), value};
+                std::vector<bool> bitmap{true, value % 10 != 0};   // every tenth value is null
+                ASSERT_GE(page.addRow(codec, row, bitmap), 0);
+            }
+            refs.push_back({b, pages[b].data()});
+        }
+        SyncPageIo io(4);
+        std::vector<int32_t> results;
+        ASSERT_EQ(table.writePages(io, refs, results), 0);
+    }
+    PageFile table;
+    ASSERT_TRUE(table.open(tablePath));
+    BTreeIndex index(1);
+    ASSERT_TRUE(index.open(filePath));
+    ASSERT_TRUE(index.buildFromTable(table, 9, codec, 1));
+    std::vector<Ctid> found = index.lookup(77);
+    ASSERT_EQ(found.size(), 1u);
+    EXPECT_EQ(found[0], ctid(1, 27));
+    EXPECT_TRUE(index.lookup(70).empty());
+    int32_t count = 0;
+    BTreeIterator it = index.range(0, 1000);
+    BTreeKey entry;
+    while (it.next(entry)) {
+        count++;
+    }
+    EXPECT_EQ(count, 150 - 15);
+    EXPECT_FALSE(index.buildFromTable(table, 9, codec, 0));   // not an integer column
+    table.close();
+    std::filesystem::remove(tablePath);
+}
+
+TEST_F(BTreeIndexTest, BuildFromTableReadsPaxPagesAndFailsOnDirtySharedBlocks) {
+    std::string tablePath = filePath + ".tab";
+    std::filesystem::remove(tablePath);
+    std::vector<uint8_t> types{TUPLE_TYPE_STRING, TUPLE_TYPE_INT32};
+    TupleCodec codec(types, {0, 1});
+    PageFile table;
+    ASSERT_TRUE(table.open(tablePath));
+    {
+        std::vector<std::vector<uint8_t>> pages(3, std::vector<uint8_t>(PAGE_FILE_BLOCK_SIZE));
+        ASSERT_TRUE(PaxPage::init(pages[0].data(), 9, 0, codec));
+        PaxPage pax(pages[0].data());
+        SlottedPage::init(pages[1].data(), 9, 1);
+        SlottedPage rows(pages[1].data());
+        for (int32_t i = 0; i < 30; ++i) {
+            std::vector<bool> bitmap{true, i % 10 != 0};
+            ASSERT_EQ(pax.appendRow({std::string("pax"), i}, bitmap), i);
+            ASSERT_EQ(rows.addRow(codec, {std::string("row"), 100 + i}, bitmap), i);
+        }
+        SyncPageIo io(4);
+        std::vector<int32_t> results;
+        ASSERT_EQ(table.writePages(io, {{0, pages[0].data()}, {1, pages[1].data()}}, results), 0);
+    }
+    // block 1 is dirty in the shared buffers: the build fails and leaves the buffer alone
+    std::vector<ShareBuffer*>* saved = buffers;
+    std::vector<ShareBuffer*> cache(1, nullptr);
+    ShareBuffer dirty;
+    dirty.tableId = 9;
+    dirty.blockNum = 1;
+    dirty.isDirty = true;
+    cache[0] = &dirty;
+    buffers = &cache;
+    sharedBufferMapping.insert(9, 1, 0);
+
+    BTreeIndex index(1);
+    ASSERT_TRUE(index.open(filePath));
+    EXPECT_FALSE(index.buildFromTable(table, 9, codec, 1));
+    EXPECT_TRUE(dirty.isDirty);
+    EXPECT_FALSE(sharedBufferDescs.isPinned(0));
+    sharedBufferMapping.clear();
+    buffers = saved;
+
+    // once it is flushed the file has the newest copy of every block
+    EXPECT_TRUE(index.buildFromTable(table, 9, codec, 1));
+
+    EXPECT_EQ(index.lookup(15), std::vector<Ctid>{ctid(0, 15)});
+    EXPECT_EQ(index.lookup(115), std::vector<Ctid>{ctid(1, 15)});
+    EXPECT_TRUE(index.lookup(10).empty());
+    EXPECT_TRUE(index.lookup(110).empty());
+
+    // a page that is neither kind fails the build instead of leaving rows out
+    std::vector<uint8_t> other(PAGE_FILE_BLOCK_SIZE, 0);
+    SyncPageIo io(1);
+    std::vector<int32_t> results;
+    ASSERT_EQ(table.writePages(io, {{2, other.data()}}, results), 0);
+    int32_t keys = 0;
+    EXPECT_FALSE(scanColumnKeys(table, 9, codec, 1, [&keys](int64_t, const Ctid&) { keys++; }));
+    table.close();
+    std::filesystem::remove(tablePath);
+}
@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include "../src/bufferDesc.h"
+
+// ==================== TESTY BUFFER DESC ====================
+
+TEST(BufferDescTest, PinAndUnpin) {
+    BufferDescTable descs;
+    EXPECT_FALSE(descs.isPinned(3));
+
+    descs.pin(3);
+    descs.pin(3);
+    EXPECT_EQ(descs.getPinCount(3), 2);
+    EXPECT_TRUE(descs.isPinned(3));
+
+    descs.unpin(3);
+    descs.unpin(3);
+    EXPECT_FALSE(descs.isPinned(3));
+}
+
+TEST(BufferDescTest, UnbalancedUnpinIsIgnored) {
+    BufferDescTable descs;
+    descs.unpin(0);
+    EXPECT_EQ(descs.getPinCount(0), 0);
+}
+
+TEST(BufferDescTest, DescriptorsDoNotMove) {
+    BufferDescTable descs;
+    BufferDesc* first = descs.desc(5);
+    // touching a far away slot allocates another chunk, the old one stays where it was
+    ASSERT_NE(descs.desc(BUFFER_DESC_CHUNK * 10 + 1), nullptr);
+    EXPECT_EQ(descs.desc(5), first);
+    EXPECT_EQ(descs.desc(-1), nullptr);
+    EXPECT_EQ(descs.desc(BUFFER_DESC_CHUNK * BUFFER_DESC_MAX_CHUNKS), nullptr);
+}
+
+TEST(BufferDescTest, ConcurrentPins) {
+    BufferDescTable descs;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&descs]() {
+            for (int i = 0; i < 10000; ++i) {
+                descs.pin(7);
+                descs.unpin(7);
+            }
+            descs.pin(7);
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    EXPECT_EQ(descs.getPinCount(7), 8);
+}
+
+TEST(BufferDescTest, ExclusiveContentLockExcludesOthers) {
+    BufferDescTable descs;
+    int64_t counter = 0;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&descs, &counter]() {
+            for (int i = 0; i < 10000; ++i) {
+                descs.lockContent(1, true);
+                counter++;
+                descs.unlockContent(1);
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    EXPECT_EQ(counter, 40000);
+}
+
+TEST(BufferDescTest, DifferentSlotsDoNotBlockEachOther) {
+    BufferDescTable descs;
+    descs.lockContent(1, true);
+
+    std::atomic<bool> done{false};
+    std::thread other([&descs, &done]() {
+        descs.lockContent(2, true);
+        descs.unlockContent(2);
+        done = true;
+    });
+    other.join();
+    EXPECT_TRUE(done.load());
+
+    descs.unlockContent(1);
+}
@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include "../src/bufferMapping.h"
+
+// ==================== TESTY BUFFER MAPPING ====================
+
+TEST(BufferMappingTest, LookupMissingReturnsMinusOne) {
+    BufferMappingTable table;
+    EXPECT_EQ(table.lookup(1, 0), -1);
+    EXPECT_TRUE(table.tableSlots(1).empty());
+}
+
+TEST(BufferMappingTest, InsertAndLookup) {
+    BufferMappingTable table;
+    table.insert(10, 0, 3);
+    table.insert(10, 1, 7);
+    table.insert(11, 0, 5);
+
+    EXPECT_EQ(table.lookup(10, 0), 3);
+    EXPECT_EQ(table.lookup(10, 1), 7);
+    EXPECT_EQ(table.lookup(11, 0), 5);
+    EXPECT_EQ(table.lookup(11, 1), -1);
+    EXPECT_EQ(table.size(), 3u);
+}
+
+TEST(BufferMappingTest, InsertReplacesOldSlot) {
+    BufferMappingTable table;
+    table.insert(10, 0, 3);
+    table.insert(10, 0, 4);
+
+    EXPECT_EQ(table.lookup(10, 0), 4);
+    EXPECT_EQ(table.size(), 1u);
+    EXPECT_EQ(table.tableSlots(10), std::vector<int32_t>({4}));
+}
+
+TEST(BufferMappingTest, EraseOnlyMatchingSlot) {
+    BufferMappingTable table;
+    table.insert(10, 0, 3);
+
+    // page was reloaded into another slot in the meantime
+    EXPECT_FALSE(table.erase(10, 0, 8));
+    EXPECT_EQ(table.lookup(10, 0), 3);
+
+    EXPECT_TRUE(table.erase(10, 0, 3));
+    EXPECT_EQ(table.lookup(10, 0), -1);
+    EXPECT_TRUE(table.tableSlots(10).empty());
+}
+
+TEST(BufferMappingTest, TableSlotsReturnsAllBlocks) {
+    BufferMappingTable table;
+    for (int32_t block = 0; block < 50; ++block) {
+        table.insert(42, block, block + 100);
+    }
+    table.insert(43, 0, 1);
+
+    std::vector<int32_t> slots = table.tableSlots(42);
+    std::sort(slots.begin(), slots.end());
+    ASSERT_EQ(slots.size(), 50u);
+    EXPECT_EQ(slots.front(), 100);
+    EXPECT_EQ(slots.back(), 149);
+}
+
+TEST(BufferMappingTest, NegativeIdsDoNotCollide) {
+    BufferMappingTable table;
+    table.insert(-1, 5, 1);
+    table.insert(5, -1, 2);
+
+    EXPECT_EQ(table.lookup(-1, 5), 1);
+    EXPECT_EQ(table.lookup(5, -1), 2);
+}
+
+TEST(BufferMappingTest, ClearRemovesEverything) {
+    BufferMappingTable table(4);
+    EXPECT_EQ(table.getPartitionCount(), 4);
+    for (int32_t i = 0; i < 20; ++i) {
+        table.insert(i, i, i);
+    }
+    table.clear();
+    EXPECT_EQ(table.size(), 0u);
+    EXPECT_EQ(table.lookup(3, 3), -1);
+}
+
+TEST(BufferMappingTest, ConcurrentInsertAndLookup) {
+    BufferMappingTable table;
+    const int NUM_THREADS = 8;
+    const int PAGES_PER_THREAD = 1000;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < NUM_THREADS; ++t) {
+        threads.emplace_back([&table, t]() {
+            for (int i = 0; i < PAGES_PER_THREAD; ++i) {
+                table.insert(t, i, t * PAGES_PER_THREAD + i);
+                EXPECT_EQ(table.lookup(t, i), t * PAGES_PER_THREAD + i);
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    EXPECT_EQ(table.size(), static_cast<size_t>(NUM_THREADS * PAGES_PER_THREAD));
+}
@@ -22,7 +22,7 @@ TEST_F(BuserTest, Creation) {
     
     EXPECT_EQ(user.getId(), 1);
     EXPECT_EQ(user.getUsername(), "testuser");
-    EXPECT_EQ(user.getPasswd(), "password123");
+    EXPECT_TRUE(user.checkPasswd("password123"));
     EXPECT_EQ(user.getEmail(), "test@email.com");
 }
 
@@ -37,7 +37,7 @@ TEST_F(BuserTest, Setters) {
     
     EXPECT_EQ(user.getId(), 42);
     EXPECT_EQ(user.getUsername(), "newuser");
-    EXPECT_EQ(user.getPasswd(), "newpass");
+    EXPECT_TRUE(user.checkPasswd("newpass"));
     EXPECT_EQ(user.getEmail(), "new@email.com");
 }
 
@@ -85,7 +85,7 @@ TEST_F(BuserTest, EmptyStrings) {
     
     EXPECT_EQ(user.getId(), 0);
     EXPECT_EQ(user.getUsername(), "");
-    EXPECT_EQ(user.getPasswd(), "");
+    EXPECT_TRUE(user.checkPasswd(""));
     EXPECT_EQ(user.getEmail(), "");
 }
 
@@ -95,7 +95,7 @@ TEST_F(BuserTest, LongStrings) {
     buser user(1, longString, longString, longString, false);
     
     EXPECT_EQ(user.getUsername().length(), 1000u);
-    EXPECT_EQ(user.getPasswd().length(), 1000u);
+    EXPECT_TRUE(user.checkPasswd(longString));
     EXPECT_EQ(user.getEmail().length(), 1000u);
 }
 
@@ -104,7 +104,7 @@ TEST_F(BuserTest, SpecialChars) {
     buser user(1, "user@#$%", "pass!@#$", "test+special@email.com", false);
     
     EXPECT_EQ(user.getUsername(), "user@#$%");
-    EXPECT_EQ(user.getPasswd(), "pass!@#$");
+    EXPECT_TRUE(user.checkPasswd("pass!@#$"));
     EXPECT_EQ(user.getEmail(), "test+special@email.com");
 }
 
@@ -133,7 +133,7 @@ TEST_F(BuserTest, DataIntegrity) {
     
     // User powinien mieć oryginalne wartości
     EXPECT_EQ(user.getUsername(), "original");
-    EXPECT_EQ(user.getPasswd(), "secret");
+    EXPECT_TRUE(user.checkPasswd("secret"));
     EXPECT_EQ(user.getEmail(), "test@test.com");
 }
 
@@ -145,3 +145,32 @@ TEST_F(BuserTest, MaxInt64Id) {
     EXPECT_EQ(user.getId(), maxId);
 }
 
+
+// Test skrótu SHA-256 (wektory z FIPS 180-4)
+TEST_F(BuserTest, Sha256KnownVectors) {
+    auto hex = [](const Sha256Digest& d) {
+        std::stringstream ss;
+        for (uint8_t b : d) {
+            ss << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(b);
+        }
+        return ss.str();
+    };
+    EXPECT_EQ(hex(sha256Digest("")), "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+    EXPECT_EQ(hex(sha256Digest("abc")), "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    EXPECT_EQ(hex(sha256Digest("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq")),
+              "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+    EXPECT_EQ(hex(sha256Digest(std::string(1000, 'a'))),
+              "41edece42d63e8d9bf515a9ba6932e1c20cbc9f5a5d134645adb5db1b9737ea3");
+}
+
+// Test sprawdzania hasła przez skrót
+TEST_F(BuserTest, CheckPasswdDigest) {
+    buser user(1, "user", "secret", "email@test.com", true);
+    EXPECT_TRUE(user.checkPasswd("secret"));
+    EXPECT_FALSE(user.checkPasswd("secreT"));
+    EXPECT_FALSE(user.checkPasswd(""));
+
+    user.setPasswd("changed", false);
+    EXPECT_FALSE(user.checkPasswd("secret"));
+    EXPECT_TRUE(user.checkPasswdDigest(sha256Digest("changed")));
+}
@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../src/buserIndex.h"
+
+// ==================== TESTY BUSER INDEX ====================
+
+TEST(BuserIndexTest, AuthenticateAddedUser) {
+    BuserIndex index;
+    buser* user = new buser(getNextUserId(), "idxUser1", "pass1", "a@email.com", false);
+    index.add(user);
+
+    EXPECT_EQ(index.authenticate("idxUser1", "pass1"), user);
+    EXPECT_EQ(index.findUserId("idxUser1", "pass1"), user->getId());
+    EXPECT_EQ(index.authenticate("idxUser1", "wrong"), nullptr);
+    EXPECT_EQ(index.findUserId("idxNobody", "pass1"), -1);
+}
+
+TEST(BuserIndexTest, AddIsIdempotent) {
+    BuserIndex index;
+    buser* user = new buser(getNextUserId(), "idxUser2", "pass2", "a@email.com", false);
+    index.add(user);
+    index.add(user);
+    index.add(nullptr);
+    EXPECT_EQ(index.size(), 1u);
+}
+
+TEST(BuserIndexTest, SameNameDifferentPasswords) {
+    BuserIndex index;
+    buser* first = new buser(getNextUserId(), "idxTwin", "one", "a@email.com", false);
+    buser* second = new buser(getNextUserId(), "idxTwin", "two", "b@email.com", false);
+    index.add(first);
+    index.add(second);
+    EXPECT_EQ(index.authenticate("idxTwin", "one"), first);
+    EXPECT_EQ(index.authenticate("idxTwin", "two"), second);
+}
+
+TEST(BuserIndexTest, CatchesUpWithUserCache) {
+    BuserIndex index;
+    buser* user = new buser(getNextUserId(), "idxCached", "cachedPass", "c@email.com", false);
+    addUserToCache(user);
+
+    EXPECT_EQ(index.authenticate("idxCached", "cachedPass"), user);
+    EXPECT_GE(index.size(), 1u);
+}
+
+TEST(BuserIndexTest, SecondUserOfKnownNameIsCaughtUp) {
+    BuserIndex index;
+    buser* user = new buser(getNextUserId(), "idxKnown", "right", "k@email.com", false);
+    index.addCached(user);
+    EXPECT_EQ(index.authenticate("idxKnown", "wrong"), nullptr);
+    // a second user of the name that only reached userCache is found all the same
+    buser* other = new buser(getNextUserId(), "idxKnown", "other", "k@email.com", false);
+    addUserToCache(other);
+    EXPECT_EQ(index.authenticate("idxKnown", "other"), other);
+    EXPECT_EQ(index.authenticate("idxKnown", "right"), user);
+}
+
+TEST(BuserIndexTest, RenamedUserIsNotFoundUnderOldName) {
+    BuserIndex index;
+    buser* user = new buser(getNextUserId(), "idxOldName", "pass", "r@email.com", false);
+    index.add(user);
+    user->setUsername("idxNewName");
+    EXPECT_EQ(index.authenticate("idxOldName", "pass"), nullptr);
+}
+
+TEST(BuserIndexTest, RenameReKeysSharedIndex) {
+    buser* user = new buser(getNextUserId(), "idxSharedOld", "pass", "r@email.com", false);
+    sharedBuserIndex.addCached(user);
+    size_t before = sharedBuserIndex.size();
+    user->setUsername("idxSharedNew");
+    EXPECT_EQ(sharedBuserIndex.size(), before);
+    EXPECT_EQ(sharedBuserIndex.authenticate("idxSharedNew", "pass"), user);
+    EXPECT_EQ(sharedBuserIndex.authenticate("idxSharedOld", "pass"), nullptr);
+}
+
+TEST(BuserIndexTest, ConcurrentLookups) {
+    BuserIndex index;
+    const int32_t USERS = 500;
+    for (int32_t i = 0; i < USERS; ++i) {
+        index.add(new buser(getNextUserId(), "idxConc" + std::to_string(i), "p" + std::to_string(i), "x@email.com", false));
+    }
+    std::vector<std::thread> threads;
+    std::vector<int32_t> found(4, 0);
+    for (int32_t t = 0; t < 4; ++t) {
+        threads.emplace_back([&index, &found, t]() {
+            for (int32_t i = 0; i < USERS; ++i) {
+                if (index.authenticate("idxConc" + std::to_string(i), "p" + std::to_string(i)) != nullptr) {
+                    found[t]++;
+                }
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    for (int32_t count : found) {
+        EXPECT_EQ(count, USERS);
+    }
+}
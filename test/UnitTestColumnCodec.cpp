@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "../src/columnCodec.h"
+
+// ==================== TESTY COLUMN CODEC ====================
+
+class ColumnCodecTest : public ::testing::TestWithParam<ColumnCodecLevel> {
+protected:
+    ColumnCodecLevel saved = columnCodecLevel;
+    void SetUp() override {
+        if (GetParam() > detectColumnCodecLevel()) {
+            GTEST_SKIP() << "CPU does not have this level";
+        }
+        columnCodecLevel = GetParam();
+    }
+    void TearDown() override {
+        columnCodecLevel = saved;
+    }
+
+    template<typename T>
+    void checkBigEndian() {
+        std::mt19937_64 rng(7);
+        // odd sizes leave tails for every vector width
+        for (size_t n : {0, 1, 3, 7, 15, 16, 17, 31, 33, 100, 1001}) {
+            std::vector<T> values(n);
+            for (auto& v : values) {
+                v = static_cast<T>(rng());
+            }
+            std::vector<uint8_t> out(n * sizeof(T) + 1, 0xcc);
+            EXPECT_EQ(encodeColumn(values.data(), n, out.data(), ColumnByteOrder::BIG), n * sizeof(T));
+            for (size_t i = 0; i < n; ++i) {
+                uint64_t expected = static_cast<uint64_t>(static_cast<std::make_unsigned_t<T>>(values[i]));
+                for (size_t b = 0; b < sizeof(T); ++b) {
+                    ASSERT_EQ(out[i * sizeof(T) + b], static_cast<uint8_t>(expected >> (8 * (sizeof(T) - 1 - b))))
+                        << "n " << n << " value " << i << " byte " << b;
+                }
+            }
+            EXPECT_EQ(out[n * sizeof(T)], 0xcc);   // nothing written past the span
+            std::vector<T> back(n);
+            decodeColumn(out.data(), n, back.data(), ColumnByteOrder::BIG);
+            EXPECT_EQ(back, values);
+        }
+    }
+};
+
+TEST_P(ColumnCodecTest, BigEndianInt16) { checkBigEndian<int16_t>(); }
+TEST_P(ColumnCodecTest, BigEndianInt32) { checkBigEndian<int32_t>(); }
+TEST_P(ColumnCodecTest, BigEndianInt64) { checkBigEndian<int64_t>(); }
+
+TEST_P(ColumnCodecTest, LittleEndianIsACopy) {
+    std::vector<int32_t> values{1, -2, 0x01020304};
+    std::vector<uint8_t> out(12);
+    encodeColumn(values.data(), values.size(), out.data());
+    EXPECT_EQ(out[8], 0x04);
+    EXPECT_EQ(out[11], 0x01);
+    std::vector<int8_t> bytes{-1, 2};
+    std::vector<uint8_t> out8(2);
+    encodeColumn(bytes.data(), 2, out8.data(), ColumnByteOrder::BIG);
+    EXPECT_EQ(out8[0], 0xff);
+}
+
+TEST_P(ColumnCodecTest, PackNullBitmap) {
+    std::mt19937 rng(3);
+    for (size_t n : {0, 1, 8, 9, 15, 16, 17, 32, 33, 63, 64, 65, 1000}) {
+        std::vector<uint8_t> flags(n);
+        std::vector<bool> asBools(n);
+        for (size_t i = 0; i < n; ++i) {
+            // any non-zero byte counts as not null
+            flags[i] = rng() % 3 == 0 ? 0 : static_cast<uint8_t>(1 + rng() % 255);
+            asBools[i] = flags[i] != 0;
+        }
+        std::vector<uint8_t> bits(nullBitmapSize(n) + 1, 0xcc);
+        std::vector<uint8_t> fromBools(nullBitmapSize(n));
+        EXPECT_EQ(packNullBitmap(flags.data(), n, bits.data()), nullBitmapSize(n));
+        packNullBitmap(asBools, fromBools.data());
+        EXPECT_EQ(bits[nullBitmapSize(n)], 0xcc);
+        for (size_t i = 0; i < n; ++i) {
+            ASSERT_EQ((bits[i / 8] >> (i % 8)) & 1, asBools[i] ? 1 : 0) << "n " << n << " bit " << i;
+        }
+        EXPECT_TRUE(std::equal(fromBools.begin(), fromBools.end(), bits.begin()));
+        std::vector<uint8_t> unpacked(n);
+        unpackNullBitmap(bits.data(), n, unpacked.data());
+        for (size_t i = 0; i < n; ++i) {
+            EXPECT_EQ(unpacked[i], asBools[i] ? 1 : 0);
+        }
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(Levels, ColumnCodecTest,
+                         ::testing::Values(ColumnCodecLevel::SCALAR, ColumnCodecLevel::SSSE3, ColumnCodecLevel::AVX2));
+
+TEST(ColumnCodecBoolTest, BoolsAreNormalized) {
+    bool values[3] = {true, false, true};
+    uint8_t out[3];
+    EXPECT_EQ(encodeBoolColumn(values, 3, out), 3u);
+    EXPECT_EQ(out[0], 1);
+    EXPECT_EQ(out[1], 0);
+    EXPECT_EQ(out[2], 1);
+}
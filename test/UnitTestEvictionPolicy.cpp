@@ -0,0 +1,148 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include "../src/evictionPolicy.h"
+
+// ==================== TESTY EVICTION POLICY ====================
+
+struct FakeBuffer {
+    int32_t tableId = -1;
+    int32_t blockNum = -1;
+    int32_t count = 0;
+    bool isDirty = false;
+};
+
+using FakeCache = std::vector<FakeBuffer*>;
+
+class EvictionPolicyTest : public ::testing::Test {
+protected:
+    FakeCache cache;
+    std::vector<FakeBuffer> storage;
+
+    void fill(const std::vector<int32_t>& counts, const std::vector<bool>& dirty) {
+        storage.clear();
+        storage.reserve(256);
+        cache.assign(counts.size(), nullptr);
+        for (size_t i = 0; i < counts.size(); ++i) {
+            storage.push_back(FakeBuffer{static_cast<int32_t>(100 + i), 0, counts[i], dirty[i]});
+            cache[i] = &storage.back();
+        }
+    }
+    FakeBuffer* make(int32_t tableId, int32_t blockNum) {
+        storage.push_back(FakeBuffer{tableId, blockNum, 1, false});
+        return &storage.back();
+    }
+};
+
+TEST_F(EvictionPolicyTest, ClockSweepReturnsEmptySlot) {
+    fill({3, 3, 3}, {false, false, false});
+    cache[1] = nullptr;
+    ClockSweepPolicy<FakeCache, FakeBuffer*> policy;
+    EXPECT_EQ(policy.victim(cache), 1);
+}
+
+TEST_F(EvictionPolicyTest, ClockSweepDecaysUsageCounts) {
+    fill({2, 1, 3}, {false, false, false});
+    ClockSweepPolicy<FakeCache, FakeBuffer*> policy;
+
+    EXPECT_EQ(policy.victim(cache), 1);
+    // every buffer the hand passed lost usage
+    EXPECT_EQ(cache[0]->count, 0);
+    EXPECT_EQ(cache[1]->count, 0);
+    EXPECT_EQ(cache[2]->count, 2);
+}
+
+TEST_F(EvictionPolicyTest, ClockSweepCapsUsageCount) {
+    fill({1000, 1000}, {false, false});
+    ClockSweepPolicy<FakeCache, FakeBuffer*> policy;
+
+    // capped to MAX_USAGE_COUNT, so the sweep ends after a bounded number of passes
+    EXPECT_EQ(policy.victim(cache), 0);
+    EXPECT_LE(cache[1]->count, MAX_USAGE_COUNT);
+}
+
+TEST_F(EvictionPolicyTest, ClockSweepPrefersCleanBuffer) {
+    fill({0, 0, 0}, {true, true, false});
+    ClockSweepPolicy<FakeCache, FakeBuffer*> policy;
+    EXPECT_EQ(policy.victim(cache), 2);
+}
+
+TEST_F(EvictionPolicyTest, ClockSweepTakesDirtyWhenNothingClean) {
+    fill({0, 0, 0}, {true, true, true});
+    ClockSweepPolicy<FakeCache, FakeBuffer*> policy;
+    EXPECT_EQ(policy.victim(cache), 0);
+}
+
+TEST_F(EvictionPolicyTest, ClockSweepHandAdvances) {
+    fill({0, 0, 0}, {false, false, false});
+    ClockSweepPolicy<FakeCache, FakeBuffer*> policy;
+    EXPECT_EQ(policy.victim(cache), 0);
+    EXPECT_EQ(policy.victim(cache), 1);
+    EXPECT_EQ(policy.victim(cache), 2);
+    EXPECT_EQ(policy.victim(cache), 0);
+}
+
+TEST_F(EvictionPolicyTest, LfuSelectsLowestCount) {
+    fill({10, 4, 12}, {true, true, true});
+    LfuPolicy<FakeCache, FakeBuffer*> policy;
+    EXPECT_EQ(policy.victim(cache), 1);
+}
+
+TEST_F(EvictionPolicyTest, LfuPrefersCleanOnTie) {
+    fill({5, 5}, {true, false});
+    LfuPolicy<FakeCache, FakeBuffer*> policy;
+    EXPECT_EQ(policy.victim(cache), 1);
+}
+
+TEST_F(EvictionPolicyTest, TwoQScanDoesNotFlushHotPages) {
+    // 8 slots: 4 hot pages already resident (Am), 4 slots for the scan
+    fill({5, 5, 5, 5, 0, 0, 0, 0}, {false, false, false, false, false, false, false, false});
+    TwoQPolicy<FakeCache, FakeBuffer*> policy;
+    for (size_t i = 4; i < 8; ++i) {
+        cache[i] = make(900, static_cast<int32_t>(i));
+        policy.admitted(cache, i);
+    }
+
+    // long scan, every page touched once
+    for (int32_t block = 100; block < 200; ++block) {
+        int32_t slot = policy.victim(cache);
+        ASSERT_GE(slot, 0);
+        policy.evicted(cache, slot);
+        cache[slot] = make(900, block);
+        policy.admitted(cache, slot);
+    }
+
+    for (size_t i = 0; i < 4; ++i) {
+        EXPECT_EQ(cache[i]->tableId, static_cast<int32_t>(100 + i));
+    }
+}
+
+TEST_F(EvictionPolicyTest, TwoQGhostHitGoesToAm) {
+    fill({0, 0, 0, 0}, {false, false, false, false});
+    TwoQPolicy<FakeCache, FakeBuffer*> policy;
+    for (size_t i = 0; i < 4; ++i) {
+        cache[i] = make(7, static_cast<int32_t>(i));
+        policy.admitted(cache, i);
+    }
+    // A1in over its share, oldest page (7,0) goes out and becomes a ghost
+    int32_t slot = policy.victim(cache);
+    ASSERT_EQ(slot, 0);
+    policy.evicted(cache, slot);
+
+    // (7,0) is loaded again - now it is hot and must not be the next victim
+    cache[slot] = make(7, 0);
+    cache[slot]->count = 1;
+    policy.admitted(cache, slot);
+    EXPECT_NE(policy.victim(cache), 0);
+}
+
+TEST_F(EvictionPolicyTest, FactoryCreatesRequestedPolicy) {
+    auto clock = makeEvictionPolicy<FakeCache, FakeBuffer*>(EvictionPolicyKind::CLOCK_SWEEP);
+    auto twoQ = makeEvictionPolicy<FakeCache, FakeBuffer*>(EvictionPolicyKind::TWO_Q);
+    auto lfu = makeEvictionPolicy<FakeCache, FakeBuffer*>(EvictionPolicyKind::LFU);
+    using Clock = ClockSweepPolicy<FakeCache, FakeBuffer*>;
+    using TwoQ = TwoQPolicy<FakeCache, FakeBuffer*>;
+    using Lfu = LfuPolicy<FakeCache, FakeBuffer*>;
+    EXPECT_NE(dynamic_cast<Clock*>(clock.get()), nullptr);
+    EXPECT_NE(dynamic_cast<TwoQ*>(twoQ.get()), nullptr);
+    EXPECT_NE(dynamic_cast<Lfu*>(lfu.get()), nullptr);
+}
@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+#include <errno.h>
+#include <cstring>
+#include <set>
+#include <string>
+#include <vector>
+#include "../src/framePool.h"
+#include "../src/pageFile.h"
+#include "testHelpers.h"
+
+// ==================== TESTY FRAME POOL ====================
+
+TEST(FramePoolTest, FramesAreAlignedAndDistinct) {
+    FramePool pool(16);
+    ASSERT_TRUE(pool.isReady());
+    EXPECT_EQ(pool.getFrameCount(), 16);
+    std::set<uint8_t*> frames;
+    for (int32_t i = 0; i < 16; ++i) {
+        uint8_t* f = pool.acquire();
+        ASSERT_NE(f, nullptr);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(f) % PAGE_FILE_IO_ALIGN, 0u);
+        EXPECT_GE(pool.indexOf(f), 0);
+        EXPECT_EQ(pool.frame(pool.indexOf(f)), f);
+        frames.insert(f);
+    }
+    EXPECT_EQ(frames.size(), 16u);
+    EXPECT_EQ(pool.acquire(), nullptr);
+    EXPECT_EQ(pool.getFreeCount(), 0);
+
+    uint8_t* f = *frames.begin();
+    std::memset(f, 0xab, PAGE_FILE_BLOCK_SIZE);
+    pool.release(f);
+    pool.release(f);   // double release is ignored
+    EXPECT_EQ(pool.getFreeCount(), 1);
+    uint8_t* again = pool.acquire();
+    EXPECT_EQ(again, f);
+    EXPECT_EQ(again[0], 0);   // handed out zeroed
+}
+
+TEST(FramePoolTest, ForeignMemoryIsNotAFrame) {
+    FramePool pool(2);
+    std::vector<uint8_t> other(PAGE_FILE_BLOCK_SIZE);
+    EXPECT_EQ(pool.indexOf(other.data()), -1);
+    EXPECT_EQ(pool.indexOf(pool.frame(1) + 1), -1);
+    EXPECT_EQ(pool.frame(2), nullptr);
+    pool.release(other.data());
+    EXPECT_EQ(pool.getFreeCount(), 2);
+}
+
+TEST(FramePoolTest, SizedFromPhysicalMemory) {
+    int32_t frames = FramePool::framesForMemory(0.01);
+    EXPECT_GT(frames, 0);
+    EXPECT_LT(frames, FramePool::framesForMemory(0.5));
+    EXPECT_EQ(FramePool::framesForMemory(0), 0);
+}
+
+class DirectPageFileTest : public TempFileTest<> {
+protected:
+    DirectPageFileTest() : TempFileTest("direct", ".dat") {}
+};
+
+TEST_F(DirectPageFileTest, FramesRoundTripThroughDirectIo) {
+    PageFile file;
+    ASSERT_TRUE(file.open(filePath, true));
+    std::unique_ptr<AsyncPageIo> io = makeAsyncPageIo(8);
+    FramePool pool(8);
+
+    std::vector<PageRef> refs;
+    for (int32_t b = 0; b < 8; ++b) {
+        uint8_t* f = pool.acquire();
+        std::memset(f, 'a' + b, PAGE_FILE_BLOCK_SIZE);
+        refs.push_back({b, f});
+    }
+    std::vector<int32_t> results;
+    EXPECT_EQ(file.writePages(*io, refs, results), 0);
+    EXPECT_TRUE(file.sync(*io));
+    for (auto& r : refs) {
+        std::memset(r.page, 0, PAGE_FILE_BLOCK_SIZE);
+    }
+    EXPECT_EQ(file.readPages(*io, refs, results), 0);
+    for (int32_t b = 0; b < 8; ++b) {
+        EXPECT_EQ(results[b], static_cast<int32_t>(PAGE_FILE_BLOCK_SIZE));
+        EXPECT_EQ(static_cast<uint8_t*>(refs[b].page)[PAGE_FILE_BLOCK_SIZE - 1], static_cast<uint8_t>('a' + b));
+    }
+}
+
+TEST_F(DirectPageFileTest, MisalignedPageIsRejectedInDirectMode) {
+    PageFile file;
+    ASSERT_TRUE(file.open(filePath, true));
+    if (!file.isDirect()) {
+        GTEST_SKIP() << "O_DIRECT not supported on " << filePath;
+    }
+    std::unique_ptr<AsyncPageIo> io = makeAsyncPageIo(4);
+    FramePool pool(1);
+    std::vector<uint8_t> misaligned(PAGE_FILE_BLOCK_SIZE + 1);
+    uint8_t* bad = misaligned.data();
+    if (reinterpret_cast<uintptr_t>(bad) % PAGE_FILE_IO_ALIGN == 0) {
+        bad++;
+    }
+    std::vector<PageRef> refs{{0, pool.acquire()}, {1, bad}};
+    std::vector<int32_t> results;
+    EXPECT_EQ(file.writePages(*io, refs, results), 1);
+    EXPECT_EQ(results[0], static_cast<int32_t>(PAGE_FILE_BLOCK_SIZE));
+    EXPECT_EQ(results[1], -EINVAL);
+    EXPECT_EQ(file.getBlockCount(), 1);
+}
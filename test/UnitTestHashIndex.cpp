@@ -0,0 +1,265 @@
+#include <gtest/gtest.h>
+#include <pthread.h>
+#include <algorithm>
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "../src/btreeIndex.h"
+#include "../src/hashIndex.h"
+#include "testHelpers.h"
+
+// ==================== TESTY HASH INDEX ====================
+
+class HashIndexTest : public TempFileTest<> {
+protected:
+    HashIndexTest() : TempFileTest("hash", ".idx") {}
+    void TearDown() override {
+        sharedHashIndexes.clear();
+    }
+    static Ctid ctid(int32_t block, uint16_t slot) {
+        Ctid c;
+        c.blockNum = block;
+        c.slot = slot;
+        return c;
+    }
+};
+
+TEST_F(HashIndexTest, SplitsOneBucketPerInsert) {
+    HashIndex index(1);
+    ASSERT_TRUE(index.open(filePath, 3));
+    EXPECT_EQ(index.getBucketCount(), 4u);   // rounded up to a power of two
+    const int32_t N = 30000;
+    std::vector<int64_t> keys(N);
+    for (int32_t i = 0; i < N; ++i) {
+        keys[i] = static_cast<int64_t>(i) * 7 - 1000;
+    }
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(11));
+    for (int64_t key : keys) {
+        int64_t splits = index.getSplitCount();
+        ASSERT_TRUE(index.insert(key, ctid(static_cast<int32_t>(key & 0xffff), 2)));
+        ASSERT_LE(index.getSplitCount() - splits, 1);
+    }
+    EXPECT_EQ(index.getEntryCount(), N);
+    EXPECT_EQ(index.getBucketCount(), 4 + index.getSplitCount());
+    // fill stays under the limit, so the buckets grew with the data
+    EXPECT_LE(N, static_cast<int64_t>(index.getBucketCount()) * HashIndex::BUCKET_CAPACITY * HASH_INDEX_FILL_PERCENT / 100);
+    for (int64_t key : keys) {
+        std::vector<Ctid> found = index.lookup(key);
+        ASSERT_EQ(found.size(), 1u) << key;
+        EXPECT_EQ(found[0], ctid(static_cast<int32_t>(key & 0xffff), 2));
+    }
+    EXPECT_TRUE(index.lookup(2).empty());
+}
+
+TEST_F(HashIndexTest, DuplicateKeysUseOverflowPagesAndRemove) {
+    HashIndex index(1);
+    ASSERT_TRUE(index.open(filePath));
+    // more entries of one key than fit a page, the bucket chains overflow pages
+    const int32_t COPIES = static_cast<int32_t>(HashIndex::BUCKET_CAPACITY) * 2 + 10;
+    for (int32_t i = 0; i < COPIES; ++i) {
+        ASSERT_TRUE(index.insert(42, ctid(i, static_cast<uint16_t>(i % 7))));
+    }
+    ASSERT_TRUE(index.insert(42, ctid(0, 0)));   // already there
+    EXPECT_EQ(index.getEntryCount(), COPIES);
+    EXPECT_EQ(index.lookup(42).size(), static_cast<size_t>(COPIES));
+
+    EXPECT_TRUE(index.remove(42, ctid(5, 5)));
+    EXPECT_FALSE(index.remove(42, ctid(5, 5)));
+    EXPECT_FALSE(index.remove(43, ctid(6, 6)));
+    std::vector<Ctid> found = index.lookup(42);
+    EXPECT_EQ(found.size(), static_cast<size_t>(COPIES - 1));
+    EXPECT_EQ(std::find(found.begin(), found.end(), ctid(5, 5)), found.end());
+    EXPECT_NE(std::find(found.begin(), found.end(), ctid(COPIES - 1, static_cast<uint16_t>((COPIES - 1) % 7))), found.end());
+    EXPECT_EQ(index.getEntryCount(), COPIES - 1);
+}
+
+TEST_F(HashIndexTest, ReopenKeepsBucketsAndEntries) {
+    const int32_t N = 20000;
+    uint32_t buckets = 0;
+    {
+        HashIndex index(1);
+        ASSERT_TRUE(index.open(filePath));
+        for (int32_t i = 0; i < N; ++i) {
+            ASSERT_TRUE(index.insert(i, ctid(i / 100, static_cast<uint16_t>(i % 100))));
+        }
+        buckets = index.getBucketCount();
+        index.close();
+    }
+    // a cold cache reads only the bucket's chain, no directory or tree to walk
+    HashIndex index(1, 16);
+    ASSERT_TRUE(index.open(filePath));
+    EXPECT_EQ(index.getBucketCount(), buckets);
+    EXPECT_EQ(index.getEntryCount(), N);
+    int64_t before = index.getPageReads();
+    std::vector<Ctid> found = index.lookup(12345);
+    ASSERT_EQ(found.size(), 1u);
+    EXPECT_EQ(found[0], ctid(123, 45));
+    EXPECT_LE(index.getPageReads() - before, 2);
+    for (int32_t i = 0; i < N; i += 97) {
+        ASSERT_EQ(index.lookup(i).size(), 1u) << i;
+    }
+    // the index keeps growing after a reopen
+    for (int32_t i = N; i < 2 * N; ++i) {
+        ASSERT_TRUE(index.insert(i, ctid(0, 0)));
+    }
+    EXPECT_GT(index.getBucketCount(), buckets);
+    EXPECT_EQ(index.lookup(N - 1).size(), 1u);
+    EXPECT_EQ(index.lookup(2 * N - 1).size(), 1u);
+}
+
+TEST_F(HashIndexTest, RejectsOtherIndexFiles) {
+    {
+        BTreeIndex btree(1);
+        ASSERT_TRUE(btree.open(filePath));
+        btree.close();
+    }
+    HashIndex index(1);
+    EXPECT_FALSE(index.open(filePath));
+    EXPECT_FALSE(index.insert(1, ctid(1, 1)));
+    EXPECT_TRUE(index.lookup(1).empty());
+}
+
+struct HashInsertArg {
+    HashIndex* index;
+    int32_t worker;
+    int32_t count;
+    bool ok;
+};
+
+static void* hashInsertWorker(void* p) {
+    HashInsertArg* arg = static_cast<HashInsertArg*>(p);
+    arg->ok = true;
+    for (int32_t i = 0; i < arg->count; ++i) {
+        int64_t key = static_cast<int64_t>(i) * 4 + arg->worker;
+        Ctid ctid;
+        ctid.blockNum = arg->worker;
+        arg->ok = arg->index->insert(key, ctid) && arg->ok;
+    }
+    return nullptr;
+}
+
+TEST_F(HashIndexTest, ConcurrentInsertsAndSplitsLoseNothing) {
+    HashIndex index(1);
+    ASSERT_TRUE(index.open(filePath, 1));
+    const int32_t WORKERS = 4;
+    const int32_t PER_WORKER = 8000;
+    std::vector<pthread_t> threads(WORKERS);
+    std::vector<HashInsertArg> args(WORKERS);
+    for (int32_t w = 0; w < WORKERS; ++w) {
+        args[w] = {&index, w, PER_WORKER, false};
+        ASSERT_EQ(pthread_create(&threads[w], nullptr, &hashInsertWorker, &args[w]), 0);
+    }
+    for (int32_t w = 0; w < WORKERS; ++w) {
+        pthread_join(threads[w], nullptr);
+        EXPECT_TRUE(args[w].ok);
+    }
+    EXPECT_EQ(index.getEntryCount(), WORKERS * PER_WORKER);
+    EXPECT_GT(index.getSplitCount(), 0);
+    for (int64_t key = 0; key < WORKERS * PER_WORKER; ++key) {
+        std::vector<Ctid> found = index.lookup(key);
+        ASSERT_EQ(found.size(), 1u) << key;
+        EXPECT_EQ(found[0].blockNum, static_cast<int32_t>(key % 4));
+    }
+}
+
+TEST_F(HashIndexTest, BuildFromTableAndIndexedInserts) {
+    std::string tablePath = filePath + ".tab";
+    std::filesystem::remove(tablePath);
+    std::vector<uint8_t> types{TUPLE_TYPE_STRING, TUPLE_TYPE_INT64};
+    TupleCodec codec(types, {0, 1});
+    std::vector<std::vector<uint8_t>> pages(3, std::vector<uint8_t>(PAGE_FILE_BLOCK_SIZE));
+    {
+        PageFile table;
+        ASSERT_TRUE(table.open(tablePath));
+        std::vector<PageRef> refs;
+        int64_t value = 0;
+        for (int32_t b = 0; b < 2; ++b) {
+            SlottedPage::init(pages[b].data(), 9, b);
+            SlottedPage page(pages[b].data());
+            for (int32_t i = 0; i < 40; ++i, ++value) {
+                std::vector<allVars> row{std::string("name"), value};
+                std::vector<bool> bitmap{true, value % 10 != 0};   // every tenth value is null
+                ASSERT_GE(page.addRow(codec, row, bitmap), 0);
+            }
+            refs.push_back({b, pages[b].data()});
+        }
+        SyncPageIo io(4);
+        std::vector<int32_t> results;
+        ASSERT_EQ(table.writePages(io, refs, results), 0);
+    }
+    PageFile table;
+    ASSERT_TRUE(table.open(tablePath));
+    std::shared_ptr<HashIndex> index = std::make_shared<HashIndex>(1);
+    ASSERT_TRUE(index->open(filePath));
+    ASSERT_TRUE(index->buildFromTable(table, 9, codec, 1));
+    EXPECT_EQ(index->getEntryCount(), 80 - 8);
+    std::vector<Ctid> found = index->lookup(57);
+    ASSERT_EQ(found.size(), 1u);
+    EXPECT_EQ(found[0], ctid(1, 17));
+    EXPECT_TRUE(index->lookup(50).empty());
+    EXPECT_FALSE(index->buildFromTable(table, 9, codec, 0));   // not an integer column
+    table.close();
+    std::filesystem::remove(tablePath);
+
+    // rows added through the indexed insert path show up with their ctid
+    sharedHashIndexes.attach(9, 1, index);
+    EXPECT_EQ(sharedHashIndexes.get(9, 1), index);
+    EXPECT_EQ(sharedHashIndexes.get(9, 0), nullptr);
+    SlottedPage::init(pages[2].data(), 9, 2);
+    SlottedPage page(pages[2].data());
+    std::vector<allVars> row{std::string("late"), int64_t(57)};
+    int32_t slot = addIndexedRow(page, codec, row, {true, true});
+    ASSERT_GE(slot, 0);
+    found = index->lookup(57);
+    ASSERT_EQ(found.size(), 2u);
+    EXPECT_NE(std::find(found.begin(), found.end(), ctid(2, static_cast<uint16_t>(slot))), found.end());
+    ASSERT_GE(addIndexedRow(page, codec, {std::string("null"), int64_t(100)}, {true, false}), 0);
+    EXPECT_TRUE(index->lookup(100).empty());
+
+    sharedHashIndexes.detach(9);
+    ASSERT_GE(addIndexedRow(page, codec, row, {true, true}), 0);
+    EXPECT_EQ(index->lookup(57).size(), 2u);
+}
+
+TEST_F(HashIndexTest, DeletedRowLeavesIndexBeforeItsSlotIsReused) {
+    std::shared_ptr<HashIndex> index = std::make_shared<HashIndex>(1);
+    ASSERT_TRUE(index->open(filePath));
+    sharedHashIndexes.attach(9, 1, index);
+    TupleCodec codec({TUPLE_TYPE_STRING, TUPLE_TYPE_INT64}, {0, 1});
+    std::vector<uint8_t> frame(PAGE_FILE_BLOCK_SIZE);
+    SlottedPage::init(frame.data(), 9, 4);
+    SlottedPage page(frame.data());
+    ASSERT_EQ(addIndexedRow(page, codec, {std::string("old"), int64_t(5)}, {true, true}), 0);
+    ASSERT_EQ(addIndexedRow(page, codec, {std::string("keep"), int64_t(6)}, {true, true}), 1);
+
+    EXPECT_TRUE(deleteIndexedTuple(page, codec, 0));
+    EXPECT_FALSE(deleteIndexedTuple(page, codec, 0));
+    EXPECT_TRUE(index->lookup(5).empty());
+    // the freed slot goes to the next row, the old key must not point at it
+    ASSERT_EQ(addIndexedRow(page, codec, {std::string("new"), int64_t(7)}, {true, true}), 0);
+    EXPECT_TRUE(index->lookup(5).empty());
+    EXPECT_EQ(index->lookup(7), std::vector<Ctid>{ctid(4, 0)});
+    EXPECT_EQ(index->lookup(6), std::vector<Ctid>{ctid(4, 1)});
+    EXPECT_EQ(index->getEntryCount(), 2);
+}
+
+TEST_F(HashIndexTest, RowAnIndexRejectsIsRolledBack) {
+    std::shared_ptr<HashIndex> index = std::make_shared<HashIndex>(1);
+    ASSERT_TRUE(index->open(filePath));
+    sharedHashIndexes.attach(9, 1, index);
+    sharedHashIndexes.attach(9, 0, std::make_shared<HashIndex>(2));   // never opened, takes no key
+    TupleCodec codec({TUPLE_TYPE_INT32, TUPLE_TYPE_INT64}, {1, 1});
+    std::vector<uint8_t> frame(PAGE_FILE_BLOCK_SIZE);
+    SlottedPage::init(frame.data(), 9, 4);
+    SlottedPage page(frame.data());
+    EXPECT_EQ(addIndexedRow(page, codec, {int32_t(1), int64_t(5)}, {true, true}), INDEXED_ROW_REJECTED);
+    // neither the row nor the key the open index took stays behind
+    EXPECT_EQ(page.getTuple(0, nullptr), nullptr);
+    EXPECT_TRUE(index->lookup(5).empty());
+    EXPECT_EQ(index->getEntryCount(), 0);
+    // a null skips the broken index, the row goes in
+    EXPECT_EQ(addIndexedRow(page, codec, {int32_t(0), int64_t(6)}, {false, true}), 0);
+    EXPECT_EQ(index->lookup(6), std::vector<Ctid>{ctid(4, 0)});
+}
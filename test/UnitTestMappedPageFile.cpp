@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "../src/mappedPageFile.h"
+#include "../src/pageFile.h"
+#include "testHelpers.h"
+
+// ==================== TESTY MAPPED PAGE FILE ====================
+
+class MappedPageFileTest : public TempFileTest<> {
+protected:
+    PageFile writer;
+    SyncPageIo io{8};
+
+    MappedPageFileTest() : TempFileTest("mapped", ".dat") {}
+    void SetUp() override {
+        ASSERT_TRUE(writer.open(filePath));
+    }
+    void TearDown() override {
+        writer.close();
+    }
+
+    // block first + i is filled with fill + i
+    void writeBlocks(int32_t first, int32_t count, char fill) {
+        writeTestBlocks(writer, first, count, [first, fill](uint8_t* page, int32_t blockNum) {
+            std::memset(page, fill + (blockNum - first), PAGE_FILE_BLOCK_SIZE);
+        });
+    }
+};
+
+TEST_F(MappedPageFileTest, ServesBlocksFromTheMapping) {
+    writeBlocks(0, 4, 'a');
+    MappedPageFile file;
+    ASSERT_TRUE(file.open(filePath, PageAccessHint::SEQUENTIAL));
+    EXPECT_EQ(file.getBlockCount(), 4);
+    for (int32_t b = 0; b < 4; ++b) {
+        const uint8_t* p = file.page(b);
+        ASSERT_NE(p, nullptr);
+        EXPECT_EQ(p[0], static_cast<uint8_t>('a' + b));
+        EXPECT_EQ(p[PAGE_FILE_BLOCK_SIZE - 1], static_cast<uint8_t>('a' + b));
+    }
+    EXPECT_EQ(file.page(4), nullptr);
+    EXPECT_EQ(file.page(-1), nullptr);
+    file.prefetch(0, 100);   // clamped to the mapping
+    file.setAccessHint(PageAccessHint::RANDOM);
+}
+
+TEST_F(MappedPageFileTest, WritebackIsVisibleThroughTheMapping) {
+    writeBlocks(0, 2, 'a');
+    MappedPageFile file;
+    ASSERT_TRUE(file.open(filePath));
+    const uint8_t* p = file.page(1);
+    ASSERT_NE(p, nullptr);
+    writeBlocks(1, 1, 'z');
+    EXPECT_EQ(p[0], static_cast<uint8_t>('z'));
+}
+
+TEST_F(MappedPageFileTest, RefreshPicksUpGrowthAndKeepsOldPointers) {
+    writeBlocks(0, 1, 'a');
+    MappedPageFile file;
+    ASSERT_TRUE(file.open(filePath));
+    const uint8_t* first = file.page(0);
+    ASSERT_NE(first, nullptr);
+
+    writeBlocks(1, 3, 'k');
+    EXPECT_EQ(file.page(2), nullptr);
+    ASSERT_TRUE(file.refresh());
+    EXPECT_EQ(file.getBlockCount(), 4);
+    ASSERT_NE(file.page(3), nullptr);
+    EXPECT_EQ(file.page(3)[0], static_cast<uint8_t>('k' + 2));
+    // only the new blocks were mapped, in place behind the first one
+    EXPECT_EQ(file.page(0), first);
+    EXPECT_EQ(file.page(3), first + 3 * PAGE_FILE_BLOCK_SIZE);
+    EXPECT_EQ(first[0], static_cast<uint8_t>('a'));
+}
+
+TEST_F(MappedPageFileTest, GrowthPastTheReservationIsNotMapped) {
+    writeBlocks(0, 2, 'a');
+    MappedPageFile file;
+    ASSERT_TRUE(file.open(filePath, PageAccessHint::NORMAL, 3 * PAGE_FILE_BLOCK_SIZE));
+    writeBlocks(2, 3, 'p');
+    EXPECT_FALSE(file.refresh());
+    // the reserved blocks are still served
+    EXPECT_EQ(file.getBlockCount(), 3);
+    ASSERT_NE(file.page(2), nullptr);
+    EXPECT_EQ(file.page(2)[0], static_cast<uint8_t>('p'));
+    EXPECT_EQ(file.page(3), nullptr);
+}
+
+TEST_F(MappedPageFileTest, EmptyFileMapsLater) {
+    MappedPageFile file;
+    ASSERT_TRUE(file.open(filePath));
+    EXPECT_EQ(file.getBlockCount(), 0);
+    EXPECT_EQ(file.page(0), nullptr);
+    writeBlocks(0, 2, 'c');
+    ASSERT_TRUE(file.refresh());
+    EXPECT_EQ(file.getBlockCount(), 2);
+}
+
+TEST_F(MappedPageFileTest, DirtySharedBufferWinsOverTheMapping) {
+    writeBlocks(0, 2, 'a');
+    MappedPageFile file;
+    ASSERT_TRUE(file.open(filePath));
+
+    std::vector<ShareBuffer*>* saved = buffers;
+    std::vector<ShareBuffer*> cache(1, nullptr);
+    ShareBuffer dirty;
+    dirty.tableId = 2600;
+    dirty.blockNum = 1;
+    dirty.isDirty = true;
+    cache[0] = &dirty;
+    buffers = &cache;
+    sharedBufferMapping.insert(2600, 1, 0);
+
+    PageView view = readPageView(file, 2600, 1);
+    EXPECT_EQ(view.data, nullptr);
+    EXPECT_EQ(view.buffer.buffer, &dirty);
+    EXPECT_TRUE(sharedBufferDescs.isPinned(0));
+    unpinSharedBuffer(view.buffer);
+
+    dirty.isDirty = false;
+    view = readPageView(file, 2600, 1);
+    EXPECT_EQ(view.data, file.page(1));
+    EXPECT_EQ(view.buffer.buffer, nullptr);
+    EXPECT_FALSE(sharedBufferDescs.isPinned(0));
+
+    // not resident at all
+    view = readPageView(file, 2600, 0);
+    EXPECT_EQ(view.data, file.page(0));
+
+    sharedBufferMapping.clear();
+    buffers = saved;
+}
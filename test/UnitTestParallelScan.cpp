@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "../src/parallelScan.h"
+#include "testHelpers.h"
+
+// ==================== TESTY PARALLEL SCAN CURSOR ====================
+
+TEST(ParallelScanCursorTest, ClaimsCoverTheRangeOnce) {
+    ParallelScanCursor cursor(10, 1000, 4, 64);
+    int32_t first;
+    int32_t end;
+    int32_t expected = 10;
+    std::vector<int32_t> sizes;
+    while (cursor.claim(first, end)) {
+        EXPECT_EQ(first, expected);
+        EXPECT_GT(end, first);
+        sizes.push_back(end - first);
+        expected = end;
+    }
+    EXPECT_EQ(expected, 1000);
+    EXPECT_EQ(sizes.front(), 64);
+    // the chunks shrink toward the end of the table
+    EXPECT_EQ(sizes.back(), 1);
+    EXPECT_TRUE(std::is_sorted(sizes.rbegin(), sizes.rend()));
+    EXPECT_FALSE(cursor.claim(first, end));
+}
+
+TEST(ParallelScanCursorTest, EmptyRangeHasNoClaims) {
+    ParallelScanCursor cursor(5, 5, 2);
+    int32_t first;
+    int32_t end;
+    EXPECT_FALSE(cursor.claim(first, end));
+}
+
+// ==================== TESTY PARALLEL SCAN ====================
+
+class ParallelScanTest : public TempFileTest<> {
+protected:
+    PageFile file;
+
+    ParallelScanTest() : TempFileTest("pscan", ".dat") {}
+    void SetUp() override {
+        ASSERT_TRUE(file.open(filePath));
+    }
+    void TearDown() override {
+        file.close();
+    }
+
+    // block b holds b + 1 in every int32
+    void writeBlocks(int32_t count) {
+        writeTestBlocks(file, 0, count, [](uint8_t* page, int32_t b) {
+            int32_t* values = reinterpret_cast<int32_t*>(page);
+            std::fill(values, values + PAGE_FILE_BLOCK_SIZE / sizeof(int32_t), b + 1);
+        });
+    }
+};
+
+struct ScanTotals {
+    int64_t sum = 0;
+    std::vector<int32_t> blocks;
+};
+
+TEST_F(ParallelScanTest, WorkersMergeTheirPartials) {
+    const int32_t BLOCKS = 300;
+    writeBlocks(BLOCKS);
+    ParallelScanOptions options;
+    options.workers = 4;
+    options.chunkBlocks = 8;
+    options.scan.ringFrames = 8;
+    options.scan.readAhead = 4;
+    ScanTotals totals;
+    bool ok = parallelScan(file, 1, totals,
+        [](ScanTotals& partial, const ScanPage& page) {
+            const int32_t* values = reinterpret_cast<const int32_t*>(page.data);
+            for (size_t i = 0; i < PAGE_FILE_BLOCK_SIZE / sizeof(int32_t); ++i) {
+                partial.sum += values[i];
+            }
+            partial.blocks.push_back(page.blockNum);
+        },
+        [](ScanTotals& result, const ScanTotals& partial) {
+            result.sum += partial.sum;
+            result.blocks.insert(result.blocks.end(), partial.blocks.begin(), partial.blocks.end());
+        }, options);
+    EXPECT_TRUE(ok);
+    // every block exactly once
+    std::sort(totals.blocks.begin(), totals.blocks.end());
+    ASSERT_EQ(totals.blocks.size(), static_cast<size_t>(BLOCKS));
+    for (int32_t b = 0; b < BLOCKS; ++b) {
+        EXPECT_EQ(totals.blocks[b], b);
+    }
+    int64_t perBlock = PAGE_FILE_BLOCK_SIZE / sizeof(int32_t);
+    EXPECT_EQ(totals.sum, perBlock * BLOCKS * (BLOCKS + 1) / 2);
+}
+
+TEST_F(ParallelScanTest, RangeAndMoreWorkersThanChunks) {
+    writeBlocks(20);
+    ParallelScanOptions options;
+    options.workers = 8;
+    options.scan.firstBlock = 5;
+    options.scan.endBlock = 8;
+    std::vector<int32_t> perWorker(8, 0);
+    std::atomic<int32_t> pages{0};
+    EXPECT_TRUE(runParallelScan(file, 1, [&](int32_t worker, const ScanPage& page) {
+        EXPECT_GE(page.blockNum, 5);
+        EXPECT_LT(page.blockNum, 8);
+        perWorker[worker]++;
+        pages++;
+    }, options));
+    EXPECT_EQ(pages.load(), 3);
+}
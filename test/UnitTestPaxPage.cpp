@@ -0,0 +1,136 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "../src/paxPage.h"
+#include "../src/slottedPage.h"
+#include "../src/tupleCodec.h"
+
+// ==================== TESTY PAX PAGE ====================
+
+class PaxPageTest : public ::testing::Test {
+protected:
+    std::vector<uint8_t> storage = std::vector<uint8_t>(PAGE_FILE_BLOCK_SIZE + 8);
+    uint8_t* frame = nullptr;
+    std::vector<uint8_t> types{TUPLE_TYPE_INT32, TUPLE_TYPE_INT64, TUPLE_TYPE_STRING, TUPLE_TYPE_BOOL};
+    void SetUp() override {
+        uintptr_t p = reinterpret_cast<uintptr_t>(storage.data());
+        frame = reinterpret_cast<uint8_t*>((p + 7) & ~static_cast<uintptr_t>(7));
+    }
+
+    static std::vector<allVars> makeRow(int32_t i) {
+        return {i, static_cast<int64_t>(i) * 1000, std::string("row") + std::to_string(i), i % 2 == 0};
+    }
+};
+
+TEST_F(PaxPageTest, InitSharesTheRowPageHeader) {
+    ASSERT_TRUE(PaxPage::init(frame, 5, 9, types));
+    PaxPage page(frame);
+    EXPECT_TRUE(PaxPage::isPax(frame));
+    EXPECT_EQ(page.getTableId(), 5);
+    EXPECT_EQ(page.getBlockNum(), 9);
+    EXPECT_EQ(page.getColumnCount(), 4);
+    EXPECT_EQ(page.getRowCount(), 0);
+    EXPECT_GT(page.getCapacity(), 100);
+    EXPECT_EQ(page.getColumnType(2), TUPLE_TYPE_STRING);
+    page.setLsn(77);
+    EXPECT_EQ(reinterpret_cast<SlottedPageHeader*>(frame)->lsn, 77u);
+
+    SlottedPage::init(frame, 5, 9);
+    EXPECT_FALSE(PaxPage::isPax(frame));
+}
+
+TEST_F(PaxPageTest, RowsRoundTripThroughColumns) {
+    ASSERT_TRUE(PaxPage::init(frame, 1, 0, types));
+    PaxPage page(frame);
+    for (int32_t i = 0; i < 50; ++i) {
+        std::vector<bool> bitmap{true, i % 5 != 0, i % 7 != 0, true};
+        EXPECT_EQ(page.appendRow(makeRow(i), bitmap), i);
+    }
+    for (int32_t i = 0; i < 50; ++i) {
+        std::vector<allVars> row;
+        std::vector<bool> bitmap;
+        ASSERT_TRUE(page.readRow(i, row, bitmap));
+        std::vector<allVars> expected = makeRow(i);
+        EXPECT_EQ(bitmap, (std::vector<bool>{true, i % 5 != 0, i % 7 != 0, true}));
+        EXPECT_EQ(row[0], expected[0]);
+        EXPECT_EQ(row[1], i % 5 != 0 ? expected[1] : allVars(static_cast<int64_t>(0)));
+        EXPECT_EQ(row[2], i % 7 != 0 ? expected[2] : allVars(std::string()));
+        EXPECT_EQ(row[3], expected[3]);
+    }
+    std::vector<allVars> row;
+    std::vector<bool> bitmap;
+    EXPECT_FALSE(page.readRow(50, row, bitmap));
+    std::string s;
+    EXPECT_TRUE(page.getString(2, 3, s));
+    EXPECT_EQ(s, "row3");
+    EXPECT_FALSE(page.getString(2, 7, s));   // null
+    EXPECT_FALSE(page.getString(0, 3, s));   // not a string column
+}
+
+TEST_F(PaxPageTest, ColumnScansReadOneArray) {
+    ASSERT_TRUE(PaxPage::init(frame, 1, 0, types));
+    PaxPage page(frame);
+    int64_t expectedSum = 0;
+    int64_t expectedCount = 0;
+    for (int32_t i = 0; i < 100; ++i) {
+        bool present = i % 3 != 0;
+        std::vector<bool> bitmap{true, present, true, true};
+        ASSERT_GE(page.appendRow(makeRow(i), bitmap), 0);
+        if (present) {
+            expectedSum += static_cast<int64_t>(i) * 1000;
+            expectedCount++;
+        }
+    }
+    EXPECT_EQ(page.sumColumn(0), 99 * 100 / 2);
+    EXPECT_EQ(page.sumColumn(1), expectedSum);      // nulls are stored as zero
+    EXPECT_EQ(page.countNotNull(1), expectedCount);
+    EXPECT_EQ(page.countNotNull(0), 100);
+    EXPECT_EQ(page.sumColumn(2), 0);                // strings are not summed
+
+    const int32_t* ids = page.columnArray<int32_t>(0);
+    ASSERT_NE(ids, nullptr);
+    EXPECT_EQ(ids[42], 42);
+    EXPECT_EQ(page.columnArray<int64_t>(0), nullptr);
+}
+
+TEST_F(PaxPageTest, FullPageAndBadRowsLeaveItUnchanged) {
+    ASSERT_TRUE(PaxPage::init(frame, 1, 0, types));
+    PaxPage page(frame);
+    std::vector<bool> bitmap(4, true);
+    std::vector<allVars> bad = makeRow(1);
+    bad[0] = static_cast<int64_t>(1);
+    EXPECT_EQ(page.appendRow(bad, bitmap), -1);
+    EXPECT_EQ(page.getRowCount(), 0);
+
+    // long strings use up the heap before the arrays are full
+    std::vector<allVars> wide = makeRow(1);
+    wide[2] = std::string(1000, 'x');
+    int32_t added = 0;
+    while (page.appendRow(wide, bitmap) >= 0) {
+        added++;
+    }
+    EXPECT_GT(added, 0);
+    EXPECT_LT(added, page.getCapacity());
+    // short rows still fit in what is left, up to the capacity
+    while (page.appendRow(makeRow(added), bitmap) >= 0) {
+        added++;
+    }
+    EXPECT_LE(page.getRowCount(), page.getCapacity());
+    std::string s;
+    ASSERT_TRUE(page.getString(2, 0, s));
+    EXPECT_EQ(s, std::string(1000, 'x'));
+}
+
+TEST_F(PaxPageTest, TableStorageComesFromTheCodec) {
+    TupleCodecRegistry registry;
+    EXPECT_EQ(registry.define(1, types, {})->getStorage(), TableStorage::ROW);
+    std::shared_ptr<const TupleCodec> codec = registry.define(2, types, {0, 1, 1, 0}, TableStorage::PAX);
+    EXPECT_EQ(codec->getStorage(), TableStorage::PAX);
+    ASSERT_TRUE(PaxPage::init(frame, 2, 0, *codec));
+    EXPECT_EQ(PaxPage(frame).getColumnCount(), 4);
+
+    std::vector<uint8_t> tooWide(3000, TUPLE_TYPE_INT64);
+    EXPECT_FALSE(PaxPage::init(frame, 3, 0, tooWide));
+    EXPECT_FALSE(PaxPage::init(frame, 3, 0, std::vector<uint8_t>()));
+}
@@ -1,5 +1,6 @@
 // Google Test suite for roleThreadManager
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <thread>
 #include <chrono>
 #include "../src/roleThreadManager.h"
@@ -179,4 +180,63 @@ int main(int argc, char **argv) {
 	::testing::InitGoogleTest(&argc, argv);
 	return RUN_ALL_TESTS();
 }
-*/
\ No newline at end of file
+*/
+
+// ==================== SESSION HANDLES ====================
+
+class SessionHandleTest : public ::testing::Test {
+protected:
+	void setupUser(const std::string &username, const std::string &passwd) {
+		addUserToCache(new buser(getNextUserId(), username, passwd, "test@email.com", false));
+	}
+};
+
+TEST_F(SessionHandleTest, OpenWithWrongCredentialsFails) {
+	size_t sessionsBefore = processBuffer.size();
+	EXPECT_EQ(openSession("handleNoSuchUser", "wrong", 60, 400, ""), INVALID_SESSION_HANDLE);
+	EXPECT_EQ(processBuffer.size(), sessionsBefore);   // the failed session is not left behind
+}
+
+TEST_F(SessionHandleTest, HandleDispatchesToSession) {
+	setupUser("handleUser1", "handlePass1");
+	SessionHandle handle = openSession("handleUser1", "handlePass1", 60, 401, "");
+	ASSERT_NE(handle, INVALID_SESSION_HANDLE);
+	ASSERT_TRUE(isSessionOpen(handle));
+
+	size_t cacheSizeBefore = userCache.size();
+	EXPECT_TRUE(addBuser(handle, "handleNewUser", "p", "new@email.com", false));
+	closeSession(handle);   // drains the queue
+
+	ASSERT_EQ(userCache.size(), cacheSizeBefore + 1);
+	EXPECT_EQ(userCache.back()->getUsername(), "handleNewUser");
+}
+
+TEST_F(SessionHandleTest, ClosedAndUnknownHandlesAreRejected) {
+	setupUser("handleUser2", "handlePass2");
+	SessionHandle handle = openSession("handleUser2", "handlePass2", 60, 402, "");
+	ASSERT_NE(handle, INVALID_SESSION_HANDLE);
+	size_t sessionsBefore = processBuffer.size();
+	closeSession(handle);
+
+	EXPECT_FALSE(isSessionOpen(handle));
+	EXPECT_EQ(processBuffer.size(), sessionsBefore - 1);
+	EXPECT_FALSE(addBuser(handle, "handleLate", "p", "late@email.com", false));
+	EXPECT_FALSE(addTuples(handle + 1, "", 1, {{}}, {{}}));
+	EXPECT_FALSE(addTuples(INVALID_SESSION_HANDLE, "", 1, {}, {{}}));
+}
+
+TEST_F(SessionHandleTest, HandlesAreDistinct) {
+	setupUser("handleUser3", "handlePass3");
+	SessionHandle first = openSession("handleUser3", "handlePass3", 60, 403, "");
+	SessionHandle second = openSession("handleUser3", "handlePass3", 60, 404, "");
+	ASSERT_NE(first, INVALID_SESSION_HANDLE);
+	ASSERT_NE(second, INVALID_SESSION_HANDLE);
+	EXPECT_NE(first, second);
+	// each handle has its own session, closing one leaves the other
+	closeSession(first);
+	EXPECT_FALSE(isSessionOpen(first));
+	EXPECT_TRUE(isSessionOpen(second));
+	EXPECT_FALSE(addBuser(first, "handleAfterFirst", "p", "a@email.com", false));
+	EXPECT_TRUE(addBuser(second, "handleAfterSecond", "p", "a@email.com", false));
+	closeSession(second);
+}
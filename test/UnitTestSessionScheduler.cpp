@@ -0,0 +1,138 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../src/threadPoolRole.h"
+#include "../../bufforing-stm/src/buserCache.h"
+
+// ==================== TESTY SESSION SCHEDULER ====================
+
+class SessionSchedulerTest : public ::testing::Test {
+protected:
+    SessionScheduler scheduler{2};
+
+    void setupUser(const std::string& username, const std::string& passwd) {
+        addUserToCache(new buser(getNextUserId(), username, passwd, "test@email.com", false));
+    }
+
+    bool waitFor(Session& session, int32_t timeoutMs) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+        while (!session.isFinished()) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return true;
+    }
+};
+
+TEST_F(SessionSchedulerTest, WorkerCountDefaultsToCores) {
+    SessionScheduler perCore;
+    EXPECT_GE(perCore.getWorkerCount(), 1);
+    EXPECT_EQ(scheduler.getWorkerCount(), 2);
+}
+
+TEST_F(SessionSchedulerTest, TasksOfOneSessionRunInOrder) {
+    setupUser("schedOrderOwner", "pass");
+    Session session(60, 1, &scheduler);
+    session.start("schedOrderOwner", "pass", "");
+    ASSERT_EQ(session.getThreadId(), 0);
+
+    const int32_t TASKS = 300;
+    size_t before = userCache.size();
+    for (int32_t i = 0; i < TASKS; ++i) {
+        session.addBuser(new buser(getNextUserId(), "schedOrder_" + std::to_string(i), "p", "o@email.com", false));
+    }
+    session.stop();
+
+    ASSERT_EQ(userCache.size(), before + TASKS);
+    for (int32_t i = 0; i < TASKS; ++i) {
+        EXPECT_EQ(userCache[before + i]->getUsername(), "schedOrder_" + std::to_string(i));
+    }
+}
+
+TEST_F(SessionSchedulerTest, ManySessionsOnFewWorkers) {
+    const int32_t SESSIONS = 200;
+    const int32_t TASKS = 20;
+    std::vector<std::unique_ptr<Session>> sessions;
+    for (int32_t s = 0; s < SESSIONS; ++s) {
+        std::string name = "schedMany" + std::to_string(s);
+        setupUser(name, "pass");
+        sessions.emplace_back(new Session(60, s, &scheduler));
+        sessions.back()->start(name, "pass", "");
+    }
+    size_t before = userCache.size();
+
+    std::vector<std::thread> producers;
+    for (int32_t p = 0; p < 4; ++p) {
+        producers.emplace_back([&sessions, p]() {
+            for (int32_t s = p; s < SESSIONS; s += 4) {
+                for (int32_t i = 0; i < TASKS; ++i) {
+                    std::string name = "schedMany_" + std::to_string(s) + "_" + std::to_string(i);
+                    sessions[s]->addBuser(new buser(getNextUserId(), name, "p", "m@email.com", false));
+                }
+            }
+        });
+    }
+    for (auto& t : producers) {
+        t.join();
+    }
+    for (auto& session : sessions) {
+        session->stop();
+        EXPECT_TRUE(session->isFinished());
+    }
+
+    ASSERT_EQ(userCache.size(), before + SESSIONS * TASKS);
+    // per session order is kept even though sessions moved between workers
+    std::map<std::string, int32_t> lastIndex;
+    for (size_t i = before; i < userCache.size(); ++i) {
+        std::string name = userCache[i]->getUsername();
+        size_t split = name.rfind('_');
+        std::string session = name.substr(0, split);
+        int32_t index = std::stoi(name.substr(split + 1));
+        auto it = lastIndex.find(session);
+        EXPECT_EQ(index, it == lastIndex.end() ? 0 : it->second + 1) << name;
+        lastIndex[session] = index;
+    }
+    EXPECT_EQ(lastIndex.size(), static_cast<size_t>(SESSIONS));
+}
+
+TEST_F(SessionSchedulerTest, SessionFinishesAfterTtl) {
+    setupUser("schedTtl", "pass");
+    Session session(1, 1, &scheduler);
+    session.start("schedTtl", "pass", "");
+    EXPECT_FALSE(session.isFinished());
+    EXPECT_TRUE(waitFor(session, 5000));
+}
+
+TEST_F(SessionSchedulerTest, SessionExpiresWhileTheWorkerIsBusy) {
+    SessionScheduler single(1);
+    setupUser("schedBusyOwner", "pass");
+    Session shortLived(1, 1, &single);
+    shortLived.start("schedBusyOwner", "pass", "");
+    Session busy(60, 2, &single);
+    busy.start("schedBusyOwner", "pass", "");
+    // about 3 s of slices back to back, the only worker never goes idle
+    TaskHandle last;
+    for (int32_t i = 0; i < 300; ++i) {
+        last = busy.addTuple("data/", 1, {static_cast<int64_t>(i)}, {true}, [](TaskStatus) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        });
+    }
+    ASSERT_TRUE(waitFor(shortLived, 10000));
+    EXPECT_EQ(last.status(), TaskStatus::PENDING);
+    EXPECT_EQ(last.wait(), TaskStatus::DONE);
+    busy.stop();
+}
+
+TEST_F(SessionSchedulerTest, StopWithoutStartReturns) {
+    Session session(60, 1, &scheduler);
+    session.start("schedNoSuchUser", "wrong", "");
+    EXPECT_EQ(session.getThreadId(), -1);
+    session.stop();
+    SUCCEED();
+}
@@ -0,0 +1,250 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "../src/framePool.h"
+#include "../src/slottedPage.h"
+#include "../src/tupleFormat.h"
+#include "testHelpers.h"
+
+// ==================== TESTY TUPLE FORMAT ====================
+
+TEST(TupleFormatTest, RoundTripWithNulls) {
+    std::vector<allVars> row;
+    row.push_back(static_cast<int8_t>(-3));
+    row.push_back(static_cast<int16_t>(1234));
+    row.push_back(static_cast<int32_t>(-70000));
+    row.push_back(static_cast<int64_t>(1) << 40);
+    row.push_back(true);
+    row.push_back(std::string("quake"));
+    row.push_back(static_cast<int32_t>(99));
+    std::vector<bool> bitmap{true, true, true, true, true, true, false};
+    std::vector<uint8_t> types{TUPLE_TYPE_INT8, TUPLE_TYPE_INT16, TUPLE_TYPE_INT32, TUPLE_TYPE_INT64,
+                               TUPLE_TYPE_BOOL, TUPLE_TYPE_STRING, TUPLE_TYPE_INT32};
+
+    std::vector<uint8_t> buf(tupleEncodedSize(row, bitmap));
+    EXPECT_EQ(buf.size(), 2u + 1u + 1 + 2 + 4 + 8 + 1 + (2 + 5) + 4);
+    EXPECT_EQ(encodeTuple(buf.data(), row, bitmap), buf.size());
+
+    std::vector<allVars> decoded;
+    std::vector<bool> decodedBitmap;
+    ASSERT_TRUE(decodeTuple(buf.data(), buf.size(), types, decoded, decodedBitmap));
+    EXPECT_EQ(decodedBitmap, bitmap);
+    for (size_t i = 0; i + 1 < row.size(); ++i) {
+        EXPECT_EQ(decoded[i], row[i]) << "column " << i;
+    }
+    EXPECT_EQ(std::get<int32_t>(decoded[6]), 0);   // null keeps its slot, zeroed
+
+    // fixed-width columns sit at the same offsets whatever the values are
+    std::vector<allVars> other{static_cast<int8_t>(1), static_cast<int16_t>(2)};
+    std::vector<uint8_t> a(tupleEncodedSize(other, {true, true}));
+    EXPECT_EQ(a.size(), 2u + 1u + 1 + 2);
+
+    // a null string is written as length 0, its bytes are not counted
+    std::vector<allVars> nullString{std::string("not stored"), static_cast<int8_t>(1)};
+    std::vector<bool> nullStringBitmap{false, true};
+    std::vector<uint8_t> b(tupleEncodedSize(nullString, nullStringBitmap));
+    EXPECT_EQ(b.size(), 2u + 1u + 2 + 1);
+    EXPECT_EQ(encodeTuple(b.data(), nullString, nullStringBitmap), b.size());
+
+    EXPECT_FALSE(decodeTuple(buf.data(), buf.size() - 1, types, decoded, decodedBitmap));
+    types.pop_back();
+    EXPECT_FALSE(decodeTuple(buf.data(), buf.size(), types, decoded, decodedBitmap));
+}
+
+// ==================== TESTY SLOTTED PAGE ====================
+
+class SlottedPageTest : public ::testing::Test {
+protected:
+    std::vector<uint8_t> storage = std::vector<uint8_t>(PAGE_FILE_BLOCK_SIZE + PAGE_TUPLE_ALIGN);
+    uint8_t* frame = nullptr;
+    void SetUp() override {
+        uintptr_t p = reinterpret_cast<uintptr_t>(storage.data());
+        frame = reinterpret_cast<uint8_t*>((p + PAGE_TUPLE_ALIGN - 1) & ~static_cast<uintptr_t>(PAGE_TUPLE_ALIGN - 1));
+    }
+};
+
+TEST_F(SlottedPageTest, ZeroedFrameIsNotAPage) {
+    std::memset(frame, 0, PAGE_FILE_BLOCK_SIZE);
+    EXPECT_FALSE(SlottedPage(frame).isValid());
+    SlottedPage::init(frame, 7, 3);
+    SlottedPage page(frame);
+    EXPECT_TRUE(page.isValid());
+    EXPECT_EQ(page.getTableId(), 7);
+    EXPECT_EQ(page.getBlockNum(), 3);
+    EXPECT_EQ(page.getSlotCount(), 0);
+    EXPECT_EQ(page.getSpecialSize(), 0);
+    // tuples are 8-byte aligned, the free space is rounded down to that
+    EXPECT_EQ(page.getFreeSpace(), (PAGE_FILE_BLOCK_SIZE - sizeof(SlottedPageHeader) - sizeof(LinePointer)) / 8 * 8);
+}
+
+TEST_F(SlottedPageTest, FillsUntilFullAndReadsBack) {
+    SlottedPage::init(frame, 1, 0);
+    SlottedPage page(frame);
+    char tuple[100];
+    int32_t added = 0;
+    while (true) {
+        std::memset(tuple, 'a' + added % 26, sizeof(tuple));
+        int32_t slot = page.addTuple(tuple, sizeof(tuple));
+        if (slot < 0) {
+            break;
+        }
+        EXPECT_EQ(slot, added);
+        added++;
+    }
+    // 104 bytes of tuple + 4 of line pointer each
+    EXPECT_EQ(added, static_cast<int32_t>((PAGE_FILE_BLOCK_SIZE - sizeof(SlottedPageHeader)) / 108));
+    EXPECT_LT(page.getFreeSpace(), sizeof(tuple));
+    for (int32_t i = 0; i < added; ++i) {
+        uint16_t length = 0;
+        const uint8_t* t = page.getTuple(i, &length);
+        ASSERT_NE(t, nullptr);
+        EXPECT_EQ(length, sizeof(tuple));
+        EXPECT_EQ(t[0], static_cast<uint8_t>('a' + i % 26));
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(t) % PAGE_TUPLE_ALIGN, 0u);
+    }
+    EXPECT_EQ(page.getTuple(added, nullptr), nullptr);
+}
+
+TEST_F(SlottedPageTest, DeleteCompactKeepsSlots) {
+    SlottedPage::init(frame, 1, 0);
+    SlottedPage page(frame);
+    for (int32_t i = 0; i < 10; ++i) {
+        std::string t(50 + i, static_cast<char>('0' + i));
+        ASSERT_EQ(page.addTuple(t.data(), static_cast<uint16_t>(t.size())), i);
+    }
+    uint16_t before = page.getFreeSpace();
+    EXPECT_TRUE(page.deleteTuple(2));
+    EXPECT_TRUE(page.deleteTuple(5));
+    EXPECT_FALSE(page.deleteTuple(5));
+    EXPECT_EQ(page.getTuple(2, nullptr), nullptr);
+
+    page.compact();
+    EXPECT_GT(page.getFreeSpace(), before);
+    for (int32_t i = 0; i < 10; ++i) {
+        uint16_t length = 0;
+        const uint8_t* t = page.getTuple(i, &length);
+        if (i == 2 || i == 5) {
+            EXPECT_EQ(t, nullptr);
+            continue;
+        }
+        ASSERT_NE(t, nullptr);
+        EXPECT_EQ(length, 50 + i);
+        EXPECT_EQ(std::string(reinterpret_cast<const char*>(t), length), std::string(50 + i, static_cast<char>('0' + i)));
+    }
+    // a deleted slot is reused before a new line pointer is taken
+    EXPECT_EQ(page.addTuple("x", 1), 2);
+    EXPECT_EQ(page.addTuple("y", 1), 5);
+    EXPECT_EQ(page.addTuple("z", 1), 10);
+    EXPECT_TRUE(page.isValid());
+}
+
+TEST_F(SlottedPageTest, DeletedSpaceIsReusedOnAllocation) {
+    SlottedPage::init(frame, 1, 0);
+    SlottedPage page(frame);
+    char tuple[100];
+    int32_t added = 0;
+    while (true) {
+        std::memset(tuple, 'a' + added % 26, sizeof(tuple));
+        if (page.addTuple(tuple, sizeof(tuple)) < 0) {
+            break;
+        }
+        added++;
+    }
+    uint16_t full = page.getFreeSpace();
+    ASSERT_LT(full, sizeof(tuple));
+
+    // the deleted tuple's space counts as free, allocating it compacts the page
+    EXPECT_TRUE(page.deleteTuple(3));
+    EXPECT_GE(page.getFreeSpace(), sizeof(tuple));
+    std::memset(tuple, 'z', sizeof(tuple));
+    EXPECT_EQ(page.addTuple(tuple, sizeof(tuple)), 3);
+    // the last free line was taken, a further tuple needs a new line pointer again
+    EXPECT_EQ(page.getFreeSpace(), full);
+    EXPECT_EQ(page.addTuple(tuple, sizeof(tuple)), -1);
+    for (int32_t i = 0; i < added; ++i) {
+        const uint8_t* t = page.getTuple(i, nullptr);
+        ASSERT_NE(t, nullptr);
+        EXPECT_EQ(t[0], static_cast<uint8_t>(i == 3 ? 'z' : 'a' + i % 26));
+    }
+    EXPECT_TRUE(page.isValid());
+}
+
+TEST_F(SlottedPageTest, OversizeTuplesAreRejected) {
+    SlottedPage::init(frame, 1, 0);
+    SlottedPage page(frame);
+    std::vector<uint8_t> big(70000, 0xab);
+    uint8_t* out = nullptr;
+    // lengths that wrapped to 0 once aligned up in 16 bits
+    EXPECT_EQ(page.addTuple(big.data(), 65535), -1);
+    EXPECT_EQ(page.allocTuple(65529, &out), -1);
+    EXPECT_EQ(page.addTuple(big.data(), static_cast<uint16_t>(PAGE_MAX_TUPLE_SIZE + 1)), -1);
+    EXPECT_EQ(page.getSlotCount(), 0);
+    EXPECT_EQ(page.getFreeSpace(), PAGE_MAX_TUPLE_SIZE / 8 * 8);
+
+    // encoded rows over 64 KB do not get a narrowed slot
+    std::vector<allVars> row{std::string(70000, 'x'), int32_t(1)};
+    std::vector<bool> bitmap{true, true};
+    EXPECT_EQ(page.addRow(row, bitmap), -1);
+    TupleCodec codec({TUPLE_TYPE_STRING, TUPLE_TYPE_INT32}, {0, 0});
+    EXPECT_EQ(page.addRow(codec, row, bitmap), -1);
+    EXPECT_EQ(page.getSlotCount(), 0);
+    EXPECT_TRUE(page.isValid());
+
+    // the largest tuple still fits an empty page
+    std::vector<uint8_t> largest(PAGE_MAX_TUPLE_SIZE / 8 * 8, 0xcd);
+    EXPECT_EQ(page.addTuple(largest.data(), static_cast<uint16_t>(largest.size())), 0);
+    EXPECT_EQ(page.getFreeSpace(), 0);
+}
+
+TEST_F(SlottedPageTest, SpecialAreaIsLeftAlone) {
+    SlottedPage::init(frame, 1, 0, 64);
+    SlottedPage page(frame);
+    EXPECT_EQ(page.getSpecialSize(), 64);
+    std::memset(page.getSpecial(), 0xee, 64);
+    while (page.addTuple("filler-tuple", 12) >= 0) {
+    }
+    for (int32_t i = 0; i < 64; ++i) {
+        EXPECT_EQ(page.getSpecial()[i], 0xee);
+    }
+}
+
+TEST(SlottedPageFileTest, FrameIsWrittenAndLoadedWithoutMarshalling) {
+    std::string path = tempTestPath("slotted", ".dat");
+    std::filesystem::remove(path);
+    FramePool pool(2);
+    std::unique_ptr<AsyncPageIo> io = makeAsyncPageIo(4);
+    std::vector<uint8_t> types{TUPLE_TYPE_INT64, TUPLE_TYPE_STRING};
+    {
+        PageFile file;
+        ASSERT_TRUE(file.open(path, true));
+        uint8_t* frame = pool.acquire();
+        SlottedPage::init(frame, 42, 0);
+        SlottedPage page(frame);
+        for (int64_t i = 0; i < 100; ++i) {
+            ASSERT_EQ(page.addRow({allVars(i), allVars(std::string("row") + std::to_string(i))}, {true, true}), i);
+        }
+        page.setLsn(777);
+        std::vector<int32_t> results;
+        ASSERT_EQ(file.writePages(*io, {{0, frame}}, results), 0);
+        pool.release(frame);
+    }
+    PageFile file;
+    ASSERT_TRUE(file.open(path, true));
+    uint8_t* frame = pool.acquire();
+    std::vector<int32_t> results;
+    ASSERT_EQ(file.readPages(*io, {{0, frame}}, results), 0);
+    SlottedPage page(frame);
+    ASSERT_TRUE(page.isValid());
+    EXPECT_EQ(page.getLsn(), 777u);
+    EXPECT_EQ(page.getSlotCount(), 100);
+    uint16_t length;
+    const uint8_t* t = page.getTuple(57, &length);
+    std::vector<allVars> row;
+    std::vector<bool> bitmap;
+    ASSERT_TRUE(decodeTuple(t, length, types, row, bitmap));
+    EXPECT_EQ(std::get<int64_t>(row[0]), 57);
+    EXPECT_EQ(std::get<std::string>(row[1]), "row57");
+    std::filesystem::remove(path);
+}
@@ -343,6 +343,317 @@ TEST(SysThreadPoolTests, EvictionPrefersCleanOverDirtyWhenSameCount) {
     clearFolder(testFolderPath);
 }
 
+TEST(SysThreadPoolTests, TwoQPolicyKeepsHotBuffersDuringScan) {
+    CoutSilencer silence;
+    ForceResizeBuffers(8);
+    std::filesystem::create_directories(testFolderPath);
+    setTablesPath(testFolderPath);
+    clearFolder(testFolderPath);
+
+    // hot buffers resident before the pool starts
+    for(int i = 0; i < 4; ++i) {
+        ShareBuffer* buf = new ShareBuffer();
+        buf->tableId = 1100 + i;
+        buf->blockNum = 0;
+        buf->count = 5;
+        buf->isDirty = false;
+        (*buffers)[i] = buf;
+    }
+
+    SysThreadPool<std::vector<ShareBuffer*>, ShareBuffer*> pool(buffers, EvictionPolicyKind::TWO_Q);
+    pool.start(buffers);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    // scan of 40 blocks touched once each
+    for(int i = 0; i < 40; ++i) {
+        ShareBuffer* buf = new ShareBuffer();
+        buf->tableId = 1200;
+        buf->blockNum = i;
+        buf->count = 1;
+        buf->isDirty = false;
+        pool.cacheHint(buf);
+    }
+
+    for(int i = 0; i < 4; ++i) {
+        bool found = false;
+        for(auto b : *buffers) {
+            if(b && b->tableId == 1100 + i) found = true;
+        }
+        EXPECT_TRUE(found);
+    }
+
+    pool.stop();
+    ForceResizeBuffers(8);
+    clearFolder(testFolderPath);
+}
+
+// ============================================================================
+// BACKGROUND WRITER TESTS
+// ============================================================================
+
+TEST(SysThreadPoolTests, BgWriterCleansDirtyBuffersBeforeEviction) {
+    CoutSilencer silence;
+    ForceResizeBuffers(4);
+    std::filesystem::create_directories(testFolderPath);
+    setTablesPath(testFolderPath);
+    clearFolder(testFolderPath);
+
+    for(int i = 0; i < 4; ++i) {
+        createBinFile(testFolderPath, std::to_string(1300 + i));
+        ShareBuffer* buf = new ShareBuffer();
+        buf->tableId = 1300 + i;
+        buf->blockNum = 0;
+        buf->count = 0;
+        buf->isDirty = true;
+        tableHeader* h = new tableHeader();
+        h->setData(1300+i,0,0,0,1,0,0,0,0,4096,{4},{1},{"x"});
+        buf->tableHeaderPtr = h;
+        (*buffers)[i] = buf;
+    }
+
+    SysThreadPool<std::vector<ShareBuffer*>, ShareBuffer*> pool(buffers);
+    pool.enableBgWriter(10, 100);
+    pool.start(buffers);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    EXPECT_EQ(pool.getBgWriterPagesWritten(), 4);
+    for(auto b : *buffers) {
+        EXPECT_FALSE(b->isDirty);
+    }
+    EXPECT_GT(getFileSize(testFolderPath, "1300.bin"), 0);
+
+    ShareBuffer* newBuf = new ShareBuffer();
+    newBuf->tableId = 999;
+    newBuf->blockNum = 0;
+    newBuf->count = 1;
+    newBuf->isDirty = false;
+    pool.cacheHint(newBuf);
+
+    // victim was already clean, eviction did no I/O
+    EXPECT_EQ(pool.getEvictionPagesWritten(), 0);
+
+    pool.stop();
+    ForceResizeBuffers(4);
+    clearFolder(testFolderPath);
+}
+
+TEST(SysThreadPoolTests, BgWriterRoundRespectsBatchSize) {
+    CoutSilencer silence;
+    ForceResizeBuffers(6);
+    std::filesystem::create_directories(testFolderPath);
+    setTablesPath(testFolderPath);
+    clearFolder(testFolderPath);
+
+    for(int i = 0; i < 6; ++i) {
+        createBinFile(testFolderPath, std::to_string(1400 + i));
+        ShareBuffer* buf = new ShareBuffer();
+        buf->tableId = 1400 + i;
+        buf->blockNum = 0;
+        buf->count = (i == 5) ? 5 : 0; // hot buffer is left for later rounds
+        buf->isDirty = true;
+        tableHeader* h = new tableHeader();
+        h->setData(1400+i,0,0,0,1,0,0,0,0,4096,{4},{1},{"x"});
+        buf->tableHeaderPtr = h;
+        (*buffers)[i] = buf;
+    }
+
+    SysThreadPool<std::vector<ShareBuffer*>, ShareBuffer*> pool(buffers);
+
+    EXPECT_EQ(pool.cleanAheadOfSweep(2), 2);
+    EXPECT_EQ(pool.cleanAheadOfSweep(10), 3);
+    EXPECT_EQ(pool.cleanAheadOfSweep(10), 0);
+    EXPECT_TRUE((*buffers)[5]->isDirty);
+
+    ForceResizeBuffers(6);
+    clearFolder(testFolderPath);
+}
+
+TEST(SysThreadPoolTests, BgWriterWaitsForASessionChangingThePage) {
+    CoutSilencer silence;
+    ForceResizeBuffers(1);
+    std::filesystem::create_directories(testFolderPath);
+    setTablesPath(testFolderPath);
+    clearFolder(testFolderPath);
+    createBinFile(testFolderPath, "1450");
+    ShareBuffer* buf = new ShareBuffer();
+    buf->tableId = 1450;
+    buf->blockNum = 0;
+    buf->count = 0;
+    buf->isDirty = true;
+    (*buffers)[0] = buf;
+
+    SysThreadPool<std::vector<ShareBuffer*>, ShareBuffer*> pool(buffers);
+    // a session holds the page exclusive while it changes it
+    sharedBufferDescs.lockContent(0, true);
+    std::atomic<int32_t> written{-1};
+    std::thread writer([&pool, &written]() { written = pool.cleanAheadOfSweep(10); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ(written.load(), -1);
+    EXPECT_TRUE(bufferIsDirty(buf));
+    sharedBufferDescs.unlockContent(0);
+    writer.join();
+    EXPECT_EQ(written.load(), 1);
+    EXPECT_FALSE(bufferIsDirty(buf));
+
+    // a change after the flag was taken dirties the page again, the next round writes it
+    setBufferDirty(buf, true);
+    EXPECT_EQ(pool.cleanAheadOfSweep(10), 1);
+    EXPECT_FALSE(bufferIsDirty(buf));
+
+    ForceResizeBuffers(1);
+    clearFolder(testFolderPath);
+}
+
+// ============================================================================
+// FREE SLOT RESERVE TESTS
+// ============================================================================
+
+TEST(SysThreadPoolTests, WatermarksEvictInBatches) {
+    CoutSilencer silence;
+    ForceResizeBuffers(10);
+    std::filesystem::create_directories(testFolderPath);
+    setTablesPath(testFolderPath);
+    clearFolder(testFolderPath);
+
+    for(int i = 0; i < 10; ++i) {
+        ShareBuffer* buf = new ShareBuffer();
+        buf->tableId = 1500 + i;
+        buf->blockNum = 0;
+        buf->count = 0;
+        buf->isDirty = false;
+        (*buffers)[i] = buf;
+    }
+
+    SysThreadPool<std::vector<ShareBuffer*>, ShareBuffer*> pool(buffers);
+    pool.setFreeSlotWatermarks(2, 4);
+    pool.start(buffers);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    // first request finds an empty reserve and waits for one batch of 4
+    ShareBuffer* first = new ShareBuffer();
+    first->tableId = 1600;
+    first->blockNum = 0;
+    first->count = 1;
+    pool.cacheHint(first);
+    EXPECT_EQ(pool.getSlotWaits(), 1);
+    EXPECT_EQ(pool.getFreeSlotCount(), 3);
+
+    // following requests are served from the reserve, refill happens in the background
+    for(int i = 1; i < 12; ++i) {
+        ShareBuffer* buf = new ShareBuffer();
+        buf->tableId = 1600 + i;
+        buf->blockNum = 0;
+        buf->count = 1;
+        pool.cacheHint(buf);
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    EXPECT_LE(pool.getSlotWaits(), 2);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_GE(pool.getFreeSlotCount(), 2);
+    EXPECT_LE(pool.getFreeSlotCount(), 4);
+
+    int count = 0;
+    for(auto b : *buffers) {
+        if(b != nullptr) count++;
+    }
+    EXPECT_EQ(count + pool.getFreeSlotCount(), 10);
+
+    pool.stop();
+    ForceResizeBuffers(10);
+    clearFolder(testFolderPath);
+}
+
+TEST(SysThreadPoolTests, FreeSlotCountWithOversizedWatermarks) {
+    CoutSilencer silence;
+    ForceResizeBuffers(3);
+
+    SysThreadPool<std::vector<ShareBuffer*>, ShareBuffer*> pool(buffers);
+    pool.setFreeSlotWatermarks(10, 20);
+
+    EXPECT_EQ(pool.getFreeSlotCount(), 3);
+}
+
+TEST(SysThreadPoolTests, MappingTableFollowsLoadAndEviction) {
+    CoutSilencer silence;
+    ForceResizeBuffers(2);
+    sharedBufferMapping.clear();
+    std::filesystem::create_directories(testFolderPath);
+    setTablesPath(testFolderPath);
+    clearFolder(testFolderPath);
+
+    SysThreadPool<std::vector<ShareBuffer*>, ShareBuffer*> pool(buffers);
+    pool.start(buffers);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    for(int i = 0; i < 3; ++i) {
+        ShareBuffer* buf = new ShareBuffer();
+        buf->tableId = 1700;
+        buf->blockNum = i;
+        buf->count = 0;
+        buf->isDirty = false;
+        pool.cacheHint(buf);
+    }
+
+    // block 0 was evicted for block 2
+    EXPECT_EQ(lookupSharedBuffer(1700, 0), nullptr);
+    ASSERT_NE(lookupSharedBuffer(1700, 1), nullptr);
+    ASSERT_NE(lookupSharedBuffer(1700, 2), nullptr);
+    EXPECT_EQ(lookupSharedBuffer(1700, 2)->blockNum, 2);
+    EXPECT_EQ(lookupTableBuffers(1700).size(), 2u);
+
+    pool.stop();
+    ForceResizeBuffers(2);
+    sharedBufferMapping.clear();
+    clearFolder(testFolderPath);
+}
+
+TEST(SysThreadPoolTests, PinnedBufferIsNeverEvicted) {
+    CoutSilencer silence;
+    ForceResizeBuffers(2);
+    sharedBufferMapping.clear();
+    std::filesystem::create_directories(testFolderPath);
+    setTablesPath(testFolderPath);
+    clearFolder(testFolderPath);
+
+    for(int i = 0; i < 2; ++i) {
+        ShareBuffer* buf = new ShareBuffer();
+        buf->tableId = 1800 + i;
+        buf->blockNum = 0;
+        buf->count = 0;
+        buf->isDirty = false;
+        (*buffers)[i] = buf;
+    }
+
+    SysThreadPool<std::vector<ShareBuffer*>, ShareBuffer*> pool(buffers);
+    pool.start(buffers);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ(pool.getFreeSlotCount(), 0); // registers residents in the mapping table
+
+    PinnedBuffer pinned = pinSharedBuffer(1800, 0);
+    ASSERT_NE(pinned.buffer, nullptr);
+
+    for(int i = 0; i < 5; ++i) {
+        ShareBuffer* buf = new ShareBuffer();
+        buf->tableId = 1900 + i;
+        buf->blockNum = 0;
+        buf->count = 0;
+        buf->isDirty = false;
+        pool.cacheHint(buf);
+    }
+
+    bool pinnedPresent = false;
+    for(auto b : *buffers) {
+        if(b && b->tableId == 1800) pinnedPresent = true;
+    }
+    EXPECT_TRUE(pinnedPresent);
+    unpinSharedBuffer(pinned);
+
+    pool.stop();
+    ForceResizeBuffers(2);
+    sharedBufferMapping.clear();
+    clearFolder(testFolderPath);
+}
+
 // ============================================================================
 // STRESS TESTS
 // ============================================================================
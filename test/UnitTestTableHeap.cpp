@@ -0,0 +1,279 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../src/btreeIndex.h"
+#include "../src/hashIndex.h"
+#include "../src/tableHeap.h"
+#include "../src/threadPoolRole.h"
+#include "../src/walGroupCommit.h"
+#include "../../bufforing-stm/src/buserCache.h"
+#include "testHelpers.h"
+
+// ==================== TESTY TABLE HEAP ====================
+
+class TableHeapTest : public TempFileTest<> {
+protected:
+    TupleCodec codec{{TUPLE_TYPE_INT64, TUPLE_TYPE_STRING}, {0, 1}};
+    TableHeapTest() : TempFileTest("heap", ".tab") {}
+    void TearDown() override {
+        sharedTableHeaps.clear();
+        sharedHashIndexes.clear();
+        sharedBTreeIndexes.clear();
+    }
+    static std::vector<allVars> row(int64_t i) {
+        return {i, std::string("row-") + std::to_string(i)};
+    }
+};
+
+TEST_F(TableHeapTest, BatchFillsEachPageBeforeTheNext) {
+    TableHeap heap(5);
+    ASSERT_TRUE(heap.open(filePath));
+    const int32_t N = 3000;
+    std::vector<std::vector<allVars>> rows;
+    std::vector<std::vector<bool>> bitmaps;
+    for (int32_t i = 0; i < N; ++i) {
+        rows.push_back(row(i));
+        bitmaps.push_back({true, i % 5 != 0});
+    }
+    std::vector<Ctid> ctids;
+    ASSERT_EQ(heap.insertRows(codec, rows, bitmaps, 0, ctids), static_cast<size_t>(N));
+    ASSERT_EQ(ctids.size(), static_cast<size_t>(N));
+    EXPECT_GT(heap.getBlockCount(), 1);
+    // slots run 0, 1, 2... within a page, a page is only left once it is full
+    for (int32_t i = 1; i < N; ++i) {
+        if (ctids[i].blockNum == ctids[i - 1].blockNum) {
+            EXPECT_EQ(ctids[i].slot, ctids[i - 1].slot + 1);
+        } else {
+            EXPECT_EQ(ctids[i].blockNum, ctids[i - 1].blockNum + 1);
+            EXPECT_EQ(ctids[i].slot, 0);
+        }
+    }
+    for (int32_t i = 0; i < N; i += 37) {
+        std::vector<allVars> got;
+        std::vector<bool> bitmap;
+        ASSERT_TRUE(heap.readRow(codec, ctids[i], got, bitmap));
+        EXPECT_EQ(std::get<int64_t>(got[0]), i);
+        EXPECT_EQ(bitmap[1], i % 5 != 0);
+    }
+
+    // a row that does not match the schema stops the batch
+    std::vector<std::vector<allVars>> bad{row(1), {int32_t(1), std::string("x")}, row(2)};
+    std::vector<std::vector<bool>> badBitmaps(3, {true, true});
+    ctids.clear();
+    EXPECT_EQ(heap.insertRows(codec, bad, badBitmaps, 0, ctids), 1u);
+}
+
+TEST_F(TableHeapTest, DeleteFreesTheSlotAndPagesSurviveReopen) {
+    Ctid first;
+    Ctid second;
+    {
+        TableHeap heap(5);
+        ASSERT_TRUE(heap.open(filePath));
+        ASSERT_TRUE(heap.insertRow(codec, row(1), {true, true}, 0, first));
+        ASSERT_TRUE(heap.insertRow(codec, row(2), {true, true}, 0, second));
+        EXPECT_TRUE(heap.deleteRow(codec, first));
+        EXPECT_FALSE(heap.deleteRow(codec, first));
+        std::vector<allVars> got;
+        std::vector<bool> bitmap;
+        EXPECT_FALSE(heap.readRow(codec, first, got, bitmap));
+        ASSERT_TRUE(heap.flush());
+    }
+    TableHeap heap(5);
+    ASSERT_TRUE(heap.open(filePath));
+    EXPECT_EQ(heap.getBlockCount(), 1);
+    std::vector<allVars> got;
+    std::vector<bool> bitmap;
+    ASSERT_TRUE(heap.readRow(codec, second, got, bitmap));
+    EXPECT_EQ(std::get<std::string>(got[1]), "row-2");
+    // the tail page is found again and its free slot reused
+    Ctid third;
+    ASSERT_TRUE(heap.insertRow(codec, row(3), {true, true}, 0, third));
+    EXPECT_EQ(third, first);
+}
+
+TEST_F(TableHeapTest, SessionInsertsIntoAttachedHeap) {
+    SessionScheduler scheduler(2);
+    addUserToCache(new buser(getNextUserId(), "heapUser", "pass", "test@email.com", false));
+    std::shared_ptr<TableHeap> heap = std::make_shared<TableHeap>(77);
+    ASSERT_TRUE(heap->open(filePath));
+    sharedTableHeaps.attach(heap);
+    sharedTupleCodecs.define(77, {TUPLE_TYPE_INT64, TUPLE_TYPE_STRING}, {0, 1});
+    std::string indexPath = filePath + ".idx";
+    std::filesystem::remove(indexPath);
+    std::shared_ptr<HashIndex> index = std::make_shared<HashIndex>(1);
+    ASSERT_TRUE(index->open(indexPath));
+    sharedHashIndexes.attach(77, 0, index);
+    std::string btreePath = filePath + ".btr";
+    std::filesystem::remove(btreePath);
+    std::shared_ptr<BTreeIndex> btree = std::make_shared<BTreeIndex>(2);
+    ASSERT_TRUE(btree->open(btreePath));
+    sharedBTreeIndexes.attach(77, 0, btree);
+
+    Session session(60, 1, &scheduler);
+    session.setWal(nullptr);
+    session.start("heapUser", "pass", "");
+    std::unique_ptr<tuplesAdd> batch(new tuplesAdd());
+    batch->tableId = 77;
+    for (int32_t i = 0; i < 500; ++i) {
+        batch->rows.push_back(row(i));
+        batch->bitmaps.push_back({true, true});
+    }
+    EXPECT_EQ(session.addTuples(std::move(batch)).wait(), TaskStatus::DONE);
+    EXPECT_EQ(session.addTuple("", 77, row(500), {true, false}).wait(), TaskStatus::DONE);
+    // a row the codec rejects fails the task instead of going elsewhere
+    EXPECT_EQ(session.addTuple("", 77, {std::string("x")}, {true}).wait(), TaskStatus::FAILED);
+    session.stop();
+
+    std::vector<allVars> got;
+    std::vector<bool> bitmap;
+    Ctid ctid;
+    ctid.blockNum = 0;
+    ctid.slot = 0;
+    ASSERT_TRUE(heap->readRow(codec, ctid, got, bitmap));
+    EXPECT_EQ(std::get<int64_t>(got[0]), 0);
+    // session inserts keep the table's indexes in step, deletes take the key out
+    EXPECT_EQ(index->getEntryCount(), 501);
+    std::vector<Ctid> found = index->lookup(500);
+    ASSERT_EQ(found.size(), 1u);
+    EXPECT_EQ(btree->lookup(500), found);
+    BTreeIterator it = btree->range(0, 499);
+    BTreeKey entry;
+    int32_t inRange = 0;
+    while (it.next(entry)) {
+        inRange++;
+    }
+    EXPECT_EQ(inRange, 500);
+    ASSERT_TRUE(heap->deleteRow(codec, found[0]));
+    EXPECT_TRUE(index->lookup(500).empty());
+    EXPECT_TRUE(btree->lookup(500).empty());
+    sharedTupleCodecs.erase(77);
+    sharedHashIndexes.clear();
+    sharedBTreeIndexes.clear();
+    index->close();
+    btree->close();
+    std::filesystem::remove(indexPath);
+    std::filesystem::remove(btreePath);
+}
+
+TEST_F(TableHeapTest, NewTableGetsItsCodecAndHeap) {
+    std::string dir = filePath + ".d";
+    std::filesystem::remove_all(dir);
+    ASSERT_TRUE(std::filesystem::create_directories(dir));
+    sharedTableHeaps.setDirectory(dir);
+    SessionScheduler scheduler(2);
+    addUserToCache(new buser(getNextUserId(), "heapTableUser", "pass", "test@email.com", false));
+    Session session(60, 1, &scheduler);
+    session.setWal(nullptr);
+    session.start("heapTableUser", "pass", "");
+    tableHeaderAdd* table = new tableHeaderAdd();
+    table->tableHeaderData = new tableHeader();
+    table->tableId = 79;
+    table->types = {TUPLE_TYPE_INT64, TUPLE_TYPE_STRING};
+    table->typesWithAllowNull = {0, 1};
+    table->columnNames = {"id", "name"};
+    EXPECT_EQ(session.addTable(table).wait(), TaskStatus::DONE);
+    EXPECT_NE(sharedTupleCodecs.get(79), nullptr);
+    std::shared_ptr<TableHeap> heap = sharedTableHeaps.get(79);
+    ASSERT_NE(heap, nullptr);
+    // the table's rows go to its heap right away
+    EXPECT_EQ(session.addTuple("", 79, row(3), {true, true}).wait(), TaskStatus::DONE);
+    session.stop();
+
+    std::vector<allVars> got;
+    std::vector<bool> bitmap;
+    Ctid ctid;
+    ctid.blockNum = 0;
+    ctid.slot = 0;
+    ASSERT_TRUE(heap->readRow(codec, ctid, got, bitmap));
+    EXPECT_EQ(std::get<int64_t>(got[0]), 3);
+    sharedTableHeaps.setDirectory("");
+    sharedTupleCodecs.erase(79);
+    heap->close();
+    std::filesystem::remove_all(dir);
+}
+
+TEST_F(TableHeapTest, FailedWalCommitTakesTheRowsOutAndStopsTheSession) {
+    WalGroupCommit wal;
+    ASSERT_TRUE(wal.open("/dev/full"));   // every write fails with ENOSPC
+    SessionScheduler scheduler(2);
+    addUserToCache(new buser(getNextUserId(), "heapFullUser", "pass", "test@email.com", false));
+    std::shared_ptr<TableHeap> heap = std::make_shared<TableHeap>(80);
+    ASSERT_TRUE(heap->open(filePath));
+    sharedTableHeaps.attach(heap);
+    sharedTupleCodecs.define(80, {TUPLE_TYPE_INT64, TUPLE_TYPE_STRING}, {0, 1});
+
+    Session session(60, 1, &scheduler);
+    session.setWal(&wal);
+    session.start("heapFullUser", "pass", "");
+    EXPECT_EQ(session.addTuple("", 80, row(1), {true, true}).wait(), TaskStatus::FAILED);
+    std::vector<allVars> got;
+    std::vector<bool> bitmap;
+    Ctid ctid;
+    ctid.blockNum = 0;
+    ctid.slot = 0;
+    EXPECT_FALSE(heap->readRow(codec, ctid, got, bitmap));
+    // the log is broken, the session takes nothing more
+    EXPECT_FALSE(session.addTuple("", 80, row(2), {true, true}).valid());
+    session.stop();
+    sharedTupleCodecs.erase(80);
+    wal.close();
+}
+
+TEST_F(TableHeapTest, SessionLogsBeforeTheChangeAndStampsThePage) {
+    std::string walPath = filePath + ".wal";
+    std::filesystem::remove(walPath);
+    WalGroupCommit wal;
+    ASSERT_TRUE(wal.open(walPath));
+    SessionScheduler scheduler(2);
+    addUserToCache(new buser(getNextUserId(), "heapWalUser", "pass", "test@email.com", false));
+    std::shared_ptr<TableHeap> heap = std::make_shared<TableHeap>(78);
+    heap->setWal(&wal);
+    ASSERT_TRUE(heap->open(filePath));
+    sharedTableHeaps.attach(heap);
+    sharedTupleCodecs.define(78, {TUPLE_TYPE_INT64, TUPLE_TYPE_STRING}, {0, 1});
+
+    Session session(60, 9, &scheduler);
+    session.setWal(&wal);
+    session.start("heapWalUser", "pass", "");
+    EXPECT_EQ(session.addTuple("", 78, row(1), {true, true}).wait(), TaskStatus::DONE);
+    EXPECT_EQ(session.addTuple("", 78, {std::string("x")}, {true}).wait(), TaskStatus::FAILED);
+    session.stop();
+    ASSERT_TRUE(heap->flush());
+    wal.close();
+
+    // [uint32 length][kind ...], the LSN of a record is the offset after it
+    std::ifstream in(walPath, std::ios::binary);
+    std::vector<uint8_t> log((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::vector<std::pair<uint64_t, uint8_t>> records;
+    std::vector<uint64_t> aborted;
+    for (size_t at = 0; at + sizeof(uint32_t) < log.size();) {
+        uint32_t length = 0;
+        memcpy(&length, log.data() + at, sizeof(length));
+        const uint8_t* payload = log.data() + at + sizeof(uint32_t);
+        at += sizeof(uint32_t) + length;
+        records.push_back({at, payload[0]});
+        if (payload[0] == static_cast<uint8_t>(WalRecordKind::ABORT)) {
+            uint64_t lsn = 0;
+            memcpy(&lsn, payload + 1 + sizeof(int64_t) + sizeof(int32_t), sizeof(lsn));
+            aborted.push_back(lsn);
+        }
+    }
+    ASSERT_EQ(records.size(), 3u);
+    EXPECT_EQ(records[0].second, static_cast<uint8_t>(WalRecordKind::TUPLE_ENCODED));
+    EXPECT_EQ(records[1].second, static_cast<uint8_t>(WalRecordKind::TUPLE));
+    EXPECT_EQ(records[2].second, static_cast<uint8_t>(WalRecordKind::ABORT));
+    EXPECT_EQ(aborted, std::vector<uint64_t>{records[1].first});
+
+    // the page carries the LSN of the insert that changed it
+    alignas(PAGE_TUPLE_ALIGN) static uint8_t page[PAGE_FILE_BLOCK_SIZE];
+    std::ifstream pages(filePath, std::ios::binary);
+    ASSERT_TRUE(pages.read(reinterpret_cast<char*>(page), PAGE_FILE_BLOCK_SIZE));
+    EXPECT_EQ(SlottedPage(page).getLsn(), records[0].first);
+    sharedTupleCodecs.erase(78);
+    std::filesystem::remove(walPath);
+}
@@ -0,0 +1,142 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "../src/bufferDesc.h"
+#include "../src/pageFile.h"
+#include "../src/tableScan.h"
+#include "testHelpers.h"
+
+// ==================== TESTY TABLE SCAN ====================
+
+class TableScanTest : public TempFileTest<::testing::TestWithParam<PageIoBackend>> {
+protected:
+    PageFile file;
+    SyncPageIo io{8};
+
+    TableScanTest() : TempFileTest("scan", ".dat") {}
+    void SetUp() override {
+        if (!makeAsyncPageIo(4, GetParam())) {
+            GTEST_SKIP() << "io_uring not available";
+        }
+        ASSERT_TRUE(file.open(filePath));
+    }
+    void TearDown() override {
+        file.close();
+    }
+
+    // every block starts with its number, the rest is a pattern of it
+    void writeBlocks(int32_t count) {
+        writeTestBlocks(file, 0, count, fillBlock);
+    }
+    static void fillBlock(uint8_t* page, int32_t blockNum) {
+        std::memset(page, blockNum * 7 + 1, PAGE_FILE_BLOCK_SIZE);
+        std::memcpy(page, &blockNum, sizeof(blockNum));
+    }
+    static bool blockIs(const uint8_t* page, int32_t blockNum) {
+        std::vector<uint8_t> expected(PAGE_FILE_BLOCK_SIZE);
+        fillBlock(expected.data(), blockNum);
+        return std::memcmp(page, expected.data(), PAGE_FILE_BLOCK_SIZE) == 0;
+    }
+    TableScanOptions options(int32_t ringFrames, int32_t readAhead) {
+        TableScanOptions o;
+        o.ringFrames = ringFrames;
+        o.readAhead = readAhead;
+        o.backend = GetParam();
+        return o;
+    }
+};
+
+TEST_P(TableScanTest, ReadsEveryBlockInOrderThroughASmallRing) {
+    writeBlocks(100);
+    TableScan scan(file, 1, options(4, 4));
+    ASSERT_TRUE(scan.isReady());
+    EXPECT_EQ(scan.getEndBlock(), 100);
+    ScanPage page;
+    int32_t expected = 0;
+    while (scan.next(page)) {
+        ASSERT_EQ(page.blockNum, expected);
+        ASSERT_NE(page.data, nullptr);
+        // the read-ahead of the next blocks must not touch the page being read
+        EXPECT_TRUE(blockIs(page.data, expected)) << "block " << expected;
+        expected++;
+    }
+    EXPECT_EQ(expected, 100);
+    EXPECT_FALSE(scan.failed());
+    EXPECT_EQ(scan.getBlocksRead(), 100);
+    EXPECT_FALSE(scan.next(page));
+}
+
+TEST_P(TableScanTest, ScansARangeAndZerosPastTheEnd) {
+    writeBlocks(10);
+    TableScanOptions o = options(8, 3);
+    o.firstBlock = 6;
+    o.endBlock = 12;
+    TableScan scan(file, 1, o);
+    ScanPage page;
+    std::vector<int32_t> seen;
+    while (scan.next(page)) {
+        seen.push_back(page.blockNum);
+        if (page.blockNum < 10) {
+            EXPECT_TRUE(blockIs(page.data, page.blockNum));
+        } else {
+            EXPECT_EQ(std::vector<uint8_t>(page.data, page.data + PAGE_FILE_BLOCK_SIZE), std::vector<uint8_t>(PAGE_FILE_BLOCK_SIZE, 0));
+        }
+    }
+    EXPECT_EQ(seen, (std::vector<int32_t>{6, 7, 8, 9, 10, 11}));
+}
+
+TEST_P(TableScanTest, EmptyTableEndsAtOnce) {
+    TableScan scan(file, 1, options(4, 2));
+    ScanPage page;
+    EXPECT_FALSE(scan.next(page));
+    EXPECT_FALSE(scan.failed());
+}
+
+TEST_P(TableScanTest, StopsEarlyWithReadsInFlight) {
+    writeBlocks(50);
+    {
+        TableScan scan(file, 1, options(16, 16));
+        ScanPage page;
+        ASSERT_TRUE(scan.next(page));
+        EXPECT_TRUE(blockIs(page.data, 0));
+    }
+    // the destructor waited for the reads, the file can be scanned again
+    TableScan again(file, 1, options(16, 16));
+    ScanPage page;
+    ASSERT_TRUE(again.next(page));
+    EXPECT_EQ(page.blockNum, 0);
+}
+
+TEST_P(TableScanTest, DirtySharedBufferIsReturnedPinned) {
+    writeBlocks(3);
+    std::vector<ShareBuffer*>* saved = buffers;
+    std::vector<ShareBuffer*> cache(1, nullptr);
+    ShareBuffer dirty;
+    dirty.tableId = 2700;
+    dirty.blockNum = 1;
+    dirty.isDirty = true;
+    cache[0] = &dirty;
+    buffers = &cache;
+    sharedBufferMapping.insert(2700, 1, 0);
+
+    TableScan scan(file, 2700, options(4, 2));
+    ScanPage page;
+    ASSERT_TRUE(scan.next(page));
+    EXPECT_NE(page.data, nullptr);
+    ASSERT_TRUE(scan.next(page));
+    EXPECT_EQ(page.blockNum, 1);
+    EXPECT_EQ(page.data, nullptr);
+    EXPECT_EQ(page.buffer.buffer, &dirty);
+    EXPECT_TRUE(sharedBufferDescs.isPinned(0));
+    ASSERT_TRUE(scan.next(page));
+    EXPECT_FALSE(sharedBufferDescs.isPinned(0));
+    EXPECT_TRUE(blockIs(page.data, 2));
+    EXPECT_EQ(scan.getBlocksFromShared(), 1);
+
+    sharedBufferMapping.clear();
+    buffers = saved;
+}
+
+INSTANTIATE_TEST_SUITE_P(Backends, TableScanTest,
+                         ::testing::Values(PageIoBackend::SYNC, PageIoBackend::IO_URING));
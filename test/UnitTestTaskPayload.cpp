@@ -0,0 +1,242 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+#include "../src/threadPoolRole.h"
+#include "../../bufforing-stm/src/buserCache.h"
+
+// ==================== TESTY TASK PAYLOAD ====================
+
+// Counts heap allocations made by the current thread while counting is on,
+// and allocations of the size of a row buffer made by any thread while those
+// are watched (the worker running a session is not the test thread).
+// Replacing the global operator new affects the whole test binary, so the
+// whole set of new/delete overloads is replaced together; they only count
+// and otherwise behave like the default ones.
+static thread_local bool countingAllocations = false;
+static thread_local int64_t allocationCount = 0;
+static std::atomic<size_t> watchedSizes[2] = {{0}, {0}};
+static std::atomic<int64_t> watchedAllocations{0};
+
+static void* countedAlloc(size_t size, size_t alignment) {
+    if (countingAllocations) {
+        allocationCount++;
+    }
+    if (size != 0 && (size == watchedSizes[0].load(std::memory_order_relaxed) ||
+                      size == watchedSizes[1].load(std::memory_order_relaxed))) {
+        watchedAllocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (size == 0) {
+        size = 1;
+    }
+    if (alignment <= alignof(std::max_align_t)) {
+        return std::malloc(size);
+    }
+    return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+}
+
+static void* countedNew(size_t size, size_t alignment) {
+    void* p = countedAlloc(size, alignment);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new(size_t size) { return countedNew(size, 0); }
+void* operator new[](size_t size) { return countedNew(size, 0); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size, 0); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size, 0); }
+void* operator new(size_t size, std::align_val_t al) { return countedNew(size, static_cast<size_t>(al)); }
+void* operator new[](size_t size, std::align_val_t al) { return countedNew(size, static_cast<size_t>(al)); }
+void* operator new(size_t size, std::align_val_t al, const std::nothrow_t&) noexcept { return countedAlloc(size, static_cast<size_t>(al)); }
+void* operator new[](size_t size, std::align_val_t al, const std::nothrow_t&) noexcept { return countedAlloc(size, static_cast<size_t>(al)); }
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
+
+class AllocationCounter {
+    public:
+        AllocationCounter() { allocationCount = 0; countingAllocations = true; }
+        ~AllocationCounter() { countingAllocations = false; }
+        int64_t count() const { return allocationCount; }
+};
+
+constexpr int32_t ROW_COLUMNS = 32;
+constexpr size_t ROW_STRING_BYTES = 100;   // off the SSO buffer, an allocation of its own
+
+// counts copies of row buffers made by makeRow(ROW_COLUMNS): the value array and its strings
+class RowBufferWatch {
+    public:
+        RowBufferWatch() {
+            watchedAllocations = 0;
+            watchedSizes[0] = ROW_COLUMNS * sizeof(allVars);
+            watchedSizes[1] = ROW_STRING_BYTES + 1;
+        }
+        ~RowBufferWatch() { watchedSizes[0] = 0; watchedSizes[1] = 0; }
+        int64_t count() const { return watchedAllocations.load(); }
+};
+
+static std::vector<allVars> makeRow(int32_t columns) {
+    std::vector<allVars> row;
+    row.reserve(columns);
+    for (int32_t c = 0; c < columns; ++c) {
+        if (c % 2 == 0) {
+            row.push_back(std::string(ROW_STRING_BYTES, static_cast<char>('a' + c % 26)));
+        } else {
+            row.push_back(static_cast<int64_t>(c));
+        }
+    }
+    return row;
+}
+
+TEST(TaskPayloadTest, TaskIsMoveOnly) {
+    EXPECT_FALSE(std::is_copy_constructible<Task>::value);
+    EXPECT_TRUE(std::is_move_constructible<Task>::value);
+}
+
+TEST(TaskPayloadTest, RingMovesPayloadWithoutAllocating) {
+    MpscRing<std::unique_ptr<std::vector<int>>> ring(16);
+    std::unique_ptr<std::vector<int>> payload(new std::vector<int>(1000, 7));
+    const std::vector<int>* raw = payload.get();
+
+    std::unique_ptr<std::vector<int>> out;
+    {
+        AllocationCounter counter;
+        ring.push(std::move(payload));
+        ASSERT_TRUE(ring.tryPop(out));
+        EXPECT_EQ(counter.count(), 0);
+    }
+    EXPECT_EQ(payload, nullptr);
+    EXPECT_EQ(out.get(), raw);
+}
+
+// The row and bitmap buffers (and the strings inside the row) are moved, not
+// copied; the tupleAdd nodes come from the session's slab pool.
+TEST(TaskPayloadTest, AddTupleDoesNotCopyRows) {
+    const int32_t ROWS = 1000;
+    Session session(60, 1);   // not started: tasks stay in its queue
+    std::vector<std::vector<allVars>> rows;
+    std::vector<std::vector<bool>> bitmaps;
+    for (int32_t i = 0; i < ROWS; ++i) {
+        rows.push_back(makeRow(ROW_COLUMNS));
+        bitmaps.push_back(std::vector<bool>(ROW_COLUMNS, true));
+    }
+
+    int64_t allocations;
+    int64_t rowBuffers;
+    {
+        AllocationCounter counter;
+        RowBufferWatch watch;
+        for (int32_t i = 0; i < ROWS; ++i) {
+            session.addTuple("data/", 1, std::move(rows[i]), std::move(bitmaps[i]));
+        }
+        allocations = counter.count();
+        rowBuffers = watch.count();
+    }
+    EXPECT_EQ(rowBuffers, 0);
+    // a slab per PAYLOAD_POOL_SLAB rows plus the pool's own bookkeeping, nothing per row
+    EXPECT_LE(allocations, ROWS / 10);
+    EXPECT_GE(session.getTuplePoolCapacity(), static_cast<size_t>(ROWS));
+    for (int32_t i = 0; i < ROWS; ++i) {
+        EXPECT_TRUE(rows[i].empty());
+    }
+}
+
+// the whole way: queue, worker, Session::execute, addTupleToBuffer
+TEST(TaskPayloadTest, ExecutedTupleIsNeverCopied) {
+    const int32_t ROWS = 500;
+    SessionScheduler scheduler(2);
+    addUserToCache(new buser(getNextUserId(), "payloadUser", "pass", "p@email.com", false));
+    Session session(60, 1, &scheduler);
+    session.setWal(nullptr);
+    session.start("payloadUser", "pass", "");
+    std::vector<std::vector<allVars>> rows;
+    for (int32_t i = 0; i < ROWS; ++i) {
+        rows.push_back(makeRow(ROW_COLUMNS));
+    }
+
+    int64_t rowBuffers;
+    {
+        RowBufferWatch watch;
+        TaskHandle last;
+        for (int32_t i = 0; i < ROWS; ++i) {
+            last = session.addTuple("data/", 1, std::move(rows[i]), std::vector<bool>(ROW_COLUMNS, true));
+        }
+        EXPECT_EQ(last.wait(), TaskStatus::DONE);
+        rowBuffers = watch.count();
+    }
+    session.stop();
+    EXPECT_EQ(rowBuffers, 0);
+}
+
+TEST(TaskPayloadTest, AddTuplesIsOneAllocationPerBatch) {
+    Session session(60, 1);
+    std::unique_ptr<tuplesAdd> batch(new tuplesAdd());
+    batch->tableId = 1;
+    for (int32_t i = 0; i < 100; ++i) {
+        batch->rows.push_back(makeRow(16));
+        batch->bitmaps.push_back(std::vector<bool>(16, true));
+    }
+
+    AllocationCounter counter;
+    session.addTuples(std::move(batch));
+    EXPECT_EQ(counter.count(), 0);
+}
+
+TEST(TaskPayloadTest, PoolRecyclesWithoutAllocating) {
+    PayloadPool<tupleAdd> pool;
+    {
+        std::vector<PooledPtr<tupleAdd>> warm;
+        for (size_t i = 0; i < 2 * PAYLOAD_POOL_SLAB; ++i) {
+            warm.push_back(pool.acquire());
+        }
+    }
+    EXPECT_EQ(pool.getFreeCount(), 2 * PAYLOAD_POOL_SLAB);
+
+    AllocationCounter counter;
+    for (int32_t i = 0; i < 10000; ++i) {
+        PooledPtr<tupleAdd> payload = pool.acquire();
+        payload->tableId = i;
+    }
+    EXPECT_EQ(counter.count(), 0);
+    EXPECT_EQ(pool.getCapacity(), 2 * PAYLOAD_POOL_SLAB);
+}
+
+TEST(TaskPayloadTest, ReleasedPayloadIsReset) {
+    PayloadPool<tupleAdd> pool;
+    tupleAdd* raw;
+    {
+        PooledPtr<tupleAdd> payload = pool.acquire();
+        payload->tableId = 7;
+        payload->data = makeRow(4);
+        raw = payload.get();
+    }
+    PooledPtr<tupleAdd> again = pool.acquire();
+    EXPECT_EQ(again.get(), raw);
+    EXPECT_TRUE(again->data.empty());
+}
+
+TEST(TaskPayloadTest, StoppedSessionFreesQueuedPayloads) {
+    {
+        Session session(60, 1);
+        for (int32_t i = 0; i < 10; ++i) {
+            session.addTuple("data/", 1, makeRow(4), std::vector<bool>(4, true));
+        }
+    }   // queued tasks go back to the pool before the pool is destroyed
+    SUCCEED();
+}
@@ -0,0 +1,145 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <atomic>
+#include "../src/taskQueue.h"
+
+// ==================== TESTY TASK QUEUE ====================
+
+TEST(TaskQueueTest, CapacityIsRoundedToPowerOfTwo) {
+    MpscRing<int> ring(100);
+    EXPECT_EQ(ring.capacity(), 128u);
+}
+
+TEST(TaskQueueTest, PushPopKeepsOrder) {
+    MpscRing<int> ring(8);
+    EXPECT_TRUE(ring.empty());
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_TRUE(ring.tryPush(i));
+    }
+    EXPECT_FALSE(ring.empty());
+    for (int i = 0; i < 5; ++i) {
+        int value = -1;
+        ASSERT_TRUE(ring.tryPop(value));
+        EXPECT_EQ(value, i);
+    }
+    int value;
+    EXPECT_FALSE(ring.tryPop(value));
+    EXPECT_TRUE(ring.empty());
+}
+
+TEST(TaskQueueTest, TryPushFailsWhenFull) {
+    MpscRing<int> ring(4);
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_TRUE(ring.tryPush(i));
+    }
+    EXPECT_FALSE(ring.tryPush(99));
+
+    int value;
+    ASSERT_TRUE(ring.tryPop(value));
+    EXPECT_TRUE(ring.tryPush(99));
+}
+
+TEST(TaskQueueTest, PopBatch) {
+    MpscRing<int> ring(16);
+    for (int i = 0; i < 10; ++i) {
+        ring.push(i);
+    }
+    int out[4];
+    EXPECT_EQ(ring.popBatch(out, 4), 4u);
+    EXPECT_EQ(out[0], 0);
+    EXPECT_EQ(out[3], 3);
+    int rest[16];
+    EXPECT_EQ(ring.popBatch(rest, 16), 6u);
+    EXPECT_EQ(rest[5], 9);
+    EXPECT_EQ(ring.popBatch(rest, 16), 0u);
+}
+
+TEST(TaskQueueTest, WrapAround) {
+    MpscRing<int> ring(4);
+    for (int round = 0; round < 100; ++round) {
+        ring.push(round);
+        ring.push(round + 1000);
+        int a, b;
+        ASSERT_TRUE(ring.tryPop(a));
+        ASSERT_TRUE(ring.tryPop(b));
+        EXPECT_EQ(a, round);
+        EXPECT_EQ(b, round + 1000);
+    }
+}
+
+TEST(TaskQueueTest, MultipleProducersKeepPerProducerOrder) {
+    const int NUM_PRODUCERS = 4;
+    const int PER_PRODUCER = 20000;
+    MpscRing<int64_t> ring(256);
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < NUM_PRODUCERS; ++p) {
+        producers.emplace_back([&ring, p]() {
+            for (int i = 0; i < PER_PRODUCER; ++i) {
+                ring.push((static_cast<int64_t>(p) << 32) | i);
+            }
+        });
+    }
+
+    std::vector<int64_t> last(NUM_PRODUCERS, -1);
+    int received = 0;
+    int64_t batch[32];
+    while (received < NUM_PRODUCERS * PER_PRODUCER) {
+        size_t n = ring.popBatch(batch, 32);
+        if (n == 0) {
+            ring.waitForData(nullptr);
+            continue;
+        }
+        for (size_t i = 0; i < n; ++i) {
+            int p = static_cast<int>(batch[i] >> 32);
+            int64_t seq = batch[i] & 0xffffffff;
+            EXPECT_EQ(seq, last[p] + 1);
+            last[p] = seq;
+        }
+        received += static_cast<int>(n);
+    }
+    for (auto& t : producers) {
+        t.join();
+    }
+    EXPECT_TRUE(ring.empty());
+}
+
+TEST(TaskQueueTest, ParkedConsumerWakesOnPush) {
+    MpscRing<int> ring(8);
+    std::atomic<bool> got{false};
+    std::thread consumer([&ring, &got]() {
+        timespec timeout{5, 0};
+        if (ring.waitForData(&timeout)) {
+            got = true;
+        }
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    ring.push(1);
+    consumer.join();
+    EXPECT_TRUE(got.load());
+}
+
+TEST(TaskQueueTest, WaitTimesOut) {
+    MpscRing<int> ring(8);
+    timespec timeout{0, 20 * 1000000L};
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_FALSE(ring.waitForData(&timeout));
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(15));
+}
+
+TEST(TaskQueueTest, CancelWakesParkedConsumer) {
+    MpscRing<int> ring(8);
+    std::atomic<bool> cancel{false};
+    std::thread consumer([&ring, &cancel]() {
+        timespec timeout{30, 0};
+        ring.waitForData(&timeout, &cancel);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    auto start = std::chrono::steady_clock::now();
+    cancel = true;
+    ring.wakeConsumer();
+    consumer.join();
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+}
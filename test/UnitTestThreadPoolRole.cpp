@@ -7,3 +7,162 @@
 
 // ==================== TESTY THREAD POOL ROLE ====================
 
+
+class SessionCompletionTest : public ::testing::Test {
+protected:
+    SessionScheduler scheduler{2};
+
+    void setupUser(const std::string& username, const std::string& passwd) {
+        addUserToCache(new buser(getNextUserId(), username, passwd, "test@email.com", false));
+    }
+};
+
+TEST_F(SessionCompletionTest, WaitOnLastHandleCoversPipeline) {
+    setupUser("completionUser1", "pass");
+    Session session(60, 1, &scheduler);
+    session.start("completionUser1", "pass", "");
+
+    size_t before = userCache.size();
+    TaskHandle last;
+    for (int32_t i = 0; i < 500; ++i) {
+        last = session.addBuser(new buser(getNextUserId(), "completionPipe" + std::to_string(i), "p", "c@email.com", false));
+    }
+    ASSERT_TRUE(last.valid());
+    EXPECT_EQ(last.wait(), TaskStatus::DONE);
+    EXPECT_EQ(userCache.size(), before + 500);
+    session.stop();
+}
+
+TEST_F(SessionCompletionTest, HandlesAreOrdered) {
+    Session session(60, 1, &scheduler);
+    TaskHandle first = session.addBuser(new buser(getNextUserId(), "completionOrder1", "p", "c@email.com", false));
+    TaskHandle second = session.addBuser(new buser(getNextUserId(), "completionOrder2", "p", "c@email.com", false));
+    EXPECT_LT(first.getSequence(), second.getSequence());
+    session.stop();
+}
+
+TEST_F(SessionCompletionTest, CallbackReportsStatus) {
+    setupUser("completionUser2", "pass");
+    Session session(60, 1, &scheduler);
+    session.start("completionUser2", "pass", "");
+
+    std::atomic<int32_t> done{0};
+    std::atomic<int32_t> failed{0};
+    auto callback = [&done, &failed](TaskStatus status) {
+        if (status == TaskStatus::DONE) {
+            done++;
+        } else if (status == TaskStatus::FAILED) {
+            failed++;
+        }
+    };
+    for (int32_t i = 0; i < 10; ++i) {
+        session.addBuser(new buser(getNextUserId(), "completionCb" + std::to_string(i), "p", "c@email.com", false), callback);
+    }
+    std::unique_ptr<tuplesAdd> broken(new tuplesAdd());
+    broken->rows.resize(2);          // two rows, one bitmap
+    broken->bitmaps.resize(1);
+    TaskHandle brokenHandle = session.addTuples(std::move(broken), callback);
+
+    EXPECT_EQ(brokenHandle.wait(), TaskStatus::FAILED);
+    EXPECT_EQ(brokenHandle.status(), TaskStatus::FAILED);
+    EXPECT_EQ(done.load(), 10);
+    EXPECT_EQ(failed.load(), 1);
+    session.stop();
+}
+
+TEST_F(SessionCompletionTest, FailuresStayReadableAndForgottenOnesAreUnknown) {
+    setupUser("completionUser3", "pass");
+    Session session(60, 1, &scheduler);
+    session.start("completionUser3", "pass", "");
+
+    auto broken = []() {
+        std::unique_ptr<tuplesAdd> batch(new tuplesAdd());
+        batch->rows.resize(2);
+        batch->bitmaps.resize(1);
+        return batch;
+    };
+    TaskHandle failed = session.addTuples(broken());
+    TaskHandle copy = failed;
+    EXPECT_EQ(failed.wait(), TaskStatus::FAILED);
+    // reading does not consume the outcome
+    EXPECT_EQ(failed.status(), TaskStatus::FAILED);
+    EXPECT_EQ(copy.status(), TaskStatus::FAILED);
+    EXPECT_EQ(session.taskStatus(failed.getSequence()), TaskStatus::FAILED);
+    TaskHandle succeeded = session.addBuser(new buser(getNextUserId(), "completionKept", "p", "c@email.com", false));
+    EXPECT_EQ(succeeded.wait(), TaskStatus::DONE);
+
+    TaskHandle oldest = session.addTuples(broken());
+    TaskHandle newest;
+    for (size_t i = 0; i < SESSION_FAILED_TASKS_KEPT; ++i) {
+        newest = session.addTuples(broken());
+        if ((i + 1) % (SESSION_QUEUE_CAPACITY / 2) == 0) {
+            // the queue only holds SESSION_QUEUE_CAPACITY tasks
+            session.addBuser(new buser(getNextUserId(), "completionCap" + std::to_string(i), "p", "c@email.com", false)).wait();
+        }
+    }
+    EXPECT_EQ(newest.wait(), TaskStatus::FAILED);
+    // SESSION_FAILED_TASKS_KEPT + 2 failures: the two oldest and everything before them
+    // are unknown now, never DONE
+    EXPECT_EQ(oldest.status(), TaskStatus::UNKNOWN);
+    EXPECT_EQ(failed.status(), TaskStatus::UNKNOWN);
+    EXPECT_EQ(succeeded.status(), TaskStatus::UNKNOWN);
+    session.stop();
+}
+
+TEST_F(SessionCompletionTest, PendingUntilStartedAndCancelledOnStop) {
+    setupUser("completionUser3", "pass");
+    Session idle(60, 1, &scheduler);
+    TaskHandle never = idle.addBuser(new buser(getNextUserId(), "completionNever", "p", "c@email.com", false));
+    EXPECT_EQ(never.status(), TaskStatus::PENDING);
+    EXPECT_EQ(never.waitFor(20), TaskStatus::PENDING);
+    idle.stop();
+    EXPECT_EQ(never.wait(), TaskStatus::CANCELLED);
+
+    Session late(60, 1, &scheduler);
+    TaskHandle queued = late.addBuser(new buser(getNextUserId(), "completionLate", "p", "c@email.com", false));
+    late.start("completionUser3", "pass", "");
+    EXPECT_EQ(queued.wait(), TaskStatus::DONE);
+    late.stop();
+}
+
+TEST_F(SessionCompletionTest, SubmitsAreCancelledWhenFullOrStopped) {
+    std::atomic<int32_t> cancelled{0};
+    TaskCallback onComplete = [&cancelled](TaskStatus status) {
+        if (status == TaskStatus::CANCELLED) {
+            cancelled.fetch_add(1);
+        }
+    };
+    // nothing drains an idle session, so its ring fills up and the next submit does not wait
+    Session idle(60, 1, &scheduler);
+    for (size_t i = 0; i < SESSION_QUEUE_CAPACITY; ++i) {
+        ASSERT_TRUE(idle.addTuples(std::make_unique<tuplesAdd>(), onComplete).valid());
+    }
+    TaskHandle overflow = idle.addTuples(std::make_unique<tuplesAdd>(), onComplete);
+    EXPECT_FALSE(overflow.valid());
+    EXPECT_EQ(overflow.status(), TaskStatus::CANCELLED);
+    EXPECT_EQ(cancelled.load(), 1);
+
+    // stop cancels what was queued, and later submits are cancelled right away
+    idle.stop();
+    EXPECT_EQ(cancelled.load(), static_cast<int32_t>(SESSION_QUEUE_CAPACITY) + 1);
+    EXPECT_FALSE(idle.addTuples(std::make_unique<tuplesAdd>(), onComplete).valid());
+    EXPECT_EQ(cancelled.load(), static_cast<int32_t>(SESSION_QUEUE_CAPACITY) + 2);
+
+    setupUser("completionUser4", "pass");
+    Session stopped(60, 1, &scheduler);
+    stopped.start("completionUser4", "pass", "");
+    stopped.stop();
+    buser* user = new buser(getNextUserId(), "completionStopped", "p", "c@email.com", false);
+    TaskHandle rejected = stopped.addBuser(user, onComplete);
+    EXPECT_FALSE(rejected.valid());
+    EXPECT_EQ(rejected.wait(), TaskStatus::CANCELLED);
+    EXPECT_EQ(cancelled.load(), static_cast<int32_t>(SESSION_QUEUE_CAPACITY) + 3);
+    delete user;   // a cancelled buser stays the caller's
+}
+
+TEST_F(SessionCompletionTest, InvalidHandle) {
+    TaskHandle handle;
+    EXPECT_FALSE(handle.valid());
+    EXPECT_EQ(handle.status(), TaskStatus::CANCELLED);
+    EXPECT_EQ(handle.wait(), TaskStatus::CANCELLED);
+}
@@ -0,0 +1,182 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "../src/tupleCodec.h"
+#include "../src/slottedPage.h"
+#include "../src/threadPoolRole.h"
+#include "../../bufforing-stm/src/buserCache.h"
+#include "testHelpers.h"
+
+// ==================== TESTY TUPLE CODEC ====================
+
+static std::vector<allVars> wideRow(int64_t seed) {
+    std::vector<allVars> row;
+    for (int32_t i = 0; i < 20; ++i) {
+        switch (i % 5) {
+            case 0: row.push_back(static_cast<int8_t>(seed + i)); break;
+            case 1: row.push_back(static_cast<int16_t>(seed * 3 + i)); break;
+            case 2: row.push_back(static_cast<int32_t>(seed * 7 + i)); break;
+            case 3: row.push_back(static_cast<int64_t>(seed << 20) + i); break;
+            default: row.push_back((seed + i) % 2 == 0); break;
+        }
+    }
+    return row;
+}
+
+static std::vector<uint8_t> typesOf(const std::vector<allVars>& row) {
+    std::vector<uint8_t> types;
+    for (const allVars& v : row) {
+        types.push_back(static_cast<uint8_t>(v.index()));
+    }
+    return types;
+}
+
+TEST(TupleCodecTest, FixedSchemaMatchesGenericFormat) {
+    std::vector<allVars> row = wideRow(5);
+    std::vector<bool> bitmap(row.size(), true);
+    TupleCodec codec(typesOf(row), {});
+    EXPECT_TRUE(codec.isAllFixed());
+    EXPECT_FALSE(codec.hasNullable());
+    EXPECT_EQ(codec.encodedSize(row, bitmap), tupleEncodedSize(row, bitmap));
+    EXPECT_EQ(codec.getFixedSize(), tupleEncodedSize(row, bitmap));
+
+    std::vector<uint8_t> generic(tupleEncodedSize(row, bitmap));
+    std::vector<uint8_t> fast(codec.encodedSize(row, bitmap));
+    encodeTuple(generic.data(), row, bitmap);
+    EXPECT_EQ(codec.encode(fast.data(), row, bitmap), fast.size());
+    EXPECT_EQ(fast, generic);
+
+    std::vector<allVars> decoded;
+    std::vector<bool> decodedBitmap;
+    ASSERT_TRUE(codec.decode(fast.data(), fast.size(), decoded, decodedBitmap));
+    EXPECT_EQ(decoded, row);
+    EXPECT_EQ(decodedBitmap, bitmap);
+    EXPECT_FALSE(codec.decode(fast.data(), fast.size() - 1, decoded, decodedBitmap));
+}
+
+TEST(TupleCodecTest, NullableAndStringColumns) {
+    std::vector<uint8_t> types{TUPLE_TYPE_INT32, TUPLE_TYPE_STRING, TUPLE_TYPE_INT64, TUPLE_TYPE_STRING, TUPLE_TYPE_BOOL};
+    TupleCodec codec(types, {0, 1, 1, 0, 0});
+    EXPECT_FALSE(codec.isAllFixed());
+    EXPECT_TRUE(codec.hasNullable());
+    std::vector<allVars> row{allVars(int32_t(11)), allVars(std::string("skipped")), allVars(int64_t(-9)),
+                             allVars(std::string("name")), allVars(true)};
+    std::vector<bool> bitmap{true, false, true, true, true};
+
+    std::vector<uint8_t> generic(tupleEncodedSize(row, bitmap));
+    size_t genericSize = encodeTuple(generic.data(), row, bitmap);
+    std::vector<uint8_t> fast(codec.encodedSize(row, bitmap));
+    size_t fastSize = codec.encode(fast.data(), row, bitmap);
+    ASSERT_GT(fastSize, 0u);
+    EXPECT_EQ(fastSize, genericSize);
+    EXPECT_EQ(fastSize, fast.size());   // the null string is sized as written, length only
+    EXPECT_TRUE(std::equal(fast.begin(), fast.begin() + fastSize, generic.begin()));
+
+    std::vector<allVars> decoded;
+    std::vector<bool> decodedBitmap;
+    ASSERT_TRUE(codec.decode(fast.data(), fastSize, decoded, decodedBitmap));
+    EXPECT_EQ(decodedBitmap, bitmap);
+    EXPECT_EQ(std::get<std::string>(decoded[1]), "");
+    EXPECT_EQ(std::get<std::string>(decoded[3]), "name");
+    EXPECT_EQ(std::get<int64_t>(decoded[2]), -9);
+
+    // only the prefix before the first string has fixed offsets
+    int32_t first = 0;
+    EXPECT_TRUE(codec.readColumn(fast.data(), fastSize, 0, first));
+    EXPECT_EQ(first, 11);
+    int64_t behindString = 0;
+    EXPECT_FALSE(codec.readColumn(fast.data(), fastSize, 2, behindString));
+}
+
+TEST(TupleCodecTest, RowsNotMatchingTheSchemaAreRejected) {
+    TupleCodec codec({TUPLE_TYPE_INT32, TUPLE_TYPE_INT64}, {0, 1});
+    std::vector<uint8_t> out(64);
+    // wrong type
+    EXPECT_EQ(codec.encode(out.data(), {allVars(int64_t(1)), allVars(int64_t(2))}, {true, true}), 0u);
+    // null in a not null column
+    EXPECT_EQ(codec.encode(out.data(), {allVars(int32_t(1)), allVars(int64_t(2))}, {false, true}), 0u);
+    // column count
+    EXPECT_EQ(codec.encode(out.data(), {allVars(int32_t(1))}, {true}), 0u);
+    EXPECT_EQ(codec.encodedSize({allVars(int32_t(1))}, {true}), 0u);
+    // null in a nullable column is fine and reads back as null
+    std::vector<allVars> withNull{allVars(int32_t(1)), allVars(int64_t(2))};
+    size_t size = codec.encode(out.data(), withNull, {true, false});
+    EXPECT_GT(size, 0u);
+    std::vector<uint8_t> generic(tupleEncodedSize(withNull, {true, false}));
+    encodeTuple(generic.data(), withNull, {true, false});
+    EXPECT_TRUE(std::equal(generic.begin(), generic.end(), out.begin()));   // null value zeroed in place
+    int64_t value = 0;
+    EXPECT_FALSE(codec.readColumn(out.data(), size, 1, value));
+    int32_t key = 0;
+    EXPECT_TRUE(codec.readColumn(out.data(), size, 0, key));
+    EXPECT_EQ(key, 1);
+    int64_t wrongWidth = 0;
+    EXPECT_FALSE(codec.readColumn(out.data(), size, 0, wrongWidth));
+}
+
+TEST(TupleCodecTest, PageRowsThroughTheCodec) {
+    std::vector<uint8_t> storage(PAGE_FILE_BLOCK_SIZE);
+    SlottedPage::init(storage.data(), 3, 0);
+    SlottedPage page(storage.data());
+    std::vector<allVars> row = wideRow(1);
+    TupleCodec codec(typesOf(row), {});
+    int32_t rows = 0;
+    while (page.addRow(codec, wideRow(rows), std::vector<bool>(row.size(), true)) >= 0) {
+        rows++;
+    }
+    EXPECT_EQ(rows, static_cast<int32_t>((PAGE_FILE_BLOCK_SIZE - sizeof(SlottedPageHeader)) /
+                                         (((codec.getFixedSize() + 7) / 8 * 8) + sizeof(LinePointer))));
+    uint16_t length;
+    const uint8_t* t = page.getTuple(17, &length);
+    std::vector<allVars> decoded;
+    std::vector<bool> bitmap;
+    ASSERT_TRUE(codec.decode(t, length, decoded, bitmap));
+    EXPECT_EQ(decoded, wideRow(17));
+    // rejected rows leave no tuple behind
+    SlottedPage::init(storage.data(), 3, 0);
+    EXPECT_EQ(page.addRow(codec, {allVars(int32_t(1))}, {true}), -1);
+    EXPECT_EQ(page.getSlotCount(), 0);
+}
+
+TEST(TupleCodecTest, Registry) {
+    TupleCodecRegistry registry;
+    EXPECT_EQ(registry.get(1), nullptr);
+    std::shared_ptr<const TupleCodec> first = registry.define(1, {TUPLE_TYPE_INT32}, {});
+    EXPECT_EQ(registry.get(1), first);
+    std::shared_ptr<const TupleCodec> second = registry.define(1, {TUPLE_TYPE_INT32, TUPLE_TYPE_INT8}, {});
+    EXPECT_EQ(registry.get(1), second);
+    EXPECT_EQ(first->getColumnCount(), 1u);   // a reader keeps the old one alive
+    registry.erase(1);
+    EXPECT_EQ(registry.get(1), nullptr);
+}
+
+TEST(TupleCodecTest, WalRecordsUseTheTableCodec) {
+    std::string walPath = tempTestPath("codec_wal", ".log");
+    std::filesystem::remove(walPath);
+    WalGroupCommit wal;
+    ASSERT_TRUE(wal.open(walPath));
+    SessionScheduler scheduler(1);
+    addUserToCache(new buser(getNextUserId(), "codecWalUser", "pass", "c@email.com", false));
+    sharedTupleCodecs.define(2700, {TUPLE_TYPE_INT64, TUPLE_TYPE_INT32}, {});
+
+    Session session(60, 9, &scheduler);
+    session.setWal(&wal);
+    session.start("codecWalUser", "pass", "");
+    TaskHandle h = session.addTuple("data/", 2700, {allVars(int64_t(1)), allVars(int32_t(2))}, {true, true});
+    EXPECT_EQ(h.wait(), TaskStatus::DONE);
+    session.stop();
+    wal.close();
+    sharedTupleCodecs.erase(2700);
+
+    std::ifstream in(walPath, std::ios::binary);
+    std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    // [uint32 record length][kind][int64 xid][int32 table][uint32 tuple length][tuple]
+    ASSERT_GE(bytes.size(), 4u + 1 + 8 + 4 + 4);
+    EXPECT_EQ(bytes[4], static_cast<uint8_t>(WalRecordKind::TUPLE_ENCODED));
+    uint32_t tupleLength;
+    memcpy(&tupleLength, bytes.data() + 4 + 1 + 8 + 4, sizeof(tupleLength));
+    EXPECT_EQ(tupleLength, TUPLE_HEADER_SIZE + 1u + 8 + 4);
+    std::filesystem::remove(walPath);
+}
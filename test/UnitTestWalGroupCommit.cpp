@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../src/walGroupCommit.h"
+#include "../src/threadPoolRole.h"
+#include "testHelpers.h"
+#include "../../bufforing-stm/src/buserCache.h"
+
+// ==================== TESTY WAL GROUP COMMIT ====================
+
+class WalGroupCommitTest : public TempFileTest<> {
+protected:
+    WalGroupCommitTest() : TempFileTest("wal", ".log") {}
+};
+
+TEST_F(WalGroupCommitTest, AppendCommitWritesRecord) {
+    WalGroupCommit wal;
+    EXPECT_EQ(wal.append("x", 1), 0u);   // closed
+    ASSERT_TRUE(wal.open(filePath));
+
+    std::string record = "hello";
+    uint64_t lsn = wal.append(record.data(), static_cast<uint32_t>(record.size()));
+    EXPECT_EQ(lsn, sizeof(uint32_t) + record.size());
+    EXPECT_TRUE(wal.commit(lsn));
+    EXPECT_EQ(wal.getFlushedLsn(), lsn);
+    EXPECT_EQ(wal.getFsyncCount(), 1);
+    EXPECT_EQ(std::filesystem::file_size(filePath), lsn);
+
+    // already durable, no second fsync
+    EXPECT_TRUE(wal.commit(lsn));
+    EXPECT_EQ(wal.getFsyncCount(), 1);
+}
+
+TEST_F(WalGroupCommitTest, ReopenContinuesLsn) {
+    uint64_t first;
+    {
+        WalGroupCommit wal;
+        ASSERT_TRUE(wal.open(filePath));
+        first = wal.append("abc", 3);
+        wal.close();
+    }
+    WalGroupCommit wal;
+    ASSERT_TRUE(wal.open(filePath));
+    EXPECT_EQ(wal.getFlushedLsn(), first);
+    uint64_t second = wal.append("de", 2);
+    EXPECT_EQ(second, first + sizeof(uint32_t) + 2);
+    wal.close();
+    EXPECT_EQ(std::filesystem::file_size(filePath), second);
+}
+
+TEST_F(WalGroupCommitTest, ConcurrentCommitsShareFsyncs) {
+    WalGroupCommit wal;
+    ASSERT_TRUE(wal.open(filePath));
+    wal.setCommitDelay(2000);
+    wal.setCommitSiblings(1);
+
+    const int32_t THREADS = 8;
+    const int32_t COMMITS = 50;
+    std::atomic<int32_t> failures{0};
+    std::vector<std::thread> threads;
+    for (int32_t t = 0; t < THREADS; ++t) {
+        threads.emplace_back([&wal, &failures]() {
+            for (int32_t i = 0; i < COMMITS; ++i) {
+                uint64_t lsn = wal.append("record", 6);
+                if (!wal.commit(lsn) || wal.getFlushedLsn() < lsn) {
+                    failures++;
+                }
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    EXPECT_EQ(failures.load(), 0);
+    EXPECT_EQ(wal.getCommitCount(), THREADS * COMMITS);
+    EXPECT_LT(wal.getFsyncCount(), THREADS * COMMITS);
+    wal.close();
+    EXPECT_EQ(std::filesystem::file_size(filePath), static_cast<uintmax_t>(THREADS * COMMITS * (sizeof(uint32_t) + 6)));
+}
+
+TEST_F(WalGroupCommitTest, RowEncoding) {
+    std::vector<uint8_t> out;
+    std::vector<allVars> row;
+    row.push_back(static_cast<int32_t>(7));
+    row.push_back(std::string("ab"));
+    walPutRow(out, row, {true, false});
+    // columns + (index, not null, int32) + (index, not null, length, "ab")
+    EXPECT_EQ(out.size(), 4u + (2 + 4) + (2 + 4 + 2));
+    EXPECT_EQ(out[4], static_cast<uint8_t>(row[0].index()));
+    EXPECT_EQ(out[5], 1);
+    EXPECT_EQ(out[11], 0);
+}
+
+TEST_F(WalGroupCommitTest, SessionBatchIsCommittedBeforeCompletion) {
+    WalGroupCommit wal;
+    ASSERT_TRUE(wal.open(filePath));
+    SessionScheduler scheduler(2);
+    addUserToCache(new buser(getNextUserId(), "walSessionUser", "pass", "w@email.com", false));
+
+    Session session(60, 5, &scheduler);
+    session.setWal(&wal);
+    session.start("walSessionUser", "pass", "");
+    TaskHandle last;
+    for (int32_t i = 0; i < 20; ++i) {
+        std::vector<allVars> row;
+        row.push_back(static_cast<int64_t>(i));
+        last = session.addTuple("data/", 3, std::move(row), std::vector<bool>{true});
+    }
+    EXPECT_EQ(last.wait(), TaskStatus::DONE);
+    EXPECT_GT(wal.getFlushedLsn(), 0u);
+    EXPECT_LE(wal.getFsyncCount(), 20);
+    session.stop();
+    wal.close();
+    EXPECT_GT(std::filesystem::file_size(filePath), 20u * sizeof(uint32_t));
+}
@@ -0,0 +1,46 @@
+#ifndef TESTHELPERS_H
+#define TESTHELPERS_H
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "../src/pageFile.h"
+
+// Helpers shared by the tests that work on real files.
+
+// quake_<name>_test_<pid><extension> in the temp directory, so parallel runs do not collide
+inline std::string tempTestPath(const std::string& name, const std::string& extension) {
+    return (std::filesystem::temp_directory_path() / ("quake_" + name + "_test_" + std::to_string(getpid()) + extension)).string();
+}
+
+// fixture owning filePath: removed before the test and again once the fixture (and
+// the files its members keep open) is gone
+template<typename Base = ::testing::Test>
+class TempFileTest : public Base {
+protected:
+    std::string filePath;
+    TempFileTest(const std::string& name, const std::string& extension) : filePath(tempTestPath(name, extension)) {
+        std::filesystem::remove(filePath);
+    }
+    ~TempFileTest() override {
+        std::filesystem::remove(filePath);
+    }
+};
+
+// writes blocks first .. first + count - 1 of file, fill(page, blockNum) makes each page
+template<typename Fill>
+void writeTestBlocks(PageFile& file, int32_t first, int32_t count, Fill fill) {
+    SyncPageIo io(8);
+    std::vector<std::vector<uint8_t>> pages(count, std::vector<uint8_t>(PAGE_FILE_BLOCK_SIZE));
+    std::vector<PageRef> refs;
+    for (int32_t i = 0; i < count; ++i) {
+        fill(pages[i].data(), first + i);
+        refs.push_back({first + i, pages[i].data()});
+    }
+    std::vector<int32_t> results;
+    ASSERT_EQ(file.writePages(io, refs, results), 0);
+}
+
+#endif